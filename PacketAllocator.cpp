@@ -72,13 +72,91 @@ static inline void SIMDSafeFree(void* ptr)
 }
 
 
+//------------------------------------------------------------------------------
+// WindowPool
+
+WindowPool::~WindowPool()
+{
+    for (unsigned i = 0, count = FreeWindows.GetSize(); i < count; ++i) {
+        SIMDSafeFree(FreeWindows.GetRef(i));
+    }
+}
+
+uint8_t* WindowPool::Acquire(unsigned windowBytes)
+{
+    {
+        std::lock_guard<std::mutex> locker(Lock);
+
+        PKTALLOC_DEBUG_ASSERT(WindowBytes == 0 || WindowBytes == windowBytes);
+        WindowBytes = windowBytes;
+
+        const unsigned count = FreeWindows.GetSize();
+        if (count > 0)
+        {
+            uint8_t* window = FreeWindows.GetRef(count - 1);
+            FreeWindows.SetSize_Copy(count - 1);
+            return window;
+        }
+    }
+
+    return SIMDSafeAllocate(windowBytes);
+}
+
+void WindowPool::Release(uint8_t* window)
+{
+    PKTALLOC_DEBUG_ASSERT(window != nullptr);
+
+    {
+        std::lock_guard<std::mutex> locker(Lock);
+        if (FreeWindows.Append(window)) {
+            return;
+        }
+    }
+
+    // Could not grow the list, so free the window rather than leak it
+    SIMDSafeFree(window);
+}
+
+unsigned WindowPool::Trim(unsigned keepBytes)
+{
+    unsigned pooledBytes;
+    {
+        std::lock_guard<std::mutex> locker(Lock);
+
+        unsigned count = FreeWindows.GetSize();
+        const unsigned keepCount = (WindowBytes > 0) ? keepBytes / WindowBytes : 0;
+        while (count > keepCount)
+        {
+            --count;
+            SIMDSafeFree(FreeWindows.GetRef(count));
+        }
+        FreeWindows.SetSize_Copy(count);
+        pooledBytes = count * WindowBytes;
+    }
+    return pooledBytes;
+}
+
+unsigned WindowPool::GetPooledBytes()
+{
+    std::lock_guard<std::mutex> locker(Lock);
+    return FreeWindows.GetSize() * WindowBytes;
+}
+
+
 //------------------------------------------------------------------------------
 // Allocator
 
-Allocator::Allocator()
+Allocator::Allocator(WindowPool* pool)
+    : Pool(pool)
 {
     static_assert(kAlignmentBytes == kUnitSize, "update SIMDSafeAllocate");
 
+    // Pooled allocators do not keep windows of their own
+    if (Pool) {
+        ALLOC_DEBUG_INTEGRITY_CHECK();
+        return;
+    }
+
     PreferredWindows.SetSize_NoCopy(kPreallocatedWindows);
 
     HugeChunkStart = SIMDSafeAllocate(kWindowSizeBytes * kPreallocatedWindows);
@@ -112,7 +190,12 @@ Allocator::~Allocator()
         WindowHeader* window = PreferredWindows.GetRef(i);
         PKTALLOC_DEBUG_ASSERT(window != nullptr);
         if (window && !window->Preallocated) {
-            SIMDSafeFree(window);
+            if (Pool) {
+                Pool->Release((uint8_t*)window);
+            }
+            else {
+                SIMDSafeFree(window);
+            }
         }
     }
     for (unsigned i = 0, count = FullWindows.GetSize(); i < count; ++i)
@@ -120,10 +203,26 @@ Allocator::~Allocator()
         WindowHeader* window = FullWindows.GetRef(i);
         PKTALLOC_DEBUG_ASSERT(window != nullptr);
         if (window && !window->Preallocated) {
-            SIMDSafeFree(window);
+            if (Pool) {
+                Pool->Release((uint8_t*)window);
+            }
+            else {
+                SIMDSafeFree(window);
+            }
         }
     }
     SIMDSafeFree(HugeChunkStart);
+
+    for (unsigned i = 0; i < kLargeClassCount; ++i)
+    {
+        uint8_t* block = LargeFreeLists[i];
+        while (block)
+        {
+            uint8_t* next = *(uint8_t**)(block + kUnitSize);
+            SIMDSafeFree(block);
+            block = next;
+        }
+    }
 }
 
 unsigned Allocator::GetMemoryUsedBytes() const
@@ -145,19 +244,33 @@ unsigned Allocator::GetMemoryUsedBytes() const
             sum += kWindowMaxUnits - window->FreeUnitCount;
         }
     }
-    return sum * kUnitSize;
+    return sum * kUnitSize + LargeUsedBytes;
 }
 
 unsigned Allocator::GetMemoryAllocatedBytes() const
 {
-    return (unsigned)((PreferredWindows.GetSize() + FullWindows.GetSize()) * kWindowMaxUnits * kUnitSize);
+    const unsigned windowBytes = (unsigned)((PreferredWindows.GetSize() + FullWindows.GetSize()) * kWindowMaxUnits * kUnitSize);
+    return windowBytes + LargeUsedBytes + LargeKeptBytes;
+}
+
+unsigned Allocator::GetFallbackAllocateCount() const
+{
+    return FallbackAllocateCount;
+}
+
+unsigned Allocator::GetCapacityBytes(const uint8_t* ptr) const
+{
+    if (!ptr) {
+        return 0;
+    }
+    const AllocationHeader* regionHeader = (const AllocationHeader*)(ptr - kUnitSize);
+    PKTALLOC_DEBUG_ASSERT(!regionHeader->IsFreed());
+    return (regionHeader->UsedUnits - 1) * kUnitSize;
 }
 
 bool Allocator::IntegrityCheck() const
 {
-#ifdef PKTALLOC_SHRINK
     PKTALLOC_DEBUG_ASSERT(PreferredWindows.GetSize() >= EmptyWindowCount);
-#endif // PKTALLOC_SHRINK
 
     unsigned emptyCount = 0;
     unsigned preallocatedCount = 0;
@@ -252,16 +365,16 @@ bool Allocator::IntegrityCheck() const
         }
     }
 
-    if (preallocatedCount != kPreallocatedWindows) {
+    // Pooled allocators and allocators that failed to preallocate have none
+    const unsigned expectedPreallocated = HugeChunkStart ? kPreallocatedWindows : 0;
+    if (preallocatedCount != expectedPreallocated) {
         PKTALLOC_DEBUG_BREAK(); // Lost a preallocated window
         return false;
     }
-#ifdef PKTALLOC_SHRINK
     if (emptyCount != EmptyWindowCount) {
         PKTALLOC_DEBUG_BREAK(); // EmptyWindowCount does not match 
         return false;
     }
-#endif // PKTALLOC_SHRINK
     return true;
 }
 
@@ -326,14 +439,12 @@ uint8_t* Allocator::Allocate(unsigned bytes)
             regionHeader->UsedUnits = units;
 
             // Update window header
-#ifdef PKTALLOC_SHRINK
             if (window->FreeUnitCount >= kWindowMaxUnits &&
                 !window->Preallocated)
             {
                 PKTALLOC_DEBUG_ASSERT(EmptyWindowCount > 0);
                 --EmptyWindowCount;
             }
-#endif // PKTALLOC_SHRINK
             window->FreeUnitCount -= units;
             usedPtr->SetRange(regionStart, regionStart + units);
             window->ResumeScanOffset = regionStart + units;
@@ -397,7 +508,13 @@ uint8_t* Allocator::allocateFromNewWindow(unsigned units)
 {
     ALLOC_DEBUG_INTEGRITY_CHECK();
 
-    uint8_t* headerStart = SIMDSafeAllocate(kWindowSizeBytes);
+    uint8_t* headerStart;
+    if (Pool) {
+        headerStart = Pool->Acquire(kWindowSizeBytes);
+    }
+    else {
+        headerStart = SIMDSafeAllocate(kWindowSizeBytes);
+    }
     if (!headerStart) {
         return nullptr; // Allocation failure
     }
@@ -575,8 +692,9 @@ void Allocator::Free(uint8_t* ptr)
     WindowHeader* window = regionHeader->Header;
     if (!window)
     {
+        const unsigned units = regionHeader->UsedUnits;
         regionHeader->UsedUnits = 0; // Mark freed
-        fallbackFree(ptr);
+        fallbackFree(ptr, units);
         return;
     }
 
@@ -626,19 +744,54 @@ void Allocator::Free(uint8_t* ptr)
         PreferredWindows.Append(window);
     }
 
-#ifdef PKTALLOC_SHRINK
-    // If we should do some bulk cleanup:
     if (window->FreeUnitCount >= kWindowMaxUnits &&
-        !window->Preallocated &&
-        ++EmptyWindowCount >= kEmptyWindowCleanupThreshold)
+        !window->Preallocated)
     {
-        freeEmptyWindows();
-    }
+        // If we already keep an empty window, hand this one back to the pool.
+        // Keeping one avoids taking the pool lock on every allocation when
+        // usage hovers around a window boundary:
+        if (Pool && EmptyWindowCount >= kPoolKeptEmptyWindows)
+        {
+            releaseWindowToPool(window);
+            ALLOC_DEBUG_INTEGRITY_CHECK();
+            return;
+        }
+
+        ++EmptyWindowCount;
+
+#ifdef PKTALLOC_SHRINK
+        // If we should do some bulk cleanup:
+        if (EmptyWindowCount >= kEmptyWindowCleanupThreshold) {
+            freeEmptyWindows();
+        }
 #endif // PKTALLOC_SHRINK
+    }
 
     ALLOC_DEBUG_INTEGRITY_CHECK();
 }
 
+void Allocator::releaseWindowToPool(WindowHeader* window)
+{
+    PKTALLOC_DEBUG_ASSERT(Pool && window->FullListIndex == kNotInFullList);
+
+    // Empty windows are always in the preferred list:
+    const unsigned count = PreferredWindows.GetSize();
+    for (unsigned i = 0; i < count; ++i)
+    {
+        if (PreferredWindows.GetRef(i) != window) {
+            continue;
+        }
+
+        PreferredWindows.GetRef(i) = PreferredWindows.GetRef(count - 1);
+        PreferredWindows.SetSize_Copy(count - 1);
+
+        Pool->Release((uint8_t*)window);
+        return;
+    }
+
+    PKTALLOC_DEBUG_BREAK(); // Window not found
+}
+
 #ifdef PKTALLOC_SHRINK
 
 void Allocator::freeEmptyWindows()
@@ -683,16 +836,60 @@ void Allocator::freeEmptyWindows()
 
 #endif // PKTALLOC_SHRINK
 
+int Allocator::getLargeClass(unsigned& units)
+{
+    if (units <= kLargeClassBaseUnits) {
+        return -1; // Only with PKTALLOC_DISABLE
+    }
+
+    // Find the power of two above the base that contains this size
+    unsigned doubling = 0;
+    for (unsigned x = (units - 1) / kLargeClassBaseUnits; x > 1; x >>= 1) {
+        ++doubling;
+    }
+    if (doubling >= kLargeClassDoublings) {
+        return -1;
+    }
+
+    // Round up to the next quarter step
+    const unsigned step = (kLargeClassBaseUnits << doubling) / 4;
+    units = (units + step - 1) & ~(step - 1);
+
+    // Units are now 5..8 steps
+    PKTALLOC_DEBUG_ASSERT(units / step >= 5 && units / step <= 8);
+    return (int)(doubling * 4 + units / step - 5);
+}
+
 uint8_t* Allocator::fallbackAllocate(unsigned bytes)
 {
     // Calculate number of units required by this allocation
     // Note: +1 for the AllocationHeader
-    const unsigned units = (bytes + kUnitSize - 1) / kUnitSize + 1;
+    unsigned units = (bytes + kUnitSize - 1) / kUnitSize + 1;
 
-    uint8_t* ptr = SIMDSafeAllocate(kUnitSize * units);
-    if (!ptr) {
-        return nullptr;
+    const int largeClass = getLargeClass(units);
+
+    uint8_t* ptr = nullptr;
+    if (largeClass >= 0 && LargeFreeLists[largeClass])
+    {
+        // Reuse a block freed earlier in the same size class
+        ptr = LargeFreeLists[largeClass];
+        LargeFreeLists[largeClass] = *(uint8_t**)(ptr + kUnitSize);
+        PKTALLOC_DEBUG_ASSERT(LargeFreeCounts[largeClass] > 0);
+        --LargeFreeCounts[largeClass];
+        LargeKeptBytes -= units * kUnitSize;
+#ifdef PKTALLOC_SCRUB_MEMORY
+        memset(ptr + kUnitSize, 0, (units - 1) * kUnitSize);
+#endif // PKTALLOC_SCRUB_MEMORY
     }
+    else
+    {
+        ptr = SIMDSafeAllocate(kUnitSize * units);
+        if (!ptr) {
+            return nullptr;
+        }
+        ++FallbackAllocateCount;
+    }
+    LargeUsedBytes += units * kUnitSize;
 
     AllocationHeader* regionHeader = (AllocationHeader*)ptr;
 #ifdef PKTALLOC_DEBUG
@@ -704,10 +901,31 @@ uint8_t* Allocator::fallbackAllocate(unsigned bytes)
     return ptr + kUnitSize;
 }
 
-void Allocator::fallbackFree(uint8_t* ptr)
+void Allocator::fallbackFree(uint8_t* ptr, unsigned units)
 {
     PKTALLOC_DEBUG_ASSERT(ptr);
-    SIMDSafeFree(ptr - kUnitSize);
+    PKTALLOC_DEBUG_ASSERT(LargeUsedBytes >= units * kUnitSize);
+    LargeUsedBytes -= units * kUnitSize;
+
+    uint8_t* block = ptr - kUnitSize;
+
+    // Keep a few blocks in each size class for reuse.
+    // Pooled allocators do not hold on to memory while idle
+    unsigned classUnits = units;
+    const int largeClass = getLargeClass(classUnits);
+    if (largeClass >= 0 &&
+        !Pool &&
+        LargeFreeCounts[largeClass] < kLargeClassKeepMax)
+    {
+        PKTALLOC_DEBUG_ASSERT(classUnits == units);
+        *(uint8_t**)ptr = LargeFreeLists[largeClass];
+        LargeFreeLists[largeClass] = block;
+        ++LargeFreeCounts[largeClass];
+        LargeKeptBytes += units * kUnitSize;
+        return;
+    }
+
+    SIMDSafeFree(block);
 }
 
 
@@ -55,6 +55,7 @@
 #include <stdint.h>
 #include <new>
 #include <cstring> // memcpy
+#include <mutex>
 
 #ifdef _WIN32
     #include <intrin.h> // __popcnt64
@@ -84,11 +85,12 @@ namespace pktalloc {
 //#define PKTALLOC_ENABLE_ALLOCATOR_INTEGRITY_CHECKS
 
 
-#if defined(__AVX2__) || (defined (_MSC_VER) && _MSC_VER >= 1900)
-    #define PKTALLOC_ALIGN_BYTES 32 /**< Allocating on 256-bit boundaries */
-#else // __AVX2__
+/// Alignment does not depend on the instruction set selected at runtime
+#if defined(ANDROID) || defined(IOS) || defined(LINUX_ARM) || defined(__powerpc__) || defined(__s390__)
     #define PKTALLOC_ALIGN_BYTES 16 /**< Allocating on 128-bit boundaries */
-#endif // __AVX2__
+#else // Desktop
+    #define PKTALLOC_ALIGN_BYTES 64 /**< Allocating on cache line boundaries */
+#endif // Desktop
 
 /// Alignment requirements of library
 static const unsigned kAlignmentBytes = PKTALLOC_ALIGN_BYTES;
@@ -97,12 +99,16 @@ static const unsigned kAlignmentBytes = PKTALLOC_ALIGN_BYTES;
 static const unsigned kUnitSize = kAlignmentBytes;
 
 /// Maximum number of units per window, tuned for ~1400 byte packets.
-/// Tune this if the data sizes are larger
-static const unsigned kWindowMaxUnits = 2048;
+/// Tune this if the data sizes are larger.
+/// Windows are 64 KB with 64-byte units and 32 KB with 16-byte units
+static const unsigned kWindowMaxUnits = (kUnitSize >= 64) ? 1024 : 2048;
 
 /// Preallocated windows (about 128 KB on desktop)
 static const unsigned kPreallocatedWindows = 2;
 
+/// Pooled allocators keep this many empty windows before giving them back
+static const unsigned kPoolKeptEmptyWindows = 1;
+
 /// PKTALLOC_SHRINK: Keep some windows around
 static const unsigned kEmptyWindowMinimum = 32;
 
@@ -588,6 +594,53 @@ public:
 };
 
 
+//------------------------------------------------------------------------------
+// WindowPool
+
+/**
+    Pool of allocator windows shared between many Allocator objects.
+
+    An Allocator created with a pool does not preallocate any windows.  It
+    takes windows from the pool as it grows and keeps at most one empty
+    window, giving the rest back as they empty, so idle codecs hold at most
+    one window and the windows freed by one codec are reused by the next.
+    The pool keeps what it is given until Trim() is called.  Each Allocator still only reports the
+    windows it holds, so per-codec memory statistics stay accurate.
+
+    The pool is only touched when a window is taken or returned, and that is
+    protected by a mutex.  Using one pool per thread avoids contention.
+    The pool must outlive every Allocator that uses it.
+*/
+class WindowPool
+{
+public:
+    ~WindowPool();
+
+    /// Take a window from the pool, or allocate a new one if it is empty.
+    /// All windows must be the same size.  Returns nullptr on OOM
+    uint8_t* Acquire(unsigned windowBytes);
+
+    /// Give a window back to the pool
+    void Release(uint8_t* window);
+
+    /// Free pooled windows until at most `keepBytes` are held.
+    /// Returns the bytes still held by the pool
+    unsigned Trim(unsigned keepBytes);
+
+    /// Statistics API: Bytes held by the pool that are not in use
+    unsigned GetPooledBytes();
+
+protected:
+    std::mutex Lock;
+
+    /// Windows that are not in use
+    LightVector<uint8_t*> FreeWindows;
+
+    /// Size of each window in bytes
+    unsigned WindowBytes = 0;
+};
+
+
 //------------------------------------------------------------------------------
 // Allocator
 
@@ -595,7 +648,9 @@ public:
 class Allocator
 {
 public:
-    Allocator();
+    /// If a pool is provided, windows are taken from it and given back to it
+    /// instead of being allocated and preallocated for this object alone
+    explicit Allocator(WindowPool* pool = nullptr);
     ~Allocator();
 
     /**
@@ -603,7 +658,8 @@ public:
 
         Allocate some memory from the pre-allocated blocks.
         If not enough memory is available it will internally add another block.
-        Allocations that cannot fit in a block are performed with calloc().
+        Allocations that cannot fit in a block are rounded up to a size class,
+        and are reused from blocks freed earlier or performed with calloc().
 
         Returns a pointer to the allocated memory block that is `bytes` in size.
         Returns nullptr if memory request could not be satisfied.
@@ -678,11 +734,19 @@ public:
         }
     }
 
+    /// Returns the number of bytes that can be used in an allocation, which
+    /// may be more than requested.  Reallocate() within this size is free
+    unsigned GetCapacityBytes(const uint8_t* ptr) const;
+
     /// Statistics API
     unsigned GetMemoryUsedBytes() const;
     unsigned GetMemoryAllocatedBytes() const;
     bool IntegrityCheck() const;
 
+    /// Statistics API: Number of large blocks that had to be allocated with
+    /// calloc() because no freed block of the same size class was available
+    unsigned GetFallbackAllocateCount() const;
+
 protected:
     typedef CustomBitSet<kWindowMaxUnits> UsedMaskT;
 
@@ -696,6 +760,20 @@ protected:
     /// List index takes on this value if it is in the preferred list
     static const int kNotInFullList = -1;
 
+    /// Large blocks are rounded up to one of 4 size classes per power of two
+    /// above this many units, so at most 25% of each block is wasted
+    static const unsigned kLargeClassBaseUnits = kWindowMaxUnits / 4;
+
+    /// Number of powers of two with size classes.
+    /// Larger blocks are allocated with the exact size and never kept
+    static const unsigned kLargeClassDoublings = 8;
+
+    /// Number of large size classes
+    static const unsigned kLargeClassCount = kLargeClassDoublings * 4;
+
+    /// Maximum number of freed blocks kept in each size class
+    static const unsigned kLargeClassKeepMax = 4;
+
     /// This is at the front of each allocation window
     struct WindowHeader
     {
@@ -754,6 +832,22 @@ protected:
     /// Preallocated windows on startup
     uint8_t* HugeChunkStart = nullptr;
 
+    /// Shared pool that windows come from, or nullptr
+    WindowPool* Pool = nullptr;
+
+    /// Freed large blocks in each size class, linked through their first bytes
+    uint8_t* LargeFreeLists[kLargeClassCount] = {};
+
+    /// Number of blocks in each of the LargeFreeLists
+    uint8_t LargeFreeCounts[kLargeClassCount] = {};
+
+    /// Bytes in large blocks that are allocated and that are kept for reuse
+    unsigned LargeUsedBytes = 0;
+    unsigned LargeKeptBytes = 0;
+
+    /// Number of large blocks allocated with calloc()
+    unsigned FallbackAllocateCount = 0;
+
     /// List of "preferred" windows with lower utilization
     /// We switch Preferred to Full when a scan fails to find an empty slot
     LightVector<WindowHeader*> PreferredWindows;
@@ -765,10 +859,10 @@ protected:
     static const unsigned kPreferredThresholdUnits = 3 * kWindowMaxUnits / 4;
 
 
-#ifdef PKTALLOC_SHRINK
     /// Counter of the number of empty windows, which triggers us to clean house on Free()
     unsigned EmptyWindowCount = 0;
 
+#ifdef PKTALLOC_SHRINK
     /// Walk the preferred list and free any empty windows
     void freeEmptyWindows();
 #endif
@@ -779,9 +873,17 @@ protected:
     /// Allocate the units from a new window
     uint8_t* allocateFromNewWindow(unsigned units);
 
+    /// Hand an empty window in the preferred list back to the pool
+    void releaseWindowToPool(WindowHeader* window);
+
+    /// Returns the size class for a large block of the given units,
+    /// and rounds up the units to the class size.
+    /// Returns -1 if the block is too large to have a size class
+    static int getLargeClass(unsigned& units);
+
     /// Fallback functions used when the custom allocator will not work
     uint8_t* fallbackAllocate(unsigned bytes);
-    void fallbackFree(uint8_t* ptr);
+    void fallbackFree(uint8_t* ptr, unsigned units);
 };
 
 
@@ -117,12 +117,65 @@ bool GrowingAlignedByteMatrix::Resize(pktalloc::Allocator* allocator, unsigned r
 }
 
 
+//------------------------------------------------------------------------------
+// SumCheckpoint
+
+bool AddSumSnapshot(
+    pktalloc::Allocator* allocator,
+    GrowingAlignedDataBuffer& dest,
+    const GrowingAlignedDataBuffer& a,
+    const GrowingAlignedDataBuffer& b)
+{
+    SIAMESE_DEBUG_ASSERT(&dest != &a && &dest != &b);
+    const unsigned bytes = a.Bytes > b.Bytes ? a.Bytes : b.Bytes;
+
+    if (bytes <= 0)
+    {
+        dest.Bytes = 0;
+        return true;
+    }
+
+    if (!dest.Initialize(allocator, bytes)) {
+        return false;
+    }
+    if (a.Bytes > 0) {
+        memcpy(dest.Data, a.Data, a.Bytes);
+    }
+    memset(dest.Data + a.Bytes, 0, bytes - a.Bytes);
+    if (b.Bytes > 0) {
+        gf256_add_mem(dest.Data, b.Data, b.Bytes);
+    }
+    return true;
+}
+
+
 //------------------------------------------------------------------------------
 // OriginalPacket
 
 unsigned OriginalPacket::Initialize(pktalloc::Allocator* allocator, const SiameseOriginalPacket& packet)
 {
-    SIAMESE_DEBUG_ASSERT(allocator && packet.Data && packet.DataBytes > 0 && packet.PacketNum < kColumnPeriod);
+    SIAMESE_DEBUG_ASSERT(packet.Data);
+
+    // Copy the packet as a single segment
+    SiameseSegment segment;
+    segment.Data      = packet.Data;
+    segment.DataBytes = packet.DataBytes;
+
+    return InitializeSegments(allocator, packet, &segment, 1);
+}
+
+unsigned OriginalPacket::InitializeSegments(
+    pktalloc::Allocator* allocator,
+    const SiameseOriginalPacket& packet,
+    const SiameseSegment* segments,
+    unsigned segmentCount)
+{
+    SIAMESE_DEBUG_ASSERT(allocator && segments && packet.DataBytes > 0 && packet.PacketNum < kColumnPeriod);
+
+    // Do not reallocate application memory
+    if (IsExternal()) {
+        ReleaseExternal();
+    }
 
     // Allocate space for the packet
     const unsigned bufferSize = kMaxPacketLengthFieldBytes + packet.DataBytes;
@@ -133,8 +186,18 @@ unsigned OriginalPacket::Initialize(pktalloc::Allocator* allocator, const Siames
     HeaderBytes = SerializeHeader_PacketLength(packet.DataBytes, Buffer.Data);
     SIAMESE_DEBUG_ASSERT(HeaderBytes <= kMaxPacketLengthFieldBytes);
 
-    // Copy packet data after the length
-    memcpy(Buffer.Data + HeaderBytes, packet.Data, packet.DataBytes);
+    // Gather segments after the length
+    uint8_t* data = Buffer.Data + HeaderBytes;
+    for (unsigned i = 0; i < segmentCount; ++i)
+    {
+        const unsigned segmentBytes = segments[i].DataBytes;
+        if (segmentBytes > 0)
+        {
+            memcpy(data, segments[i].Data, segmentBytes);
+            data += segmentBytes;
+        }
+    }
+    SIAMESE_DEBUG_ASSERT(data == Buffer.Data + HeaderBytes + packet.DataBytes);
 
     Buffer.Bytes = HeaderBytes + packet.DataBytes;
 
@@ -143,5 +206,59 @@ unsigned OriginalPacket::Initialize(pktalloc::Allocator* allocator, const Siames
     return HeaderBytes;
 }
 
+unsigned OriginalPacket::InitializeZeroCopy(
+    pktalloc::Allocator* allocator,
+    const SiameseOriginalPacket& packet,
+    SiameseReleaseCallback release,
+    void* context)
+{
+    SIAMESE_DEBUG_ASSERT(allocator && packet.Data && packet.DataBytes > 0 && packet.PacketNum < kColumnPeriod);
+    SIAMESE_DEBUG_ASSERT(release != nullptr);
+    static_assert(SIAMESE_ZERO_COPY_HEADROOM >= kMaxPacketLengthFieldBytes, "Update this");
+
+    if (IsExternal()) {
+        ReleaseExternal();
+    }
+    else {
+        // Return the buffer this slot had, since the application data replaces it
+        Buffer.Free(allocator);
+    }
+
+    // Serialize the packet length into the headroom just before the data
+    uint8_t header[kMaxPacketLengthFieldBytes];
+    HeaderBytes = SerializeHeader_PacketLength(packet.DataBytes, header);
+    SIAMESE_DEBUG_ASSERT(HeaderBytes <= kMaxPacketLengthFieldBytes);
+
+    uint8_t* data = const_cast<uint8_t*>(packet.Data) - HeaderBytes;
+    memcpy(data, header, HeaderBytes);
+
+    Buffer.Data  = data;
+    Buffer.Bytes = HeaderBytes + packet.DataBytes;
+
+    ExternalRelease = release;
+    ExternalContext = context;
+
+    Column = packet.PacketNum;
+
+    return HeaderBytes;
+}
+
+void OriginalPacket::ReleaseExternal()
+{
+    SIAMESE_DEBUG_ASSERT(IsExternal());
+
+    // Clear state before the callback in case it re-enters the encoder
+    SiameseReleaseCallback release = ExternalRelease;
+    void* context                  = ExternalContext;
+    const uint8_t* data            = Buffer.Data + HeaderBytes;
+
+    ExternalRelease = nullptr;
+    ExternalContext = nullptr;
+    Buffer.Data     = nullptr;
+    Buffer.Bytes    = 0;
+
+    release(context, data);
+}
+
 
 } // namespace siamese
@@ -34,6 +34,7 @@
 
     + Parameters of the Siamese and Cauchy matrix structures
     + Growing buffer/matrix structures
+    + MulAddMultiGather structure
     + OriginalPacket structure
     + RecoveryMetadata structure
 */
@@ -145,6 +146,13 @@ static const unsigned kPairAddRate = 16;
 /// of this size in order to reduce the cost of elimination
 static const unsigned kSubwindowSize = kColumnLaneCount * 8;
 
+/// Returns the slot within a subwindow that holds the given window element.
+/// All subwindow lookups go through here so the layout is kept in one place
+SIAMESE_FORCE_INLINE unsigned GetSubwindowSlot(unsigned windowElement)
+{
+    return windowElement % kSubwindowSize;
+}
+
 /// Thomas Wang's 32-bit -> 32-bit integer hash function
 /// http://burtleburtle.net/bob/hash/integer.html
 SIAMESE_FORCE_INLINE uint32_t Int32Hash(uint32_t key)
@@ -173,6 +181,29 @@ SIAMESE_FORCE_INLINE unsigned GetRowOpcode(unsigned lane, unsigned row)
     return (opcode == 0) ? kZeroValue : (unsigned)opcode;
 }
 
+/// Calculate the matrix element that a row opcode gives a column in its lane,
+/// where CX = GetColumnValue(column) and RX = GetRowValue(row)
+SIAMESE_FORCE_INLINE uint8_t GetOpcodeValue(unsigned opcode, uint8_t CX, uint8_t RX)
+{
+    const uint8_t CX2 = gf256_sqr(CX);
+    unsigned value = 0;
+
+    if (opcode & 1)
+        value ^= 1;
+    if (opcode & 2)
+        value ^= CX;
+    if (opcode & 4)
+        value ^= CX2;
+    if (opcode & 8)
+        value ^= RX;
+    if (opcode & 16)
+        value ^= gf256_mul(CX, RX);
+    if (opcode & 32)
+        value ^= gf256_mul(CX2, RX);
+
+    return (uint8_t)value;
+}
+
 
 //------------------------------------------------------------------------------
 // MDS Erasure Codes using Cauchy Matrix
@@ -254,6 +285,31 @@ struct GrowingAlignedDataBuffer
         return true;
     }
 
+    /// Growing like GrowZeroPadded(), but when the buffer has to move it gets
+    /// 50% more room than needed.  Running sums grow a little at a time as
+    /// longer packets arrive, so this keeps them from being copied each time
+    bool GrowZeroPaddedAmortized(pktalloc::Allocator* allocator, unsigned bytes)
+    {
+        SIAMESE_DEBUG_ASSERT(allocator && bytes > 0);
+        if (Data && bytes <= Bytes) {
+            return true;
+        }
+
+        if (!Data || bytes > allocator->GetCapacityBytes(Data))
+        {
+            Data = allocator->Reallocate(Data, bytes + bytes / 2, pktalloc::Realloc::CopyExisting);
+            if (!Data)
+            {
+                Bytes = 0;
+                return false;
+            }
+        }
+
+        memset(Data + Bytes, 0, bytes - Bytes);
+        Bytes = bytes;
+        return true;
+    }
+
     /// Growing *dropping* existing data in the buffer
     /// Newly grown buffer space will *not* be initialized to zeros
     bool Initialize(pktalloc::Allocator* allocator, unsigned bytes)
@@ -283,6 +339,84 @@ struct GrowingAlignedDataBuffer
 };
 
 
+//------------------------------------------------------------------------------
+// MulAddMultiGather
+
+/// Multiply-adds buffers into one destination.  Short buffers are added
+/// right away with gf256_muladd_mem().  Longer buffers of the same length are
+/// gathered and added in groups with gf256_muladd_multi_mem(), so the
+/// destination is only streamed once per group.
+/// Call Flush() before reading the destination.
+struct MulAddMultiGather
+{
+    /// Flush automatically after this many sources
+    static const unsigned kMaxSources = 16;
+
+    /// Sources shorter than this are added right away.  Below this the
+    /// per-call overhead of gf256_muladd_multi_mem() for small groups is more
+    /// than the cost of streaming the destination once per source
+    static const unsigned kMinGatherBytes = 512;
+
+    /// Destination buffer
+    uint8_t* Dest = nullptr;
+    unsigned DestBytes = 0;
+
+    /// Gathered sources, which all have the same length
+    uint8_t Coefficients[kMaxSources];
+    const void* Sources[kMaxSources];
+    int SourceBytes[kMaxSources];
+    unsigned Count = 0;
+
+
+    /// Start gathering for a new destination
+    SIAMESE_FORCE_INLINE void Reset(uint8_t* dest, unsigned destBytes)
+    {
+        SIAMESE_DEBUG_ASSERT(Count == 0);
+        Dest      = dest;
+        DestBytes = destBytes;
+        Count     = 0;
+    }
+
+    /// Gather dest[0..bytes) += y * data[0..bytes)
+    SIAMESE_FORCE_INLINE void Add(uint8_t y, const uint8_t* data, unsigned bytes)
+    {
+        SIAMESE_DEBUG_ASSERT(Dest && bytes <= DestBytes);
+        if (bytes < kMinGatherBytes)
+        {
+            if (bytes > 0) {
+                gf256_muladd_mem(Dest, y, data, (int)bytes);
+            }
+            return;
+        }
+
+        // Splitting the group where a source ends is slow, so only
+        // sources of the same length are added together
+        if (Count > 0 && SourceBytes[0] != (int)bytes) {
+            Flush();
+        }
+
+        Coefficients[Count] = y;
+        Sources[Count]      = data;
+        SourceBytes[Count]  = (int)bytes;
+        if (++Count >= kMaxSources) {
+            Flush();
+        }
+    }
+
+    /// Multiply-add all gathered sources into the destination
+    SIAMESE_FORCE_INLINE void Flush()
+    {
+        if (Count == 1) {
+            gf256_muladd_mem(Dest, Coefficients[0], Sources[0], SourceBytes[0]);
+        }
+        else if (Count > 1) {
+            gf256_muladd_multi_mem(Dest, Coefficients, Sources, SourceBytes, (int)Count);
+        }
+        Count = 0;
+    }
+};
+
+
 //------------------------------------------------------------------------------
 // GrowingAlignedByteMatrix
 
@@ -335,6 +469,52 @@ struct GrowingAlignedByteMatrix
 };
 
 
+//------------------------------------------------------------------------------
+// SumCheckpoint
+
+/**
+    Running sum checkpoints
+
+    Restarting the running sums from a new start point would mean accumulating
+    thousands of originals again for large windows.  Instead the encoder and
+    decoder windows keep a snapshot of every lane sum at regular intervals.
+
+    Each snapshot is the sum of all the lane elements from a fixed origin up
+    to the checkpoint, so the difference between two snapshots is the sum of
+    the elements between them.  A sum that starts elsewhere keeps a base,
+    which is the snapshot value at its own start point.  Saving a checkpoint
+    stores Sum + Base, and a restarted sum skips ahead by loading
+    Snapshot + Base.
+*/
+
+/// State of a running sum checkpoint base
+enum class SumCheckpointBase
+{
+    Unknown,    ///< Not calculated yet
+    Valid,      ///< Buffer is ready to use
+    Unavailable ///< Sum does not start inside the window so no checkpoints
+};
+
+static_assert(kColumnLaneCount * kColumnSumCount <= 32, "ValidMask is too small");
+
+struct SumCheckpoint
+{
+    /// Snapshot of each lane sum as it passed the checkpoint element
+    GrowingAlignedDataBuffer Sums[kColumnLaneCount][kColumnSumCount];
+
+    /// Bit (laneIndex * kColumnSumCount + sumIndex) is set for valid snapshots
+    uint32_t ValidMask = 0;
+};
+
+/// Set dest = a + b, where a and b may have different lengths or be empty.
+/// Returns false on OOM
+bool AddSumSnapshot(
+    pktalloc::Allocator* allocator,
+    GrowingAlignedDataBuffer& dest,
+    const GrowingAlignedDataBuffer& a,
+    const GrowingAlignedDataBuffer& b);
+
+
 //------------------------------------------------------------------------------
 // OriginalPacket
 
@@ -350,10 +530,131 @@ struct OriginalPacket
     /// Keep track of the number of bytes for header on the packet data
     unsigned HeaderBytes = 0;
 
+    /// If not nullptr, Buffer.Data references application memory that is
+    /// handed back through this callback instead of being freed
+    SiameseReleaseCallback ExternalRelease = nullptr;
+    void* ExternalContext = nullptr;
+
 
     /// Write data to buffer with length prefix and initialize other members
     /// Returns the number of bytes overhead, or 0 on out-of-memory error
     unsigned Initialize(pktalloc::Allocator* allocator, const SiameseOriginalPacket& packet);
+
+    /// Initialize from the concatenation of the given segments.
+    /// packet.DataBytes must be the total length and packet.Data is unused.
+    /// Returns the number of bytes overhead, or 0 on out-of-memory error
+    unsigned InitializeSegments(
+        pktalloc::Allocator* allocator,
+        const SiameseOriginalPacket& packet,
+        const SiameseSegment* segments,
+        unsigned segmentCount);
+
+    /// Reference application data in place, writing the length prefix into
+    /// the kMaxPacketLengthFieldBytes of headroom in front of packet.Data.
+    /// Returns the number of bytes overhead
+    unsigned InitializeZeroCopy(
+        pktalloc::Allocator* allocator,
+        const SiameseOriginalPacket& packet,
+        SiameseReleaseCallback release,
+        void* context);
+
+    /// Returns true if Buffer.Data is application memory
+    SIAMESE_FORCE_INLINE bool IsExternal() const
+    {
+        return ExternalRelease != nullptr;
+    }
+
+    /// Hand application memory back, leaving the buffer empty
+    void ReleaseExternal();
+};
+
+
+//------------------------------------------------------------------------------
+// SubwindowRing
+
+/**
+    Ring of subwindow pointers used by the encoder and decoder windows.
+
+    Subwindow i of the window lives at Ring[(HeadIndex + i) & RingMask].
+    Removing subwindows from the front advances HeadIndex and copies only the
+    removed pointers to the back, where they are recycled as the window grows
+    again.  Nothing is shifted and no subwindow is constructed twice.
+
+    Subwindows are allocated from the codec allocator and are released when
+    it is destroyed.
+*/
+template<class SubwindowT>
+struct SubwindowRing
+{
+    /// Ring storage.  The allocated size is a power of two
+    pktalloc::LightVector<SubwindowT*> Ring;
+    unsigned RingMask = 0;
+
+    /// Ring index of the first subwindow
+    unsigned HeadIndex = 0;
+
+    /// Number of subwindows in the ring
+    unsigned Size = 0;
+
+
+    /// Number of subwindows in the ring
+    SIAMESE_FORCE_INLINE unsigned GetSize() const
+    {
+        return Size;
+    }
+
+    /// Subwindow by position from the front of the window
+    SIAMESE_FORCE_INLINE SubwindowT* GetRef(unsigned index) const
+    {
+        SIAMESE_DEBUG_ASSERT(index < Size);
+        return Ring.GetRef((HeadIndex + index) & RingMask);
+    }
+
+    /// Replace the subwindow at the given position
+    SIAMESE_FORCE_INLINE void SetRef(unsigned index, SubwindowT* subwindow)
+    {
+        SIAMESE_DEBUG_ASSERT(index < Size);
+        Ring.GetRef((HeadIndex + index) & RingMask) = subwindow;
+    }
+
+    /// Add a subwindow to the back.  Returns false on OOM
+    bool Append(SubwindowT* subwindow)
+    {
+        const unsigned oldSize = Ring.GetSize();
+
+        // If the ring is full, double it:
+        if (Size >= oldSize)
+        {
+            const unsigned newSize = (oldSize > 0) ? oldSize * 2 : 8;
+            if (!Ring.SetSize_Copy(newSize)) {
+                return false;
+            }
+
+            // Unwrap the part before the head so the ring stays in order
+            if (HeadIndex > 0) {
+                memcpy(Ring.GetPtr(oldSize), Ring.GetPtr(0), HeadIndex * sizeof(SubwindowT*));
+            }
+            RingMask = newSize - 1;
+        }
+
+        Ring.GetRef((HeadIndex + Size) & RingMask) = subwindow;
+        ++Size;
+        return true;
+    }
+
+    /// Move the given number of subwindows from the front to the back
+    void RotateFront(unsigned count)
+    {
+        SIAMESE_DEBUG_ASSERT(count <= Size);
+
+        // Copy removed pointers to the back in order.  When the back wraps
+        // onto a front slot, that slot has already been copied
+        for (unsigned i = 0; i < count; ++i) {
+            Ring.GetRef((HeadIndex + Size + i) & RingMask) = Ring.GetRef((HeadIndex + i) & RingMask);
+        }
+
+        HeadIndex = (HeadIndex + count) & RingMask;
+    }
 };
 
 
@@ -29,6 +29,9 @@
 
 #include "SiameseDecoder.h"
 #include "SiameseSerializers.h"
+#include "SiameseThreadPool.h"
+
+#include <algorithm> // std::rotate
 
 namespace siamese {
 
@@ -53,7 +56,8 @@ DecoderStats::DecoderStats()
 //------------------------------------------------------------------------------
 // Decoder
 
-Decoder::Decoder()
+Decoder::Decoder(pktalloc::WindowPool* pool)
+    : TheAllocator(pool)
 {
     RecoveryPackets.TheAllocator  = &TheAllocator;
     RecoveryPackets.CheckedRegion = &CheckedRegion;
@@ -65,9 +69,49 @@ Decoder::Decoder()
     RecoveryMatrix.TheAllocator   = &TheAllocator;
     RecoveryMatrix.Window         = &Window;
     RecoveryMatrix.CheckedRegion  = &CheckedRegion;
+    RecoveryMatrix.RecoveryPackets = &RecoveryPackets;
     CheckedRegion.RecoveryMatrix  = &RecoveryMatrix;
 }
 
+Decoder::~Decoder()
+{
+    // The worker threads must not outlive the decoder
+    StopThreads();
+}
+
+SiameseResult Decoder::StartThreads(unsigned threadCount)
+{
+    if (Window.EmergencyDisabled) {
+        return Siamese_Disabled;
+    }
+    if (Workers) {
+        return Siamese_InvalidInput;
+    }
+
+    ThreadPool* workers = new (std::nothrow) ThreadPool;
+    if (!workers) {
+        return Siamese_Disabled;
+    }
+    if (!workers->Start(threadCount))
+    {
+        delete workers;
+        return Siamese_Disabled;
+    }
+
+    Workers = workers;
+    return Siamese_Success;
+}
+
+void Decoder::StopThreads()
+{
+    if (Workers)
+    {
+        Workers->Stop();
+        delete Workers;
+        Workers = nullptr;
+    }
+}
+
 SiameseResult Decoder::Get(SiameseOriginalPacket& packetOut)
 {
     // Note: Keep this in sync with Encoder::Get
@@ -179,10 +223,16 @@ SiameseResult Decoder::GenerateAcknowledgement(
         *pDebugMsg << "Building ack from nextExpectedColumn=" << nextColumnExpected << " : NACKs = {";
     }
 
+    // Serialize the loss ranges that the window keeps up to date
+    const DecoderLossRanges& lossRanges = Window.LossRanges;
+    const unsigned rangeCount = lossRanges.GetCount();
+    unsigned rangeIndex = 0;
+
     // While there is room for another maximum-length loss range:
     while (byteLimit >= kMaxLossRangeFieldBytes)
     {
-        const unsigned rangeStart = Window.FindNextLostElement(rangeOffset);
+        const unsigned rangeStart = (rangeIndex < rangeCount) ? lossRanges.GetStart(rangeIndex) : windowCount;
+        SIAMESE_DEBUG_ASSERT(rangeStart == Window.FindNextLostElement(rangeOffset));
         if (rangeStart >= windowCount)
         {
             SIAMESE_DEBUG_ASSERT(rangeStart == windowCount);
@@ -204,7 +254,9 @@ SiameseResult Decoder::GenerateAcknowledgement(
         }
         SIAMESE_DEBUG_ASSERT(rangeStart >= rangeOffset);
 
-        unsigned rangeEnd = Window.FindNextGotElement(rangeStart + 1);
+        const unsigned rangeEnd = lossRanges.GetEnd(rangeIndex);
+        ++rangeIndex;
+        SIAMESE_DEBUG_ASSERT(rangeEnd == Window.FindNextGotElement(rangeStart + 1));
         SIAMESE_DEBUG_ASSERT(rangeEnd > rangeStart);
         SIAMESE_DEBUG_ASSERT(rangeEnd <= windowCount);
         unsigned lossCountM1 = rangeEnd - rangeStart - 1; // Loss count minus 1
@@ -254,6 +306,21 @@ SiameseResult Decoder::GenerateAcknowledgement(
     return Siamese_Success;
 }
 
+SiameseResult Decoder::AddOriginal(
+    const SiameseOriginalPacket& packet,
+    const SiameseSegment* segments,
+    unsigned segmentCount)
+{
+    const SiameseResult result = Window.AddOriginal(packet, segments, segmentCount);
+
+    // Remove it from any recovery packets that were eliminated without it
+    if (result == Siamese_Success) {
+        EliminateLateOriginal(Window.ColumnToElement(packet.PacketNum));
+    }
+
+    return result;
+}
+
 SiameseResult Decoder::AddRecovery(const SiameseRecoveryPacket& packet)
 {
     if (Window.EmergencyDisabled) {
@@ -374,7 +441,9 @@ SiameseResult Decoder::AddRecovery(const SiameseRecoveryPacket& packet)
 #endif
         {
             // If there is no running sum or it does not match the new one:
-            if (Window.SumColumnCount == 0 || Window.SumColumnStart != metadata.ColumnStart)
+            if (Window.SumColumnCount == 0 ||
+                Window.SumColumnStart != metadata.ColumnStart ||
+                Window.SumColumnCount > metadata.SumCount)
             {
                 // Then we need to have all the data in the sum at hand or it is useless.
                 const unsigned elementSumStart = Window.ColumnToElement(metadata.ColumnStart);
@@ -440,7 +509,14 @@ SiameseResult Decoder::AddRecovery(const SiameseRecoveryPacket& packet)
     recovery->ElementEnd   = elementEnd;
 
     // Insert it into the sorted packet list
-    RecoveryPackets.Insert(recovery, outOfOrder);
+    if (!RecoveryPackets.Insert(recovery, outOfOrder))
+    {
+        recovery->Buffer.Free(&TheAllocator);
+        TheAllocator.Destruct(recovery);
+        Window.EmergencyDisabled = true;
+        Logger.Error("AddRecovery.Insert OOM");
+        return Siamese_Disabled;
+    }
 
     // Remove elements from the front if possible
     if (elementStart >= kDecoderRemoveThreshold) {
@@ -467,6 +543,12 @@ bool Decoder::AddSingleRecovery(const SiameseRecoveryPacket& packet, const Recov
         return true;
     }
 
+    windowOriginal = Window.GetWritableWindowElement(element);
+    if (!windowOriginal) {
+        SIAMESE_DEBUG_BREAK(); // OOM
+        return false;
+    }
+
     // Check: Deserialize length from the front
     SIAMESE_DEBUG_ASSERT(packet.DataBytes > (unsigned)footerSize);
     const unsigned lengthPlusDataBytes = packet.DataBytes - footerSize;
@@ -511,6 +593,8 @@ bool Decoder::AddSingleRecovery(const SiameseRecoveryPacket& packet, const Recov
         return false;
     }
 
+    EliminateLateOriginal(element);
+
     // If the added element is somewhere inside the previously checked region:
     if (element >= CheckedRegion.ElementStart &&
         element < CheckedRegion.NextCheckStart)
@@ -545,17 +629,18 @@ bool Decoder::CheckRecoveryPossible()
     }
 
     RecoveryPacket* recovery;
-    unsigned nextCheckStart, recoveryCount, lostCount;
+    unsigned recoveryIndex, nextCheckStart, recoveryCount, lostCount;
 
     // If we just started checking again:
-    if (!CheckedRegion.LastRecovery)
+    if (CheckedRegion.RecoveryCount == 0)
     {
-        recovery = RecoveryPackets.Head;
+        recovery = RecoveryPackets.Head();
         if (!recovery) {
             return false; // No recovery data
         }
 
-        CheckedRegion.FirstRecovery = recovery;
+        recoveryIndex = RecoveryPackets.HeadIndex;
+        CheckedRegion.FirstRecovery = recoveryIndex;
         CheckedRegion.ElementStart  = recovery->ElementStart;
 #ifdef SIAMESE_DEBUG
         const unsigned lostPacketsBeforeLDPC = Window.RangeLostPackets(0, recovery->ElementStart);
@@ -582,16 +667,16 @@ bool Decoder::CheckRecoveryPossible()
             return true; // It is already possible
         }
 
-        recovery       = CheckedRegion.LastRecovery;
+        recoveryIndex  = CheckedRegion.LastRecovery;
         nextCheckStart = CheckedRegion.NextCheckStart;
     }
     SIAMESE_DEBUG_ASSERT(lostCount > 0);
 
     // While we do not have enough recovery data:
     while ((recoveryCount < lostCount || CheckedRegion.SolveFailed) &&
-           (recovery->Next != nullptr))
+           (recoveryIndex + 1 != RecoveryPackets.EndIndex()))
     {
-        recovery = recovery->Next;
+        recovery = RecoveryPackets.GetPacket(++recoveryIndex);
         ++recoveryCount;
 
         // Accumulate losses within the range of this recovery packet, skipping
@@ -612,7 +697,7 @@ bool Decoder::CheckRecoveryPossible()
     }
 
     // Remember state for the next time around
-    CheckedRegion.LastRecovery   = recovery;
+    CheckedRegion.LastRecovery   = recoveryIndex;
     CheckedRegion.RecoveryCount  = recoveryCount;
     CheckedRegion.LostCount      = lostCount;
     CheckedRegion.NextCheckStart = nextCheckStart;
@@ -668,12 +753,12 @@ SiameseResult Decoder::Decode(SiameseOriginalPacket** packetsPtrOut, unsigned* c
         return Siamese_NeedMoreData;
     }
 
-    RecoveryPacket* recovery = CheckedRegion.LastRecovery;
-    unsigned nextCheckStart  = CheckedRegion.NextCheckStart;
-    unsigned recoveryCount   = CheckedRegion.RecoveryCount;
-    unsigned lostCount       = CheckedRegion.LostCount;
+    unsigned recoveryIndex  = CheckedRegion.LastRecovery;
+    unsigned nextCheckStart = CheckedRegion.NextCheckStart;
+    unsigned recoveryCount  = CheckedRegion.RecoveryCount;
+    unsigned lostCount      = CheckedRegion.LostCount;
 
-    SIAMESE_DEBUG_ASSERT(recovery != nullptr && nextCheckStart > CheckedRegion.ElementStart);
+    SIAMESE_DEBUG_ASSERT(recoveryCount > 0 && nextCheckStart > CheckedRegion.ElementStart);
     SIAMESE_DEBUG_ASSERT(lostCount > 0 && lostCount <= recoveryCount);
 
     for (;;)
@@ -698,10 +783,10 @@ SiameseResult Decoder::Decode(SiameseOriginalPacket** packetsPtrOut, unsigned* c
             }
         }
 
-        if (recovery->Next == nullptr) {
+        if (recoveryIndex + 1 == RecoveryPackets.EndIndex()) {
             break;
         }
-        recovery = recovery->Next;
+        RecoveryPacket* recovery = RecoveryPackets.GetPacket(++recoveryIndex);
         ++recoveryCount;
 
         // Accumulate losses within the range of this recovery packet, skipping
@@ -719,17 +804,96 @@ SiameseResult Decoder::Decode(SiameseOriginalPacket** packetsPtrOut, unsigned* c
     }
 
     // Remember state for the next time around
-    CheckedRegion.LastRecovery   = recovery;
+    CheckedRegion.LastRecovery   = recoveryIndex;
     CheckedRegion.NextCheckStart = nextCheckStart;
     CheckedRegion.RecoveryCount  = recoveryCount;
     CheckedRegion.LostCount      = lostCount;
     return Siamese_NeedMoreData;
 }
 
+/// Calculate the matrix element that a recovery packet gives an element in
+/// its range, matching RecoveryMatrixState::GenerateMatrix()
+static uint8_t GetRecoveryValue(
+    const RecoveryPacket* recovery,
+    unsigned element,
+    unsigned column)
+{
+    if (element >= recovery->ElementEnd) {
+        return 0;
+    }
+
+    const RecoveryMetadata metadata = recovery->Metadata;
+    const unsigned elementStart     = recovery->ElementStart;
+    uint8_t value = 0;
+
+#ifdef SIAMESE_ENABLE_CAUCHY
+    // If it is a Cauchy or parity row:
+    if (metadata.SumCount <= SIAMESE_CAUCHY_THRESHOLD)
+    {
+        if (element >= elementStart) {
+            value = (metadata.Row == 0) ? 1 : CauchyElement(metadata.Row - 1, column % kCauchyMaxColumns);
+        }
+    }
+    else
+#endif // SIAMESE_ENABLE_CAUCHY
+    {
+        const uint8_t RX = GetRowValue(metadata.Row);
+
+        // If the element is in the running sums for this row:
+        if (SubtractColumns(column, metadata.ColumnStart) < metadata.SumCount)
+        {
+            const unsigned opcode = GetRowOpcode(column % kColumnLaneCount, metadata.Row);
+            value = GetOpcodeValue(opcode, GetColumnValue(column), RX);
+        }
+
+        // If the element may be one of the light columns for this row:
+        if (element >= elementStart)
+        {
+            PCGRandom prng;
+            prng.Seed(metadata.Row, metadata.LDPCCount);
+
+            const unsigned pairCount = (metadata.LDPCCount + kPairAddRate - 1) / kPairAddRate;
+            for (unsigned i = 0; i < pairCount; ++i)
+            {
+                const unsigned element1 = elementStart + (prng.Next() % metadata.LDPCCount);
+                if (element1 == element) {
+                    value ^= 1;
+                }
+                const unsigned elementRX = elementStart + (prng.Next() % metadata.LDPCCount);
+                if (elementRX == element) {
+                    value ^= RX;
+                }
+            }
+        }
+    }
+
+    return value;
+}
+
 SiameseResult Decoder::DecodeCheckedRegion()
 {
     Logger.Debug("Attempting decode...");
 
+    // Most repairs are for a single lost packet, which needs no matrix
+    if (CheckedRegion.LostCount == 1)
+    {
+        const SiameseResult singleResult = DecodeSingleLoss();
+        if (singleResult != Siamese_NeedMoreData) {
+            CheckedRegion.Reset();
+        }
+        return singleResult;
+    }
+
+#ifdef SIAMESE_ENABLE_CAUCHY
+    // Regions covered by Cauchy rows have a closed-form inverse
+    if (SelectCauchyRows())
+    {
+        const SiameseResult cauchyResult = DecodeCauchyRows();
+        CheckedRegion.Reset();
+        return cauchyResult;
+    }
+#endif // SIAMESE_ENABLE_CAUCHY
+
 #ifdef SIAMESE_DECODER_DUMP_SOLVER_PERF
     bool skipLog = CheckedRegion.LostCount <= 1;
     if (!skipLog)
@@ -809,12 +973,175 @@ SiameseResult Decoder::DecodeCheckedRegion()
     return solveResult;
 }
 
+SiameseResult Decoder::DecodeSingleLoss()
+{
+    SIAMESE_DEBUG_ASSERT(CheckedRegion.LostCount == 1);
+
+    /*
+        With only one packet lost in the checked region, each recovery row is
+        a multiple of that packet once the received data is eliminated from
+        it.  So one row is enough: Its matrix element for the lost column is
+        calculated directly, the received data is eliminated from it in one
+        pass, and the result is divided by that element.  There is no matrix
+        to generate, no Gaussian elimination, and no pivots to track.
+    */
+
+    const unsigned element = Window.FindNextLostElement(CheckedRegion.ElementStart);
+    if (element >= CheckedRegion.NextCheckStart)
+    {
+        Window.EmergencyDisabled = true;
+        Logger.Error("DecodeSingleLoss.FindNextLostElement failed");
+        SIAMESE_DEBUG_BREAK(); // Should never happen
+        return Siamese_Disabled;
+    }
+    const unsigned column = Window.ElementToColumn(element);
+
+    // Pick the cheapest row that covers the lost packet.  Rows eliminated by
+    // IdleWork() are ready to use, and Cauchy/parity rows do not need the
+    // running sums to be moved
+    RecoveryPacket* solveRecovery = nullptr;
+    uint8_t y = 0;
+    unsigned bestCost = 3;
+
+    const unsigned recoveryEnd = CheckedRegion.LastRecovery + 1;
+    for (unsigned recoveryIndex = CheckedRegion.FirstRecovery; recoveryIndex != recoveryEnd; ++recoveryIndex)
+    {
+        RecoveryPacket* recovery = RecoveryPackets.GetPacket(recoveryIndex);
+        const uint8_t value = GetRecoveryValue(recovery, element, column);
+        if (value == 0) {
+            continue;
+        }
+
+        unsigned cost = 2;
+        if (recovery->Eliminated) {
+            cost = 0;
+        }
+#ifdef SIAMESE_ENABLE_CAUCHY
+        else if (recovery->Metadata.SumCount <= SIAMESE_CAUCHY_THRESHOLD) {
+            cost = 1;
+        }
+#endif // SIAMESE_ENABLE_CAUCHY
+        else if (Window.SumsUnavailable(recovery->Metadata)) {
+            continue;
+        }
+
+        if (cost < bestCost)
+        {
+            solveRecovery = recovery;
+            y = value;
+            bestCost = cost;
+            if (cost == 0) {
+                break;
+            }
+        }
+    }
+
+    // If no row has a non-zero element for the lost column:
+    if (!solveRecovery)
+    {
+        CheckedRegion.SolveFailed = true;
+        Stats.Counts[SiameseDecoderStats_SolveFailCount]++;
+        return Siamese_NeedMoreData;
+    }
+
+    if (!solveRecovery->Eliminated)
+    {
+#ifdef SIAMESE_ENABLE_CAUCHY
+        // If it is a Cauchy or parity row:
+        if (solveRecovery->Metadata.SumCount <= SIAMESE_CAUCHY_THRESHOLD) {
+            EliminateCauchyRow(solveRecovery);
+        }
+        else
+#endif // SIAMESE_ENABLE_CAUCHY
+        if (!EliminateSumRow(solveRecovery, true))
+        {
+            Window.EmergencyDisabled = true;
+            Logger.Error("DecodeSingleLoss.EliminateSumRow failed");
+            return Siamese_Disabled;
+        }
+    }
+
+    GrowingAlignedDataBuffer& recoveryBuffer = solveRecovery->Buffer;
+    uint8_t* buffer = recoveryBuffer.Data;
+    unsigned bufferBytes = recoveryBuffer.Bytes;
+    SIAMESE_DEBUG_ASSERT(buffer && bufferBytes > 0);
+
+    // Note: Parity rows have y = 1 so the data is revealed already
+    const uint8_t inv_y = gf256_inv(y);
+
+    // Reveal the first chunk of bytes of data
+    unsigned lengthCheckBytes = pktalloc::kAlignmentBytes;
+    if (lengthCheckBytes > bufferBytes) {
+        lengthCheckBytes = bufferBytes;
+    }
+    if (y != 1) {
+        gf256_mul_mem_inplace(buffer, inv_y, lengthCheckBytes);
+    }
+
+    // Check the embedded length field
+    unsigned length;
+    const int headerBytes = DeserializeHeader_PacketLength(buffer, lengthCheckBytes, length);
+    if (headerBytes < 0 || length == 0 || headerBytes + length > bufferBytes)
+    {
+        // See BackSubstitution() for common causes
+        Window.EmergencyDisabled = true;
+        Logger.Error("DecodeSingleLoss corrupted recovered data len");
+        SIAMESE_DEBUG_BREAK(); // Should never happen
+        return Siamese_Disabled;
+    }
+
+    // Reveal the rest of the original packet data
+    bufferBytes = headerBytes + length;
+    if (y != 1 && bufferBytes > lengthCheckBytes)
+    {
+        gf256_mul_mem_inplace(
+            buffer + lengthCheckBytes,
+            inv_y,
+            bufferBytes - lengthCheckBytes);
+    }
+
+    // Swap original and recovery buffers
+    OriginalPacket* original = Window.GetWritableWindowElement(element);
+    if (!original)
+    {
+        Window.EmergencyDisabled = true;
+        Logger.Error("DecodeSingleLoss.GetWritableWindowElement OOM");
+        return Siamese_Disabled;
+    }
+    SIAMESE_DEBUG_ASSERT(original->Buffer.Bytes == 0);
+    uint8_t* oldOriginalData = original->Buffer.Data;
+    original->Buffer.Data    = buffer;
+    original->Buffer.Bytes   = bufferBytes;
+    original->Column         = column;
+    original->HeaderBytes    = (unsigned)headerBytes;
+    recoveryBuffer.Data      = oldOriginalData;
+    recoveryBuffer.Bytes     = 0;
+
+    // Write recovered packet data
+    Window.RecoveredPackets.SetSize_NoCopy(1);
+    SiameseOriginalPacket* recoveredPtr = Window.RecoveredPackets.GetPtr(0);
+    recoveredPtr->Data      = buffer + headerBytes;
+    recoveredPtr->DataBytes = length;
+    recoveredPtr->PacketNum = column;
+
+    if (!Window.RecoveredColumns.Append(column))
+    {
+        Window.EmergencyDisabled = true;
+        SIAMESE_DEBUG_BREAK(); // OOM
+        return Siamese_Disabled;
+    }
+
+    Logger.Trace("Single loss decoded: Column=", column, " Row=", solveRecovery->Metadata.Row);
+
+    Stats.Counts[SiameseDecoderStats_SingleLossSolveCount]++;
+
+    return FinishSolution(Window.MarkGotColumn(column));
+}
+
 bool Decoder::EliminateOriginalData()
 {
     SIAMESE_DEBUG_ASSERT(CheckedRegion.LostCount == RecoveryMatrix.Columns.GetSize());
 
-    std::ostringstream* pDebugMsg = nullptr;
-
     // Note: This is done because the Siamese sums need to be accumulated from
     // left to right in the same order that the encoder generated them.
     // This step tends to be slow because there is a lot of data that was
@@ -823,6 +1150,21 @@ bool Decoder::EliminateOriginalData()
     const unsigned rows = CheckedRegion.RecoveryCount;
     SIAMESE_DEBUG_ASSERT(CheckedRegion.RecoveryCount == RecoveryMatrix.Rows.GetSize());
 
+    /*
+        With worker threads, only the running sums are accumulated here.
+        The sums for each row must be read before they move on for the next
+        row, but the rest of the row only reads original data.  So each row
+        is handed to the workers as soon as its running sums are added, and
+        the workers eliminate the Cauchy/parity rows and the light columns
+        while this thread moves the sums along for the next row.
+    */
+    const bool parallel = (Workers != nullptr) && (rows >= kEliminateParallelMinRows);
+    bool success = false;
+
+    if (parallel && !BeginEliminateTasks(rows)) {
+        return false;
+    }
+
     // Eliminate data in sorted row order regardless of pivot order:
     for (unsigned matrixRowIndex = 0; matrixRowIndex < rows; ++matrixRowIndex)
     {
@@ -830,236 +1172,427 @@ bool Decoder::EliminateOriginalData()
             continue;
         }
 
-        RecoveryPacket* recovery        = RecoveryMatrix.Rows.GetRef(matrixRowIndex).Recovery;
-        const RecoveryMetadata metadata = recovery->Metadata;
-        const unsigned elementStart     = recovery->ElementStart;
-        const unsigned elementEnd       = recovery->ElementEnd;
-        GrowingAlignedDataBuffer& recoveryBuffer = recovery->Buffer;
-        SIAMESE_DEBUG_ASSERT(recoveryBuffer.Data && recoveryBuffer.Bytes > 0);
+        RecoveryPacket* recovery = RecoveryMatrix.Rows.GetRef(matrixRowIndex).Recovery;
+        SIAMESE_DEBUG_ASSERT(recovery->Buffer.Data && recovery->Buffer.Bytes > 0);
+
+        // If IdleWork() already eliminated this row:
+        if (recovery->Eliminated) {
+            continue;
+        }
 
 #ifdef SIAMESE_ENABLE_CAUCHY
         // If it is a Cauchy or parity row:
-        if (metadata.SumCount <= SIAMESE_CAUCHY_THRESHOLD)
+        if (recovery->Metadata.SumCount <= SIAMESE_CAUCHY_THRESHOLD)
         {
-            // If this is a parity row:
-            if (metadata.Row == 0)
-            {
-                // Fill columns from left for new rows:
-                for (unsigned j = elementStart; j < elementEnd; ++j)
-                {
-                    OriginalPacket* original = Window.GetWindowElement(j);
-                    unsigned addBytes = original->Buffer.Bytes;
-                    if (addBytes > 0)
-                    {
-                        if (addBytes > recoveryBuffer.Bytes) {
-                            SIAMESE_DEBUG_BREAK(); // Should never happen
-                            addBytes = recoveryBuffer.Bytes;
-                        }
-                        gf256_add_mem(recoveryBuffer.Data, original->Buffer.Data, addBytes);
-                    }
-                }
+            if (parallel) {
+                PublishEliminateTask(recovery);
             }
-            else // This is a Cauchy row:
-            {
-                // Fill columns from left for new rows:
-                for (unsigned j = elementStart; j < elementEnd; ++j)
-                {
-                    OriginalPacket* original = Window.GetWindowElement(j);
-                    unsigned addBytes = original->Buffer.Bytes;
-                    if (addBytes > 0)
-                    {
-                        const uint8_t y = CauchyElement(metadata.Row - 1, original->Column % kCauchyMaxColumns);
-                        if (addBytes > recoveryBuffer.Bytes) {
-                            SIAMESE_DEBUG_BREAK(); // Should never happen
-                            addBytes = recoveryBuffer.Bytes;
-                        }
-                        gf256_muladd_mem(recoveryBuffer.Data, y, original->Buffer.Data, addBytes);
-                    }
-                }
+            else {
+                EliminateCauchyRow(recovery);
             }
-
             continue;
         }
 #endif // SIAMESE_ENABLE_CAUCHY
 
-        // Zero the product sum
-        const unsigned recoveryBytes = recoveryBuffer.Bytes;
-        if (!ProductSum.Initialize(&TheAllocator, recoveryBytes)) {
-            return false;
+        if (parallel)
+        {
+            // Finish the running sum part here and let a worker thread add
+            // the light columns with its own product sum
+            if (!EliminateSumRow(recovery, false)) {
+                goto ExitEliminate;
+            }
+
+            PublishEliminateTask(recovery);
+            continue;
         }
-        memset(ProductSum.Data, 0, recoveryBytes);
 
-        Logger.Debug("Starting sums for row=", recovery->Metadata.Row, " start=", recovery->Metadata.ColumnStart, " count=", recovery->Metadata.SumCount);
+        if (!EliminateSumRow(recovery, true)) {
+            goto ExitEliminate;
+        }
+    }
 
-        // Convert column start to window element.
-        // If some of the summed elements have fallen out of the window,
-        // then start it at the first element in the window (0).
-        unsigned sumElementStart = Window.ColumnToElement(recovery->Metadata.ColumnStart);
+    // Return false if GetSum() ran out of memory
+    success = !Window.EmergencyDisabled;
 
-        /*
-            If the recovery packet indicates a different siamese sum, then we
-            will need to clear the running sums and recreate them from scratch.
-
-            Sums need to be restarted if the start point changed, which should
-            be a jump of over 128 packets that were acknowledged.  They would
-            also need to be restarted if the number of summed columns has
-            reduced instead of increased.  In both cases, data needs to be
-            removed from the running sum.  Instead of being clever about how to
-            remove that data, we just start over from scratch to avoid a huge
-            amount of extra complexity.
-
-            TBD: Collect real data on how much it would help to checkpoint on
-            the decoder side.  I suspect it would not help much because multi-
-            packet losses probably do not often straddle these checkpoints.
-            For example if start point changes 1/128 packets, then the benefit
-            of checkpoints is only felt in about 1% of the multi-loss cases,
-            which are already much less common than single losses.
-
-            Due to the way we order recovery packets in the list, and therefore
-            how they get ordered as matrix rows for the matrix we are solving,
-            often times sums will only roll forward or skip ahead.
-        */
-        if (metadata.ColumnStart != Window.SumColumnStart ||
-            metadata.SumCount < Window.SumColumnCount)
-        {
-            // If we have to restart the sums but the data is not available:
-            if (Window.InvalidElement(sumElementStart)) {
-                // This should never happen.  The code that decides when to
-                // remove data from the window should have kept this data.
-                SIAMESE_DEBUG_BREAK();
-                return false;
-            }
+ExitEliminate:
+    // The workers must be done with the rows before they are used
+    if (parallel) {
+        Workers->WaitBatch();
+    }
+
+    return success;
+}
+
+bool Decoder::EliminateSumRow(RecoveryPacket* recovery, bool lightColumns)
+{
+    const RecoveryMetadata metadata = recovery->Metadata;
+    const unsigned elementEnd       = recovery->ElementEnd;
+    GrowingAlignedDataBuffer& recoveryBuffer = recovery->Buffer;
+
+    // Zero the product sum
+    const unsigned recoveryBytes = recoveryBuffer.Bytes;
+    if (!ProductSum.Initialize(&TheAllocator, recoveryBytes)) {
+        return false;
+    }
+    memset(ProductSum.Data, 0, recoveryBytes);
+
+    Logger.Debug("Starting sums for row=", recovery->Metadata.Row, " start=", recovery->Metadata.ColumnStart, " count=", recovery->Metadata.SumCount);
+
+    // Convert column start to window element.
+    // If some of the summed elements have fallen out of the window,
+    // then start it at the first element in the window (0).
+    unsigned sumElementStart = Window.ColumnToElement(recovery->Metadata.ColumnStart);
 
-            Window.ResetSums(sumElementStart);
-            Window.SumColumnStart = metadata.ColumnStart;
+    /*
+        If the recovery packet indicates a different siamese sum, then we
+        will need to clear the running sums and recreate them from scratch.
+
+        Sums need to be restarted if the start point changed, which should
+        be a jump of over 128 packets that were acknowledged.  They would
+        also need to be restarted if the number of summed columns has
+        reduced instead of increased.  In both cases, data needs to be
+        removed from the running sum.  Instead of being clever about how to
+        remove that data, we start over from the new start point.
+
+        Starting over does not mean accumulating everything again:
+        GetSum() will resume from the furthest running sum checkpoint that
+        does not pass the end of this recovery packet.
+        See the running sum checkpoint comments in SiameseDecoder.h.
+
+        Due to the way we order recovery packets in the list, and therefore
+        how they get ordered as matrix rows for the matrix we are solving,
+        often times sums will only roll forward or skip ahead.
+    */
+    if (metadata.ColumnStart != Window.SumColumnStart ||
+        metadata.SumCount < Window.SumColumnCount)
+    {
+        // If we have to restart the sums but the data is not available:
+        if (Window.InvalidElement(sumElementStart)) {
+            // This should never happen.  The code that decides when to
+            // remove data from the window should have kept this data.
+            SIAMESE_DEBUG_BREAK();
+            return false;
         }
-        else
-        {
-            if (Window.InvalidElement(sumElementStart)) {
-                sumElementStart = 0;
-            }
 
-            // Prepare any lane sums that have not accumulated data yet to
-            // receive data, since we are about to start accumulaing into
-            // some of these running sums.
-            if (!Window.StartSums(sumElementStart, recoveryBytes)) {
-                return false;
-            }
+        Window.ResetSums(sumElementStart);
+        Window.SumColumnStart = metadata.ColumnStart;
+    }
+    else
+    {
+        if (Window.InvalidElement(sumElementStart)) {
+            sumElementStart = 0;
         }
-        Window.SumColumnCount = metadata.SumCount;
 
-        // Eliminate dense recovery data outside of matrix:
-        for (unsigned laneIndex = 0; laneIndex < kColumnLaneCount; ++laneIndex)
-        {
-            const unsigned opcode = GetRowOpcode(laneIndex, metadata.Row);
+        // Prepare any lane sums that have not accumulated data yet to
+        // receive data, since we are about to start accumulaing into
+        // some of these running sums.
+        if (!Window.StartSums(sumElementStart, recoveryBytes)) {
+            return false;
+        }
+    }
+    Window.SumColumnCount = metadata.SumCount;
 
-            // For summations into the RecoveryPacket buffer:
-            unsigned mask = 1;
-            for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex)
+    // Eliminate dense recovery data outside of matrix:
+    for (unsigned laneIndex = 0; laneIndex < kColumnLaneCount; ++laneIndex)
+    {
+        const unsigned opcode = GetRowOpcode(laneIndex, metadata.Row);
+
+        // For summations into the RecoveryPacket buffer:
+        unsigned mask = 1;
+        for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex)
+        {
+            if (opcode & mask)
             {
-                if (opcode & mask)
+                const GrowingAlignedDataBuffer* sum = Window.GetSum(laneIndex, sumIndex, elementEnd);
+                SIAMESE_DEBUG_ASSERT(elementEnd + kColumnLaneCount >= Window.Lanes[laneIndex].Sums[sumIndex].ElementEnd);
+                unsigned addBytes = sum->Bytes;
+                if (addBytes > 0)
                 {
-                    const GrowingAlignedDataBuffer* sum = Window.GetSum(laneIndex, sumIndex, elementEnd);
-                    SIAMESE_DEBUG_ASSERT(elementEnd + kColumnLaneCount >= Window.Lanes[laneIndex].Sums[sumIndex].ElementEnd);
-                    unsigned addBytes = sum->Bytes;
-                    if (addBytes > 0)
-                    {
-                        if (addBytes > recoveryBytes) {
-                            addBytes = recoveryBytes;
-                        }
-                        gf256_add_mem(recoveryBuffer.Data, sum->Data, addBytes);
+                    if (addBytes > recoveryBytes) {
+                        addBytes = recoveryBytes;
                     }
+                    gf256_add_mem(recoveryBuffer.Data, sum->Data, addBytes);
                 }
-                mask <<= 1;
             }
+            mask <<= 1;
+        }
 
-            // For summations into the ProductWorkspace buffer:
-            for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex)
+        // For summations into the ProductWorkspace buffer:
+        for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex)
+        {
+            if (opcode & mask)
             {
-                if (opcode & mask)
+                const GrowingAlignedDataBuffer* sum = Window.GetSum(laneIndex, sumIndex, elementEnd);
+                SIAMESE_DEBUG_ASSERT(elementEnd + kColumnLaneCount >= Window.Lanes[laneIndex].Sums[sumIndex].ElementEnd);
+                unsigned addBytes = sum->Bytes;
+                if (addBytes > 0)
                 {
-                    const GrowingAlignedDataBuffer* sum = Window.GetSum(laneIndex, sumIndex, elementEnd);
-                    SIAMESE_DEBUG_ASSERT(elementEnd + kColumnLaneCount >= Window.Lanes[laneIndex].Sums[sumIndex].ElementEnd);
-                    unsigned addBytes = sum->Bytes;
-                    if (addBytes > 0)
-                    {
-                        if (addBytes > recoveryBytes)
-                            addBytes = recoveryBytes;
-                        gf256_add_mem(ProductSum.Data, sum->Data, addBytes);
-                    }
+                    if (addBytes > recoveryBytes)
+                        addBytes = recoveryBytes;
+                    gf256_add_mem(ProductSum.Data, sum->Data, addBytes);
                 }
-                mask <<= 1;
             }
+            mask <<= 1;
         }
+    }
 
-        // Eliminate light recovery data outside of matrix:
-        PCGRandom prng;
-        prng.Seed(metadata.Row, metadata.LDPCCount);
-        SIAMESE_DEBUG_ASSERT(metadata.SumCount >= metadata.LDPCCount);
+    // Eliminate light recovery data outside of matrix:
+    if (lightColumns) {
+        AddLightColumns(recovery, recoveryBuffer.Data, ProductSum.Data);
+    }
 
-        if (Logger.ShouldLog(logger::Level::Debug))
-        {
-            delete pDebugMsg;
-            pDebugMsg = new std::ostringstream();
-            *pDebugMsg << "(Eliminate originals) LDPC columns (*=missing): ";
-        }
+    const uint8_t RX = GetRowValue(metadata.Row);
+    SIAMESE_DEBUG_ASSERT(recoveryBuffer.Bytes == ProductSum.Bytes);
+    gf256_muladd_mem(recoveryBuffer.Data, RX, ProductSum.Data, recoveryBytes);
+
+    // Return false if GetSum() ran out of memory
+    return !Window.EmergencyDisabled;
+}
 
-        const unsigned pairCount = (metadata.LDPCCount + kPairAddRate - 1) / kPairAddRate;
-        for (unsigned i = 0; i < pairCount; ++i)
+void Decoder::EliminateCauchyRow(RecoveryPacket* recovery)
+{
+#ifdef SIAMESE_ENABLE_CAUCHY
+    const RecoveryMetadata metadata = recovery->Metadata;
+    const unsigned elementStart     = recovery->ElementStart;
+    const unsigned elementEnd       = recovery->ElementEnd;
+    GrowingAlignedDataBuffer& recoveryBuffer = recovery->Buffer;
+    SIAMESE_DEBUG_ASSERT(metadata.SumCount <= SIAMESE_CAUCHY_THRESHOLD);
+
+    // If this is a parity row:
+    if (metadata.Row == 0)
+    {
+        // Fill columns from left for new rows:
+        for (unsigned j = elementStart; j < elementEnd; ++j)
         {
-            const unsigned element1   = elementStart + (prng.Next() % metadata.LDPCCount);
-            OriginalPacket* original1 = Window.GetWindowElement(element1);
-            unsigned addBytes1 = original1->Buffer.Bytes;
-            if (addBytes1 > 0)
+            OriginalPacket* original = Window.GetWindowElement(j);
+            unsigned addBytes = original->Buffer.Bytes;
+            if (addBytes > 0)
             {
-                if (addBytes1 > recoveryBytes)
-                {
+                if (addBytes > recoveryBuffer.Bytes) {
                     SIAMESE_DEBUG_BREAK(); // Should never happen
-                    addBytes1 = recoveryBytes;
+                    addBytes = recoveryBuffer.Bytes;
                 }
-                gf256_add_mem(recoveryBuffer.Data, original1->Buffer.Data, addBytes1);
-
-                if (pDebugMsg)
-                    *pDebugMsg << element1 << " ";
-            }
-            else
-            {
-                if (pDebugMsg)
-                    *pDebugMsg << element1 << "* ";
+                gf256_add_mem(recoveryBuffer.Data, original->Buffer.Data, addBytes);
             }
+        }
+    }
+    else // This is a Cauchy row:
+    {
+        MulAddMultiGather gather;
+        gather.Reset(recoveryBuffer.Data, recoveryBuffer.Bytes);
 
-            const unsigned elementRX   = elementStart + (prng.Next() % metadata.LDPCCount);
-            OriginalPacket* originalRX = Window.GetWindowElement(elementRX);
-            unsigned addBytesRX = originalRX->Buffer.Bytes;
-            if (addBytesRX > 0)
+        // Fill columns from left for new rows:
+        for (unsigned j = elementStart; j < elementEnd; ++j)
+        {
+            OriginalPacket* original = Window.GetWindowElement(j);
+            unsigned addBytes = original->Buffer.Bytes;
+            if (addBytes > 0)
             {
-                if (addBytesRX > recoveryBytes)
-                {
+                const uint8_t y = CauchyElement(metadata.Row - 1, original->Column % kCauchyMaxColumns);
+                if (addBytes > recoveryBuffer.Bytes) {
                     SIAMESE_DEBUG_BREAK(); // Should never happen
-                    addBytesRX = recoveryBytes;
+                    addBytes = recoveryBuffer.Bytes;
                 }
-                gf256_add_mem(ProductSum.Data, originalRX->Buffer.Data, addBytesRX);
+                gather.Add(y, original->Buffer.Data, addBytes);
+            }
+        }
 
-                if (pDebugMsg)
-                    *pDebugMsg << elementRX << " ";
+        gather.Flush();
+    }
+#else // SIAMESE_ENABLE_CAUCHY
+    SIAMESE_DEBUG_BREAK(); // Should never be called
+    (void)recovery;
+#endif // SIAMESE_ENABLE_CAUCHY
+}
+
+void Decoder::EliminateLateOriginal(unsigned element)
+{
+    const OriginalPacket* original = Window.GetWindowElement(element);
+    const unsigned column          = original->Column;
+    SIAMESE_DEBUG_ASSERT(original->Buffer.Bytes > 0);
+
+    // Recovery packets are sorted by end element, so only the newest ones
+    // can cover this element.  Usually this stops at the first one
+    for (unsigned recoveryIndex = RecoveryPackets.EndIndex();
+         recoveryIndex != RecoveryPackets.HeadIndex;)
+    {
+        RecoveryPacket* recovery = RecoveryPackets.GetPacket(--recoveryIndex);
+        if (recovery->ElementEnd <= element) {
+            break;
+        }
+
+        // If the element is eliminated along with the rest of the row later:
+        if (!recovery->Eliminated) {
+            continue;
+        }
+
+        const uint8_t value = GetRecoveryValue(recovery, element, column);
+        if (value == 0) {
+            continue;
+        }
+
+        unsigned addBytes = original->Buffer.Bytes;
+        if (addBytes > recovery->Buffer.Bytes)
+        {
+            SIAMESE_DEBUG_BREAK(); // Should never happen
+            addBytes = recovery->Buffer.Bytes;
+        }
+        gf256_muladd_mem(recovery->Buffer.Data, value, original->Buffer.Data, addBytes);
+    }
+}
+
+void Decoder::AddLightColumns(
+    RecoveryPacket* recovery,
+    uint8_t* recoveryData,
+    uint8_t* productData)
+{
+    const RecoveryMetadata metadata = recovery->Metadata;
+    const unsigned elementStart     = recovery->ElementStart;
+    const unsigned recoveryBytes    = recovery->Buffer.Bytes;
+
+    std::ostringstream* pDebugMsg = nullptr;
+
+    PCGRandom prng;
+    prng.Seed(metadata.Row, metadata.LDPCCount);
+    SIAMESE_DEBUG_ASSERT(metadata.SumCount >= metadata.LDPCCount);
+
+    if (Logger.ShouldLog(logger::Level::Debug))
+    {
+        pDebugMsg = new std::ostringstream();
+        *pDebugMsg << "(Eliminate originals) LDPC columns (*=missing): ";
+    }
+
+    const unsigned pairCount = (metadata.LDPCCount + kPairAddRate - 1) / kPairAddRate;
+    for (unsigned i = 0; i < pairCount; ++i)
+    {
+        const unsigned element1   = elementStart + (prng.Next() % metadata.LDPCCount);
+        OriginalPacket* original1 = Window.GetWindowElement(element1);
+        unsigned addBytes1 = original1->Buffer.Bytes;
+        if (addBytes1 > 0)
+        {
+            if (addBytes1 > recoveryBytes)
+            {
+                SIAMESE_DEBUG_BREAK(); // Should never happen
+                addBytes1 = recoveryBytes;
             }
-            else
+            gf256_add_mem(recoveryData, original1->Buffer.Data, addBytes1);
+
+            if (pDebugMsg)
+                *pDebugMsg << element1 << " ";
+        }
+        else
+        {
+            if (pDebugMsg)
+                *pDebugMsg << element1 << "* ";
+        }
+
+        const unsigned elementRX   = elementStart + (prng.Next() % metadata.LDPCCount);
+        OriginalPacket* originalRX = Window.GetWindowElement(elementRX);
+        unsigned addBytesRX = originalRX->Buffer.Bytes;
+        if (addBytesRX > 0)
+        {
+            if (addBytesRX > recoveryBytes)
             {
-                if (pDebugMsg)
-                    *pDebugMsg << elementRX << "* ";
+                SIAMESE_DEBUG_BREAK(); // Should never happen
+                addBytesRX = recoveryBytes;
             }
+            gf256_add_mem(productData, originalRX->Buffer.Data, addBytesRX);
+
+            if (pDebugMsg)
+                *pDebugMsg << elementRX << " ";
+        }
+        else
+        {
+            if (pDebugMsg)
+                *pDebugMsg << elementRX << "* ";
         }
+    }
 
-        if (pDebugMsg)
-            Logger.Debug(pDebugMsg->str());
+    if (pDebugMsg)
+    {
+        Logger.Debug(pDebugMsg->str());
+        delete pDebugMsg;
+    }
+}
 
-        SIAMESE_DEBUG_ASSERT(recoveryBuffer.Bytes == ProductSum.Bytes);
-        const uint8_t RX = GetRowValue(metadata.Row);
-        gf256_muladd_mem(recoveryBuffer.Data, RX, ProductSum.Data, ProductSum.Bytes);
+bool Decoder::BeginEliminateTasks(unsigned rows)
+{
+    if (!EliminateTasks.SetSize_NoCopy(rows)) {
+        return false;
     }
+    EliminateTaskCount = 0;
 
-    // Return false if GetSum() ran out of memory
-    return !Window.EmergencyDisabled;
+    // Find the longest row that a worker may need a product sum for
+    unsigned maxBytes = 0;
+    for (unsigned matrixRowIndex = 0; matrixRowIndex < rows; ++matrixRowIndex)
+    {
+        if (!RecoveryMatrix.Rows.GetRef(matrixRowIndex).UsedForSolution) {
+            continue;
+        }
+        const unsigned bytes = RecoveryMatrix.Rows.GetRef(matrixRowIndex).Recovery->Buffer.Bytes;
+        if (maxBytes < bytes) {
+            maxBytes = bytes;
+        }
+    }
+
+    // Allocate the product sums here, because the allocator is not thread-safe
+    for (unsigned i = 0, count = Workers->GetWorkerCount(); i < count; ++i)
+    {
+        GrowingAlignedDataBuffer& productSum = WorkerProductSums[i];
+        if (maxBytes > 0 &&
+            productSum.Bytes < maxBytes &&
+            !productSum.Initialize(&TheAllocator, maxBytes))
+        {
+            return false;
+        }
+    }
+
+    Workers->BeginBatch(&Decoder::RunEliminateTask, this);
+    return true;
+}
+
+void Decoder::PublishEliminateTask(RecoveryPacket* recovery)
+{
+    SIAMESE_DEBUG_ASSERT(EliminateTaskCount < EliminateTasks.GetSize());
+    EliminateTasks.GetRef(EliminateTaskCount) = recovery;
+    Workers->Publish(++EliminateTaskCount);
+}
+
+void Decoder::RunEliminateTask(void* context, unsigned workerIndex, unsigned taskIndex)
+{
+    Decoder* decoder         = reinterpret_cast<Decoder*>(context);
+    RecoveryPacket* recovery = decoder->EliminateTasks.GetRef(taskIndex);
+
+#ifdef SIAMESE_ENABLE_CAUCHY
+    if (recovery->Metadata.SumCount <= SIAMESE_CAUCHY_THRESHOLD)
+    {
+        decoder->EliminateCauchyRow(recovery);
+        return;
+    }
+#endif // SIAMESE_ENABLE_CAUCHY
+
+    // Note: The running sums were already added by EliminateOriginalData()
+    GrowingAlignedDataBuffer& recoveryBuffer = recovery->Buffer;
+    GrowingAlignedDataBuffer& productSum     = decoder->WorkerProductSums[workerIndex];
+    const unsigned recoveryBytes = recoveryBuffer.Bytes;
+    SIAMESE_DEBUG_ASSERT(productSum.Bytes >= recoveryBytes);
+    memset(productSum.Data, 0, recoveryBytes);
+
+    decoder->AddLightColumns(recovery, recoveryBuffer.Data, productSum.Data);
+
+    const uint8_t RX = GetRowValue(recovery->Metadata.Row);
+    gf256_muladd_mem(recoveryBuffer.Data, RX, productSum.Data, recoveryBytes);
+}
+
+/// Choose the number of bytes in each stripe of the solution
+static unsigned GetSolveStripeBytes(unsigned rows)
+{
+    SIAMESE_DEBUG_ASSERT(rows > 0);
+    unsigned stripeBytes = kSolveWorkingSetBytes / rows;
+    if (stripeBytes < kSolveMinStripeBytes) {
+        stripeBytes = kSolveMinStripeBytes;
+    }
+    return stripeBytes - stripeBytes % pktalloc::kAlignmentBytes;
 }
 
 bool Decoder::MultiplyLowerTriangle()
@@ -1067,36 +1600,88 @@ bool Decoder::MultiplyLowerTriangle()
     // Note: This step tends to be slow because it is a dense triangular
     // matrix-vector product
 
+    // Row j only needs rows i < j, and those are final by the time we reach
+    // row j, so each destination row gathers all of its sources and is
+    // streamed through once instead of once per source.
+
     const unsigned columns = CheckedRegion.LostCount;
 
-    // Multiply lower triangle following solution order from left to right:
-    for (unsigned col_i = 0; col_i < columns - 1; ++col_i)
+    // Make room for the summations first, so the rows can then be updated a
+    // stripe at a time.  Rows are grown in solution order because each row
+    // must be as long as the longest row it references.
+    unsigned longestBytes = 0;
+    for (unsigned col_j = 0; col_j < columns; ++col_j)
     {
-        const unsigned matrixRowIndex_i = RecoveryMatrix.Pivots.GetRef(col_i);
-        const GrowingAlignedDataBuffer& recovery_i = RecoveryMatrix.Rows.GetRef(matrixRowIndex_i).Recovery->Buffer;
-        const uint8_t* srcData = recovery_i.Data;
-        const unsigned srcBytes = recovery_i.Bytes;
-        SIAMESE_DEBUG_ASSERT(srcData && srcBytes > 0);
+        const unsigned matrixRowIndex_j = RecoveryMatrix.Pivots.GetRef(col_j);
+        GrowingAlignedDataBuffer& recovery_j = RecoveryMatrix.Rows.GetRef(matrixRowIndex_j).Recovery->Buffer;
+        SIAMESE_DEBUG_ASSERT(recovery_j.Data && recovery_j.Bytes > 0);
 
-        for (unsigned col_j = col_i + 1; col_j < columns; ++col_j)
+        // Find the longest row referenced by this row
+        unsigned maxSrcBytes = 0;
+        for (unsigned col_i = 0; col_i < col_j; ++col_i)
         {
-            const unsigned matrixRowIndex_j = RecoveryMatrix.Pivots.GetRef(col_j);
-            const uint8_t y = RecoveryMatrix.Matrix.Get(matrixRowIndex_j, col_i);
-
             // If this row does not reference this column:
-            if (y == 0) {
+            if (RecoveryMatrix.Matrix.Get(matrixRowIndex_j, col_i) == 0) {
                 continue;
             }
 
+            const unsigned matrixRowIndex_i = RecoveryMatrix.Pivots.GetRef(col_i);
+            const unsigned srcBytes = RecoveryMatrix.Rows.GetRef(matrixRowIndex_i).Recovery->Buffer.Bytes;
+            if (maxSrcBytes < srcBytes) {
+                maxSrcBytes = srcBytes;
+            }
+        }
+
+        if (maxSrcBytes > 0 && !recovery_j.GrowZeroPadded(&TheAllocator, maxSrcBytes)) {
+            return false;
+        }
+
+        if (longestBytes < recovery_j.Bytes) {
+            longestBytes = recovery_j.Bytes;
+        }
+    }
+
+    // Do all of the row updates for one stripe before moving on to the next,
+    // so the stripe stays in cache while it is read back by later rows
+    const unsigned stripeBytes = GetSolveStripeBytes(columns);
+    for (unsigned stripeStart = 0; stripeStart < longestBytes; stripeStart += stripeBytes)
+    {
+        const unsigned stripeEnd = stripeStart + stripeBytes;
+
+        // Multiply lower triangle following solution order from left to right:
+        for (unsigned col_j = 1; col_j < columns; ++col_j)
+        {
+            const unsigned matrixRowIndex_j = RecoveryMatrix.Pivots.GetRef(col_j);
             GrowingAlignedDataBuffer& recovery_j = RecoveryMatrix.Rows.GetRef(matrixRowIndex_j).Recovery->Buffer;
-            SIAMESE_DEBUG_ASSERT(recovery_j.Data && recovery_j.Bytes > 0);
+            if (recovery_j.Bytes <= stripeStart) {
+                continue;
+            }
 
-            // Make room for the summation
-            if (!recovery_j.GrowZeroPadded(&TheAllocator, srcBytes)) {
-                return false;
+            const unsigned destEnd = (recovery_j.Bytes < stripeEnd) ? recovery_j.Bytes : stripeEnd;
+
+            MulAddMultiGather gather;
+            gather.Reset(recovery_j.Data + stripeStart, destEnd - stripeStart);
+
+            for (unsigned col_i = 0; col_i < col_j; ++col_i)
+            {
+                const uint8_t y = RecoveryMatrix.Matrix.Get(matrixRowIndex_j, col_i);
+                if (y == 0) {
+                    continue;
+                }
+
+                const unsigned matrixRowIndex_i = RecoveryMatrix.Pivots.GetRef(col_i);
+                const GrowingAlignedDataBuffer& recovery_i = RecoveryMatrix.Rows.GetRef(matrixRowIndex_i).Recovery->Buffer;
+                SIAMESE_DEBUG_ASSERT(recovery_i.Data && recovery_i.Bytes > 0);
+                SIAMESE_DEBUG_ASSERT(recovery_i.Bytes <= recovery_j.Bytes);
+                if (recovery_i.Bytes <= stripeStart) {
+                    continue;
+                }
+
+                const unsigned srcEnd = (recovery_i.Bytes < stripeEnd) ? recovery_i.Bytes : stripeEnd;
+                gather.Add(y, recovery_i.Data + stripeStart, srcEnd - stripeStart);
             }
 
-            gf256_muladd_mem(recovery_j.Data, y, srcData, srcBytes);
+            gather.Flush();
         }
     }
 
@@ -1112,6 +1697,12 @@ SiameseResult Decoder::BackSubstitution()
     Window.RecoveredPackets.SetSize_NoCopy(columns);
 
     bool iterateNextExpected = false;
+    unsigned longestBytes = 0;
+
+    // Solve the first stripe of each row, which reveals the packet lengths.
+    // The rest of the data is solved afterwards a stripe at a time.
+    const unsigned stripeBytes = GetSolveStripeBytes(columns);
+    static_assert(kSolveMinStripeBytes >= pktalloc::kAlignmentBytes, "Length field must be in the first stripe");
 
     // For each column starting with the right-most column:
     for (int col_i = columns - 1; col_i >= 0; --col_i)
@@ -1125,16 +1716,47 @@ SiameseResult Decoder::BackSubstitution()
         const uint8_t y = RecoveryMatrix.Matrix.Get(matrixRowIndex, col_i);
 
         SIAMESE_DEBUG_ASSERT(buffer && recovery->Buffer.Bytes > 0);
+
+        unsigned bufferBytes = recovery->Buffer.Bytes;
+        const unsigned stripeEnd = (bufferBytes < stripeBytes) ? bufferBytes : stripeBytes;
+
+        // Eliminate the columns solved so far (to the right) from this row.
+        // Gathering them here means this row is streamed through only once.
+        MulAddMultiGather gather;
+        gather.Reset(buffer, stripeEnd);
+
+        for (unsigned col_k = col_i + 1; col_k < columns; ++col_k)
+        {
+            const uint8_t x = RecoveryMatrix.Matrix.Get(matrixRowIndex, col_k);
+            if (x == 0) {
+                continue;
+            }
+
+            const GrowingAlignedDataBuffer& solved_k = RecoveryMatrix.Columns.GetRef(col_k).Original->Buffer;
+            SIAMESE_DEBUG_ASSERT(solved_k.Data && solved_k.Bytes > 0);
+
+            unsigned addBytes = solved_k.Bytes;
+            if (addBytes > bufferBytes) {
+                SIAMESE_DEBUG_BREAK(); // This should never happen
+                addBytes = bufferBytes;
+            }
+            if (addBytes > stripeEnd) {
+                addBytes = stripeEnd;
+            }
+
+            gather.Add(x, solved_k.Data, addBytes);
+        }
+
+        gather.Flush();
         SIAMESE_DEBUG_ASSERT(y != 0);
         const uint8_t inv_y = gf256_inv(y);
 
         // Reveal the first chunk of bytes of data
-        unsigned bufferBytes = recovery->Buffer.Bytes;
         unsigned lengthCheckBytes = pktalloc::kAlignmentBytes;
         if (lengthCheckBytes > bufferBytes) {
             lengthCheckBytes = bufferBytes;
         }
-        gf256_mul_mem(buffer, buffer, inv_y, lengthCheckBytes);
+        gf256_mul_mem_inplace(buffer, inv_y, lengthCheckBytes);
 
         // Check the embedded length field
         unsigned length;
@@ -1155,12 +1777,15 @@ SiameseResult Decoder::BackSubstitution()
 
         // Reduce buffer bytes to only cover the original packet data
         bufferBytes = headerBytes + length;
-        if (bufferBytes > lengthCheckBytes) {
-            gf256_mul_mem(
-                buffer + lengthCheckBytes,
+        const unsigned revealEnd = (bufferBytes < stripeEnd) ? bufferBytes : stripeEnd;
+        if (revealEnd > lengthCheckBytes) {
+            gf256_mul_mem_inplace(
                 buffer + lengthCheckBytes,
                 inv_y,
-                bufferBytes - lengthCheckBytes);
+                revealEnd - lengthCheckBytes);
+        }
+        if (longestBytes < bufferBytes) {
+            longestBytes = bufferBytes;
         }
 
         // Swap original and recovery buffers
@@ -1188,35 +1813,301 @@ SiameseResult Decoder::BackSubstitution()
         Logger.Trace("GE Decoded: Column=", original->Column, " Row=", recovery->Metadata.Row);
 
         iterateNextExpected |= Window.MarkGotColumn(original->Column);
+    }
 
-        // Eliminate from all other pivot rows above it:
-        for (unsigned col_j = 0; col_j < (unsigned)col_i; ++col_j)
-        {
-            unsigned pivot_j = RecoveryMatrix.Pivots.GetRef(col_j);
-            const uint8_t x  = RecoveryMatrix.Matrix.Get(pivot_j, col_i);
+    // Solve the remaining stripes now that the packet lengths are known.
+    // Each stripe is finished for all columns before moving on to the next
+    for (unsigned stripeStart = stripeBytes; stripeStart < longestBytes; stripeStart += stripeBytes)
+    {
+        const unsigned stripeEnd = stripeStart + stripeBytes;
 
-            if (x == 0) {
+        for (int col_i = columns - 1; col_i >= 0; --col_i)
+        {
+            GrowingAlignedDataBuffer& solved_i = RecoveryMatrix.Columns.GetRef(col_i).Original->Buffer;
+            if (solved_i.Bytes <= stripeStart) {
                 continue;
             }
 
-            const GrowingAlignedDataBuffer& buffer_j = RecoveryMatrix.Rows.GetRef(pivot_j).Recovery->Buffer;
-            SIAMESE_DEBUG_ASSERT(buffer_j.Data && buffer_j.Bytes > 0);
+            const unsigned matrixRowIndex = RecoveryMatrix.Pivots.GetRef(col_i);
+            const unsigned destEnd = (solved_i.Bytes < stripeEnd) ? solved_i.Bytes : stripeEnd;
+            uint8_t* dest = solved_i.Data + stripeStart;
 
-            unsigned addBytes = bufferBytes;
-            if (addBytes > buffer_j.Bytes) {
-                SIAMESE_DEBUG_BREAK(); // This should never happen
-                addBytes = buffer_j.Bytes;
+            MulAddMultiGather gather;
+            gather.Reset(dest, destEnd - stripeStart);
+
+            for (unsigned col_k = col_i + 1; col_k < columns; ++col_k)
+            {
+                const uint8_t x = RecoveryMatrix.Matrix.Get(matrixRowIndex, col_k);
+                if (x == 0) {
+                    continue;
+                }
+
+                const GrowingAlignedDataBuffer& solved_k = RecoveryMatrix.Columns.GetRef(col_k).Original->Buffer;
+                if (solved_k.Bytes <= stripeStart) {
+                    continue;
+                }
+
+                // Bytes past the end of this packet are not needed
+                const unsigned srcEnd = (solved_k.Bytes < destEnd) ? solved_k.Bytes : destEnd;
+                gather.Add(x, solved_k.Data + stripeStart, srcEnd - stripeStart);
             }
 
-            gf256_muladd_mem(buffer_j.Data, x, buffer, addBytes);
+            gather.Flush();
+
+            const uint8_t inv_y = gf256_inv(RecoveryMatrix.Matrix.Get(matrixRowIndex, col_i));
+            gf256_mul_mem_inplace(dest, inv_y, destEnd - stripeStart);
+        }
+    }
+
+    return FinishSolution(iterateNextExpected);
+}
+
+bool Decoder::SelectCauchyRows()
+{
+#ifdef SIAMESE_ENABLE_CAUCHY
+    const unsigned lostCount = CheckedRegion.LostCount;
+
+    // A Cauchy row cannot cover more lost packets than this
+    if (lostCount > kCauchyMaxColumns) {
+        return false;
+    }
+
+    if (!CauchySolver.Elements.SetSize_NoCopy(lostCount) ||
+        !CauchySolver.ColumnY.SetSize_NoCopy(lostCount) ||
+        !CauchySolver.Rows.SetSize_NoCopy(lostCount) ||
+        !CauchySolver.RowX.SetSize_NoCopy(lostCount))
+    {
+        return false;
+    }
+
+    // Find the lost elements
+    pktalloc::CustomBitSet<256> usedY;
+    unsigned element = CheckedRegion.ElementStart;
+    for (unsigned j = 0; j < lostCount; ++j, ++element)
+    {
+        element = Window.FindNextLostElement(element);
+        if (element >= CheckedRegion.NextCheckStart) {
+            SIAMESE_DEBUG_BREAK(); // Should never happen
+            return false;
+        }
+
+        const uint8_t y = (uint8_t)(Window.ElementToColumn(element) % kCauchyMaxColumns);
+        if (usedY.Check(y)) {
+            return false;
+        }
+        usedY.Set(y);
+
+        CauchySolver.Elements.GetRef(j) = element;
+        CauchySolver.ColumnY.GetRef(j)  = y;
+    }
+
+    const unsigned lostStart = CauchySolver.Elements.GetRef(0);
+    const unsigned lostEnd   = CauchySolver.Elements.GetRef(lostCount - 1) + 1;
+
+    // Select rows that cover all of the lost elements
+    pktalloc::CustomBitSet<256> usedX;
+    unsigned rowCount = 0;
+    CauchySolver.ParityIndex = -1;
+
+    const unsigned recoveryEnd = CheckedRegion.LastRecovery + 1;
+    for (unsigned recoveryIndex = CheckedRegion.FirstRecovery;
+         recoveryIndex != recoveryEnd && rowCount < lostCount;
+         ++recoveryIndex)
+    {
+        RecoveryPacket* recovery = RecoveryPackets.GetPacket(recoveryIndex);
+        const RecoveryMetadata metadata = recovery->Metadata;
+
+        if (metadata.SumCount > SIAMESE_CAUCHY_THRESHOLD ||
+            recovery->ElementStart > lostStart ||
+            recovery->ElementEnd < lostEnd)
+        {
+            continue;
+        }
+
+        // If this is a parity row:
+        if (metadata.Row == 0)
+        {
+            // A second parity row would be the same equation
+            if (CauchySolver.ParityIndex >= 0) {
+                continue;
+            }
+            CauchySolver.ParityIndex = (int)rowCount;
+        }
+        else
+        {
+            // A repeated Cauchy row would also be the same equation
+            const uint8_t x = (uint8_t)(metadata.Row - 1 + kCauchyMaxColumns);
+            if (usedX.Check(x)) {
+                continue;
+            }
+            usedX.Set(x);
+
+            CauchySolver.RowX.GetRef(rowCount) = x;
+        }
+
+        CauchySolver.Rows.GetRef(rowCount++) = recovery;
+    }
+
+    return rowCount == lostCount;
+#else // SIAMESE_ENABLE_CAUCHY
+    return false;
+#endif // SIAMESE_ENABLE_CAUCHY
+}
+
+SiameseResult Decoder::DecodeCauchyRows()
+{
+#ifdef SIAMESE_ENABLE_CAUCHY
+    const unsigned columns = CauchySolver.Elements.GetSize();
+    SIAMESE_DEBUG_ASSERT(columns == CheckedRegion.LostCount && columns == CauchySolver.Rows.GetSize());
+
+    // Eliminate the received data from each row.  Every row covers all of
+    // the lost packets, so none of them are longer than the shortest row
+    unsigned solveBytes = 0;
+    for (unsigned i = 0; i < columns; ++i)
+    {
+        RecoveryPacket* recovery = CauchySolver.Rows.GetRef(i);
+        if (!recovery->Eliminated) {
+            EliminateCauchyRow(recovery);
+        }
+
+        if (i == 0 || solveBytes > recovery->Buffer.Bytes) {
+            solveBytes = recovery->Buffer.Bytes;
+        }
+    }
+    SIAMESE_DEBUG_ASSERT(solveBytes > 0);
+
+    if (!CauchySolver.GenerateInverse())
+    {
+        Window.EmergencyDisabled = true;
+        Logger.Error("DecodeCauchyRows.GenerateInverse OOM");
+        return Siamese_Disabled;
+    }
+
+    // Make room for the solutions, which are written directly into the window
+    for (unsigned j = 0; j < columns; ++j)
+    {
+        OriginalPacket* original = Window.GetWritableWindowElement(CauchySolver.Elements.GetRef(j));
+        SIAMESE_DEBUG_ASSERT(!original || original->Buffer.Bytes == 0);
+        if (!original || !original->Buffer.Initialize(&TheAllocator, solveBytes))
+        {
+            Window.EmergencyDisabled = true;
+            Logger.Error("DecodeCauchyRows.Initialize OOM");
+            return Siamese_Disabled;
+        }
+    }
+
+    Window.RecoveredPackets.SetSize_NoCopy(columns);
+
+    bool iterateNextExpected = false;
+    unsigned longestBytes = 0;
+
+    // Solve the first stripe of each packet, which reveals the packet lengths.
+    // The rest of the data is solved afterwards a stripe at a time.
+    const unsigned stripeBytes = GetSolveStripeBytes(columns);
+    const unsigned firstStripeEnd = (solveBytes < stripeBytes) ? solveBytes : stripeBytes;
+
+    for (unsigned j = 0; j < columns; ++j)
+    {
+        MultiplyCauchyInverse(j, 0, firstStripeEnd);
+
+        OriginalPacket* original = Window.GetWindowElement(CauchySolver.Elements.GetRef(j));
+        uint8_t* buffer = original->Buffer.Data;
+
+        // Check the embedded length field
+        unsigned length;
+        const int headerBytes = DeserializeHeader_PacketLength(buffer, firstStripeEnd, length);
+        if (headerBytes < 0 || length == 0 || headerBytes + length > solveBytes)
+        {
+            // See BackSubstitution() for common causes
+            Window.EmergencyDisabled = true;
+            Logger.Error("DecodeCauchyRows corrupted recovered data len");
+            SIAMESE_DEBUG_BREAK(); // Should never happen
+            return Siamese_Disabled;
+        }
+
+        const unsigned column = Window.ElementToColumn(CauchySolver.Elements.GetRef(j));
+        original->Buffer.Bytes = headerBytes + length;
+        original->Column       = column;
+        original->HeaderBytes  = (unsigned)headerBytes;
+        if (longestBytes < original->Buffer.Bytes) {
+            longestBytes = original->Buffer.Bytes;
         }
+
+        // Write recovered packet data
+        SiameseOriginalPacket* recoveredPtr = Window.RecoveredPackets.GetPtr(j);
+        recoveredPtr->Data      = buffer + headerBytes;
+        recoveredPtr->DataBytes = length;
+        recoveredPtr->PacketNum = column;
+
+        if (!Window.RecoveredColumns.Append(column))
+        {
+            Window.EmergencyDisabled = true;
+            SIAMESE_DEBUG_BREAK(); // OOM
+            return Siamese_Disabled;
+        }
+
+        Logger.Trace("Cauchy Decoded: Column=", column);
+
+        iterateNextExpected |= Window.MarkGotColumn(column);
+    }
+
+    // Solve the remaining stripes now that the packet lengths are known.
+    // Each stripe is finished for all columns before moving on to the next
+    for (unsigned stripeStart = stripeBytes; stripeStart < longestBytes; stripeStart += stripeBytes)
+    {
+        const unsigned stripeEnd = stripeStart + stripeBytes;
+
+        for (unsigned j = 0; j < columns; ++j)
+        {
+            const unsigned solvedBytes = Window.GetWindowElement(CauchySolver.Elements.GetRef(j))->Buffer.Bytes;
+            if (solvedBytes > stripeStart) {
+                MultiplyCauchyInverse(j, stripeStart, (solvedBytes < stripeEnd) ? solvedBytes : stripeEnd);
+            }
+        }
+    }
+
+    Stats.Counts[SiameseDecoderStats_CauchySolveCount]++;
+
+    return FinishSolution(iterateNextExpected);
+#else // SIAMESE_ENABLE_CAUCHY
+    SIAMESE_DEBUG_BREAK(); // Should never be called
+    return Siamese_Disabled;
+#endif // SIAMESE_ENABLE_CAUCHY
+}
+
+void Decoder::MultiplyCauchyInverse(unsigned j, unsigned stripeStart, unsigned stripeEnd)
+{
+    const unsigned rows      = CauchySolver.Rows.GetSize();
+    const uint8_t* inverse   = CauchySolver.Inverse.GetPtr(j * rows);
+    const unsigned bytes     = stripeEnd - stripeStart;
+    OriginalPacket* original = Window.GetWindowElement(CauchySolver.Elements.GetRef(j));
+    uint8_t* dest            = original->Buffer.Data + stripeStart;
+    SIAMESE_DEBUG_ASSERT(rows > 0 && stripeStart < stripeEnd);
+
+    // The first row overwrites the destination and the rest are added to it,
+    // so each destination stripe is streamed through once
+    gf256_mul_mem(dest, CauchySolver.Rows.GetRef(0)->Buffer.Data + stripeStart, inverse[0], bytes);
+
+    MulAddMultiGather gather;
+    gather.Reset(dest, bytes);
+
+    for (unsigned i = 1; i < rows; ++i)
+    {
+        const GrowingAlignedDataBuffer& recoveryBuffer = CauchySolver.Rows.GetRef(i)->Buffer;
+        SIAMESE_DEBUG_ASSERT(recoveryBuffer.Bytes >= stripeEnd);
+        gather.Add(inverse[i], recoveryBuffer.Data + stripeStart, bytes);
     }
 
+    gather.Flush();
+}
+
+SiameseResult Decoder::FinishSolution(bool iterateNextExpected)
+{
     // We always expect to have recovered the next expected packet
     if (!iterateNextExpected)
     {
         Window.EmergencyDisabled = true;
-        Logger.Error("BackSubstitution.iterateNextExpected failed");
+        Logger.Error("FinishSolution.iterateNextExpected failed");
         SIAMESE_DEBUG_BREAK(); // Should never happen
         return Siamese_Disabled;
     }
@@ -1224,10 +2115,17 @@ SiameseResult Decoder::BackSubstitution()
     // Iterate the next expected element beyond the recovery region
     Window.IterateNextExpectedElement(CheckedRegion.NextCheckStart);
 
-    Logger.Debug("BackSubstitution: Deleting recovery packets before element ", Window.NextExpectedElement, " column = ", (Window.NextExpectedElement + Window.ColumnStart));
+    Logger.Debug("FinishSolution: Deleting recovery packets before element ", Window.NextExpectedElement, " column = ", (Window.NextExpectedElement + Window.ColumnStart));
 
     RecoveryPackets.DeletePacketsBefore(Window.NextExpectedElement);
 
+    // Remove the solution from the remaining recovery packets that IdleWork()
+    // eliminated without it.  Note the rows used to solve were all deleted
+    const unsigned recoveredCount = Window.RecoveredPackets.GetSize();
+    for (unsigned i = 0; i < recoveredCount; ++i) {
+        EliminateLateOriginal(Window.ColumnToElement(Window.RecoveredPackets.GetRef(i).PacketNum));
+    }
+
     if (CheckedRegion.NextCheckStart >= kDecoderRemoveThreshold) {
         Window.RemoveElements();
     }
@@ -1245,6 +2143,7 @@ SiameseResult Decoder::GetStatistics(uint64_t* statsOut, unsigned statsCount)
 
     // Fill in memory allocated
     Stats.Counts[SiameseDecoderStats_MemoryUsed] = TheAllocator.GetMemoryAllocatedBytes();
+    Stats.Counts[SiameseDecoderStats_FallbackAllocateCount] = TheAllocator.GetFallbackAllocateCount();
 
     for (unsigned i = 0; i < statsCount; ++i) {
         statsOut[i] = Stats.Counts[i];
@@ -1253,167 +2152,374 @@ SiameseResult Decoder::GetStatistics(uint64_t* statsOut, unsigned statsCount)
     return Siamese_Success;
 }
 
+SiameseResult Decoder::IdleWork(unsigned budgetUsec)
+{
+    if (Window.EmergencyDisabled) {
+        return Siamese_Disabled;
+    }
+
+    const uint64_t deadlineUsec = (budgetUsec > 0) ? GetTimeUsec() + budgetUsec : 0;
+
+    /*
+        Eliminate the received original data from each recovery packet in
+        list order, which is the order Decode() uses for matrix rows, so the
+        running sums roll forward the same way.  Originals that are filled in
+        afterwards are removed by EliminateLateOriginal(), which keeps each
+        eliminated row equal to the sum of its lost columns.  The matrix
+        generated for the row does not depend on when it was eliminated.
+    */
+    for (unsigned recoveryIndex = RecoveryPackets.HeadIndex;
+         recoveryIndex != RecoveryPackets.EndIndex();
+         ++recoveryIndex)
+    {
+        RecoveryPacket* recovery = RecoveryPackets.GetPacket(recoveryIndex);
+        if (recovery->Eliminated) {
+            continue;
+        }
+
+        if (deadlineUsec != 0 && GetTimeUsec() >= deadlineUsec) {
+            return Siamese_NeedMoreData;
+        }
+
+#ifdef SIAMESE_ENABLE_CAUCHY
+        // If it is a Cauchy or parity row:
+        if (recovery->Metadata.SumCount <= SIAMESE_CAUCHY_THRESHOLD) {
+            EliminateCauchyRow(recovery);
+        }
+        else
+#endif // SIAMESE_ENABLE_CAUCHY
+        {
+            // If the running sums would need to restart from data that was
+            // removed, leave the row for Decode() to handle
+            if (Window.SumsUnavailable(recovery->Metadata)) {
+                continue;
+            }
+
+            if (!EliminateSumRow(recovery, true))
+            {
+                Window.EmergencyDisabled = true;
+                Logger.Error("IdleWork.EliminateSumRow failed");
+                return Siamese_Disabled;
+            }
+        }
+
+        recovery->Eliminated = true;
+        Stats.Counts[SiameseDecoderStats_IdleEliminationCount]++;
+    }
+
+    return Siamese_Success;
+}
+
 
 //------------------------------------------------------------------------------
-// DecoderPacketWindow
+// DecoderGotBitmap
 
-bool DecoderPacketWindow::MarkGotColumn(unsigned column)
+/// Mask of the bits in [bitStart, bitEnd) of a word.
+/// Precondition: bitStart < bitEnd <= 64
+static SIAMESE_FORCE_INLINE uint64_t GetWordRangeMask(unsigned bitStart, unsigned bitEnd)
 {
-    // Convert to window element
-    const unsigned element = ColumnToElement(column);
-    if (InvalidElement(element))
+    return (DecoderGotBitmap::kAllOnes << bitStart) &
+        (DecoderGotBitmap::kAllOnes >> (DecoderGotBitmap::kWordBits - bitEnd));
+}
+
+bool DecoderGotBitmap::Grow(unsigned wordCount)
+{
+    const unsigned oldWordCount = Words.GetSize();
+    if (wordCount <= oldWordCount) {
+        return true;
+    }
+
+    const unsigned oldSummaryCount = FullSummary.GetSize();
+    const unsigned summaryCount = (wordCount + kWordBits - 1) / kWordBits;
+
+    if (!Words.SetSize_Copy(wordCount) ||
+        !FullSummary.SetSize_Copy(summaryCount) ||
+        !AnySummary.SetSize_Copy(summaryCount))
     {
-        EmergencyDisabled = true;
-        Logger.Error("MarkGotColumn failed");
-        SIAMESE_DEBUG_BREAK(); // Should never happen
         return false;
     }
 
-    DecoderSubwindow* subwindow = Subwindows.GetRef(element / kSubwindowSize);
-    subwindow->GotCount++;
-    subwindow->Got.Set(element % kSubwindowSize);
+    memset(Words.GetPtr(oldWordCount), 0, (wordCount - oldWordCount) * sizeof(uint64_t));
+    if (summaryCount > oldSummaryCount)
+    {
+        const unsigned bytes = (summaryCount - oldSummaryCount) * sizeof(uint64_t);
+        memset(FullSummary.GetPtr(oldSummaryCount), 0, bytes);
+        memset(AnySummary.GetPtr(oldSummaryCount), 0, bytes);
+    }
 
-    return (element == NextExpectedElement);
+    return true;
 }
 
-unsigned DecoderPacketWindow::RangeLostPackets(unsigned elementStart, unsigned elementEnd)
+unsigned DecoderGotBitmap::FindSummaryWord(
+    const pktalloc::LightVector<uint64_t>& summary,
+    unsigned wordStart,
+    unsigned wordEnd,
+    bool invert)
 {
-    if (elementStart >= elementEnd) {
-        return 0;
+    if (wordStart >= wordEnd) {
+        return wordEnd;
     }
 
-    unsigned lostCount = 0;
+    const uint64_t flip = invert ? kAllOnes : 0;
+    const unsigned summaryEnd = (wordEnd + kWordBits - 1) / kWordBits;
+    unsigned summaryIndex = wordStart / kWordBits;
 
-    // Accumulate first partial subwindow (if any)
-    unsigned subwindowStart = elementStart / kSubwindowSize;
-    SIAMESE_DEBUG_ASSERT(subwindowStart < Subwindows.GetSize());
-    const unsigned bitStart = elementStart % kSubwindowSize;
-    if (bitStart > 0)
+    // Eliminate low bits of the first summary word
+    uint64_t bits = (summary.GetRef(summaryIndex) ^ flip) & (kAllOnes << (wordStart % kWordBits));
+
+    for (;;)
     {
-        unsigned bitEnd = bitStart + elementEnd - elementStart;
-        if (bitEnd > kSubwindowSize) {
-            bitEnd = kSubwindowSize;
+        if (bits != 0)
+        {
+            const unsigned wordIndex = summaryIndex * kWordBits + pktalloc::TrailingZeros64(bits);
+            return (wordIndex < wordEnd) ? wordIndex : wordEnd;
+        }
+
+        if (++summaryIndex >= summaryEnd) {
+            return wordEnd;
         }
-        const unsigned bitMaxSet = bitEnd - bitStart; // Bit count in range
-        lostCount += bitMaxSet - Subwindows.GetRef(subwindowStart)->Got.RangePopcount(bitStart, bitEnd);
-        ++subwindowStart;
+        bits = summary.GetRef(summaryIndex) ^ flip;
     }
+}
 
-    // Accumulate whole subwindows of losses
-    const unsigned subwindowEnd = elementEnd / kSubwindowSize;
-    SIAMESE_DEBUG_ASSERT(subwindowEnd <= Subwindows.GetSize());
-    for (unsigned i = subwindowStart; i < subwindowEnd; ++i) {
-        lostCount += kSubwindowSize - Subwindows.GetRef(i)->GotCount;
+unsigned DecoderGotBitmap::RangeClearCount(unsigned elementStart, unsigned elementEnd) const
+{
+    if (elementStart >= elementEnd) {
+        return 0;
     }
 
-    // Accumulate last partial subwindow (if any, common case)
-    if (subwindowEnd >= subwindowStart)
+    const unsigned firstWord = elementStart / kWordBits;
+    const unsigned lastWord = (elementEnd - 1) / kWordBits;
+    SIAMESE_DEBUG_ASSERT(lastWord < Words.GetSize());
+
+    unsigned clearCount = 0;
+
+    // Only visit the words that have any clear bits
+    for (unsigned wordIndex = FindSummaryWord(FullSummary, firstWord, lastWord + 1, true);
+        wordIndex <= lastWord;
+        wordIndex = FindSummaryWord(FullSummary, wordIndex + 1, lastWord + 1, true))
     {
-        const unsigned lastSubwindowBits = elementEnd - subwindowEnd * kSubwindowSize;
+        const unsigned bitStart = (wordIndex == firstWord) ? elementStart % kWordBits : 0;
+        const unsigned bitEnd = (wordIndex == lastWord) ? elementEnd - lastWord * kWordBits : kWordBits;
 
-        if (lastSubwindowBits > 0)
-        {
-            const unsigned gotCount = Subwindows.GetRef(subwindowEnd)->Got.RangePopcount(0, lastSubwindowBits);
+        clearCount += pktalloc::PopCount64(~Words.GetRef(wordIndex) & GetWordRangeMask(bitStart, bitEnd));
+    }
 
-            lostCount += lastSubwindowBits - gotCount;
+    return clearCount;
+}
+
+unsigned DecoderGotBitmap::FindFirstClear(unsigned elementStart, unsigned elementEnd) const
+{
+    if (elementStart >= elementEnd) {
+        return elementEnd;
+    }
+
+    unsigned wordIndex = elementStart / kWordBits;
+    SIAMESE_DEBUG_ASSERT(wordIndex < Words.GetSize());
+    uint64_t bits = ~Words.GetRef(wordIndex) & (kAllOnes << (elementStart % kWordBits));
+
+    // If the first word is full from the start element, skip to the next non-full word
+    if (bits == 0)
+    {
+        const unsigned wordEnd = (elementEnd + kWordBits - 1) / kWordBits;
+        wordIndex = FindSummaryWord(FullSummary, wordIndex + 1, wordEnd, true);
+        if (wordIndex >= wordEnd) {
+            return elementEnd;
         }
+        bits = ~Words.GetRef(wordIndex);
     }
 
-    return lostCount;
+    const unsigned element = wordIndex * kWordBits + pktalloc::TrailingZeros64(bits);
+    return (element < elementEnd) ? element : elementEnd;
 }
 
-unsigned DecoderPacketWindow::FindNextLostElement(unsigned elementStart)
+unsigned DecoderGotBitmap::FindFirstSet(unsigned elementStart, unsigned elementEnd) const
 {
-    if (elementStart >= Count) {
-        return Count;
+    if (elementStart >= elementEnd) {
+        return elementEnd;
     }
 
-    const unsigned subwindowEnd = (Count + kSubwindowSize - 1) / kSubwindowSize;
-    unsigned subwindowIndex = elementStart / kSubwindowSize;
-    unsigned bitIndex = elementStart % kSubwindowSize;
-    SIAMESE_DEBUG_ASSERT(subwindowEnd <= Subwindows.GetSize());
-    SIAMESE_DEBUG_ASSERT(subwindowIndex < Subwindows.GetSize());
+    unsigned wordIndex = elementStart / kWordBits;
+    SIAMESE_DEBUG_ASSERT(wordIndex < Words.GetSize());
+    uint64_t bits = Words.GetRef(wordIndex) & (kAllOnes << (elementStart % kWordBits));
 
-    while (subwindowIndex < subwindowEnd)
+    // If the first word is empty from the start element, skip to the next non-empty word
+    if (bits == 0)
     {
-        // If there may be any lost packets in this subwindow:
-        if (Subwindows.GetRef(subwindowIndex)->GotCount < kSubwindowSize)
-        {
-            for (;;)
-            {
-                // Seek next clear bit
-                bitIndex = Subwindows.GetRef(subwindowIndex)->Got.FindFirstClear(bitIndex);
+        const unsigned wordEnd = (elementEnd + kWordBits - 1) / kWordBits;
+        wordIndex = FindSummaryWord(AnySummary, wordIndex + 1, wordEnd, false);
+        if (wordIndex >= wordEnd) {
+            return elementEnd;
+        }
+        bits = Words.GetRef(wordIndex);
+    }
 
-                // If there were none, skip this subwindow
-                if (bitIndex >= kSubwindowSize) {
-                    break;
-                }
+    const unsigned element = wordIndex * kWordBits + pktalloc::TrailingZeros64(bits);
+    return (element < elementEnd) ? element : elementEnd;
+}
 
-                // Calculate element index and stop if we hit the end of the valid data
-                unsigned nextElement = subwindowIndex * kSubwindowSize + bitIndex;
-                if (nextElement > Count) {
-                    nextElement = Count;
-                }
+void DecoderGotBitmap::RemoveWords(unsigned wordCount)
+{
+    const unsigned totalWords = Words.GetSize();
+    if (wordCount == 0) {
+        return;
+    }
+    if (wordCount > totalWords) {
+        wordCount = totalWords;
+    }
 
-                return nextElement;
-            }
+    const unsigned keptWords = totalWords - wordCount;
+    memmove(Words.GetPtr(0), Words.GetPtr(wordCount), keptWords * sizeof(uint64_t));
+    memset(Words.GetPtr(keptWords), 0, wordCount * sizeof(uint64_t));
+
+    // Rebuild the summaries.  This happens once per removal of whole
+    // subwindows so it is cheap compared to the scans it speeds up
+    const unsigned summaryCount = FullSummary.GetSize();
+    memset(FullSummary.GetPtr(0), 0, summaryCount * sizeof(uint64_t));
+    memset(AnySummary.GetPtr(0), 0, summaryCount * sizeof(uint64_t));
+
+    for (unsigned wordIndex = 0; wordIndex < keptWords; ++wordIndex)
+    {
+        const uint64_t word = Words.GetRef(wordIndex);
+        const uint64_t summaryBit = (uint64_t)1 << (wordIndex % kWordBits);
+        if (word != 0) {
+            AnySummary.GetRef(wordIndex / kWordBits) |= summaryBit;
+        }
+        if (word == kAllOnes) {
+            FullSummary.GetRef(wordIndex / kWordBits) |= summaryBit;
         }
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// DecoderLossRanges
+
+bool DecoderLossRanges::AddLost(unsigned elementStart, unsigned elementEnd)
+{
+    if (elementStart >= elementEnd) {
+        return true;
+    }
 
-        // Reset bit index to the front of the next subwindow
-        bitIndex = 0;
+    const unsigned count = GetCount();
 
-        // Check next subwindow
-        ++subwindowIndex;
+    // If this continues the last range, extend it
+    if (count > 0 && GetEnd(count - 1) == elementStart)
+    {
+        Ranges.GetRef(count - 1).End = elementEnd + ElementOffset;
+        return true;
     }
+    SIAMESE_DEBUG_ASSERT(count == 0 || GetEnd(count - 1) < elementStart);
 
-    return Count;
+    Range range;
+    range.Start = elementStart + ElementOffset;
+    range.End = elementEnd + ElementOffset;
+    return Ranges.Append(range);
 }
 
-unsigned DecoderPacketWindow::FindNextGotElement(unsigned elementStart)
+bool DecoderLossRanges::RemoveLost(unsigned element)
 {
-    if (elementStart >= Count) {
-        return Count;
+    const unsigned count = GetCount();
+
+    // Binary search for the first range that ends after the element
+    unsigned low = 0, high = count;
+    while (low < high)
+    {
+        const unsigned mid = (low + high) / 2;
+        if (GetEnd(mid) > element) {
+            high = mid;
+        }
+        else {
+            low = mid + 1;
+        }
+    }
+
+    // If the element was not lost:
+    if (low >= count || GetStart(low) > element) {
+        return true;
     }
 
-    const unsigned subwindowEnd = (Count + kSubwindowSize - 1) / kSubwindowSize;
-    unsigned subwindowIndex = elementStart / kSubwindowSize;
-    unsigned bitIndex = elementStart % kSubwindowSize;
-    SIAMESE_DEBUG_ASSERT(subwindowEnd <= Subwindows.GetSize());
-    SIAMESE_DEBUG_ASSERT(subwindowIndex < Subwindows.GetSize());
+    Range* range = Ranges.GetPtr(low);
+    const unsigned stored = element + ElementOffset;
 
-    while (subwindowIndex < subwindowEnd)
+    if (range->Start == stored)
     {
-        // If there may be any got packets in this subwindow:
-        if (Subwindows.GetRef(subwindowIndex)->GotCount > 0)
+        // If the range is now empty, remove it
+        if (++range->Start == range->End)
         {
-            for (;;)
-            {
-                // Seek next set bit
-                bitIndex = Subwindows.GetRef(subwindowIndex)->Got.FindFirstSet(bitIndex);
+            memmove(range, range + 1, (count - low - 1) * sizeof(Range));
+            Ranges.SetSize_Copy(count - 1);
+        }
+    }
+    else if (range->End == stored + 1) {
+        range->End = stored;
+    }
+    else
+    {
+        // Split the range in two around the element
+        if (!Ranges.SetSize_Copy(count + 1)) {
+            return false;
+        }
+        range = Ranges.GetPtr(low);
+        memmove(range + 2, range + 1, (count - low - 1) * sizeof(Range));
+        range[1].Start = stored + 1;
+        range[1].End = range->End;
+        range->End = stored;
+    }
 
-                // If there were none, skip this subwindow
-                if (bitIndex >= kSubwindowSize) {
-                    break;
-                }
+    return true;
+}
 
-                // Calculate element index and stop if we hit the end of the valid data
-                unsigned nextElement = subwindowIndex * kSubwindowSize + bitIndex;
-                if (nextElement > Count) {
-                    nextElement = Count;
-                }
 
-                return nextElement;
-            }
-        }
+//------------------------------------------------------------------------------
+// DecoderPacketWindow
 
-        // Reset bit index to the front of the next subwindow
-        bitIndex = 0;
+bool DecoderPacketWindow::MarkGotColumn(unsigned column)
+{
+    // Convert to window element
+    const unsigned element = ColumnToElement(column);
+    if (InvalidElement(element))
+    {
+        EmergencyDisabled = true;
+        Logger.Error("MarkGotColumn failed");
+        SIAMESE_DEBUG_BREAK(); // Should never happen
+        return false;
+    }
+
+    GotBitmap.Set(element);
+    if (!LossRanges.RemoveLost(element))
+    {
+        EmergencyDisabled = true;
+        Logger.Error("MarkGotColumn.RemoveLost OOM");
+        return false;
+    }
+
+    // Recovered data gets plugged into the running sums but not checkpoints
+    InvalidateSumCheckpoints(element);
+
+    return (element == NextExpectedElement);
+}
+
+unsigned DecoderPacketWindow::RangeLostPackets(unsigned elementStart, unsigned elementEnd)
+{
+    SIAMESE_DEBUG_ASSERT(elementEnd <= Subwindows.GetSize() * kSubwindowSize);
+    return GotBitmap.RangeClearCount(elementStart, elementEnd);
+}
+
+unsigned DecoderPacketWindow::FindNextLostElement(unsigned elementStart)
+{
+    if (elementStart >= Count) {
+        return Count;
+    }
+    return GotBitmap.FindFirstClear(elementStart, Count);
+}
 
-        // Check next subwindow
-        ++subwindowIndex;
+unsigned DecoderPacketWindow::FindNextGotElement(unsigned elementStart)
+{
+    if (elementStart >= Count) {
+        return Count;
     }
-
-    return Count;
+    return GotBitmap.FindFirstSet(elementStart, Count);
 }
 
 void DecoderPacketWindow::IterateNextExpectedElement(unsigned elementStart)
@@ -1433,6 +2539,24 @@ void DecoderPacketWindow::IterateNextExpectedElement(unsigned elementStart)
     NextExpectedElement = nextLostElement;
 }
 
+OriginalPacket* DecoderPacketWindow::GetWritableWindowElement(unsigned windowElement)
+{
+    SIAMESE_DEBUG_ASSERT(windowElement < Count);
+    const unsigned subwindowIndex = windowElement / kSubwindowSize;
+    DecoderSubwindow* subwindow = Subwindows.GetRef(subwindowIndex);
+
+    if (subwindow == EmptySubwindow)
+    {
+        subwindow = TheAllocator->Construct<DecoderSubwindow>();
+        if (!subwindow) {
+            return nullptr; // Out of memory
+        }
+        Subwindows.SetRef(subwindowIndex, subwindow);
+    }
+
+    return &subwindow->Originals[GetSubwindowSlot(windowElement)];
+}
+
 bool DecoderPacketWindow::GrowWindow(const unsigned windowElementEnd)
 {
     // Note: Adding a buffer of lane count to create space ahead for snapshots
@@ -1442,34 +2566,46 @@ bool DecoderPacketWindow::GrowWindow(const unsigned windowElementEnd)
 
     if (subwindowsNeeded > subwindowCount)
     {
-        // Note resizing larger will keep old data in the vector
-        if (!Subwindows.SetSize_Copy(subwindowsNeeded))
-            return false;
+        if (!EmptySubwindow)
+        {
+            EmptySubwindow = TheAllocator->Construct<DecoderSubwindow>();
+            if (!EmptySubwindow)
+                return false; // Out of memory
+        }
 
-        // For each subwindow to initialize:
+        // New subwindows share the empty one until data is written to them
         for (unsigned i = subwindowCount; i < subwindowsNeeded; ++i)
         {
-            DecoderSubwindow* subwindow = TheAllocator->Construct<DecoderSubwindow>();
-            if (!subwindow)
+            if (!Subwindows.Append(EmptySubwindow))
                 return false; // Out of memory
-
-            Subwindows.GetRef(i) = subwindow;
         }
+
+        if (!GotBitmap.Grow(subwindowsNeeded))
+            return false;
     }
 
     // If this element expands the window:
     if (windowElementEnd > Count)
+    {
+        // The new elements are lost until they arrive
+        if (!LossRanges.AddLost(Count, windowElementEnd))
+            return false;
+
         Count = windowElementEnd;
+    }
 
     return true;
 }
 
-SiameseResult DecoderPacketWindow::AddOriginal(const SiameseOriginalPacket& packet)
+SiameseResult DecoderPacketWindow::AddOriginal(
+    const SiameseOriginalPacket& packet,
+    const SiameseSegment* segments,
+    unsigned segmentCount)
 {
     if (EmergencyDisabled)
         return Siamese_Disabled;
 
-    SIAMESE_DEBUG_ASSERT(packet.Data && packet.DataBytes > 0);
+    SIAMESE_DEBUG_ASSERT((packet.Data || segments) && packet.DataBytes > 0);
     const unsigned element = ColumnToElement(packet.PacketNum);
 
     // If we just received an old element before our window:
@@ -1488,10 +2624,7 @@ SiameseResult DecoderPacketWindow::AddOriginal(const SiameseOriginalPacket& pack
     }
 
     // Grab the window element for this packet
-    DecoderSubwindow* subwindowPtr  = Subwindows.GetRef(element / kSubwindowSize);
-    const unsigned subwindowElement = element % kSubwindowSize;
-
-    OriginalPacket* original = &subwindowPtr->Originals[subwindowElement];
+    OriginalPacket* original = GetWindowElement(element);
     if (original->Buffer.Bytes > 0)
     {
         Logger.Debug("Ignored a packet already received: ", packet.PacketNum);
@@ -1499,8 +2632,19 @@ SiameseResult DecoderPacketWindow::AddOriginal(const SiameseOriginalPacket& pack
         return Siamese_DuplicateData;
     }
 
+    original = GetWritableWindowElement(element);
+    if (!original)
+    {
+        EmergencyDisabled = true;
+        Logger.Error("AddOriginal.GetWritableWindowElement OOM");
+        return Siamese_Disabled;
+    }
+
     // Make space for the packet data
-    if (0 == original->Initialize(TheAllocator, packet))
+    const unsigned headerBytes = segments ?
+        original->InitializeSegments(TheAllocator, packet, segments, segmentCount) :
+        original->Initialize(TheAllocator, packet);
+    if (0 == headerBytes)
     {
         EmergencyDisabled = true;
         Logger.Error("AddOriginal.Initialize OOM");
@@ -1508,9 +2652,36 @@ SiameseResult DecoderPacketWindow::AddOriginal(const SiameseOriginalPacket& pack
     }
     SIAMESE_DEBUG_ASSERT(original->Buffer.Bytes > 1);
 
-    // Increment the number of packets filled in for this subwindow
-    subwindowPtr->GotCount++;
-    subwindowPtr->Got.Set(subwindowElement);
+    GotBitmap.Set(element);
+    if (!LossRanges.RemoveLost(element))
+    {
+        EmergencyDisabled = true;
+        Logger.Error("AddOriginal.RemoveLost OOM");
+        return Siamese_Disabled;
+    }
+
+    // If the running sums in this lane have already passed the element, then
+    // they do not include it so they cannot be checkpointed until restarted
+    DecoderColumnLane& lane = Lanes[packet.PacketNum % kColumnLaneCount];
+    bool passedBySums = false;
+    for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex)
+    {
+        DecoderSum& sum = lane.Sums[sumIndex];
+        if (element >= sum.ElementStart && element < sum.ElementEnd) {
+            sum.BaseState = SumCheckpointBase::Unavailable;
+            passedBySums = true;
+        }
+    }
+    InvalidateSumCheckpoints(element);
+
+    // Plug the hole in the running sums before they are used again.
+    // This happens when Decoder::IdleWork() rolled the sums past a loss
+    if (passedBySums && !RecoveredColumns.Append(packet.PacketNum))
+    {
+        EmergencyDisabled = true;
+        Logger.Error("AddOriginal.RecoveredColumns OOM");
+        return Siamese_Disabled;
+    }
 
     // If this was the next expected element:
     if (element == NextExpectedElement)
@@ -1573,7 +2744,7 @@ bool DecoderPacketWindow::PlugSumHoles(unsigned elementStart)
                 if (originalBytes > sum.Buffer.Bytes)
                 {
                     // Grow sum to encompass the original data
-                    if (!sum.Buffer.GrowZeroPadded(TheAllocator, originalBytes))
+                    if (!sum.Buffer.GrowZeroPaddedAmortized(TheAllocator, originalBytes))
                         return false;
                 }
 
@@ -1595,147 +2766,499 @@ bool DecoderPacketWindow::PlugSumHoles(unsigned elementStart)
         }
     }
 
-    // Clear recovered packets to avoid double-plugging holes in the sums
-    RecoveredColumns.Clear();
-
+    // Clear recovered packets to avoid double-plugging holes in the sums
+    RecoveredColumns.Clear();
+
+    return true;
+}
+
+void DecoderPacketWindow::ResetSums(unsigned elementStart)
+{
+    Logger.Info("ResetSums at ", elementStart);
+
+    // For each lane:
+    for (unsigned laneIndex = 0; laneIndex < kColumnLaneCount; ++laneIndex)
+    {
+        // Find the next window element that is in this lane beginning at `elementStart`
+        const unsigned laneElementStart = GetNextLaneElement(elementStart, laneIndex);
+
+        // For each of the sums in the lane:
+        for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex)
+        {
+            // Clear the buffer and element start/end range
+            DecoderSum& sum  = Lanes[laneIndex].Sums[sumIndex];
+            sum.ElementStart = laneElementStart;
+            sum.ElementEnd   = laneElementStart;
+            sum.Buffer.Bytes = 0;
+            sum.BaseState    = SumCheckpointBase::Unknown;
+        }
+    }
+
+    // Keep checkpointing from the same start point if possible
+    StartSumCheckpoints(elementStart);
+
+    // Clear recovered packets to avoid double-plugging holes in the sums
+    RecoveredColumns.Clear();
+}
+
+bool DecoderPacketWindow::StartSums(unsigned elementStart, unsigned bufferBytes)
+{
+    // Start checkpointing if not already
+    StartSumCheckpoints(elementStart);
+
+    for (unsigned laneIndex = 0; laneIndex < kColumnLaneCount; ++laneIndex)
+    {
+        // Get the next window element in this lane beginning with `elementStart`
+        const unsigned laneElementStart = GetNextLaneElement(elementStart, laneIndex);
+
+        for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex)
+        {
+            DecoderSum& sum = Lanes[laneIndex].Sums[sumIndex];
+
+            // If the sum contains no data or starts in a different place:
+            if (sum.Buffer.Bytes == 0)
+            {
+                Logger.Debug("Re-Restarting sum for ", laneIndex, " sum ", sumIndex, " at column ", laneElementStart + ColumnStart, " current sum bytes = ", sum.Buffer.Bytes);
+
+                sum.ElementEnd = laneElementStart;
+                sum.BaseState  = SumCheckpointBase::Unknown;
+            }
+            else if (sum.ElementStart != laneElementStart)
+            {
+                Logger.Debug("Restarting sum for ", laneIndex, " sum ", sumIndex, " at column ", laneElementStart + ColumnStart, " current sum bytes = ", sum.Buffer.Bytes);
+
+                sum.ElementEnd = laneElementStart;
+                sum.Buffer.Bytes = 0;
+                sum.BaseState  = SumCheckpointBase::Unknown;
+            }
+
+            // Update the start element
+            sum.ElementStart = laneElementStart;
+
+            // Grow and zero pad
+            if (!sum.Buffer.GrowZeroPaddedAmortized(TheAllocator, bufferBytes)) {
+                return false;
+            }
+
+            SIAMESE_DEBUG_ASSERT((sum.ElementStart + ColumnStart) % kColumnLaneCount == laneIndex);
+            SIAMESE_DEBUG_ASSERT((sum.ElementEnd   + ColumnStart) % kColumnLaneCount == laneIndex);
+        }
+    }
+
+    // If we have previously recovered packets, use them to plug holes in the sums:
+    if (RecoveredColumns.GetSize() != 0) {
+        // If holes cannot be plugged:
+        if (!PlugSumHoles(elementStart)) {
+            SIAMESE_DEBUG_BREAK(); // Should never happen
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const GrowingAlignedDataBuffer* DecoderPacketWindow::GetSum(unsigned laneIndex, unsigned sumIndex, unsigned elementEnd)
+{
+    DecoderSum& sum = Lanes[laneIndex].Sums[sumIndex];
+
+    SIAMESE_DEBUG_ASSERT(sum.ElementStart <= sum.ElementEnd);
+    SIAMESE_DEBUG_ASSERT((sum.ElementStart + ColumnStart) % kColumnLaneCount == laneIndex);
+    SIAMESE_DEBUG_ASSERT((sum.ElementEnd + ColumnStart) % kColumnLaneCount == laneIndex);
+
+    unsigned element = sum.ElementEnd;
+    if (element >= elementEnd) {
+        return &sum.Buffer;
+    }
+
+    // Next element at which to checkpoint this sum.
+    // This is left at elementEnd (never reached) if not checkpointing
+    unsigned checkpointElement = elementEnd;
+    unsigned checkpointIndex   = 0;
+
+    if (HasSumCheckpoints)
+    {
+        const unsigned firstElement = GetFirstSumCheckpointElement() + laneIndex;
+
+        // Find the first checkpoint at or after the next element
+        if (element > firstElement) {
+            checkpointIndex = (element - firstElement + kDecoderCheckpointInterval - 1) / kDecoderCheckpointInterval;
+        }
+
+        // If this sum will reach a checkpoint and it can use checkpoints:
+        if (firstElement + checkpointIndex * kDecoderCheckpointInterval <= elementEnd &&
+            PrepareSumCheckpointBase(laneIndex, sumIndex))
+        {
+            // Skip ahead to the furthest checkpoint within reach
+            if (!LoadSumCheckpoint(laneIndex, sumIndex, elementEnd))
+            {
+                EmergencyDisabled = true;
+                goto ExitSum;
+            }
+
+            element = sum.ElementEnd;
+            if (element >= elementEnd) {
+                return &sum.Buffer;
+            }
+
+            if (element > firstElement) {
+                checkpointIndex = (element - firstElement + kDecoderCheckpointInterval - 1) / kDecoderCheckpointInterval;
+            }
+            checkpointElement = firstElement + checkpointIndex * kDecoderCheckpointInterval;
+        }
+    }
+
+    // For each element to accumulate in this lane:
+    do
+    {
+        SIAMESE_DEBUG_ASSERT((element + ColumnStart) % kColumnLaneCount == laneIndex);
+
+        // If the sum has reached a checkpoint:
+        if (element == checkpointElement)
+        {
+            if (!SaveSumCheckpoint(checkpointIndex, laneIndex, sumIndex))
+            {
+                EmergencyDisabled = true;
+                goto ExitSum;
+            }
+
+            ++checkpointIndex;
+            checkpointElement += kDecoderCheckpointInterval;
+        }
+
+        if (!AccumulateSumElement(sum.Buffer, laneIndex, sumIndex, element))
+        {
+            EmergencyDisabled = true;
+            goto ExitSum;
+        }
+
+        element += kColumnLaneCount;
+    } while (element < elementEnd);
+
+    SIAMESE_DEBUG_ASSERT((element + ColumnStart) % kColumnLaneCount == laneIndex);
+
+    sum.ElementEnd = element;
+
+ExitSum:
+    return &sum.Buffer;
+}
+
+bool DecoderPacketWindow::AccumulateSumElement(
+    GrowingAlignedDataBuffer& sumBuffer,
+    unsigned laneIndex,
+    unsigned sumIndex,
+    unsigned element)
+{
+    SIAMESE_DEBUG_ASSERT((element + ColumnStart) % kColumnLaneCount == laneIndex);
+    OriginalPacket* original     = GetWindowElement(element);
+    const unsigned originalBytes = original->Buffer.Bytes;
+
+    Logger.Info("Lane ", laneIndex,  " sum ",  sumIndex,  " accumulating column: ",  element + ColumnStart,  ". Got = ",  (originalBytes > 0));
+
+    if (originalBytes > 0)
+    {
+        SIAMESE_DEBUG_ASSERT(original->Column % kColumnLaneCount == laneIndex);
+        if (originalBytes > sumBuffer.Bytes)
+        {
+            // Grow sum to encompass the original data
+            if (!sumBuffer.GrowZeroPaddedAmortized(TheAllocator, originalBytes)) {
+                return false;
+            }
+        }
+
+        // Sum += PacketData
+        if (sumIndex == 0)
+            gf256_add_mem(sumBuffer.Data, original->Buffer.Data, originalBytes);
+        else
+        {
+            uint8_t CX = GetColumnValue(original->Column);
+            if (sumIndex == 2)
+                CX = gf256_sqr(CX);
+
+            // Sum += CX * PacketData
+            gf256_muladd_mem(sumBuffer.Data, CX, original->Buffer.Data, originalBytes);
+        }
+    }
+
+    SIAMESE_DEBUG_ASSERT(original->Buffer.Bytes == 0 || original->Column % kColumnLaneCount == laneIndex);
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// DecoderPacketWindow : Running Sum Checkpoints
+
+void DecoderPacketWindow::StartSumCheckpoints(unsigned elementStart)
+{
+    const unsigned count = SumCheckpoints.GetSize();
+
+    // Keep the start point while any snapshot or base is relative to it
+    if (HasSumCheckpoints)
+    {
+        for (unsigned i = 0; i < count; ++i) {
+            if (SumCheckpoints.GetRef(i)->ValidMask != 0) {
+                return;
+            }
+        }
+        for (unsigned laneIndex = 0; laneIndex < kColumnLaneCount; ++laneIndex) {
+            for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex) {
+                if (Lanes[laneIndex].Sums[sumIndex].BaseState == SumCheckpointBase::Valid) {
+                    return;
+                }
+            }
+        }
+    }
+
+    Logger.Info("Starting sum checkpoints at ", elementStart);
+
+    // First checkpoint is one interval after the next subwindow boundary
+    const unsigned roundedStart = elementStart + kSubwindowSize - 1;
+    const unsigned firstElement = roundedStart - (roundedStart % kSubwindowSize) + kDecoderCheckpointInterval;
+
+    SumCheckpointColumnFirst   = ElementToColumn(firstElement);
+    SumCheckpointColumnStart   = ElementToColumn(elementStart);
+    SumCheckpointStartInWindow = true;
+    HasSumCheckpoints          = true;
+}
+
+bool DecoderPacketWindow::PrepareSumCheckpointBase(unsigned laneIndex, unsigned sumIndex)
+{
+    DecoderSum& sum = Lanes[laneIndex].Sums[sumIndex];
+
+    if (sum.BaseState == SumCheckpointBase::Valid) {
+        return true;
+    }
+    if (sum.BaseState == SumCheckpointBase::Unavailable) {
+        return false;
+    }
+
+    const unsigned sumStart = sum.ElementStart;
+
+    // Find the nearest known point to the sum start, on either side.
+    // The checkpoint start point itself is known to be an empty sum
+    const GrowingAlignedDataBuffer* snapshot = nullptr;
+    unsigned snapshotElement = 0;
+    unsigned bestDistance    = ~(unsigned)0;
+
+    if (SumCheckpointStartInWindow)
+    {
+        snapshotElement = GetNextLaneElement(ColumnToElement(SumCheckpointColumnStart), laneIndex);
+        bestDistance    = (sumStart >= snapshotElement) ? sumStart - snapshotElement : snapshotElement - sumStart;
+    }
+
+    const unsigned firstElement = GetFirstSumCheckpointElement() + laneIndex;
+    const unsigned count        = SumCheckpoints.GetSize();
+    const uint32_t validBit     = 1u << (laneIndex * kColumnSumCount + sumIndex);
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        if (0 == (SumCheckpoints.GetRef(i)->ValidMask & validBit)) {
+            continue;
+        }
+
+        const unsigned checkpointElement = firstElement + i * kDecoderCheckpointInterval;
+        const unsigned distance = (sumStart >= checkpointElement) ? sumStart - checkpointElement : checkpointElement - sumStart;
+        if (distance < bestDistance)
+        {
+            bestDistance    = distance;
+            snapshot        = &SumCheckpoints.GetRef(i)->Sums[laneIndex][sumIndex];
+            snapshotElement = checkpointElement;
+        }
+    }
+
+    // If there is nothing to start from:
+    if (bestDistance == ~(unsigned)0) {
+        return false;
+    }
+
+    GrowingAlignedDataBuffer& base = sum.CheckpointBase;
+    const GrowingAlignedDataBuffer empty;
+
+    if (!AddSumSnapshot(TheAllocator, base, snapshot ? *snapshot : empty, empty))
+    {
+        EmergencyDisabled = true;
+        return false;
+    }
+
+    // Base = Snapshot +/- the elements between the snapshot and the sum start
+    unsigned element    = (snapshotElement < sumStart) ? snapshotElement : sumStart;
+    unsigned elementEnd = (snapshotElement < sumStart) ? sumStart : snapshotElement;
+    for (; element < elementEnd; element += kColumnLaneCount)
+    {
+        if (!AccumulateSumElement(base, laneIndex, sumIndex, element))
+        {
+            EmergencyDisabled = true;
+            return false;
+        }
+    }
+
+    sum.BaseState = SumCheckpointBase::Valid;
     return true;
 }
 
-void DecoderPacketWindow::ResetSums(unsigned elementStart)
+bool DecoderPacketWindow::LoadSumCheckpoint(unsigned laneIndex, unsigned sumIndex, unsigned elementEnd)
 {
-    Logger.Info("ResetSums at ", elementStart);
+    DecoderSum& sum = Lanes[laneIndex].Sums[sumIndex];
+    SIAMESE_DEBUG_ASSERT(sum.BaseState == SumCheckpointBase::Valid);
 
-    // For each lane:
-    for (unsigned laneIndex = 0; laneIndex < kColumnLaneCount; ++laneIndex)
+    const unsigned firstElement = GetFirstSumCheckpointElement() + laneIndex;
+    const unsigned count        = SumCheckpoints.GetSize();
+    if (count <= 0 || elementEnd < firstElement) {
+        return true;
+    }
+
+    const uint32_t validBit = 1u << (laneIndex * kColumnSumCount + sumIndex);
+
+    // Start from the last checkpoint that does not pass the end element
+    unsigned i = (elementEnd - firstElement) / kDecoderCheckpointInterval;
+    if (i >= count) {
+        i = count - 1;
+    }
+
+    // Search backwards for a valid checkpoint ahead of the sum:
+    for (;;)
     {
-        // Find the next window element that is in this lane beginning at `elementStart`
-        const unsigned laneElementStart = GetNextLaneElement(elementStart, laneIndex);
+        const unsigned checkpointElement = firstElement + i * kDecoderCheckpointInterval;
+        if (checkpointElement <= sum.ElementEnd) {
+            break;
+        }
 
-        // For each of the sums in the lane:
-        for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex)
+        SumCheckpoint* checkpoint = SumCheckpoints.GetRef(i);
+        if (checkpoint->ValidMask & validBit)
         {
-            // Clear the buffer and element start/end range
-            DecoderSum& sum  = Lanes[laneIndex].Sums[sumIndex];
-            sum.ElementStart = laneElementStart;
-            sum.ElementEnd   = laneElementStart;
-            sum.Buffer.Bytes = 0;
+            // Sum = Snapshot - Base
+            if (!AddSumSnapshot(TheAllocator, sum.Buffer, checkpoint->Sums[laneIndex][sumIndex], sum.CheckpointBase)) {
+                return false;
+            }
+
+            Logger.Debug("Lane ", laneIndex, " sum ", sumIndex, " resumed from checkpoint at column ", checkpointElement + ColumnStart);
+
+            sum.ElementEnd = checkpointElement;
+            Stats->Counts[SiameseDecoderStats_SumCheckpointCount]++;
+            break;
+        }
+
+        if (i == 0) {
+            break;
         }
+        --i;
     }
 
-    // Clear recovered packets to avoid double-plugging holes in the sums
-    RecoveredColumns.Clear();
+    return true;
 }
 
-bool DecoderPacketWindow::StartSums(unsigned elementStart, unsigned bufferBytes)
+bool DecoderPacketWindow::SaveSumCheckpoint(unsigned checkpointIndex, unsigned laneIndex, unsigned sumIndex)
 {
-    for (unsigned laneIndex = 0; laneIndex < kColumnLaneCount; ++laneIndex)
+    const unsigned count = SumCheckpoints.GetSize();
+
+    // If the checkpoint list must grow:
+    if (checkpointIndex >= count)
     {
-        // Get the next window element in this lane beginning with `elementStart`
-        const unsigned laneElementStart = GetNextLaneElement(elementStart, laneIndex);
+        // Note resizing larger will keep old data in the vector
+        if (!SumCheckpoints.SetSize_Copy(checkpointIndex + 1)) {
+            return false;
+        }
 
-        for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex)
+        for (unsigned i = count; i <= checkpointIndex; ++i)
         {
-            DecoderSum& sum = Lanes[laneIndex].Sums[sumIndex];
-
-            // If the sum contains no data or starts in a different place:
-            if (sum.Buffer.Bytes == 0)
-            {
-                Logger.Debug("Re-Restarting sum for ", laneIndex, " sum ", sumIndex, " at column ", laneElementStart + ColumnStart, " current sum bytes = ", sum.Buffer.Bytes);
-
-                sum.ElementEnd = laneElementStart;
-            }
-            else if (sum.ElementStart != laneElementStart)
+            SumCheckpoint* checkpoint = TheAllocator->Construct<SumCheckpoint>();
+            if (!checkpoint)
             {
-                Logger.Debug("Restarting sum for ", laneIndex, " sum ", sumIndex, " at column ", laneElementStart + ColumnStart, " current sum bytes = ", sum.Buffer.Bytes);
-
-                sum.ElementEnd = laneElementStart;
-                sum.Buffer.Bytes = 0;
+                SumCheckpoints.SetSize_Copy(i);
+                return false; // Out of memory
             }
 
-            // Update the start element
-            sum.ElementStart = laneElementStart;
+            SumCheckpoints.GetRef(i) = checkpoint;
+        }
+    }
 
-            // Grow and zero pad
-            if (!sum.Buffer.GrowZeroPadded(TheAllocator, bufferBytes)) {
-                return false;
-            }
+    SumCheckpoint* checkpoint = SumCheckpoints.GetRef(checkpointIndex);
+    const uint32_t validBit = 1u << (laneIndex * kColumnSumCount + sumIndex);
 
-            SIAMESE_DEBUG_ASSERT((sum.ElementStart + ColumnStart) % kColumnLaneCount == laneIndex);
-            SIAMESE_DEBUG_ASSERT((sum.ElementEnd   + ColumnStart) % kColumnLaneCount == laneIndex);
-        }
+    // If this snapshot was already taken:
+    if (checkpoint->ValidMask & validBit) {
+        return true;
     }
 
-    // If we have previously recovered packets, use them to plug holes in the sums:
-    if (RecoveredColumns.GetSize() != 0) {
-        // If holes cannot be plugged:
-        if (!PlugSumHoles(elementStart)) {
-            SIAMESE_DEBUG_BREAK(); // Should never happen
-            return false;
-        }
+    const DecoderSum& sum = Lanes[laneIndex].Sums[sumIndex];
+    SIAMESE_DEBUG_ASSERT(sum.BaseState == SumCheckpointBase::Valid);
+
+    // Snapshot = Sum + Base
+    if (!AddSumSnapshot(TheAllocator, checkpoint->Sums[laneIndex][sumIndex], sum.Buffer, sum.CheckpointBase)) {
+        return false;
     }
 
+    checkpoint->ValidMask |= validBit;
     return true;
 }
 
-const GrowingAlignedDataBuffer* DecoderPacketWindow::GetSum(unsigned laneIndex, unsigned sumIndex, unsigned elementEnd)
+void DecoderPacketWindow::InvalidateSumCheckpoints(unsigned element)
 {
-    DecoderSum& sum = Lanes[laneIndex].Sums[sumIndex];
-
-    SIAMESE_DEBUG_ASSERT(sum.ElementStart <= sum.ElementEnd);
-    SIAMESE_DEBUG_ASSERT((sum.ElementStart + ColumnStart) % kColumnLaneCount == laneIndex);
-    SIAMESE_DEBUG_ASSERT((sum.ElementEnd + ColumnStart) % kColumnLaneCount == laneIndex);
-
-    unsigned element = sum.ElementEnd;
-    if (element >= elementEnd) {
-        return &sum.Buffer;
+    if (!HasSumCheckpoints) {
+        return;
     }
 
-    // For each element to accumulate in this lane:
-    do
+    // If the element is not before the checkpoint start point:
+    if (!SumCheckpointStartInWindow ||
+        element >= ColumnToElement(SumCheckpointColumnStart))
     {
-        SIAMESE_DEBUG_ASSERT((element + ColumnStart) % kColumnLaneCount == laneIndex);
-        OriginalPacket* original     = GetWindowElement(element);
-        const unsigned originalBytes = original->Buffer.Bytes;
+        // Snapshots after the element include it
+        const unsigned firstElement = GetFirstSumCheckpointElement();
+        const unsigned count        = SumCheckpoints.GetSize();
+        unsigned i = 0;
+        if (element >= firstElement) {
+            i = (element - firstElement) / kDecoderCheckpointInterval + 1;
+        }
 
-        Logger.Info("Lane ", laneIndex,  " sum ",  sumIndex,  " accumulating column: ",  element + ColumnStart,  ". Got = ",  (originalBytes > 0));
+        for (; i < count; ++i) {
+            SumCheckpoints.GetRef(i)->ValidMask = 0;
+        }
+    }
 
-        if (originalBytes > 0)
-        {
-            SIAMESE_DEBUG_ASSERT(original->Column % kColumnLaneCount == laneIndex);
-            if (originalBytes > sum.Buffer.Bytes)
-            {
-                // Grow sum to encompass the original data
-                if (!sum.Buffer.GrowZeroPadded(TheAllocator, originalBytes))
-                {
-                    EmergencyDisabled = true;
-                    goto ExitSum;
-                }
-            }
+    // Bases for sums in this lane that start after the element may include it
+    DecoderColumnLane& lane = Lanes[ElementToColumn(element) % kColumnLaneCount];
+    for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex)
+    {
+        DecoderSum& sum = lane.Sums[sumIndex];
+        if (sum.BaseState == SumCheckpointBase::Valid && element < sum.ElementStart) {
+            sum.BaseState = SumCheckpointBase::Unknown;
+        }
+    }
+}
 
-            // Sum += PacketData
-            if (sumIndex == 0)
-                gf256_add_mem(sum.Buffer.Data, original->Buffer.Data, originalBytes);
-            else
-            {
-                uint8_t CX = GetColumnValue(original->Column);
-                if (sumIndex == 2)
-                    CX = gf256_sqr(CX);
+void DecoderPacketWindow::RemoveSumCheckpoints(unsigned removedElementCount)
+{
+    if (!HasSumCheckpoints) {
+        return;
+    }
 
-                // Sum += CX * PacketData
-                gf256_muladd_mem(sum.Buffer.Data, CX, original->Buffer.Data, originalBytes);
-            }
-        }
+    // If the start point is removed, then only the differences between
+    // snapshots are still useful
+    if (SumCheckpointStartInWindow &&
+        ColumnToElement(SumCheckpointColumnStart) < removedElementCount)
+    {
+        SumCheckpointStartInWindow = false;
+    }
 
-        SIAMESE_DEBUG_ASSERT(original->Buffer.Bytes == 0 || original->Column % kColumnLaneCount == laneIndex);
-        element += kColumnLaneCount;
-    } while (element < elementEnd);
+    const unsigned firstElement = GetFirstSumCheckpointElement();
+    if (firstElement >= removedElementCount) {
+        return;
+    }
 
-    SIAMESE_DEBUG_ASSERT((element + ColumnStart) % kColumnLaneCount == laneIndex);
+    // Skip checkpoints that are in the removed region
+    const unsigned removedCount = (removedElementCount - firstElement + kDecoderCheckpointInterval - 1) / kDecoderCheckpointInterval;
+    SumCheckpointColumnFirst = AddColumns(SumCheckpointColumnFirst, removedCount * kDecoderCheckpointInterval);
 
-    sum.ElementEnd = element;
+    const unsigned count = SumCheckpoints.GetSize();
+    for (unsigned i = 0; i < count && i < removedCount; ++i) {
+        SumCheckpoints.GetRef(i)->ValidMask = 0;
+    }
 
-ExitSum:
-    return &sum.Buffer;
+    // Removed checkpoints are moved to the end for later reuse
+    if (removedCount < count)
+    {
+        SumCheckpoint** checkpoints = SumCheckpoints.GetPtr(0);
+        std::rotate(checkpoints, checkpoints + removedCount, checkpoints + count);
+    }
 }
 
 /*
@@ -1792,9 +3315,11 @@ void DecoderPacketWindow::RemoveElements()
     unsigned targetSumColumnCount = 0;
     unsigned initialRecoveryBytes = 0;
     bool seenSum = false;
+    bool seenEliminatedSum = false;
 
     // If there are no recovery packets in the list:
-    const RecoveryPacket* recovery = RecoveryPackets->Head;
+    unsigned recoveryIndex = RecoveryPackets->HeadIndex;
+    const RecoveryPacket* recovery = RecoveryPackets->Head();
     if (!recovery)
     {
         const RecoveryMetadata metadata = RecoveryPackets->LastRecoveryMetadata;
@@ -1836,7 +3361,11 @@ void DecoderPacketWindow::RemoveElements()
             if (sumCount > SIAMESE_CAUCHY_THRESHOLD)
 #endif
             {
-                if (!seenSum)
+                // If IdleWork() eliminated this row it no longer needs the sums
+                if (recovery->Eliminated) {
+                    seenEliminatedSum = true;
+                }
+                else if (!seenSum)
                 {
                     // This should only take the first sum start/count into
                     // account because if we accumulate any data it will be
@@ -1869,10 +3398,10 @@ void DecoderPacketWindow::RemoveElements()
             }
 
             // Try next recovery packet
-            recovery = recovery->Next;
-            if (!recovery) {
+            if (++recoveryIndex == RecoveryPackets->EndIndex()) {
                 break;
             }
+            recovery = RecoveryPackets->GetPacket(recoveryIndex);
 
             // If we found an earlier element, use it:
             if (firstKeptElement > recovery->ElementStart) {
@@ -1882,6 +3411,15 @@ void DecoderPacketWindow::RemoveElements()
                 initialRecoveryBytes = recovery->Buffer.Bytes;
             }
         }
+
+        // If all the rows with running sums were eliminated, then keep the
+        // running sums where they are for the next recovery packets
+        if (!seenSum && seenEliminatedSum && SumColumnCount != 0)
+        {
+            targetSumStartColumn = SumColumnStart;
+            targetSumColumnCount = SumColumnCount;
+            seenSum = true;
+        }
     }
 
     // If we have not hit a threshold yet:
@@ -1953,8 +3491,14 @@ void DecoderPacketWindow::RemoveElements()
                 if (Lanes[laneIndex].Sums[sumIndex].ElementStart >= removedElementCount) {
                     Lanes[laneIndex].Sums[sumIndex].ElementStart -= removedElementCount;
                 }
-                else {
+                else
+                {
                     Lanes[laneIndex].Sums[sumIndex].ElementStart = laneIndex;
+
+                    // The base cannot be calculated once the start is removed
+                    if (Lanes[laneIndex].Sums[sumIndex].BaseState == SumCheckpointBase::Unknown) {
+                        Lanes[laneIndex].Sums[sumIndex].BaseState = SumCheckpointBase::Unavailable;
+                    }
                 }
 
                 SIAMESE_DEBUG_ASSERT(Lanes[laneIndex].Sums[sumIndex].ElementEnd >= removedElementCount);
@@ -1976,43 +3520,22 @@ void DecoderPacketWindow::RemoveElements()
         SumColumnCount = 0;
     }
 
-    // Reset windows before putting them on the back
-    for (unsigned i = 0; i < firstKeptSubwindow; ++i) {
-        Subwindows.GetRef(i)->Reset();
-    }
-
-    // Shift kept subwindows to the front of the vector:
+    // Drop running sum checkpoints that are being removed
+    RemoveSumCheckpoints(removedElementCount);
 
-    // Resize a temporary buffer for removed subwindows
-    if (!SubwindowsShift.SetSize_NoCopy(firstKeptSubwindow))
+    // Reset windows before putting them on the back
+    for (unsigned i = 0; i < firstKeptSubwindow; ++i)
     {
-        SIAMESE_DEBUG_BREAK(); // OOM
-        EmergencyDisabled = true;
-        return;
+        DecoderSubwindow* subwindow = Subwindows.GetRef(i);
+        if (subwindow != EmptySubwindow) {
+            subwindow->Reset();
+        }
     }
+    GotBitmap.RemoveWords(firstKeptSubwindow);
+    LossRanges.RemoveElements(removedElementCount);
 
-    // Store removed subwindows temporarily
-    memcpy(
-        SubwindowsShift.GetPtr(0),
-        Subwindows.GetPtr(0),
-        firstKeptSubwindow * sizeof(DecoderSubwindow*)
-    );
-
-    const unsigned subwindowsShifted = Subwindows.GetSize() - firstKeptSubwindow;
-
-    // Shift subwindows to front that are being kept
-    memmove(
-        Subwindows.GetPtr(0),
-        Subwindows.GetPtr(firstKeptSubwindow),
-        subwindowsShifted * sizeof(DecoderSubwindow*)
-    );
-
-    // Removed subwindows are moved to the end (unordered) for later reuse
-    memcpy(
-        Subwindows.GetPtr(subwindowsShifted),
-        SubwindowsShift.GetPtr(0),
-        firstKeptSubwindow * sizeof(DecoderSubwindow*)
-    );
+    // Removed subwindows are recycled at the back of the ring
+    Subwindows.RotateFront(firstKeptSubwindow);
 
     // Update the count of elements in the window
     SIAMESE_DEBUG_ASSERT(Count >= removedElementCount);
@@ -2073,56 +3596,31 @@ void RecoveryMatrixState::PopulateColumns(const unsigned oldColumns, const unsig
     // The column count increased which means we should have some columns to check
     SIAMESE_DEBUG_ASSERT(elementStart < elementEnd);
 
-    // Check the current subwindow for next lost packet:
-    const unsigned subwindowEnd = (elementEnd + kSubwindowSize - 1) / kSubwindowSize;
-    unsigned subwindowIndex     = elementStart / kSubwindowSize;
-
-    unsigned bitIndex = elementStart % kSubwindowSize;
-    unsigned column   = oldColumns;
+    unsigned column = oldColumns;
 
-    while (subwindowIndex < subwindowEnd)
+    // For each lost element in the new part of the region:
+    for (unsigned element = Window->GotBitmap.FindFirstClear(elementStart, elementEnd);
+        element < elementEnd;
+        element = Window->GotBitmap.FindFirstClear(element + 1, elementEnd))
     {
-        SIAMESE_DEBUG_ASSERT(subwindowIndex < Window->Subwindows.GetSize());
-
-        DecoderSubwindow* subwindowPtr = Window->Subwindows.GetRef(subwindowIndex);
-
-        // If there may be any lost packets in this subwindow:
-        if (subwindowPtr->GotCount < kSubwindowSize)
+        ColumnInfo* columnPtr = Columns.GetPtr(column);
+        columnPtr->Column     = Window->ElementToColumn(element);
+        columnPtr->Original   = Window->GetWritableWindowElement(element);
+        if (!columnPtr->Original)
         {
-            do
-            {
-                // Seek next clear bit
-                bitIndex = subwindowPtr->Got.FindFirstClear(bitIndex);
-
-                // If there were none, skip this subwindow
-                if (bitIndex >= kSubwindowSize)
-                    break;
-
-                // Calculate element index and stop if we hit the end of the valid data
-                const unsigned element = subwindowIndex * kSubwindowSize + bitIndex;
-                SIAMESE_DEBUG_ASSERT(element < elementEnd);
-
-                ColumnInfo* columnPtr = Columns.GetPtr(column);
-                columnPtr->Column     = Window->ElementToColumn(element);
-                columnPtr->Original   = &subwindowPtr->Originals[bitIndex];
-                columnPtr->CX         = GetColumnValue(columnPtr->Column);
-
-                // Point lost original packet to recovery matrix column
-                SIAMESE_DEBUG_ASSERT(columnPtr->Original->Buffer.Bytes == 0);
-                columnPtr->Original->Column = column;
-
-                // If we just added the last column:
-                if (++column >= newColumns)
-                    return;
-
-            } while (++bitIndex < kSubwindowSize);
+            Window->EmergencyDisabled = true;
+            Logger.Error("PopulateColumns.GetWritableWindowElement OOM");
+            return;
         }
+        columnPtr->CX         = GetColumnValue(columnPtr->Column);
 
-        // Reset bit index to the front of the next subwindow
-        bitIndex = 0;
+        // Point lost original packet to recovery matrix column
+        SIAMESE_DEBUG_ASSERT(columnPtr->Original->Buffer.Bytes == 0);
+        columnPtr->Original->Column = column;
 
-        // Check next subwindow
-        ++subwindowIndex;
+        // If we just added the last column:
+        if (++column >= newColumns)
+            return;
     }
 
     SIAMESE_DEBUG_BREAK(); // Should never get here
@@ -2136,15 +3634,10 @@ void RecoveryMatrixState::PopulateRows(const unsigned oldRows, const unsigned ne
 
     Rows.SetSize_Copy(newRows);
 
-    RecoveryPacket* recovery;
-    if (oldRows > 0)
-        recovery = Rows.GetRef(oldRows - 1).Recovery->Next;
-    else
-        recovery = CheckedRegion->FirstRecovery;
-    SIAMESE_DEBUG_ASSERT(recovery);
-
-    for (unsigned rowIndex = oldRows; rowIndex < newRows; ++rowIndex, recovery = recovery->Next)
+    // Rows are the recovery packets of the checked region in list order
+    for (unsigned rowIndex = oldRows; rowIndex < newRows; ++rowIndex)
     {
+        RecoveryPacket* recovery = RecoveryPackets->GetPacket(CheckedRegion->FirstRecovery + rowIndex);
         RowInfo* rowPtr = Rows.GetPtr(rowIndex);
         rowPtr->Recovery          = recovery;
         rowPtr->UsedForSolution   = false;
@@ -2184,6 +3677,11 @@ bool RecoveryMatrixState::GenerateMatrix()
     }
 
     PopulateColumns(oldColumns, columns);
+    if (Window->EmergencyDisabled)
+    {
+        Reset();
+        return false;
+    }
     PopulateRows(oldRows, rows);
 
     const unsigned stride = Matrix.AllocatedColumns;
@@ -2277,27 +3775,11 @@ bool RecoveryMatrixState::GenerateMatrix()
 
             // Generate opcode and parameters
             const uint8_t CX      = Columns.GetRef(j).CX;
-            const uint8_t CX2     = gf256_sqr(CX);
             const unsigned lane   = column % kColumnLaneCount;
             const unsigned opcode = GetRowOpcode(lane, metadata.Row);
 
-            unsigned value = 0;
-
             // Interpret opcode to calculate matrix row element j
-            if (opcode & 1)
-                value ^= 1;
-            if (opcode & 2)
-                value ^= CX;
-            if (opcode & 4)
-                value ^= CX2;
-            if (opcode & 8)
-                value ^= RX;
-            if (opcode & 16)
-                value ^= gf256_mul(CX, RX);
-            if (opcode & 32)
-                value ^= gf256_mul(CX2, RX);
-
-            rowData[j] = (uint8_t)value;
+            rowData[j] = GetOpcodeValue(opcode, CX, RX);
         }
 
         if (pDebugMsg)
@@ -2531,6 +4013,79 @@ NextPivot:;
 }
 
 
+//------------------------------------------------------------------------------
+// CauchySolverState
+
+bool CauchySolverState::GenerateInverse()
+{
+    const unsigned n = Elements.GetSize();
+    SIAMESE_DEBUG_ASSERT(n > 0 && Rows.GetSize() == n);
+
+    if (!RowScale.SetSize_NoCopy(n) || !Inverse.SetSize_NoCopy(n * n)) {
+        return false;
+    }
+
+    // A(i) = Q(X(i)) / Prod(k != i: X(i) + X(k))
+    for (unsigned i = 0; i < n; ++i)
+    {
+        if ((int)i == ParityIndex) {
+            continue;
+        }
+
+        const uint8_t x = RowX.GetRef(i);
+        uint8_t numerator = 1, denominator = 1;
+
+        for (unsigned j = 0; j < n; ++j) {
+            numerator = gf256_mul(numerator, x ^ ColumnY.GetRef(j));
+        }
+        for (unsigned k = 0; k < n; ++k)
+        {
+            if (k != i && (int)k != ParityIndex) {
+                denominator = gf256_mul(denominator, x ^ RowX.GetRef(k));
+            }
+        }
+
+        RowScale.GetRef(i) = gf256_div(numerator, denominator);
+    }
+
+    // Inverse(j, i) = C(j) * A(i) / (X(i) + Y(j)), or C(j) for the parity row
+    for (unsigned j = 0; j < n; ++j)
+    {
+        const uint8_t y = ColumnY.GetRef(j);
+        uint8_t numerator = 1, denominator = 1;
+
+        // C(j) = P(Y(j)) / Prod(k != j: Y(j) + Y(k))
+        for (unsigned i = 0; i < n; ++i)
+        {
+            if ((int)i != ParityIndex) {
+                numerator = gf256_mul(numerator, y ^ RowX.GetRef(i));
+            }
+        }
+        for (unsigned k = 0; k < n; ++k)
+        {
+            if (k != j) {
+                denominator = gf256_mul(denominator, y ^ ColumnY.GetRef(k));
+            }
+        }
+        const uint8_t c = gf256_div(numerator, denominator);
+
+        uint8_t* inverseRow = Inverse.GetPtr(j * n);
+        for (unsigned i = 0; i < n; ++i)
+        {
+            if ((int)i == ParityIndex) {
+                inverseRow[i] = c;
+            }
+            else {
+                const uint8_t x = RowX.GetRef(i);
+                inverseRow[i] = gf256_div(gf256_mul(c, RowScale.GetRef(i)), x ^ y);
+            }
+        }
+    }
+
+    return true;
+}
+
+
 //------------------------------------------------------------------------------
 // CheckedRegionState
 
@@ -2538,8 +4093,8 @@ void CheckedRegionState::Reset()
 {
     ElementStart   = 0;
     NextCheckStart = 0;
-    FirstRecovery  = nullptr;
-    LastRecovery   = nullptr;
+    FirstRecovery  = 0;
+    LastRecovery   = 0;
     RecoveryCount  = 0;
     LostCount      = 0;
     SolveFailed    = false;
@@ -2564,60 +4119,91 @@ void CheckedRegionState::DecrementElementCounters(const unsigned elementCount)
 //------------------------------------------------------------------------------
 // RecoveryPacketList
 
-void RecoveryPacketList::Insert(RecoveryPacket* recovery, bool outOfOrder)
+/// Initial number of recovery packets the ring can hold before it grows
+static const unsigned kRecoveryRingInitialSize = 32;
+static_assert((kRecoveryRingInitialSize & (kRecoveryRingInitialSize - 1)) == 0, "Must be a power of two");
+
+bool RecoveryPacketList::GrowRing()
+{
+    const unsigned oldSize = Ring ? RingMask + 1 : 0;
+    const unsigned newSize = oldSize ? oldSize * 2 : kRecoveryRingInitialSize;
+
+    RecoveryPacket** newRing = reinterpret_cast<RecoveryPacket**>(
+        TheAllocator->Allocate(newSize * sizeof(RecoveryPacket*)));
+    if (!newRing) {
+        return false;
+    }
+
+    // Copy the packets over, keeping each at the same index
+    const unsigned newMask = newSize - 1;
+    for (unsigned i = 0; i < RecoveryPacketCount; ++i)
+    {
+        const unsigned index = HeadIndex + i;
+        newRing[index & newMask] = Ring[index & RingMask];
+    }
+
+    TheAllocator->Free(reinterpret_cast<uint8_t*>(Ring));
+    Ring     = newRing;
+    RingMask = newMask;
+    return true;
+}
+
+bool RecoveryPacketList::Insert(RecoveryPacket* recovery, bool outOfOrder)
 {
-    RecoveryPacket* prev = Tail;
-    RecoveryPacket* next = nullptr;
+    if (!Ring || RecoveryPacketCount > RingMask)
+    {
+        if (!GrowRing()) {
+            return false;
+        }
+    }
 
     const unsigned recoveryStart = recovery->Metadata.ColumnStart;
     const unsigned recoveryEnd   = recovery->ElementEnd;
 
-    // Search for insertion point:
-    for (; prev; next = prev, prev = prev->Prev)
+    /*
+        This insertion order guarantees that the left and right side of
+        the recovery input ranges are monotonically increasing as in:
+
+            recovery 0: 012345
+            recovery 1:   23456 <- Cauchy row
+            recovery 2: 01234567
+            recovery 3:     45678
+            recovery 4:     456789
+
+        The new packet goes after every packet that ends before it, and after
+        packets that end at the same place but start after it.  The packets
+        that it goes after are all at the front of the list, so the insertion
+        point is found by binary search.  Usually it is the end of the list.
+    */
+    unsigned low = 0, high = RecoveryPacketCount;
+    while (low < high)
     {
-        const unsigned prevStart = prev->Metadata.ColumnStart;
-        const unsigned prevEnd   = prev->ElementEnd;
-
-        /*
-            This insertion order guarantees that the left and right side of
-            the recovery input ranges are monotonically increasing as in:
-
-                recovery 0: 012345
-                recovery 1:   23456 <- Cauchy row
-                recovery 2: 01234567
-                recovery 3:     45678
-                recovery 4:     456789
-        */
-        if (recoveryEnd >= prevEnd)
+        const unsigned mid = (low + high) / 2;
+        const RecoveryPacket* prev = Ring[(HeadIndex + mid) & RingMask];
+        const unsigned prevStart   = prev->Metadata.ColumnStart;
+        const unsigned prevEnd     = prev->ElementEnd;
+
+        if (recoveryEnd > prevEnd ||
+            (recoveryEnd == prevEnd &&
+             IsColumnDeltaNegative(SubtractColumns(recoveryStart, prevStart))))
         {
-            if (recoveryEnd > prevEnd) {
-                break;
-            }
-            if (IsColumnDeltaNegative(SubtractColumns(recoveryStart, prevStart))) {
-                break;
-            }
+            low = mid + 1;
+        }
+        else {
+            high = mid;
         }
     }
 
-    // Insert into linked list
-    recovery->Next = next;
-    recovery->Prev = prev;
-    if (prev) {
-        prev->Next = recovery;
-    }
-    else {
-        Head = recovery;
-    }
-    if (next) {
-        next->Prev = recovery;
-    }
-    else {
-        Tail = recovery;
+    // Shift newer packets up one index to make room
+    const unsigned insertIndex = HeadIndex + low;
+    for (unsigned index = EndIndex(); index != insertIndex; --index) {
+        Ring[index & RingMask] = Ring[(index - 1) & RingMask];
     }
+    Ring[insertIndex & RingMask] = recovery;
 
     // If inserting at head or somewhere in the middle:
     // Invalidate the checked region because a smaller solution may be available
-    if (!prev || next) {
+    if (low == 0 || low < RecoveryPacketCount) {
         CheckedRegion->Reset();
     }
     // Note that for the case where we insert at the end of a non-empty list we do
@@ -2632,43 +4218,35 @@ void RecoveryPacketList::Insert(RecoveryPacket* recovery, bool outOfOrder)
         LastRecoveryMetadata = recovery->Metadata;
         LastRecoveryBytes = recovery->Buffer.Bytes;
     }
+
+    return true;
 }
 
 void RecoveryPacketList::DeletePacketsBefore(const unsigned element)
 {
-    RecoveryPacket* recovery = Head;
-    unsigned deleteCount     = 0;
-
     // Examine recovery packets starting with the oldest
-    for (RecoveryPacket* next; recovery; recovery = next)
+    while (RecoveryPacketCount > 0)
     {
+        RecoveryPacket* recovery = Ring[HeadIndex & RingMask];
+
         // Stop once we eclipse the element
-        if (recovery->ElementEnd > element)
+        if (recovery->ElementEnd > element) {
             break;
+        }
 
-        next = recovery->Next;
         recovery->Buffer.Free(TheAllocator);
         TheAllocator->Destruct(recovery);
-        ++deleteCount;
-    }
-
-    Head = recovery;
-    if (recovery)
-    {
-        recovery->Prev = nullptr;
-        RecoveryPacketCount -= deleteCount;
-    }
-    else
-    {
-        Tail = nullptr;
-        RecoveryPacketCount = 0;
+        ++HeadIndex;
+        --RecoveryPacketCount;
     }
 }
 
 void RecoveryPacketList::DecrementElementCounters(const unsigned elementCount)
 {
-    for (RecoveryPacket* recovery = Head; recovery; recovery = recovery->Next)
+    for (unsigned i = 0; i < RecoveryPacketCount; ++i)
     {
+        RecoveryPacket* recovery = Ring[(HeadIndex + i) & RingMask];
+
         SIAMESE_DEBUG_ASSERT(recovery->ElementEnd >= elementCount);
         recovery->ElementEnd -= elementCount;
 
@@ -2677,22 +4255,11 @@ void RecoveryPacketList::DecrementElementCounters(const unsigned elementCount)
     }
 }
 
-void RecoveryPacketList::Delete(RecoveryPacket* recovery)
+void RecoveryPacketList::DeleteHead()
 {
-    SIAMESE_DEBUG_ASSERT(recovery);
-    RecoveryPacket* prev = recovery->Prev;
-    RecoveryPacket* next = recovery->Next;
-
-    if (prev)
-        prev->Next = next;
-    else
-        Head = next;
-
-    if (next)
-        next->Prev = prev;
-    else
-        Tail = prev;
-
+    SIAMESE_DEBUG_ASSERT(RecoveryPacketCount > 0);
+    RecoveryPacket* recovery = Ring[HeadIndex & RingMask];
+    ++HeadIndex;
     --RecoveryPacketCount;
 
     recovery->Buffer.Free(TheAllocator);
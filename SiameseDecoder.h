@@ -128,6 +128,11 @@ struct DecoderSum
 
     /// Running sum
     GrowingAlignedDataBuffer Buffer;
+
+    /// Checkpointed sum of the lane elements before ElementStart.
+    /// Adding this to the running sum gives the value to checkpoint
+    GrowingAlignedDataBuffer CheckpointBase;
+    SumCheckpointBase BaseState = SumCheckpointBase::Unknown;
 };
 
 struct DecoderColumnLane
@@ -137,15 +142,35 @@ struct DecoderColumnLane
 };
 
 
+//------------------------------------------------------------------------------
+// Decoder Sum Checkpoints
+
+/*
+    Running sum checkpoints: See SumCheckpoint
+
+    When the sum start point moves or the sum count shrinks, the running sums
+    must be restarted.  Instead of accumulating the window again, the decoder
+    keeps a snapshot of the sums every kDecoderCheckpointInterval elements,
+    all summed from SumCheckpointColumnStart.  The CheckpointBase of a sum is
+    calculated from the nearest snapshot to its start point, so it only costs
+    a fraction of an interval to produce.
+
+    Snapshots (and bases) are dropped when data arrives for an element they
+    include, so that they always match what would be accumulated from scratch.
+*/
+
+/// Number of window elements between running sum checkpoints.
+/// Each checkpoint holds a copy of every lane sum, so this trades memory for
+/// how far a sum must be accumulated again after it is restarted
+static const unsigned kDecoderCheckpointInterval = 16 * kSubwindowSize;
+static_assert(kDecoderCheckpointInterval % kSubwindowSize == 0, "Checkpoints are on subwindow boundaries");
+
+
 //------------------------------------------------------------------------------
 // RecoveryPacket
 
 struct RecoveryPacket
 {
-    /// Linked list of recovery packets
-    RecoveryPacket* Next = nullptr;
-    RecoveryPacket* Prev = nullptr;
-
     /// Metadata attached to packet
     RecoveryMetadata Metadata;
 
@@ -162,6 +187,10 @@ struct RecoveryPacket
     /// Number of lost packets leading up to the end of this recovery packet range
     unsigned LostCount = 0;
 
+    /// Set once IdleWork() has eliminated the received original data from the
+    /// buffer.  Originals filled in afterwards are eliminated as they arrive
+    bool Eliminated = false;
+
     /// Packet data
     GrowingAlignedDataBuffer Buffer;
 };
@@ -193,9 +222,10 @@ struct CheckedRegionState
     /// Checked recovery region start window element
     unsigned ElementStart = 0;
 
-    /// First and last recovery packets included in the check
-    RecoveryPacket* FirstRecovery = nullptr;
-    RecoveryPacket* LastRecovery = nullptr;
+    /// Indices of the first and last recovery packets included in the check.
+    /// See RecoveryPacketList for how packets are indexed
+    unsigned FirstRecovery = 0;
+    unsigned LastRecovery = 0;
 
     /// One element after the recovery region we have tested
     unsigned NextCheckStart = 0;
@@ -218,14 +248,32 @@ struct CheckedRegionState
 //------------------------------------------------------------------------------
 // RecoveryPacketList
 
+/**
+    Recovery packets are kept sorted in a ring buffer of pointers, which is
+    grown by doubling.  Each packet is addressed by an index that counts up
+    from the first packet ever inserted, so deleting packets from the front
+    only advances HeadIndex and the indices of the remaining packets stay the
+    same.  This lets the checked region remember a range of packets by index.
+    Inserting in the middle shifts the newer packets up by one index, but it
+    also resets the checked region.
+
+    Packets arrive mostly in order so most insertions are at the end, and the
+    insertion point is found with a binary search when they are not.
+    Note that indices wrap around, so loops should compare them with !=.
+*/
 struct RecoveryPacketList
 {
     pktalloc::Allocator* TheAllocator = nullptr;
     CheckedRegionState* CheckedRegion = nullptr;
 
-    /// Sorted list of recovery packets, ordered from oldest to newest
-    RecoveryPacket* Head = nullptr; ///< Oldest recovery packet
-    RecoveryPacket* Tail = nullptr; ///< Newest recovery packet
+    /// Ring buffer of recovery packets, ordered from oldest to newest
+    RecoveryPacket** Ring = nullptr;
+
+    /// Ring size minus one.  The ring size is a power of two
+    unsigned RingMask = 0;
+
+    /// Index of the oldest recovery packet
+    unsigned HeadIndex = 0;
 
     /// Number of recovery packets in the list
     unsigned RecoveryPacketCount = 0;
@@ -236,13 +284,38 @@ struct RecoveryPacketList
 
     SIAMESE_FORCE_INLINE bool IsEmpty() const
     {
-        SIAMESE_DEBUG_ASSERT((RecoveryPacketCount != 0) == (Head != nullptr));
         return RecoveryPacketCount == 0;
     }
 
+    /// Index one past the newest recovery packet
+    SIAMESE_FORCE_INLINE unsigned EndIndex() const
+    {
+        return HeadIndex + RecoveryPacketCount;
+    }
+
+    /// Get the recovery packet at the given index
+    SIAMESE_FORCE_INLINE RecoveryPacket* GetPacket(unsigned index) const
+    {
+        SIAMESE_DEBUG_ASSERT(index - HeadIndex < RecoveryPacketCount);
+        return Ring[index & RingMask];
+    }
+
+    /// Oldest recovery packet, or nullptr if empty
+    SIAMESE_FORCE_INLINE RecoveryPacket* Head() const
+    {
+        return IsEmpty() ? nullptr : Ring[HeadIndex & RingMask];
+    }
+
+    /// Newest recovery packet, or nullptr if empty
+    SIAMESE_FORCE_INLINE RecoveryPacket* Tail() const
+    {
+        return IsEmpty() ? nullptr : Ring[(EndIndex() - 1) & RingMask];
+    }
+
     /// Insert recovery packet into sorted list.
-    /// Out of order RecoveryPackets will not update LastRecoveryMetadata
-    void Insert(RecoveryPacket* packet, bool outOfOrder);
+    /// Out of order RecoveryPackets will not update LastRecoveryMetadata.
+    /// Returns false on OOM
+    bool Insert(RecoveryPacket* packet, bool outOfOrder);
 
     /// Delete all packets before this element
     void DeletePacketsBefore(const unsigned element);
@@ -250,8 +323,154 @@ struct RecoveryPacketList
     /// Decrement all the element counters by a given amount
     void DecrementElementCounters(const unsigned elementCount);
 
-    /// Delete the given recovery packet from the list - Used only by unit test
-    void Delete(RecoveryPacket* recovery);
+    /// Delete the oldest recovery packet from the list - Used only by unit test
+    void DeleteHead();
+
+protected:
+    /// Double the size of the ring.  Returns false on OOM
+    bool GrowRing();
+};
+
+
+//------------------------------------------------------------------------------
+// DecoderGotBitmap
+
+/**
+    Window-wide bitmap of the elements that have been received or recovered.
+
+    The bits are one contiguous array of 64-bit words, one word per subwindow,
+    so scans do not need to load the subwindow pointers.  Two summary levels
+    keep one bit per word:
+
+        FullSummary: Set when every element in the word has been received.
+        AnySummary: Set when any element in the word has been received.
+
+    Range loss counts only visit words that are not full, and searches for
+    the next hole or the next received element skip 64 words per summary
+    word.  A 16K element window is covered by four summary words.
+*/
+struct DecoderGotBitmap
+{
+    static const unsigned kWordBits = 64;
+    static const uint64_t kAllOnes = ~(uint64_t)0;
+
+    /// Bit per element
+    pktalloc::LightVector<uint64_t> Words;
+
+    /// Bit per word
+    pktalloc::LightVector<uint64_t> FullSummary;
+    pktalloc::LightVector<uint64_t> AnySummary;
+
+
+    /// Make sure at least the given number of words are available.
+    /// New words are clear.  Returns false on OOM
+    bool Grow(unsigned wordCount);
+
+    /// Mark an element as received
+    SIAMESE_FORCE_INLINE void Set(unsigned element)
+    {
+        const unsigned wordIndex = element / kWordBits;
+        SIAMESE_DEBUG_ASSERT(wordIndex < Words.GetSize());
+        uint64_t& word = Words.GetRef(wordIndex);
+        word |= (uint64_t)1 << (element % kWordBits);
+
+        const uint64_t summaryBit = (uint64_t)1 << (wordIndex % kWordBits);
+        AnySummary.GetRef(wordIndex / kWordBits) |= summaryBit;
+        if (word == kAllOnes) {
+            FullSummary.GetRef(wordIndex / kWordBits) |= summaryBit;
+        }
+    }
+
+    /// Returns the number of clear bits in [elementStart, elementEnd)
+    unsigned RangeClearCount(unsigned elementStart, unsigned elementEnd) const;
+
+    /// Returns the first clear bit in [elementStart, elementEnd),
+    /// or elementEnd if they are all set
+    unsigned FindFirstClear(unsigned elementStart, unsigned elementEnd) const;
+
+    /// Returns the first set bit in [elementStart, elementEnd),
+    /// or elementEnd if they are all clear
+    unsigned FindFirstSet(unsigned elementStart, unsigned elementEnd) const;
+
+    /// Remove words from the front, shifting the rest down and clearing
+    /// the words that open up at the end
+    void RemoveWords(unsigned wordCount);
+
+protected:
+    /// Returns the first word in [wordStart, wordEnd) that has its summary
+    /// bit set (or clear if invert is true), or wordEnd if there is none
+    static unsigned FindSummaryWord(
+        const pktalloc::LightVector<uint64_t>& summary,
+        unsigned wordStart,
+        unsigned wordEnd,
+        bool invert);
+};
+
+static_assert(kSubwindowSize == DecoderGotBitmap::kWordBits, "One bitmap word per subwindow");
+
+
+//------------------------------------------------------------------------------
+// DecoderLossRanges
+
+/**
+    Sorted list of the runs of lost elements in the window.
+
+    It is patched in place as data arrives, is recovered, or the window grows,
+    so acknowledgements can serialize the NACK list without scanning the window.
+    Ranges are maximal: two neighboring ranges are always separated by at least
+    one received element.
+
+    Range bounds are stored with ElementOffset added, so removing elements from
+    the front of the window only bumps the offset.  Comparisons are made after
+    subtracting the offset, so the stored values are allowed to wrap around.
+*/
+struct DecoderLossRanges
+{
+    struct Range
+    {
+        /// First lost element, plus ElementOffset
+        unsigned Start;
+
+        /// One beyond the last lost element, plus ElementOffset
+        unsigned End;
+    };
+
+    pktalloc::LightVector<Range> Ranges;
+    unsigned ElementOffset = 0;
+
+
+    /// Number of loss ranges
+    SIAMESE_FORCE_INLINE unsigned GetCount() const
+    {
+        return Ranges.GetSize();
+    }
+
+    /// First lost window element in the range
+    SIAMESE_FORCE_INLINE unsigned GetStart(unsigned rangeIndex) const
+    {
+        return Ranges.GetRef(rangeIndex).Start - ElementOffset;
+    }
+
+    /// One beyond the last lost window element in the range
+    SIAMESE_FORCE_INLINE unsigned GetEnd(unsigned rangeIndex) const
+    {
+        return Ranges.GetRef(rangeIndex).End - ElementOffset;
+    }
+
+    /// Add lost elements [elementStart, elementEnd) at the end of the window.
+    /// Returns false on OOM
+    bool AddLost(unsigned elementStart, unsigned elementEnd);
+
+    /// Remove an element that has been received or recovered.
+    /// Returns false on OOM
+    bool RemoveLost(unsigned element);
+
+    /// Elements were removed from the front of the window
+    SIAMESE_FORCE_INLINE void RemoveElements(unsigned elementCount)
+    {
+        SIAMESE_DEBUG_ASSERT(GetCount() == 0 || GetStart(0) >= elementCount);
+        ElementOffset += elementCount;
+    }
 };
 
 
@@ -260,19 +479,12 @@ struct RecoveryPacketList
 
 struct DecoderSubwindow
 {
-    /// Original packets in this subwindow indexed by packet number
+    /// Original packets in this subwindow indexed by GetSubwindowSlot()
     std::array<OriginalPacket, kSubwindowSize> Originals;
 
-    /// Keeping track of which entries are filled in more efficiently
-    pktalloc::CustomBitSet<kSubwindowSize> Got;
-    unsigned GotCount = 0;
-
 
     void Reset()
     {
-        Got.ClearAll();
-        GotCount = 0;
-
         for (unsigned i = 0; i < kSubwindowSize; ++i)
         {
             Originals[i].Column = 0;
@@ -303,8 +515,21 @@ struct DecoderPacketWindow
     /// Next expected element
     unsigned NextExpectedElement = 0;
 
-    /// Allocated Subwindows
-    pktalloc::LightVector<DecoderSubwindow*> Subwindows;
+    /// Allocated Subwindows, with removed ones recycled at the back
+    SubwindowRing<DecoderSubwindow> Subwindows;
+
+    /// Shared empty subwindow that stands in for every subwindow that has
+    /// not had any data written to it yet, so a jump ahead in the window
+    /// does not allocate the span in between.  Its elements read as lost.
+    /// It must never be written: Use GetWritableWindowElement() instead
+    DecoderSubwindow* EmptySubwindow = nullptr;
+
+    /// Which window elements have been received or recovered,
+    /// with one bitmap word per subwindow
+    DecoderGotBitmap GotBitmap;
+
+    /// Runs of lost elements, used to build acknowledgements
+    DecoderLossRanges LossRanges;
 
     /// Set of lanes we're maintaining
     DecoderColumnLane Lanes[kColumnLaneCount];
@@ -318,8 +543,17 @@ struct DecoderPacketWindow
     /// List of columns that have been recovered
     pktalloc::LightVector<unsigned> RecoveredColumns;
 
-    /// Temporary workspace reused each time subwindows must be shifted
-    pktalloc::LightVector<DecoderSubwindow*> SubwindowsShift;
+    /// Running sum checkpoints, spaced kDecoderCheckpointInterval elements
+    /// apart beginning at SumCheckpointColumnFirst
+    pktalloc::LightVector<SumCheckpoint*> SumCheckpoints;
+    unsigned SumCheckpointColumnFirst = 0;
+
+    /// Column that all checkpoints are summed from
+    unsigned SumCheckpointColumnStart = 0;
+    bool SumCheckpointStartInWindow = false;
+
+    /// Have checkpoints been started?
+    bool HasSumCheckpoints = false;
 
     /// If input is invalid or we run out of memory, the decoder is disabled
     /// to prevent it from allowing exploits to run or cause crashes
@@ -344,6 +578,15 @@ struct DecoderPacketWindow
         return (element >= Count);
     }
 
+    /// Returns true if the running sums for a Siamese row would need to be
+    /// restarted from data that was already removed from the window
+    SIAMESE_FORCE_INLINE bool SumsUnavailable(const RecoveryMetadata& metadata) const
+    {
+        return (metadata.ColumnStart != SumColumnStart ||
+                metadata.SumCount < SumColumnCount) &&
+               InvalidElement(ColumnToElement(metadata.ColumnStart));
+    }
+
     /// Convert a window element to a column
     SIAMESE_FORCE_INLINE unsigned ElementToColumn(unsigned element) const
     {
@@ -369,9 +612,14 @@ struct DecoderPacketWindow
     SIAMESE_FORCE_INLINE OriginalPacket* GetWindowElement(unsigned windowElement)
     {
         SIAMESE_DEBUG_ASSERT(windowElement < Count);
-        return &(Subwindows.GetRef(windowElement / kSubwindowSize)->Originals[windowElement % kSubwindowSize]);
+        return &(Subwindows.GetRef(windowElement / kSubwindowSize)->Originals[GetSubwindowSlot(windowElement)]);
     }
 
+    /// Get element from the window for writing, allocating its subwindow
+    /// if it is still the shared empty one.  Returns nullptr on OOM
+    /// Precondition: 0 <= element < Count
+    OriginalPacket* GetWritableWindowElement(unsigned windowElement);
+
     /// Returns the number of lost packets in the given range (inclusive)
     /// windowElementStart < Count: First element to test
     /// windowElementStart <= Count: One element beyond the last one to test
@@ -388,8 +636,12 @@ struct DecoderPacketWindow
     /// Find the next expected element
     void IterateNextExpectedElement(unsigned elementStart);
 
-    /// Append a packet to the end of the set
-    SiameseResult AddOriginal(const SiameseOriginalPacket& packet);
+    /// Append a packet to the end of the set.
+    /// If segments is not nullptr the packet data is gathered from them
+    SiameseResult AddOriginal(
+        const SiameseOriginalPacket& packet,
+        const SiameseSegment* segments = nullptr,
+        unsigned segmentCount = 0);
 
     /// Mark that we got a column
     /// Returns true if this was the next expected element
@@ -407,6 +659,40 @@ struct DecoderPacketWindow
     /// Reset all sums to start from the given element
     void ResetSums(unsigned elementStart);
 
+    /// Add one window element into a running sum buffer
+    bool AccumulateSumElement(
+        GrowingAlignedDataBuffer& sumBuffer,
+        unsigned laneIndex,
+        unsigned sumIndex,
+        unsigned element);
+
+    /// Begin checkpointing sums from the given element if not already
+    void StartSumCheckpoints(unsigned elementStart);
+
+    /// Make sure the checkpoint base for a sum is valid.
+    /// Returns false if the sum cannot be checkpointed
+    bool PrepareSumCheckpointBase(unsigned laneIndex, unsigned sumIndex);
+
+    /// Resume a running sum from the furthest valid checkpoint that does not
+    /// pass the given end element, if it is ahead of the sum
+    bool LoadSumCheckpoint(unsigned laneIndex, unsigned sumIndex, unsigned elementEnd);
+
+    /// Save a running sum into the given checkpoint
+    bool SaveSumCheckpoint(unsigned checkpointIndex, unsigned laneIndex, unsigned sumIndex);
+
+    /// Drop checkpoints and bases that include the given element,
+    /// because data has arrived for it since they were calculated
+    void InvalidateSumCheckpoints(unsigned element);
+
+    /// Drop checkpoints that have fallen out of the front of the window
+    void RemoveSumCheckpoints(unsigned removedElementCount);
+
+    /// Get the element at which the first checkpoint is taken
+    SIAMESE_FORCE_INLINE unsigned GetFirstSumCheckpointElement() const
+    {
+        return ColumnToElement(SumCheckpointColumnFirst);
+    }
+
     /// Plug holes in the running sum from previous recovery action
     bool PlugSumHoles(unsigned elementStart);
 
@@ -436,6 +722,7 @@ struct RecoveryMatrixState
     pktalloc::Allocator* TheAllocator = nullptr;
     DecoderPacketWindow* Window = nullptr;
     CheckedRegionState* CheckedRegion = nullptr;
+    RecoveryPacketList* RecoveryPackets = nullptr;
 
     struct RowInfo
     {
@@ -542,6 +829,63 @@ protected:
 };
 
 
+//------------------------------------------------------------------------------
+// CauchySolverState
+
+/**
+    Cauchy recovery rows have matrix elements 1 / (X(i) + Y(j)), where X(i)
+    is from the row number and Y(j) is from the column.  So if there are as
+    many Cauchy rows as lost packets in the checked region, and each row
+    covers all of them, then the inverse of the matrix is known in closed
+    form and can be written down in O(n^2) without Gaussian elimination.
+
+    The closed form comes from treating the recovery data as the values of
+    the rational function f(z) = Sum(d_j / (z + Y(j))) at the points X(i).
+    Multiplying through by Q(z) = Prod(z + Y(j)) gives a polynomial N(z) of
+    degree below n that is found by Lagrange interpolation, and then each
+    lost packet is d_j = N(Y(j)) / Q'(Y(j)).  A parity row is the sum of the
+    lost packets, which is the leading coefficient of N(z), so one parity
+    row can stand in for one of the Cauchy rows.
+
+    The inverse matrix is then:
+
+        Inverse(j, i) = C(j) * A(i) / (X(i) + Y(j))  for Cauchy rows
+        Inverse(j, p) = C(j)                          for the parity row
+
+    where P(z) = Prod(z + X(i)) over the Cauchy rows, and:
+
+        A(i) = Q(X(i)) / Prod(k != i: X(i) + X(k))
+        C(j) = P(Y(j)) / Prod(k != j: Y(j) + Y(k))
+*/
+struct CauchySolverState
+{
+    /// Lost elements in the checked region, from left to right
+    pktalloc::LightVector<unsigned> Elements;
+
+    /// Y(j) for each lost element
+    pktalloc::LightVector<uint8_t> ColumnY;
+
+    /// Recovery rows selected to solve for the lost elements
+    pktalloc::LightVector<RecoveryPacket*> Rows;
+
+    /// X(i) for each row, unused for the parity row
+    pktalloc::LightVector<uint8_t> RowX;
+
+    /// A(i) for each row, unused for the parity row
+    pktalloc::LightVector<uint8_t> RowScale;
+
+    /// Index of the parity row in Rows, or -1 if there is none
+    int ParityIndex = -1;
+
+    /// Inverse matrix: Element j, i is at j * n + i
+    pktalloc::LightVector<uint8_t> Inverse;
+
+
+    /// Generate the inverse matrix for the selected rows and elements
+    bool GenerateInverse();
+};
+
+
 //------------------------------------------------------------------------------
 // Decoder
 
@@ -549,17 +893,46 @@ protected:
 static const unsigned kDecoderRemoveThreshold = 2 * kSubwindowSize;
 static_assert(kDecoderRemoveThreshold % kSubwindowSize == 0, "It removes on window boundaries");
 
+/// Minimum number of recovery rows to eliminate before the worker threads
+/// are used.  Below this, waking the workers costs more than it saves
+static const unsigned kEliminateParallelMinRows = 8;
+
+/// Target working set in bytes when solving for the lost packets.
+/// MultiplyLowerTriangle() and BackSubstitution() finish one stripe of every
+/// row before moving on, so the stripes of all the rows should fit in cache
+static const unsigned kSolveWorkingSetBytes = 256 * 1024;
+
+/// Minimum number of bytes in each stripe, so per-stripe overhead stays small
+static const unsigned kSolveMinStripeBytes = 1024;
+
+class ThreadPool;
+
 class Decoder
 {
 public:
-    Decoder();
+    /// Optionally takes allocator windows from a pool shared with other codecs
+    explicit Decoder(pktalloc::WindowPool* pool = nullptr);
+    ~Decoder();
+
+    /// Start worker threads for large decodes
+    SiameseResult StartThreads(unsigned threadCount);
+
+    /// Stop the worker threads
+    void StopThreads();
 
     SiameseResult AddRecovery(const SiameseRecoveryPacket& packet);
 
-    SIAMESE_FORCE_INLINE SiameseResult AddOriginal(
-        const SiameseOriginalPacket& packet)
+    SiameseResult AddOriginal(
+        const SiameseOriginalPacket& packet,
+        const SiameseSegment* segments = nullptr,
+        unsigned segmentCount = 0);
+
+    SIAMESE_FORCE_INLINE SiameseResult AddOriginalSegments(
+        const SiameseOriginalPacket& packet,
+        const SiameseSegment* segments,
+        unsigned segmentCount)
     {
-        return Window.AddOriginal(packet);
+        return AddOriginal(packet, segments, segmentCount);
     }
 
     SIAMESE_FORCE_INLINE SiameseResult IsReadyToDecode()
@@ -585,6 +958,9 @@ public:
         uint64_t* statsOut,
         unsigned statsCount);
 
+    /// Eliminate received data from stored recovery packets ahead of Decode()
+    SiameseResult IdleWork(unsigned budgetUsec);
+
 protected:
     /// When the allocator goes out of scope all our buffer allocations are freed
     pktalloc::Allocator TheAllocator;
@@ -604,9 +980,22 @@ protected:
     /// Matrix containing recovery packets that may admit a solution
     RecoveryMatrixState RecoveryMatrix;
 
+    /// Closed-form solver for checked regions covered by Cauchy rows
+    CauchySolverState CauchySolver;
+
     /// Product sum for current row
     GrowingAlignedDataBuffer ProductSum;
 
+    /// Worker threads, if running.  See SiameseThreadPool.h
+    ThreadPool* Workers = nullptr;
+
+    /// Recovery rows handed to the worker threads by EliminateOriginalData()
+    pktalloc::LightVector<RecoveryPacket*> EliminateTasks;
+    unsigned EliminateTaskCount = 0;
+
+    /// Product sum for each worker thread, indexed by worker index
+    GrowingAlignedDataBuffer WorkerProductSums[SIAMESE_DECODER_MAX_THREADS + 1];
+
     /// Filter data that is received out of order by comparing its extent to
     /// the latest column seen so far
     unsigned LatestColumn = 0;
@@ -618,17 +1007,61 @@ protected:
     /// Attempt to solve the checked region matrix
     SiameseResult DecodeCheckedRegion();
 
+    /// Solve a checked region with only one lost packet without a matrix
+    SiameseResult DecodeSingleLoss();
+
+    /// Select Cauchy rows that cover all the losses in the checked region.
+    /// Returns false if the closed-form Cauchy solver cannot be used
+    bool SelectCauchyRows();
+
+    /// Solve a checked region with the rows from SelectCauchyRows()
+    SiameseResult DecodeCauchyRows();
+
+    /// Multiply a stripe of the selected Cauchy rows by row j of the inverse
+    void MultiplyCauchyInverse(unsigned j, unsigned stripeStart, unsigned stripeEnd);
+
     /// Returns true if recovery is possible
     bool CheckRecoveryPossible();
 
     /// Recovery step: Eliminate original data that was successfully received
     bool EliminateOriginalData();
 
+    /// Add the running sums of a Siamese row to it, and the light columns
+    /// unless a worker thread will add them.  Returns false on failure
+    bool EliminateSumRow(RecoveryPacket* recovery, bool lightColumns);
+
+    /// Eliminate original data from a Cauchy or parity row
+    void EliminateCauchyRow(RecoveryPacket* recovery);
+
+    /// Eliminate an original that was filled in from the recovery packets
+    /// that IdleWork() already eliminated without it
+    void EliminateLateOriginal(unsigned element);
+
+    /// Add the light (LDPC) columns of a Siamese row to the given buffers
+    void AddLightColumns(
+        RecoveryPacket* recovery,
+        uint8_t* recoveryData,
+        uint8_t* productData);
+
+    /// Prepare worker threads to eliminate up to the given number of rows.
+    /// Returns false on OOM
+    bool BeginEliminateTasks(unsigned rows);
+
+    /// Hand a row to the worker threads.  Its running sums must be done
+    void PublishEliminateTask(RecoveryPacket* recovery);
+
+    /// Called by the worker threads to eliminate data from a row
+    static void RunEliminateTask(void* context, unsigned workerIndex, unsigned taskIndex);
+
     /// Recovery step: Multiply lower triangle following solution order
     bool MultiplyLowerTriangle();
 
     /// Recovery step: Back-substitute upper triangle to reveal original data
     SiameseResult BackSubstitution();
+
+    /// Final recovery step: Move past the solved region and release the
+    /// recovery packets it used
+    SiameseResult FinishSolution(bool iterateNextExpected);
 };
 
 
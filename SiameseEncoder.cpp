@@ -28,8 +28,11 @@
 */
 
 #include "SiameseEncoder.h"
+#include "SiameseEncoderPipeline.h"
 #include "SiameseSerializers.h"
 
+#include <algorithm> // std::rotate
+
 namespace siamese {
 
 #ifdef SIAMESE_ENCODER_DUMP_VERBOSE
@@ -77,12 +80,18 @@ void EncoderPacketWindow::ClearWindow()
         {
             lane.Sum[sumIndex].Bytes   = 0;
             lane.NextElement[sumIndex] = laneIndex;
+            lane.BaseState[sumIndex]   = SumCheckpointBase::Unknown;
         }
         lane.LongestPacket = 0;
     }
 }
 
-SiameseResult EncoderPacketWindow::Add(SiameseOriginalPacket& packet)
+SiameseResult EncoderPacketWindow::Add(
+    SiameseOriginalPacket& packet,
+    const SiameseSegment* segments,
+    unsigned segmentCount,
+    SiameseReleaseCallback release,
+    void* context)
 {
     if (EmergencyDisabled) {
         return Siamese_Disabled;
@@ -129,7 +138,17 @@ SiameseResult EncoderPacketWindow::Add(SiameseOriginalPacket& packet)
 
     // Initialize original packet with received data
     OriginalPacket* original = GetWindowElement(element);
-    if (0 == original->Initialize(TheAllocator, packet))
+    unsigned headerBytes;
+    if (release) {
+        headerBytes = original->InitializeZeroCopy(TheAllocator, packet, release, context);
+    }
+    else if (segments) {
+        headerBytes = original->InitializeSegments(TheAllocator, packet, segments, segmentCount);
+    }
+    else {
+        headerBytes = original->Initialize(TheAllocator, packet);
+    }
+    if (0 == headerBytes)
     {
         EmergencyDisabled = true;
         Logger.Error("WindowAdd.Initialize OOM");
@@ -177,6 +196,9 @@ void EncoderPacketWindow::StartNewWindow(unsigned column)
         Lanes[laneIndex].LongestPacket = 0;
     }
 
+    // Old snapshots are not summed from data in this window
+    ClearSumCheckpoints();
+
     Logger.Info(">>> Starting a new window from column ", ColumnStart);
 }
 
@@ -199,6 +221,7 @@ void EncoderPacketWindow::RemoveBefore(unsigned firstKeptColumn)
         else
         {
             // Removed everything
+            ReleaseElements(0, Count);
             Count = 0;
 
             Logger.Info("Remove before column ", firstKeptColumn, " - Removed everything");
@@ -215,6 +238,31 @@ void EncoderPacketWindow::RemoveBefore(unsigned firstKeptColumn)
     }
 }
 
+void EncoderPacketWindow::ReleaseElements(unsigned elementStart, unsigned elementEnd)
+{
+    for (unsigned element = elementStart; element < elementEnd; ++element)
+    {
+        OriginalPacket* original = GetWindowElement(element);
+        if (original->IsExternal()) {
+            original->ReleaseExternal();
+        }
+    }
+}
+
+void EncoderPacketWindow::ReleaseAllElements()
+{
+    for (unsigned i = 0, count = Subwindows.GetSize(); i < count; ++i)
+    {
+        EncoderSubwindow* subwindow = Subwindows.GetRef(i);
+        for (OriginalPacket& original : subwindow->Originals)
+        {
+            if (original.IsExternal()) {
+                original.ReleaseExternal();
+            }
+        }
+    }
+}
+
 void EncoderPacketWindow::ResetSums(unsigned elementStart)
 {
     // Recreate all the sums from scratch after this:
@@ -227,6 +275,7 @@ void EncoderPacketWindow::ResetSums(unsigned elementStart)
         {
             Lanes[laneIndex].NextElement[sumIndex] = nextElement;
             Lanes[laneIndex].Sum[sumIndex].Bytes   = 0;
+            Lanes[laneIndex].BaseState[sumIndex]   = SumCheckpointBase::Unknown;
         }
     }
 
@@ -234,6 +283,10 @@ void EncoderPacketWindow::ResetSums(unsigned elementStart)
     SumEndElement   = elementStart;
     SumColumnStart  = ElementToColumn(elementStart);
     SumErasedCount  = 0;
+
+    // Keep checkpointing from the old start point if there are snapshots.
+    // GetSum() will resume the new sums from them
+    StartSumCheckpoints(elementStart);
 }
 
 void EncoderPacketWindow::RemoveElements()
@@ -262,7 +315,22 @@ void EncoderPacketWindow::RemoveElements()
             }
         }
 
-        if (removedElementCount > SumStartElement) {
+        if (removedElementCount > SumStartElement)
+        {
+            // Calculate checkpoint bases while the sum start is still in the window
+            if (HasSumCheckpoints)
+            {
+                for (unsigned laneIndex = 0; laneIndex < kColumnLaneCount; ++laneIndex)
+                {
+                    for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex)
+                    {
+                        if (!PrepareSumCheckpointBase(laneIndex, sumIndex)) {
+                            Lanes[laneIndex].BaseState[sumIndex] = SumCheckpointBase::Unavailable;
+                        }
+                    }
+                }
+            }
+
             SumErasedCount += removedElementCount - SumStartElement;
         }
 
@@ -281,38 +349,13 @@ void EncoderPacketWindow::RemoveElements()
         }
     }
 
-    // Shift kept subwindows to the front of the vector:
-
-    // Resize a temporary buffer for removed subwindows
-    if (!SubwindowsShift.SetSize_NoCopy(firstKeptSubwindow))
-    {
-        SIAMESE_DEBUG_BREAK(); // OOM
-        EmergencyDisabled = true;
-        return;
-    }
+    // The removed elements are no longer needed for the running sums
+    ReleaseElements(0, removedElementCount);
 
-    // Store removed subwindows temporarily
-    memcpy(
-        SubwindowsShift.GetPtr(0),
-        Subwindows.GetPtr(0),
-        firstKeptSubwindow * sizeof(EncoderSubwindow*)
-    );
+    RemoveSumCheckpoints(removedElementCount);
 
-    const unsigned subwindowsShifted = Subwindows.GetSize() - firstKeptSubwindow;
-
-    // Shift subwindows to front that are being kept
-    memmove(
-        Subwindows.GetPtr(0),
-        Subwindows.GetPtr(firstKeptSubwindow),
-        subwindowsShifted * sizeof(EncoderSubwindow*)
-    );
-
-    // Removed subwindows are moved to the end (unordered) for later reuse
-    memcpy(
-        Subwindows.GetPtr(subwindowsShifted),
-        SubwindowsShift.GetPtr(0),
-        firstKeptSubwindow * sizeof(EncoderSubwindow*)
-    );
+    // Removed subwindows are recycled at the back of the ring
+    Subwindows.RotateFront(firstKeptSubwindow);
 
     // Update the count of elements in the window
     SIAMESE_DEBUG_ASSERT(Count >= removedElementCount);
@@ -359,62 +402,424 @@ void EncoderPacketWindow::RemoveElements()
 const GrowingAlignedDataBuffer* EncoderPacketWindow::GetSum(unsigned laneIndex, unsigned sumIndex, unsigned elementEnd)
 {
     EncoderColumnLane& lane = Lanes[laneIndex];
+    GrowingAlignedDataBuffer& sum = lane.Sum[sumIndex];
     unsigned element = lane.NextElement[sumIndex];
     SIAMESE_DEBUG_ASSERT(element % kColumnLaneCount == laneIndex);
     SIAMESE_DEBUG_ASSERT(element < Count + kColumnLaneCount);
 
-    if (element < elementEnd)
+    if (element >= elementEnd) {
+        return &sum;
+    }
+
+    // Next element at which to checkpoint this sum.
+    // This is left at elementEnd (never reached) if not checkpointing
+    unsigned checkpointElement = elementEnd;
+    unsigned checkpointIndex   = 0;
+
+    if (HasSumCheckpoints)
     {
-        GrowingAlignedDataBuffer& sum = lane.Sum[sumIndex];
+        const unsigned firstElement = GetFirstSumCheckpointElement() + laneIndex;
 
-        // Grow this sum for this lane to fit new (larger) data if needed
-        if (lane.LongestPacket > 0 &&
-            !sum.GrowZeroPadded(TheAllocator, lane.LongestPacket))
-        {
-            EmergencyDisabled = true;
-            goto ExitSum;
+        // Find the first checkpoint at or after the next element
+        if (element > firstElement) {
+            checkpointIndex = (element - firstElement + kEncoderCheckpointInterval - 1) / kEncoderCheckpointInterval;
         }
 
-        do
+        // If this sum will reach a checkpoint and it can use checkpoints:
+        if (firstElement + checkpointIndex * kEncoderCheckpointInterval <= elementEnd &&
+            PrepareSumCheckpointBase(laneIndex, sumIndex))
         {
-            Logger.Info("Lane ", laneIndex, " sum ", sumIndex, " accumulating column: ", ColumnStart + element);
+            // Skip ahead to the furthest checkpoint within reach
+            if (!LoadSumCheckpoint(laneIndex, sumIndex, elementEnd))
+            {
+                EmergencyDisabled = true;
+                goto ExitSum;
+            }
 
-            OriginalPacket* original = GetWindowElement(element);
-            const unsigned column    = original->Column;
-            unsigned addBytes        = original->Buffer.Bytes;
+            element = lane.NextElement[sumIndex];
+            if (element > firstElement) {
+                checkpointIndex = (element - firstElement + kEncoderCheckpointInterval - 1) / kEncoderCheckpointInterval;
+            }
+            checkpointElement = firstElement + checkpointIndex * kEncoderCheckpointInterval;
+        }
+    }
+
+    // Grow this sum for this lane to fit new (larger) data if needed
+    if (lane.LongestPacket > 0 &&
+        !sum.GrowZeroPaddedAmortized(TheAllocator, lane.LongestPacket))
+    {
+        EmergencyDisabled = true;
+        goto ExitSum;
+    }
 
-            if (!sum.GrowZeroPadded(TheAllocator, addBytes))
+    // For each element to accumulate in this lane:
+    while (element < elementEnd)
+    {
+        // If the sum has reached a checkpoint:
+        if (element == checkpointElement)
+        {
+            if (!SaveSumCheckpoint(checkpointIndex, laneIndex, sumIndex))
             {
                 EmergencyDisabled = true;
                 goto ExitSum;
             }
 
-            SIAMESE_DEBUG_ASSERT(original->Buffer.Bytes <= sum.Bytes || element < FirstUnremovedElement);
+            ++checkpointIndex;
+            checkpointElement += kEncoderCheckpointInterval;
+        }
+
+        if (!AccumulateSumElement(sum, laneIndex, sumIndex, element))
+        {
+            EmergencyDisabled = true;
+            goto ExitSum;
+        }
+
+        element += kColumnLaneCount;
+    }
+
+    // Store next element to accumulate
+    lane.NextElement[sumIndex] = element;
+
+ExitSum:
+    return &sum;
+}
+
+bool EncoderPacketWindow::AccumulateSumElement(
+    GrowingAlignedDataBuffer& sumBuffer,
+    unsigned laneIndex,
+    unsigned sumIndex,
+    unsigned element)
+{
+    Logger.Info("Lane ", laneIndex, " sum ", sumIndex, " accumulating column: ", ColumnStart + element);
+
+    OriginalPacket* original = GetWindowElement(element);
+    const unsigned column    = original->Column;
+    unsigned addBytes        = original->Buffer.Bytes;
+
+    if (!sumBuffer.GrowZeroPaddedAmortized(TheAllocator, addBytes)) {
+        return false;
+    }
+
+    // Sum += PacketData
+    if (sumIndex == 0) {
+        gf256_add_mem(sumBuffer.Data, original->Buffer.Data, addBytes);
+    }
+    else
+    {
+        // Sum += CX[2] * PacketData
+        uint8_t CX = GetColumnValue(column);
+        if (sumIndex == 2) {
+            CX = gf256_sqr(CX);
+        }
+        gf256_muladd_mem(sumBuffer.Data, CX, original->Buffer.Data, addBytes);
+    }
+
+    SIAMESE_DEBUG_ASSERT(original->Column % kColumnLaneCount == laneIndex);
+    return true;
+}
+
 
-            // Sum += PacketData
-            if (sumIndex == 0) {
-                gf256_add_mem(sum.Data, original->Buffer.Data, addBytes);
+//------------------------------------------------------------------------------
+// EncoderPacketWindow : Running Sum Checkpoints
+
+void EncoderPacketWindow::StartSumCheckpoints(unsigned elementStart)
+{
+    // Keep the start point while any snapshot is relative to it
+    if (HasSumCheckpoints)
+    {
+        for (unsigned i = 0, count = SumCheckpoints.GetSize(); i < count; ++i) {
+            if (SumCheckpoints.GetRef(i)->ValidMask != 0) {
+                return;
             }
-            else
+        }
+    }
+
+    Logger.Info("Starting sum checkpoints at ", elementStart);
+
+    // First checkpoint is one interval after the next subwindow boundary
+    const unsigned roundedStart = elementStart + kSubwindowSize - 1;
+    const unsigned firstElement = roundedStart - (roundedStart % kSubwindowSize) + kEncoderCheckpointInterval;
+
+    SumCheckpointColumnFirst   = ElementToColumn(firstElement);
+    SumCheckpointColumnStart   = ElementToColumn(elementStart);
+    SumCheckpointStartInWindow = true;
+    HasSumCheckpoints          = true;
+}
+
+void EncoderPacketWindow::ClearSumCheckpoints()
+{
+    for (unsigned i = 0, count = SumCheckpoints.GetSize(); i < count; ++i) {
+        SumCheckpoints.GetRef(i)->ValidMask = 0;
+    }
+
+    for (unsigned laneIndex = 0; laneIndex < kColumnLaneCount; ++laneIndex) {
+        for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex) {
+            Lanes[laneIndex].BaseState[sumIndex] = SumCheckpointBase::Unknown;
+        }
+    }
+
+    SumCheckpointStartInWindow = false;
+    HasSumCheckpoints          = false;
+}
+
+bool EncoderPacketWindow::PrepareSumCheckpointBase(unsigned laneIndex, unsigned sumIndex)
+{
+    EncoderColumnLane& lane = Lanes[laneIndex];
+
+    if (lane.BaseState[sumIndex] == SumCheckpointBase::Valid) {
+        return true;
+    }
+    if (lane.BaseState[sumIndex] == SumCheckpointBase::Unavailable) {
+        return false;
+    }
+
+    const unsigned sumStart = GetNextLaneElement(SumStartElement, laneIndex);
+
+    // Find the nearest known point to the sum start, on either side.
+    // The checkpoint start point itself is known to be an empty sum
+    const GrowingAlignedDataBuffer* snapshot = nullptr;
+    unsigned snapshotElement = 0;
+    unsigned bestDistance    = ~(unsigned)0;
+
+    if (SumCheckpointStartInWindow)
+    {
+        snapshotElement = GetNextLaneElement(ColumnToElement(SumCheckpointColumnStart), laneIndex);
+        bestDistance    = (sumStart >= snapshotElement) ? sumStart - snapshotElement : snapshotElement - sumStart;
+    }
+
+    const unsigned firstElement = GetFirstSumCheckpointElement() + laneIndex;
+    const unsigned count        = SumCheckpoints.GetSize();
+    const uint32_t validBit     = 1u << (laneIndex * kColumnSumCount + sumIndex);
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        if (0 == (SumCheckpoints.GetRef(i)->ValidMask & validBit)) {
+            continue;
+        }
+
+        const unsigned checkpointElement = firstElement + i * kEncoderCheckpointInterval;
+        const unsigned distance = (sumStart >= checkpointElement) ? sumStart - checkpointElement : checkpointElement - sumStart;
+        if (distance < bestDistance)
+        {
+            bestDistance    = distance;
+            snapshot        = &SumCheckpoints.GetRef(i)->Sums[laneIndex][sumIndex];
+            snapshotElement = checkpointElement;
+        }
+    }
+
+    // If there is nothing to start from:
+    if (bestDistance == ~(unsigned)0) {
+        return false;
+    }
+
+    GrowingAlignedDataBuffer& base = lane.CheckpointBase[sumIndex];
+    const GrowingAlignedDataBuffer empty;
+
+    if (!AddSumSnapshot(TheAllocator, base, snapshot ? *snapshot : empty, empty))
+    {
+        EmergencyDisabled = true;
+        return false;
+    }
+
+    // Base = Snapshot +/- the elements between the snapshot and the sum start
+    unsigned element    = (snapshotElement < sumStart) ? snapshotElement : sumStart;
+    unsigned elementEnd = (snapshotElement < sumStart) ? sumStart : snapshotElement;
+    for (; element < elementEnd; element += kColumnLaneCount)
+    {
+        if (!AccumulateSumElement(base, laneIndex, sumIndex, element))
+        {
+            EmergencyDisabled = true;
+            return false;
+        }
+    }
+
+    lane.BaseState[sumIndex] = SumCheckpointBase::Valid;
+    return true;
+}
+
+bool EncoderPacketWindow::LoadSumCheckpoint(unsigned laneIndex, unsigned sumIndex, unsigned elementEnd)
+{
+    EncoderColumnLane& lane = Lanes[laneIndex];
+    SIAMESE_DEBUG_ASSERT(lane.BaseState[sumIndex] == SumCheckpointBase::Valid);
+
+    const unsigned firstElement = GetFirstSumCheckpointElement() + laneIndex;
+    const unsigned count        = SumCheckpoints.GetSize();
+    if (count <= 0 || elementEnd < firstElement) {
+        return true;
+    }
+
+    const uint32_t validBit = 1u << (laneIndex * kColumnSumCount + sumIndex);
+
+    // Start from the last checkpoint that does not pass the end element
+    unsigned i = (elementEnd - firstElement) / kEncoderCheckpointInterval;
+    if (i >= count) {
+        i = count - 1;
+    }
+
+    // Search backwards for a valid checkpoint ahead of the sum:
+    for (;;)
+    {
+        const unsigned checkpointElement = firstElement + i * kEncoderCheckpointInterval;
+        if (checkpointElement <= lane.NextElement[sumIndex]) {
+            break;
+        }
+
+        SumCheckpoint* checkpoint = SumCheckpoints.GetRef(i);
+        if (checkpoint->ValidMask & validBit)
+        {
+            // Sum = Snapshot - Base
+            if (!AddSumSnapshot(TheAllocator, lane.Sum[sumIndex], checkpoint->Sums[laneIndex][sumIndex], lane.CheckpointBase[sumIndex])) {
+                return false;
+            }
+
+            Logger.Debug("Lane ", laneIndex, " sum ", sumIndex, " resumed from checkpoint at column ", checkpointElement + ColumnStart);
+
+            lane.NextElement[sumIndex] = checkpointElement;
+            Stats->Counts[SiameseEncoderStats_SumCheckpointCount]++;
+            break;
+        }
+
+        if (i == 0) {
+            break;
+        }
+        --i;
+    }
+
+    return true;
+}
+
+bool EncoderPacketWindow::SaveSumCheckpoint(unsigned checkpointIndex, unsigned laneIndex, unsigned sumIndex)
+{
+    const unsigned count = SumCheckpoints.GetSize();
+
+    // If the checkpoint list must grow:
+    if (checkpointIndex >= count)
+    {
+        // Note resizing larger will keep old data in the vector
+        if (!SumCheckpoints.SetSize_Copy(checkpointIndex + 1)) {
+            return false;
+        }
+
+        for (unsigned i = count; i <= checkpointIndex; ++i)
+        {
+            SumCheckpoint* checkpoint = TheAllocator->Construct<SumCheckpoint>();
+            if (!checkpoint)
             {
-                // Sum += CX[2] * PacketData
-                uint8_t CX = GetColumnValue(column);
-                if (sumIndex == 2) {
-                    CX = gf256_sqr(CX);
-                }
-                gf256_muladd_mem(sum.Data, CX, original->Buffer.Data, addBytes);
+                SumCheckpoints.SetSize_Copy(i);
+                return false; // Out of memory
             }
 
-            SIAMESE_DEBUG_ASSERT(original->Column % kColumnLaneCount == laneIndex);
-            element += kColumnLaneCount;
-        } while (element < elementEnd);
+            SumCheckpoints.GetRef(i) = checkpoint;
+        }
+    }
+
+    SumCheckpoint* checkpoint = SumCheckpoints.GetRef(checkpointIndex);
+    const uint32_t validBit = 1u << (laneIndex * kColumnSumCount + sumIndex);
 
-        // Store next element to accumulate
-        lane.NextElement[sumIndex] = element;
+    // If this snapshot was already taken:
+    if (checkpoint->ValidMask & validBit) {
+        return true;
     }
 
-ExitSum:
-    return &lane.Sum[sumIndex];
+    const EncoderColumnLane& lane = Lanes[laneIndex];
+    SIAMESE_DEBUG_ASSERT(lane.BaseState[sumIndex] == SumCheckpointBase::Valid);
+
+    // Snapshot = Sum + Base
+    if (!AddSumSnapshot(TheAllocator, checkpoint->Sums[laneIndex][sumIndex], lane.Sum[sumIndex], lane.CheckpointBase[sumIndex])) {
+        return false;
+    }
+
+    checkpoint->ValidMask |= validBit;
+    return true;
+}
+
+void EncoderPacketWindow::RemoveSumCheckpoints(unsigned removedElementCount)
+{
+    if (!HasSumCheckpoints) {
+        return;
+    }
+
+    // If the start point is removed, then only the differences between
+    // snapshots are still useful
+    if (SumCheckpointStartInWindow &&
+        ColumnToElement(SumCheckpointColumnStart) < removedElementCount)
+    {
+        SumCheckpointStartInWindow = false;
+    }
+
+    const unsigned firstElement = GetFirstSumCheckpointElement();
+    if (firstElement >= removedElementCount) {
+        return;
+    }
+
+    // Skip checkpoints that are in the removed region
+    const unsigned removedCount = (removedElementCount - firstElement + kEncoderCheckpointInterval - 1) / kEncoderCheckpointInterval;
+    SumCheckpointColumnFirst = AddColumns(SumCheckpointColumnFirst, removedCount * kEncoderCheckpointInterval);
+
+    const unsigned count = SumCheckpoints.GetSize();
+    for (unsigned i = 0; i < count && i < removedCount; ++i) {
+        SumCheckpoints.GetRef(i)->ValidMask = 0;
+    }
+
+    // Removed checkpoints are moved to the end for later reuse
+    if (removedCount < count)
+    {
+        SumCheckpoint** checkpoints = SumCheckpoints.GetPtr(0);
+        std::rotate(checkpoints, checkpoints + removedCount, checkpoints + count);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// EncoderPacketWindow : Idle Work
+
+bool EncoderPacketWindow::AccumulateSums(uint64_t deadlineUsec)
+{
+    // If sums are not in use (e.g. Cauchy rows are being sent) there is nothing to do
+    if (SumEndElement <= SumStartElement) {
+        return true;
+    }
+
+    for (;;)
+    {
+        // Find the furthest behind sum
+        unsigned elementStart = Count;
+        for (unsigned laneIndex = 0; laneIndex < kColumnLaneCount; ++laneIndex)
+        {
+            for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex)
+            {
+                const unsigned element = Lanes[laneIndex].NextElement[sumIndex];
+                if (elementStart > element) {
+                    elementStart = element;
+                }
+            }
+        }
+        if (elementStart >= Count) {
+            return true;
+        }
+
+        // Advance every sum by a chunk so the deadline is checked often
+        unsigned elementEnd = elementStart + kIdleWorkChunkElements;
+        if (elementEnd > Count) {
+            elementEnd = Count;
+        }
+
+        for (unsigned laneIndex = 0; laneIndex < kColumnLaneCount; ++laneIndex)
+        {
+            for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex)
+            {
+                GetSum(laneIndex, sumIndex, elementEnd);
+            }
+        }
+
+        if (EmergencyDisabled) {
+            return false;
+        }
+
+        if (deadlineUsec != 0 && elementEnd < Count && GetTimeUsec() >= deadlineUsec) {
+            return false;
+        }
+    }
 }
 
 
@@ -803,7 +1208,8 @@ void EncoderAcknowledgementState::Clear()
 //------------------------------------------------------------------------------
 // Encoder
 
-Encoder::Encoder()
+Encoder::Encoder(pktalloc::WindowPool* pool)
+    : TheAllocator(pool)
 {
     Window.TheAllocator = &TheAllocator;
     Window.Stats        = &Stats;
@@ -811,6 +1217,48 @@ Encoder::Encoder()
     Ack.TheWindow       = &Window;
 }
 
+Encoder::~Encoder()
+{
+    // The worker thread must not outlive the encoder
+    StopPipeline();
+
+    // Hand back any application memory we are still referencing
+    Window.ReleaseAllElements();
+}
+
+SiameseResult Encoder::StartPipeline(unsigned readyCount)
+{
+    if (Window.EmergencyDisabled) {
+        return Siamese_Disabled;
+    }
+    if (Pipeline) {
+        return Siamese_InvalidInput;
+    }
+
+    EncoderPipeline* pipeline = new (std::nothrow) EncoderPipeline;
+    if (!pipeline) {
+        return Siamese_Disabled;
+    }
+    if (!pipeline->Start(this, readyCount))
+    {
+        delete pipeline;
+        return Siamese_Disabled;
+    }
+
+    Pipeline = pipeline;
+    return Siamese_Success;
+}
+
+void Encoder::StopPipeline()
+{
+    if (Pipeline)
+    {
+        Pipeline->Stop();
+        delete Pipeline;
+        Pipeline = nullptr;
+    }
+}
+
 SiameseResult Encoder::Acknowledge(
     const uint8_t* data,
     unsigned bytes,
@@ -1043,53 +1491,56 @@ SiameseResult Encoder::Retransmit(SiameseOriginalPacket& originalOut)
     return Siamese_NeedMoreData;
 }
 
-void Encoder::AddDenseColumns(unsigned row, uint8_t* productWorkspace)
+void Encoder::AddDenseColumns(
+    const unsigned* rows,
+    uint8_t* const* recoveryBuffers,
+    uint8_t* const* productWorkspaces,
+    unsigned count)
 {
     const unsigned recoveryBytes = Window.LongestPacket;
 
     // For each lane:
     for (unsigned laneIndex = 0; laneIndex < kColumnLaneCount; ++laneIndex)
     {
-        // Compute the operations to run for this lane and row
-        unsigned opcode = GetRowOpcode(laneIndex, row);
+        // Compute the operations to run for this lane and each row
+        unsigned opcodes[kEncodeBatchMax];
+        unsigned usedMask = 0;
+        for (unsigned i = 0; i < count; ++i)
+        {
+            opcodes[i] = GetRowOpcode(laneIndex, rows[i]);
+            usedMask |= opcodes[i];
+        }
 
-        // For summations into the RecoveryPacket buffer:
-        unsigned mask = 1;
+        // For each running sum in this lane:
         for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex)
         {
-            if (opcode & mask)
-            {
-                const GrowingAlignedDataBuffer* sum = Window.GetSum(laneIndex, sumIndex, Window.Count);
-                unsigned addBytes = sum->Bytes;
+            // Opcode bits for summations into the RecoveryPacket and ProductWorkspace buffers
+            const unsigned recoveryMask = 1 << sumIndex;
+            const unsigned productMask  = 1 << (sumIndex + kColumnSumCount);
 
-                if (addBytes > 0)
-                {
-                    if (addBytes > recoveryBytes) {
-                        addBytes = recoveryBytes;
-                    }
-                    gf256_add_mem(RecoveryPacket.Data, sum->Data, addBytes);
-                }
+            if (0 == (usedMask & (recoveryMask | productMask))) {
+                continue;
             }
-            mask <<= 1;
-        }
 
-        // For summations into the ProductWorkspace buffer:
-        for (unsigned sumIndex = 0; sumIndex < kColumnSumCount; ++sumIndex)
-        {
-            if (opcode & mask)
-            {
-                const GrowingAlignedDataBuffer* sum = Window.GetSum(laneIndex, sumIndex, Window.Count);
-                unsigned addBytes = sum->Bytes;
+            // Look the sum up once and add it to every row that uses it
+            const GrowingAlignedDataBuffer* sum = Window.GetSum(laneIndex, sumIndex, Window.Count);
+            unsigned addBytes = sum->Bytes;
+            if (addBytes <= 0) {
+                continue;
+            }
+            if (addBytes > recoveryBytes) {
+                addBytes = recoveryBytes;
+            }
 
-                if (addBytes > 0)
-                {
-                    if (addBytes > recoveryBytes) {
-                        addBytes = recoveryBytes;
-                    }
-                    gf256_add_mem(productWorkspace, sum->Data, addBytes);
+            for (unsigned i = 0; i < count; ++i)
+            {
+                if (opcodes[i] & recoveryMask) {
+                    gf256_add_mem(recoveryBuffers[i], sum->Data, addBytes);
+                }
+                if (opcodes[i] & productMask) {
+                    gf256_add_mem(productWorkspaces[i], sum->Data, addBytes);
                 }
             }
-            mask <<= 1;
         }
     }
 
@@ -1097,7 +1548,7 @@ void Encoder::AddDenseColumns(unsigned row, uint8_t* productWorkspace)
     Window.SumEndElement = Window.Count;
 }
 
-void Encoder::AddLightColumns(unsigned row, uint8_t* productWorkspace)
+void Encoder::AddLightColumns(unsigned row, uint8_t* recoveryData, uint8_t* productWorkspace)
 {
     const unsigned startElement = Window.FirstUnremovedElement;
     SIAMESE_DEBUG_ASSERT(Window.SumEndElement >= startElement);
@@ -1132,8 +1583,8 @@ void Encoder::AddLightColumns(unsigned row, uint8_t* productWorkspace)
         SIAMESE_DEBUG_ASSERT(Window.LongestPacket >= original1->Buffer.Bytes);
         SIAMESE_DEBUG_ASSERT(Window.LongestPacket >= originalRX->Buffer.Bytes);
 
-        gf256_add_mem(RecoveryPacket.Data, original1->Buffer.Data,  original1->Buffer.Bytes);
-        gf256_add_mem(productWorkspace,    originalRX->Buffer.Data, originalRX->Buffer.Bytes);
+        gf256_add_mem(recoveryData,     original1->Buffer.Data,  original1->Buffer.Bytes);
+        gf256_add_mem(productWorkspace, originalRX->Buffer.Data, originalRX->Buffer.Bytes);
     }
 
     if (pDebugMsg)
@@ -1145,6 +1596,39 @@ void Encoder::AddLightColumns(unsigned row, uint8_t* productWorkspace)
 
 SiameseResult Encoder::Encode(SiameseRecoveryPacket& packet)
 {
+    return EncodeBatch(&packet, 1);
+}
+
+unsigned Encoder::GetMaxRecoveryBytes() const
+{
+    return Window.LongestPacket + kMaxRecoveryMetadataBytes;
+}
+
+SiameseResult Encoder::EncodeInto(
+    uint8_t* buffer,
+    unsigned bufferBytes,
+    SiameseRecoveryPacket& packet)
+{
+    static_assert(kMaxPacketLengthFieldBytes + (unsigned)kMaxRecoveryMetadataBytes <= SIAMESE_ENCODE_INTO_OVERHEAD, "Update this");
+
+    // Window.LongestPacket only shrinks while encoding, so this is an upper bound
+    if (bufferBytes < GetMaxRecoveryBytes())
+    {
+        packet.Data      = nullptr;
+        packet.DataBytes = 0;
+        return Siamese_InvalidInput;
+    }
+
+    return EncodeBatch(&packet, 1, &buffer);
+}
+
+SiameseResult Encoder::EncodeBatch(
+    SiameseRecoveryPacket* packets,
+    unsigned count,
+    uint8_t* const* outputs)
+{
+    SIAMESE_DEBUG_ASSERT(count >= 1 && count <= kEncodeBatchMax);
+
     if (Window.EmergencyDisabled) {
         return Siamese_Disabled;
     }
@@ -1152,7 +1636,9 @@ SiameseResult Encoder::Encode(SiameseRecoveryPacket& packet)
     // If there are no packets so far:
     if (Window.Count <= 0)
     {
-        packet.DataBytes = 0;
+        for (unsigned i = 0; i < count; ++i) {
+            packets[i].DataBytes = 0;
+        }
         return Siamese_NeedMoreData;
     }
 
@@ -1165,8 +1651,15 @@ SiameseResult Encoder::Encode(SiameseRecoveryPacket& packet)
     const unsigned unacknowledgedCount = Window.GetUnacknowledgedCount();
 
     // If there is only a single packet so far:
-    if (unacknowledgedCount == 1) {
-        return GenerateSinglePacket(packet);
+    if (unacknowledgedCount == 1)
+    {
+        // There is only one distinct recovery packet in this case
+        for (unsigned i = 1; i < count; ++i)
+        {
+            packets[i].Data      = nullptr;
+            packets[i].DataBytes = 0;
+        }
+        return GenerateSinglePacket(packets[0], outputs ? outputs[0] : nullptr);
     }
 
     // Calculate upper bound on width of sum for this recovery packet
@@ -1180,7 +1673,7 @@ SiameseResult Encoder::Encode(SiameseRecoveryPacket& packet)
 #ifdef SIAMESE_ENABLE_CAUCHY
         // If the number of packets in flight is small enough, use Cauchy rows for now:
         if (unacknowledgedCount <= SIAMESE_CAUCHY_THRESHOLD) {
-            return GenerateCauchyPacket(packet);
+            return GenerateCauchyPackets(packets, count, outputs);
         }
 #endif // SIAMESE_ENABLE_CAUCHY
 
@@ -1201,58 +1694,114 @@ SiameseResult Encoder::Encode(SiameseRecoveryPacket& packet)
             // Stop using sums
             Window.SumEndElement = Window.SumStartElement;
 
-            return GenerateCauchyPacket(packet);
+            return GenerateCauchyPackets(packets, count, outputs);
         }
     }
 #endif // SIAMESE_ENABLE_CAUCHY
 
-    // Advance row index
-    const unsigned row = NextRow;
-    if (++NextRow >= kRowPeriod) {
-        NextRow = 0;
+    // Advance row index for each packet
+    unsigned rows[kEncodeBatchMax];
+    for (unsigned i = 0; i < count; ++i)
+    {
+        rows[i] = NextRow;
+        if (++NextRow >= kRowPeriod) {
+            NextRow = 0;
+        }
     }
 
     // Reset workspaces
     const unsigned recoveryBytes = Window.LongestPacket;
     const unsigned alignedBytes = pktalloc::NextAlignedOffset(recoveryBytes);
-    if (!RecoveryPacket.Initialize(&TheAllocator, 2 * alignedBytes + kMaxRecoveryMetadataBytes))
+    uint8_t* recoveryBuffers[kEncodeBatchMax];
+    uint8_t* productWorkspaces[kEncodeBatchMax];
+    for (unsigned i = 0; i < count; ++i)
     {
-        Window.EmergencyDisabled = true;
-        return Siamese_Disabled;
-    }
-    SIAMESE_DEBUG_ASSERT(RecoveryPacket.Bytes >= alignedBytes * 2);
-    memset(RecoveryPacket.Data, 0, alignedBytes * 2);
-    uint8_t* productWorkspace = RecoveryPacket.Data + alignedBytes;
+        // If writing to application memory, only the product workspace is ours
+        if (outputs)
+        {
+            GrowingAlignedDataBuffer& productWorkspace = ProductWorkspaces[i];
+            if (!productWorkspace.Initialize(&TheAllocator, alignedBytes))
+            {
+                Window.EmergencyDisabled = true;
+                return Siamese_Disabled;
+            }
+            recoveryBuffers[i]   = outputs[i];
+            productWorkspaces[i] = productWorkspace.Data;
+            memset(recoveryBuffers[i], 0, recoveryBytes);
+            memset(productWorkspaces[i], 0, alignedBytes);
+            continue;
+        }
 
-    // Generate the recovery packet
-    AddDenseColumns(row, productWorkspace);
-    AddLightColumns(row, productWorkspace);
+        GrowingAlignedDataBuffer& recoveryPacket = RecoveryPackets[i];
+        if (!recoveryPacket.Initialize(&TheAllocator, 2 * alignedBytes + kMaxRecoveryMetadataBytes))
+        {
+            Window.EmergencyDisabled = true;
+            return Siamese_Disabled;
+        }
+        SIAMESE_DEBUG_ASSERT(recoveryPacket.Bytes >= alignedBytes * 2);
+        memset(recoveryPacket.Data, 0, alignedBytes * 2);
+        recoveryBuffers[i]   = recoveryPacket.Data;
+        productWorkspaces[i] = recoveryPacket.Data + alignedBytes;
+    }
 
-    // RecoveryPacket += RX * ProductWorkspace
-    const uint8_t RX = GetRowValue(row);
-    gf256_muladd_mem(RecoveryPacket.Data, RX, productWorkspace, recoveryBytes);
+    // Generate the recovery packets: Each lane sum is visited once for all rows
+    AddDenseColumns(rows, recoveryBuffers, productWorkspaces, count);
 
     RecoveryMetadata metadata;
     SIAMESE_DEBUG_ASSERT(Window.SumEndElement + Window.SumErasedCount >= Window.SumStartElement);
     metadata.SumCount    = Window.SumEndElement - Window.SumStartElement + Window.SumErasedCount;
     metadata.LDPCCount   = unacknowledgedCount;
     metadata.ColumnStart = Window.SumColumnStart;
-    metadata.Row         = row;
 
-    // Serialize metadata into the last few bytes of the packet
-    // Note: This saves an extra copy to move the data around
-    const unsigned footerBytes = SerializeFooter_RecoveryMetadata(metadata, RecoveryPacket.Data + recoveryBytes);
-    packet.Data      = RecoveryPacket.Data;
-    packet.DataBytes = recoveryBytes + footerBytes;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        uint8_t* recoveryData = recoveryBuffers[i];
 
-    Stats.Counts[SiameseEncoderStats_RecoveryCount]++;
-    Stats.Counts[SiameseEncoderStats_RecoveryBytes] += packet.DataBytes;
+        AddLightColumns(rows[i], recoveryData, productWorkspaces[i]);
 
-    Logger.Info("Generated Siamese sum recovery packet start=", metadata.ColumnStart, " ldpcCount=", metadata.LDPCCount, " sumCount=", metadata.SumCount, " row=", metadata.Row);
+        // RecoveryPacket += RX * ProductWorkspace
+        const uint8_t RX = GetRowValue(rows[i]);
+        gf256_muladd_mem(recoveryData, RX, productWorkspaces[i], recoveryBytes);
+
+        metadata.Row = rows[i];
+
+        // Serialize metadata into the last few bytes of the packet
+        // Note: This saves an extra copy to move the data around
+        const unsigned footerBytes = SerializeFooter_RecoveryMetadata(metadata, recoveryData + recoveryBytes);
+        packets[i].Data      = recoveryData;
+        packets[i].DataBytes = recoveryBytes + footerBytes;
+
+        Stats.Counts[SiameseEncoderStats_RecoveryCount]++;
+        Stats.Counts[SiameseEncoderStats_RecoveryBytes] += packets[i].DataBytes;
+
+        Logger.Info("Generated Siamese sum recovery packet start=", metadata.ColumnStart, " ldpcCount=", metadata.LDPCCount, " sumCount=", metadata.SumCount, " row=", metadata.Row);
+    }
 
     return Siamese_Success;
 }
 
+SiameseResult Encoder::IdleWork(unsigned budgetUsec)
+{
+    if (Window.EmergencyDisabled) {
+        return Siamese_Disabled;
+    }
+
+    const uint64_t deadlineUsec = (budgetUsec > 0) ? GetTimeUsec() + budgetUsec : 0;
+
+    // Remove acknowledged data here instead of during the next Encode()
+    if (Window.Count > 0 && Window.FirstUnremovedElement >= kEncoderRemoveThreshold) {
+        Window.RemoveElements();
+    }
+
+    const bool caughtUp = Window.AccumulateSums(deadlineUsec);
+
+    if (Window.EmergencyDisabled) {
+        return Siamese_Disabled;
+    }
+
+    return caughtUp ? Siamese_Success : Siamese_NeedMoreData;
+}
+
 SiameseResult Encoder::Get(SiameseOriginalPacket& originalOut)
 {
     // Note: Keep this in sync with Decoder::Get
@@ -1293,20 +1842,41 @@ SiameseResult Encoder::Get(SiameseOriginalPacket& originalOut)
     return Siamese_Success;
 }
 
-SiameseResult Encoder::GenerateSinglePacket(SiameseRecoveryPacket& packet)
+SiameseResult Encoder::GenerateSinglePacket(SiameseRecoveryPacket& packet, uint8_t* output)
 {
     OriginalPacket* original     = Window.GetWindowElement(Window.FirstUnremovedElement);
     const unsigned originalBytes = original->Buffer.Bytes;
+    uint8_t* recoveryData        = original->Buffer.Data;
 
-    // Note: This often does not actually reallocate or move since we overallocate
-    if (!original->Buffer.GrowZeroPadded(&TheAllocator, originalBytes + kMaxRecoveryMetadataBytes))
+    if (output)
     {
-        Window.EmergencyDisabled = true;
-        return Siamese_Disabled;
+        recoveryData = output;
+        memcpy(recoveryData, original->Buffer.Data, originalBytes);
+    }
+    // Application memory cannot grow, so copy it out to make room for the footer
+    else if (original->IsExternal())
+    {
+        if (!RecoveryPackets[0].Initialize(&TheAllocator, originalBytes + kMaxRecoveryMetadataBytes))
+        {
+            Window.EmergencyDisabled = true;
+            return Siamese_Disabled;
+        }
+        recoveryData = RecoveryPackets[0].Data;
+        memcpy(recoveryData, original->Buffer.Data, originalBytes);
     }
+    else
+    {
+        // Note: This often does not actually reallocate or move since we overallocate
+        if (!original->Buffer.GrowZeroPadded(&TheAllocator, originalBytes + kMaxRecoveryMetadataBytes))
+        {
+            Window.EmergencyDisabled = true;
+            return Siamese_Disabled;
+        }
 
-    // Set bytes back to original
-    original->Buffer.Bytes = originalBytes;
+        // Set bytes back to original
+        original->Buffer.Bytes = originalBytes;
+        recoveryData = original->Buffer.Data;
+    }
 
     // Serialize metadata into the last few bytes of the packet
     // Note: This saves an extra copy to move the data around
@@ -1316,8 +1886,8 @@ SiameseResult Encoder::GenerateSinglePacket(SiameseRecoveryPacket& packet)
     metadata.ColumnStart = original->Column;
     metadata.Row         = 0;
 
-    const unsigned footerBytes = SerializeFooter_RecoveryMetadata(metadata, original->Buffer.Data + originalBytes);
-    packet.Data      = original->Buffer.Data;
+    const unsigned footerBytes = SerializeFooter_RecoveryMetadata(metadata, recoveryData + originalBytes);
+    packet.Data      = recoveryData;
     packet.DataBytes = originalBytes + footerBytes;
 
     Logger.Info("Generated single recovery packet start=", metadata.ColumnStart, " ldpcCount=", metadata.LDPCCount, " sumCount=", metadata.SumCount, " row=", metadata.Row);
@@ -1331,15 +1901,28 @@ SiameseResult Encoder::GenerateSinglePacket(SiameseRecoveryPacket& packet)
 
 #ifdef SIAMESE_ENABLE_CAUCHY
 
-SiameseResult Encoder::GenerateCauchyPacket(SiameseRecoveryPacket& packet)
+SiameseResult Encoder::GenerateCauchyPackets(
+    SiameseRecoveryPacket* packets,
+    unsigned count,
+    uint8_t* const* outputs)
 {
-    // Reset recovery packet
+    // Reset recovery packets
     const unsigned firstElement  = Window.FirstUnremovedElement;
     const unsigned recoveryBytes = Window.LongestPacket;
-    if (!RecoveryPacket.Initialize(&TheAllocator, recoveryBytes + kMaxRecoveryMetadataBytes))
+    uint8_t* recoveryBuffers[kEncodeBatchMax];
+    for (unsigned i = 0; i < count; ++i)
     {
-        Window.EmergencyDisabled = true;
-        return Siamese_Disabled;
+        if (outputs) {
+            recoveryBuffers[i] = outputs[i];
+            continue;
+        }
+
+        if (!RecoveryPackets[i].Initialize(&TheAllocator, recoveryBytes + kMaxRecoveryMetadataBytes))
+        {
+            Window.EmergencyDisabled = true;
+            return Siamese_Disabled;
+        }
+        recoveryBuffers[i] = RecoveryPackets[i].Data;
     }
 
     const unsigned unacknowledgedCount = Window.GetUnacknowledgedCount();
@@ -1348,94 +1931,103 @@ SiameseResult Encoder::GenerateCauchyPacket(SiameseRecoveryPacket& packet)
     metadata.LDPCCount   = unacknowledgedCount;
     metadata.ColumnStart = Window.ElementToColumn(firstElement);
 
-    // We have to recalculate the number of used bytes since the Cauchy/parity rows may be
-    // shorter since they do not need to contain the start of the window which may be acked.
-    unsigned usedBytes = 0;
-
-    // If it is time to generate a new parity row:
-    const unsigned nextParityElement = Window.ColumnToElement(NextParityColumn);
-    if (nextParityElement <= firstElement || IsColumnDeltaNegative(nextParityElement))
+    // Select the row for each packet.  Row 0 is a parity row, and the rest
+    // are Cauchy rows offset by one
+    unsigned rows[kEncodeBatchMax];
+    for (unsigned i = 0; i < count; ++i)
     {
-        // Set next time we write a parity row
-        NextParityColumn = AddColumns(metadata.ColumnStart, unacknowledgedCount);
+        // If it is time to generate a new parity row:
+        const unsigned nextParityElement = Window.ColumnToElement(NextParityColumn);
+        if (nextParityElement <= firstElement || IsColumnDeltaNegative(nextParityElement))
+        {
+            // Set next time we write a parity row
+            NextParityColumn = AddColumns(metadata.ColumnStart, unacknowledgedCount);
 
-        // Row 0 is a parity row
-        metadata.Row = 0;
+            rows[i] = 0;
+        }
+        else
+        {
+            // Select Cauchy row number
+            rows[i] = NextCauchyRow + 1;
+            if (++NextCauchyRow >= kCauchyMaxRows)
+                NextCauchyRow = 0;
+        }
+    }
 
-        // Unroll first column
-        OriginalPacket* original = Window.GetWindowElement(firstElement);
-        unsigned originalBytes   = original->Buffer.Bytes;
+    // Unroll first column
+    unsigned cauchyColumn    = metadata.ColumnStart % kCauchyMaxColumns;
+    OriginalPacket* original = Window.GetWindowElement(firstElement);
+    unsigned originalBytes   = original->Buffer.Bytes;
+    SIAMESE_DEBUG_ASSERT(recoveryBytes >= originalBytes);
 
-        memcpy(RecoveryPacket.Data, original->Buffer.Data, originalBytes);
-        // Pad the rest out with zeros to avoid corruption
-        SIAMESE_DEBUG_ASSERT(RecoveryPacket.Bytes >= originalBytes);
-        memset(RecoveryPacket.Data + originalBytes, 0, recoveryBytes - originalBytes);
+    MulAddMultiGather cauchyGathers[kEncodeBatchMax];
 
-        usedBytes = originalBytes;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        uint8_t* recoveryData = recoveryBuffers[i];
 
-        // For each remaining column:
-        for (unsigned element = firstElement + 1, count = Window.Count; element < count; ++element)
-        {
-            original      = Window.GetWindowElement(element);
-            originalBytes = original->Buffer.Bytes;
+        if (rows[i] == 0) {
+            memcpy(recoveryData, original->Buffer.Data, originalBytes);
+        }
+        else {
+            const uint8_t y = CauchyElement(rows[i] - 1, cauchyColumn);
+            gf256_mul_mem(recoveryData, original->Buffer.Data, y, originalBytes);
+            cauchyGathers[i].Reset(recoveryData, recoveryBytes);
+        }
 
-            SIAMESE_DEBUG_ASSERT(RecoveryPacket.Bytes >= originalBytes);
+        // Pad the rest out with zeros to avoid corruption
+        memset(recoveryData + originalBytes, 0, recoveryBytes - originalBytes);
+    }
 
-            gf256_add_mem(RecoveryPacket.Data, original->Buffer.Data, originalBytes);
+    // We have to recalculate the number of used bytes since the Cauchy/parity rows may be
+    // shorter since they do not need to contain the start of the window which may be acked.
+    unsigned usedBytes = originalBytes;
 
-            if (usedBytes < originalBytes)
-                usedBytes = originalBytes;
-        }
-    }
-    else
+    // For each remaining column:
+    // Each original is gathered for every packet, so the gathers all flush
+    // while the same group of originals is still in cache
+    for (unsigned element = firstElement + 1, windowCount = Window.Count; element < windowCount; ++element)
     {
-        // Select Cauchy row number
-        const unsigned cauchyRow = NextCauchyRow;
-        metadata.Row = cauchyRow + 1;
-        if (++NextCauchyRow >= kCauchyMaxRows)
-            NextCauchyRow = 0;
-
-        // Unroll first column
-        unsigned cauchyColumn    = metadata.ColumnStart % kCauchyMaxColumns;
-        OriginalPacket* original = Window.GetWindowElement(firstElement);
-        uint8_t y                = CauchyElement(cauchyRow, cauchyColumn);
-        unsigned originalBytes   = original->Buffer.Bytes;
-
-        gf256_mul_mem(RecoveryPacket.Data, original->Buffer.Data, y, originalBytes);
-        // Pad the rest out with zeros to avoid corruption
-        SIAMESE_DEBUG_ASSERT(recoveryBytes >= originalBytes);
-        SIAMESE_DEBUG_ASSERT(RecoveryPacket.Bytes >= originalBytes);
-        memset(RecoveryPacket.Data + originalBytes, 0, recoveryBytes - originalBytes);
+        cauchyColumn  = (cauchyColumn + 1) % kCauchyMaxColumns;
+        original      = Window.GetWindowElement(element);
+        originalBytes = original->Buffer.Bytes;
 
-        usedBytes = originalBytes;
+        SIAMESE_DEBUG_ASSERT(recoveryBytes >= originalBytes);
 
-        // For each remaining column:
-        for (unsigned element = firstElement + 1, count = Window.Count; element < count; ++element)
+        for (unsigned i = 0; i < count; ++i)
         {
-            cauchyColumn  = (cauchyColumn + 1) % kCauchyMaxColumns;
-            original      = Window.GetWindowElement(element);
-            originalBytes = original->Buffer.Bytes;
-            y             = CauchyElement(cauchyRow, cauchyColumn);
-
-            SIAMESE_DEBUG_ASSERT(RecoveryPacket.Bytes >= originalBytes);
-
-            gf256_muladd_mem(RecoveryPacket.Data, y, original->Buffer.Data, originalBytes);
-
-            if (usedBytes < originalBytes)
-                usedBytes = originalBytes;
+            // Parity rows use the cheaper XOR kernel
+            if (rows[i] == 0) {
+                gf256_add_mem(recoveryBuffers[i], original->Buffer.Data, originalBytes);
+            }
+            else
+            {
+                const uint8_t y = CauchyElement(rows[i] - 1, cauchyColumn);
+                cauchyGathers[i].Add(y, original->Buffer.Data, originalBytes);
+            }
         }
+
+        if (usedBytes < originalBytes)
+            usedBytes = originalBytes;
     }
 
-    // Slap metadata footer on the end
-    const unsigned footerBytes = SerializeFooter_RecoveryMetadata(metadata, RecoveryPacket.Data + usedBytes);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        cauchyGathers[i].Flush();
 
-    packet.Data      = RecoveryPacket.Data;
-    packet.DataBytes = usedBytes + footerBytes;
+        // Slap metadata footer on the end
+        metadata.Row = rows[i];
+        uint8_t* recoveryData = recoveryBuffers[i];
+        const unsigned footerBytes = SerializeFooter_RecoveryMetadata(metadata, recoveryData + usedBytes);
 
-    Logger.Info("Generated Cauchy/parity recovery packet start=", metadata.ColumnStart, " ldpcCount=", metadata.LDPCCount, " sumCount=", metadata.SumCount, " row=", metadata.Row);
+        packets[i].Data      = recoveryData;
+        packets[i].DataBytes = usedBytes + footerBytes;
 
-    Stats.Counts[SiameseEncoderStats_RecoveryCount]++;
-    Stats.Counts[SiameseEncoderStats_RecoveryBytes] += packet.DataBytes;
+        Logger.Info("Generated Cauchy/parity recovery packet start=", metadata.ColumnStart, " ldpcCount=", metadata.LDPCCount, " sumCount=", metadata.SumCount, " row=", metadata.Row);
+
+        Stats.Counts[SiameseEncoderStats_RecoveryCount]++;
+        Stats.Counts[SiameseEncoderStats_RecoveryBytes] += packets[i].DataBytes;
+    }
 
     return Siamese_Success;
 }
@@ -1449,6 +2041,11 @@ SiameseResult Encoder::GetStatistics(uint64_t* statsOut, unsigned statsCount)
 
     // Fill in memory allocated
     Stats.Counts[SiameseEncoderStats_MemoryUsed] = TheAllocator.GetMemoryAllocatedBytes();
+    Stats.Counts[SiameseEncoderStats_FallbackAllocateCount] = TheAllocator.GetFallbackAllocateCount();
+    if (Pipeline) {
+        Stats.Counts[SiameseEncoderStats_MemoryUsed] += Pipeline->GetMemoryAllocatedBytes();
+        Stats.Counts[SiameseEncoderStats_FallbackAllocateCount] += Pipeline->GetFallbackAllocateCount();
+    }
 
     for (unsigned i = 0; i < statsCount; ++i)
         statsOut[i] = Stats.Counts[i];
@@ -78,6 +78,11 @@ struct EncoderColumnLane
     /// Running sums.  See kColumnSumCount definition
     GrowingAlignedDataBuffer Sum[kColumnSumCount];
 
+    /// Checkpointed sum of the lane elements before SumStartElement.
+    /// Adding this to the running sum gives the value to checkpoint
+    GrowingAlignedDataBuffer CheckpointBase[kColumnSumCount];
+    SumCheckpointBase BaseState[kColumnSumCount];
+
     /// Longest packet in this lane
     /// Note: I think it's a win to keep this per-lane because if the
     /// data size is highly variable we may reduce memory accesses
@@ -85,12 +90,37 @@ struct EncoderColumnLane
 };
 
 
+//------------------------------------------------------------------------------
+// Encoder Sum Checkpoints
+
+/*
+    Running sum checkpoints: See SumCheckpoint
+
+    The encoder resets its running sums when the sum range grows too large,
+    and then every unacknowledged original would be accumulated again.
+    Instead the window keeps a snapshot of the sums every
+    kEncoderCheckpointInterval elements, all summed from
+    SumCheckpointColumnStart.  After a reset, the CheckpointBase of each sum
+    is calculated from the nearest snapshot to the new start, and the sum
+    resumes from the last snapshot before the end of the window.
+
+    Original data never changes once it is in the window, so unlike the
+    decoder the snapshots stay valid until they fall out of the window.
+*/
+
+/// Number of window elements between running sum checkpoints.
+/// Each checkpoint holds a copy of every lane sum, so this trades memory for
+/// how far a sum must be accumulated again after it is reset
+static const unsigned kEncoderCheckpointInterval = 16 * kSubwindowSize;
+static_assert(kEncoderCheckpointInterval % kSubwindowSize == 0, "Checkpoints are on subwindow boundaries");
+
+
 //------------------------------------------------------------------------------
 // EncoderSubwindow
 
 struct EncoderSubwindow
 {
-    /// Original packets in this subwindow indexed by packet number
+    /// Original packets in this subwindow indexed by GetSubwindowSlot()
     std::array<OriginalPacket, kSubwindowSize> Originals;
 
     /// Timestamp at which we last sent the packet
@@ -130,14 +160,23 @@ struct EncoderPacketWindow
     unsigned SumColumnStart = 0;
     unsigned SumErasedCount = 0;
 
-    /// Allocated Subwindows
-    pktalloc::LightVector<EncoderSubwindow*> Subwindows;
+    /// Allocated Subwindows, with removed ones recycled at the back
+    SubwindowRing<EncoderSubwindow> Subwindows;
 
     /// Running summations for each lane
     EncoderColumnLane Lanes[kColumnLaneCount];
 
-    /// Temporary workspace reused each time subwindows must be shifted
-    pktalloc::LightVector<EncoderSubwindow*> SubwindowsShift;
+    /// Running sum checkpoints, spaced kEncoderCheckpointInterval elements
+    /// apart beginning at SumCheckpointColumnFirst
+    pktalloc::LightVector<SumCheckpoint*> SumCheckpoints;
+    unsigned SumCheckpointColumnFirst = 0;
+
+    /// Column that all checkpoints are summed from
+    unsigned SumCheckpointColumnStart = 0;
+    bool SumCheckpointStartInWindow = false;
+
+    /// Have checkpoints been started?
+    bool HasSumCheckpoints = false;
 
     /// If input is invalid or we run out of memory, the encoder is disabled
     /// to prevent it from allowing exploits to run or cause crashes
@@ -170,7 +209,7 @@ struct EncoderPacketWindow
     SIAMESE_FORCE_INLINE OriginalPacket* GetWindowElement(unsigned windowElement)
     {
         SIAMESE_DEBUG_ASSERT(windowElement < Count);
-        return &(Subwindows.GetRef(windowElement / kSubwindowSize)->Originals[windowElement % kSubwindowSize]);
+        return &(Subwindows.GetRef(windowElement / kSubwindowSize)->Originals[GetSubwindowSlot(windowElement)]);
     }
 
     /// Get element send timestamp from the window, indexed by window offset not column number
@@ -178,7 +217,7 @@ struct EncoderPacketWindow
     SIAMESE_FORCE_INLINE uint32_t* GetWindowElementTimestampPtr(unsigned windowElement)
     {
         SIAMESE_DEBUG_ASSERT(windowElement < Count);
-        return &(Subwindows.GetRef(windowElement / kSubwindowSize)->LastSendMsec[windowElement % kSubwindowSize]);
+        return &(Subwindows.GetRef(windowElement / kSubwindowSize)->LastSendMsec[GetSubwindowSlot(windowElement)]);
     }
 
     /// How many slots remain in the window?
@@ -188,8 +227,21 @@ struct EncoderPacketWindow
         return SIAMESE_MAX_PACKETS - Count;
     }
 
-    /// Append a packet to the end of the set
-    SiameseResult Add(SiameseOriginalPacket& packet);
+    /// Append a packet to the end of the set.
+    /// If segments is not nullptr the packet data is gathered from them.
+    /// If release is not nullptr the packet data is referenced in place
+    SiameseResult Add(
+        SiameseOriginalPacket& packet,
+        const SiameseSegment* segments = nullptr,
+        unsigned segmentCount = 0,
+        SiameseReleaseCallback release = nullptr,
+        void* context = nullptr);
+
+    /// Hand back application memory for all elements in the given range
+    void ReleaseElements(unsigned elementStart, unsigned elementEnd);
+
+    /// Hand back application memory for every element in every subwindow
+    void ReleaseAllElements();
 
     /// Removes elements up to the given column
     void RemoveBefore(unsigned firstKeptColumn);
@@ -214,6 +266,45 @@ struct EncoderPacketWindow
     /// Get running sums for a lane
     const GrowingAlignedDataBuffer* GetSum(unsigned laneIndex, unsigned sumIndex, unsigned elementEnd);
 
+    /// Add one window element into a running sum buffer
+    bool AccumulateSumElement(
+        GrowingAlignedDataBuffer& sumBuffer,
+        unsigned laneIndex,
+        unsigned sumIndex,
+        unsigned element);
+
+    /// Begin checkpointing sums from the given element if there are no
+    /// snapshots to keep
+    void StartSumCheckpoints(unsigned elementStart);
+
+    /// Drop all checkpoints, for example when the window is started over
+    void ClearSumCheckpoints();
+
+    /// Make sure the checkpoint base for a sum is valid.
+    /// Returns false if the sum cannot be checkpointed
+    bool PrepareSumCheckpointBase(unsigned laneIndex, unsigned sumIndex);
+
+    /// Resume a running sum from the furthest valid checkpoint that does not
+    /// pass the given end element, if it is ahead of the sum
+    bool LoadSumCheckpoint(unsigned laneIndex, unsigned sumIndex, unsigned elementEnd);
+
+    /// Save a running sum into the given checkpoint
+    bool SaveSumCheckpoint(unsigned checkpointIndex, unsigned laneIndex, unsigned sumIndex);
+
+    /// Drop checkpoints that have fallen out of the front of the window
+    void RemoveSumCheckpoints(unsigned removedElementCount);
+
+    /// Get the element at which the first checkpoint is taken
+    SIAMESE_FORCE_INLINE unsigned GetFirstSumCheckpointElement() const
+    {
+        return ColumnToElement(SumCheckpointColumnFirst);
+    }
+
+    /// Fold new originals into all of the running sums ahead of time, so the
+    /// next Encode() call has less catch-up work.  Stops after deadlineUsec
+    /// unless it is 0.  Returns true if the sums caught up with the window
+    bool AccumulateSums(uint64_t deadlineUsec);
+
     /// Returns the number of elements that have not been acknowledged yet
     unsigned GetUnacknowledgedCount()
     {
@@ -334,22 +425,80 @@ protected:
 static const unsigned kEncoderRemoveThreshold = 2 * kSubwindowSize;
 static_assert(kEncoderRemoveThreshold % kSubwindowSize == 0, "It removes on window boundaries");
 
+/// Number of elements folded into the sums between deadline checks in IdleWork()
+static const unsigned kIdleWorkChunkElements = 16 * kColumnLaneCount;
+
+/// Maximum number of recovery packets generated by one EncodeBatch() call
+static const unsigned kEncodeBatchMax = SIAMESE_MAX_ENCODE_BATCH;
+
+class EncoderPipeline;
+
 class Encoder
 {
+    friend class EncoderPipeline;
+
 public:
-    Encoder();
+    /// Optionally takes allocator windows from a pool shared with other codecs
+    explicit Encoder(pktalloc::WindowPool* pool = nullptr);
+    ~Encoder();
+
+    /// Background worker, if running.  See SiameseEncoderPipeline.h
+    EncoderPipeline* Pipeline = nullptr;
+
+    /// Start the background worker
+    SiameseResult StartPipeline(unsigned readyCount);
+
+    /// Stop the background worker, applying any queued packets
+    void StopPipeline();
 
     SIAMESE_FORCE_INLINE unsigned GetRemainingSlots() const
     {
         return Window.GetRemainingSlots();
     }
 
+    /// Packet number that will be assigned to the next packet
+    SIAMESE_FORCE_INLINE unsigned GetNextPacketNum() const
+    {
+        return Window.NextColumn;
+    }
+
+    /// First column that has not been acknowledged, or the next packet
+    /// number if the window is empty
+    SIAMESE_FORCE_INLINE unsigned GetFirstUnacknowledgedColumn() const
+    {
+        if (Window.Count == 0) {
+            return Window.NextColumn;
+        }
+        return Window.ElementToColumn(Window.FirstUnremovedElement);
+    }
+
+    /// Buffer size that EncodeInto() needs for the current window
+    unsigned GetMaxRecoveryBytes() const;
+
     /// Add an original data packet to the encoder
     SIAMESE_FORCE_INLINE SiameseResult Add(SiameseOriginalPacket& packet)
     {
         return Window.Add(packet);
     }
 
+    /// Add an original data packet to the encoder without copying it
+    SIAMESE_FORCE_INLINE SiameseResult AddZeroCopy(
+        SiameseOriginalPacket& packet,
+        SiameseReleaseCallback release,
+        void* context)
+    {
+        return Window.Add(packet, nullptr, 0, release, context);
+    }
+
+    /// Add an original data packet gathered from several segments
+    SIAMESE_FORCE_INLINE SiameseResult AddSegments(
+        SiameseOriginalPacket& packet,
+        const SiameseSegment* segments,
+        unsigned segmentCount)
+    {
+        return Window.Add(packet, segments, segmentCount);
+    }
+
     /// Remove original data packet up to the given column
     SIAMESE_FORCE_INLINE void RemoveBefore(unsigned firstKeptColumn)
     {
@@ -368,6 +517,25 @@ public:
     /// Generate the next recovery packet for the data
     SiameseResult Encode(SiameseRecoveryPacket& recoveryOut);
 
+    /// Generate the next 'count' recovery packets for the data in one pass.
+    /// If outputs is not nullptr, packet i is written to outputs[i], which must
+    /// hold Window.LongestPacket + kMaxRecoveryMetadataBytes bytes.
+    /// Precondition: 1 <= count <= kEncodeBatchMax
+    SiameseResult EncodeBatch(
+        SiameseRecoveryPacket* recoveryOut,
+        unsigned count,
+        uint8_t* const* outputs = nullptr);
+
+    /// Generate the next recovery packet directly into application memory
+    SiameseResult EncodeInto(
+        uint8_t* buffer,
+        unsigned bufferBytes,
+        SiameseRecoveryPacket& recoveryOut);
+
+    /// Do deferred encoder work while the application is idle.
+    /// If budgetUsec is 0 then all of the pending work is done
+    SiameseResult IdleWork(unsigned budgetUsec);
+
     /// Get a packet in the set
     SiameseResult Get(SiameseOriginalPacket& packet);
 
@@ -387,8 +555,13 @@ protected:
     /// Acknowledgement state
     EncoderAcknowledgementState Ack;
 
-    /// Keeps a copy of the last recovery packet to speed up generating the next one
-    GrowingAlignedDataBuffer RecoveryPacket;
+    /// Keeps a copy of the last recovery packets to speed up generating the next ones.
+    /// Encode() uses the first one, and EncodeBatch() uses one per packet
+    GrowingAlignedDataBuffer RecoveryPackets[kEncodeBatchMax];
+
+    /// Product workspaces used when writing to application memory, so that
+    /// packets returned from RecoveryPackets are left intact
+    GrowingAlignedDataBuffer ProductWorkspaces[kEncodeBatchMax];
 
     /// Next row to generate for Siamese rows
     unsigned NextRow = 0;
@@ -402,16 +575,25 @@ protected:
 #endif // SIAMESE_ENABLE_CAUCHY
 
 
-    /// Normal case of generating recovery packet
-    void AddDenseColumns(unsigned row, uint8_t* productWorkspace);
-    void AddLightColumns(unsigned row, uint8_t* productWorkspace);
+    /// Normal case of generating recovery packets.
+    /// AddDenseColumns() handles all of the rows at once so each lane sum is read once
+    void AddDenseColumns(
+        const unsigned* rows,
+        uint8_t* const* recoveryBuffers,
+        uint8_t* const* productWorkspaces,
+        unsigned count);
+    void AddLightColumns(unsigned row, uint8_t* recoveryData, uint8_t* productWorkspace);
 
-    /// Generate output for the case of a single input packet
-    SiameseResult GenerateSinglePacket(SiameseRecoveryPacket& packet);
+    /// Generate output for the case of a single input packet.
+    /// If output is not nullptr the packet is written there
+    SiameseResult GenerateSinglePacket(SiameseRecoveryPacket& packet, uint8_t* output);
 
 #ifdef SIAMESE_ENABLE_CAUCHY
     /// Generate output for the case of a small number of input packets
-    SiameseResult GenerateCauchyPacket(SiameseRecoveryPacket& packet);
+    SiameseResult GenerateCauchyPackets(
+        SiameseRecoveryPacket* packets,
+        unsigned count,
+        uint8_t* const* outputs);
 #endif // SIAMESE_ENABLE_CAUCHY
 
     /// Attempt to retransmit the given original data
@@ -0,0 +1,393 @@
+/** \file
+    \brief Siamese FEC Implementation: Encoder Pipeline
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of Siamese nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SiameseEncoderPipeline.h"
+
+#include <chrono>
+
+namespace siamese {
+
+#ifdef SIAMESE_ENCODER_DUMP_VERBOSE
+    static logger::Channel Logger("EncoderPipeline", logger::Level::Debug);
+#else
+    static logger::Channel Logger("EncoderPipeline", logger::Level::Silent);
+#endif
+
+
+//------------------------------------------------------------------------------
+// EncoderPipeline
+
+bool EncoderPipeline::Start(Encoder* encoder, unsigned readyCount)
+{
+    SIAMESE_DEBUG_ASSERT(encoder && !Thread);
+    SIAMESE_DEBUG_ASSERT(readyCount >= 1 && readyCount <= SIAMESE_PIPELINE_MAX_READY);
+
+    TheEncoder    = encoder;
+    ReadyTarget   = readyCount;
+    SlotCount     = readyCount + kPipelineExtraSlots;
+    NextPacketNum = encoder->GetNextPacketNum();
+    RemainingSlots.store(encoder->GetRemainingSlots());
+    WindowStart.store(encoder->GetFirstUnacknowledgedColumn());
+
+    Terminated = false;
+
+    try
+    {
+        Thread = std::make_shared<std::thread>(&EncoderPipeline::Loop, this);
+    }
+    catch (std::system_error& /*err*/)
+    {
+        Logger.Error("Failed to start pipeline thread");
+        return false;
+    }
+
+    return true;
+}
+
+void EncoderPipeline::Stop()
+{
+    if (!Thread) {
+        return;
+    }
+
+    Terminated = true;
+
+    // Make sure that the notification happens after the termination flag is set
+    {
+        std::unique_lock<std::mutex> locker(WakeLock);
+        WakeCondition.notify_all();
+    }
+
+    try
+    {
+        if (Thread->joinable())
+            Thread->join();
+    }
+    catch (std::system_error& /*err*/)
+    {
+    }
+    Thread = nullptr;
+
+    // Do not lose packets that were queued after the worker stopped
+    std::lock_guard<std::mutex> locker(EncoderLock);
+    DrainAdds();
+}
+
+unsigned EncoderPipeline::GetMemoryAllocatedBytes() const
+{
+    return AppAllocator.GetMemoryAllocatedBytes() + WorkerAllocator.GetMemoryAllocatedBytes();
+}
+
+unsigned EncoderPipeline::GetFallbackAllocateCount() const
+{
+    return AppAllocator.GetFallbackAllocateCount() + WorkerAllocator.GetFallbackAllocateCount();
+}
+
+unsigned EncoderPipeline::GetRemainingSlots() const
+{
+    const unsigned writeIndex = AddWriteIndex.load(std::memory_order_relaxed);
+    const unsigned readIndex  = AddReadIndex.load(std::memory_order_acquire);
+    const unsigned queued     = writeIndex - readIndex;
+    const unsigned remaining  = RemainingSlots.load(std::memory_order_relaxed);
+
+    return (remaining > queued) ? remaining - queued : 0;
+}
+
+SiameseResult EncoderPipeline::Add(SiameseOriginalPacket& packet)
+{
+    if (Disabled) {
+        return Siamese_Disabled;
+    }
+
+    unsigned writeIndex = AddWriteIndex.load(std::memory_order_relaxed);
+
+    // If the worker has fallen behind, apply the queued adds here
+    if (writeIndex - AddReadIndex.load(std::memory_order_acquire) >= kPipelineAddQueueSize)
+    {
+        std::lock_guard<std::mutex> locker(EncoderLock);
+        DrainAdds();
+    }
+
+    // This is not invalid input.  See EncoderPacketWindow::Add()
+    if (GetRemainingSlots() <= 0) {
+        return Siamese_MaxPacketsReached;
+    }
+
+    QueuedAdd& queued = AddQueue[writeIndex % kPipelineAddQueueSize];
+    if (!queued.Buffer.Initialize(&AppAllocator, packet.DataBytes))
+    {
+        Disabled = true;
+        Logger.Error("Add.Initialize OOM");
+        return Siamese_Disabled;
+    }
+    memcpy(queued.Buffer.Data, packet.Data, packet.DataBytes);
+    queued.DataBytes = packet.DataBytes;
+
+    // Assign the packet number the encoder will give it
+    packet.PacketNum = NextPacketNum;
+    NextPacketNum    = IncrementColumn1(NextPacketNum);
+
+    AddWriteIndex.store(++writeIndex, std::memory_order_release);
+
+    WakeWorker();
+
+    return Siamese_Success;
+}
+
+SiameseResult EncoderPipeline::Encode(SiameseRecoveryPacket& packet)
+{
+    if (Disabled) {
+        return Siamese_Disabled;
+    }
+
+    const unsigned windowStart = WindowStart;
+
+    {
+        std::lock_guard<std::mutex> locker(ReadyLock);
+
+        // The packet returned last time is no longer needed
+        if (HandedOutSlot >= 0)
+        {
+            Slots[HandedOutSlot].State = SlotState::Free;
+            HandedOutSlot = -1;
+        }
+
+        DropStalePackets(windowStart);
+
+        if (ReadyCount > 0)
+        {
+            const unsigned slotIndex = ReadyQueue[ReadyHead];
+            ReadyHead = (ReadyHead + 1) % SlotCount;
+            --ReadyCount;
+
+            ReadySlot& slot = Slots[slotIndex];
+            slot.State    = SlotState::HandedOut;
+            HandedOutSlot = (int)slotIndex;
+            packet        = slot.Packet;
+
+            TheEncoder->Stats.Counts[SiameseEncoderStats_PipelineReadyCount]++;
+        }
+    }
+
+    // Ask the worker to replace whatever was taken or dropped
+    RefillRequested = true;
+    WakeWorker();
+
+    if (HandedOutSlot >= 0) {
+        return Siamese_Success;
+    }
+
+    // Nothing is ready, so encode on this thread
+    std::lock_guard<std::mutex> locker(EncoderLock);
+    DrainAdds();
+
+    const unsigned bufferBytes = TheEncoder->GetMaxRecoveryBytes();
+    if (!FallbackBuffer.Initialize(&AppAllocator, bufferBytes))
+    {
+        Disabled = true;
+        Logger.Error("Encode.Initialize OOM");
+        return Siamese_Disabled;
+    }
+
+    TheEncoder->Stats.Counts[SiameseEncoderStats_PipelineFallbackCount]++;
+
+    const SiameseResult result = TheEncoder->EncodeInto(FallbackBuffer.Data, bufferBytes, packet);
+    RemainingSlots.store(TheEncoder->GetRemainingSlots());
+    return result;
+}
+
+void EncoderPipeline::Lock()
+{
+    EncoderLock.lock();
+    DrainAdds();
+}
+
+void EncoderPipeline::Unlock(bool packetsAdded)
+{
+    // The API call may have added or removed packets directly
+    NextPacketNum = TheEncoder->GetNextPacketNum();
+    RemainingSlots.store(TheEncoder->GetRemainingSlots());
+
+    // An acknowledgement may have moved the window past the ready packets
+    const unsigned windowStart = TheEncoder->GetFirstUnacknowledgedColumn();
+    const bool windowMoved = (WindowStart.exchange(windowStart) != windowStart);
+
+    EncoderLock.unlock();
+
+    if (windowMoved) {
+        RefillRequested = true;
+    }
+    if (packetsAdded || windowMoved) {
+        WakeWorker();
+    }
+}
+
+void EncoderPipeline::WakeWorker()
+{
+    if (WorkerWaiting)
+    {
+        std::unique_lock<std::mutex> locker(WakeLock);
+        WakeCondition.notify_all();
+    }
+}
+
+void EncoderPipeline::WaitForWork()
+{
+    std::unique_lock<std::mutex> locker(WakeLock);
+
+    WorkerWaiting = true;
+
+    // Note: WorkerWaiting is set before checking for work, so an Add() or
+    // Encode() after this point will take WakeLock and notify us
+    if (!Terminated && !RefillRequested &&
+        AddWriteIndex.load(std::memory_order_relaxed) == AddReadIndex.load(std::memory_order_relaxed))
+    {
+        WakeCondition.wait_for(locker, std::chrono::milliseconds(kPipelineIdleWaitMsec));
+    }
+
+    WorkerWaiting = false;
+}
+
+void EncoderPipeline::Loop()
+{
+    while (!Terminated)
+    {
+        RefillRequested = false;
+
+        {
+            std::lock_guard<std::mutex> locker(EncoderLock);
+            DrainAdds();
+            FillReadyPackets();
+        }
+
+        WaitForWork();
+    }
+}
+
+void EncoderPipeline::DrainAdds()
+{
+    const unsigned writeIndex = AddWriteIndex.load(std::memory_order_acquire);
+    unsigned readIndex        = AddReadIndex.load(std::memory_order_relaxed);
+
+    while (readIndex != writeIndex)
+    {
+        QueuedAdd& queued = AddQueue[readIndex % kPipelineAddQueueSize];
+
+        SiameseOriginalPacket packet;
+        packet.Data      = queued.Buffer.Data;
+        packet.DataBytes = queued.DataBytes;
+
+        // Add() checked for room, so this can only fail if the encoder is disabled
+        if (TheEncoder->Add(packet) != Siamese_Success) {
+            Disabled = true;
+        }
+
+        // Publish the slot count before the read index so that
+        // GetRemainingSlots() never overestimates the room left
+        RemainingSlots.store(TheEncoder->GetRemainingSlots(), std::memory_order_relaxed);
+        AddReadIndex.store(++readIndex, std::memory_order_release);
+    }
+}
+
+void EncoderPipeline::DropStalePackets(unsigned windowStart)
+{
+    // Stale packets are always at the front since the window only moves forward
+    while (ReadyCount > 0)
+    {
+        const unsigned slotIndex = ReadyQueue[ReadyHead];
+        if (Slots[slotIndex].WindowStart == windowStart) {
+            break;
+        }
+
+        Slots[slotIndex].State = SlotState::Free;
+        ReadyHead = (ReadyHead + 1) % SlotCount;
+        --ReadyCount;
+    }
+}
+
+void EncoderPipeline::FillReadyPackets()
+{
+    // The window cannot move while EncoderLock is held
+    const unsigned windowStart = TheEncoder->GetFirstUnacknowledgedColumn();
+
+    while (!Terminated && !Disabled)
+    {
+        unsigned slotIndex = 0;
+        {
+            std::lock_guard<std::mutex> locker(ReadyLock);
+
+            DropStalePackets(windowStart);
+
+            if (ReadyCount >= ReadyTarget) {
+                return;
+            }
+
+            while (Slots[slotIndex].State != SlotState::Free)
+            {
+                if (++slotIndex >= SlotCount) {
+                    return;
+                }
+            }
+
+            Slots[slotIndex].State = SlotState::Filling;
+        }
+
+        ReadySlot& slot = Slots[slotIndex];
+
+        SiameseResult result = Siamese_Disabled;
+        const unsigned bufferBytes = TheEncoder->GetMaxRecoveryBytes();
+        if (slot.Buffer.Initialize(&WorkerAllocator, bufferBytes)) {
+            result = TheEncoder->EncodeInto(slot.Buffer.Data, bufferBytes, slot.Packet);
+        }
+        RemainingSlots.store(TheEncoder->GetRemainingSlots());
+
+        std::lock_guard<std::mutex> locker(ReadyLock);
+
+        if (result != Siamese_Success)
+        {
+            slot.State = SlotState::Free;
+
+            // If there is no data to encode yet, wait for more
+            if (result != Siamese_NeedMoreData)
+            {
+                Disabled = true;
+                Logger.Error("Worker encode failed: ", result);
+            }
+            return;
+        }
+
+        slot.WindowStart = windowStart;
+        slot.State       = SlotState::Ready;
+        ReadyQueue[(ReadyHead + ReadyCount) % SlotCount] = slotIndex;
+        ++ReadyCount;
+    }
+}
+
+
+} // namespace siamese
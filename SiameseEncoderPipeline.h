@@ -0,0 +1,275 @@
+/** \file
+    \brief Siamese FEC Implementation: Encoder Pipeline
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of Siamese nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+/**
+    Encoder Pipeline
+
+    Optional mode that moves the encoder work off the application thread.
+
+    A worker thread owns the expensive parts of the encoder: It folds new
+    original packets into the running sums and keeps a small ring of
+    recovery packets ready to send.  The application thread only copies
+    packets into a lock-free single-producer single-consumer queue and pops
+    finished recovery packets.
+
+    Recovery packets in the ring are tagged with the first unacknowledged
+    column of the window they were generated from.  Adds do not invalidate
+    them: A ready packet still protects the packets it covers, and newer
+    packets are covered by the ones generated to replace it.  Packets are
+    only dropped once an acknowledgement moves the window start past them.
+    If no packet is ready, Encode() falls back to encoding on the calling
+    thread.
+
+    All other encoder calls are made under EncoderLock via
+    EncoderPipelineGuard, after applying any queued adds.
+*/
+
+#include "SiameseEncoder.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+namespace siamese {
+
+
+//------------------------------------------------------------------------------
+// Constants
+
+/// Number of adds that can be queued for the worker thread.
+/// Must be a power of two
+static const unsigned kPipelineAddQueueSize = 256;
+static_assert((kPipelineAddQueueSize & (kPipelineAddQueueSize - 1)) == 0, "Must be a power of two");
+
+/// Number of slots needed beyond the ready count: One handed out to the
+/// application and one being filled by the worker
+static const unsigned kPipelineExtraSlots = 2;
+
+/// Maximum number of recovery packet slots
+static const unsigned kPipelineMaxSlots = SIAMESE_PIPELINE_MAX_READY + kPipelineExtraSlots;
+
+/// Longest time the worker sleeps before checking for work again
+static const unsigned kPipelineIdleWaitMsec = 10;
+
+
+//------------------------------------------------------------------------------
+// EncoderPipeline
+
+class EncoderPipeline
+{
+public:
+    /// Start the worker thread for the given encoder.
+    /// Precondition: 1 <= readyCount <= SIAMESE_PIPELINE_MAX_READY
+    /// Returns false if the thread could not be started
+    bool Start(Encoder* encoder, unsigned readyCount);
+
+    /// Stop the worker thread and apply any queued adds
+    void Stop();
+
+    /// Queue a packet for the worker thread and assign its packet number
+    SiameseResult Add(SiameseOriginalPacket& packet);
+
+    /// Pop a ready recovery packet, or encode one on this thread.
+    /// The returned data is valid until the next call
+    SiameseResult Encode(SiameseRecoveryPacket& packet);
+
+    /// Number of packets that can be added before the window is full
+    unsigned GetRemainingSlots() const;
+
+    /// Memory used by the queues.  Precondition: EncoderLock is held
+    unsigned GetMemoryAllocatedBytes() const;
+
+    /// Large allocations made with calloc().  Precondition: EncoderLock is held
+    unsigned GetFallbackAllocateCount() const;
+
+    /// Take the encoder lock and apply queued adds
+    void Lock();
+
+    /// Release the encoder lock.
+    /// If packetsAdded is true then the worker is woken to fold them in
+    void Unlock(bool packetsAdded);
+
+protected:
+    /// Queued add, copied from application memory
+    struct QueuedAdd
+    {
+        GrowingAlignedDataBuffer Buffer;
+        unsigned DataBytes = 0;
+    };
+
+    enum class SlotState
+    {
+        Free,       ///< Available to the worker
+        Filling,    ///< Worker is encoding into it
+        Ready,      ///< In the ready queue
+        HandedOut   ///< Returned to the application by Encode()
+    };
+
+    /// Recovery packet slot
+    struct ReadySlot
+    {
+        GrowingAlignedDataBuffer Buffer;
+        SiameseRecoveryPacket Packet;
+        unsigned WindowStart = 0;
+        SlotState State = SlotState::Free;
+    };
+
+
+    Encoder* TheEncoder = nullptr;
+
+    /// Number of ready packets to keep
+    unsigned ReadyTarget = 0;
+
+    /// Number of slots in use: ReadyTarget + kPipelineExtraSlots
+    unsigned SlotCount = 0;
+
+    /// Allocator used only by the application thread
+    pktalloc::Allocator AppAllocator;
+
+    /// Allocator used only by the worker thread
+    pktalloc::Allocator WorkerAllocator;
+
+    /// Lock held while the encoder is in use
+    std::mutex EncoderLock;
+
+    /// Worker thread
+    std::shared_ptr<std::thread> Thread;
+
+    /// Should the worker thread stop?
+    std::atomic<bool> Terminated = ATOMIC_VAR_INIT(false);
+
+    /// Set if the worker ran out of memory or the encoder failed
+    std::atomic<bool> Disabled = ATOMIC_VAR_INIT(false);
+
+
+    /// Add queue written by the application thread
+    QueuedAdd AddQueue[kPipelineAddQueueSize];
+
+    /// Next add queue index to write.  Written by the application thread
+    std::atomic<unsigned> AddWriteIndex = ATOMIC_VAR_INIT(0);
+
+    /// Next add queue index to read.  Written under EncoderLock
+    std::atomic<unsigned> AddReadIndex = ATOMIC_VAR_INIT(0);
+
+    /// Encoder remaining slots after the last applied add.  Written under EncoderLock
+    std::atomic<unsigned> RemainingSlots = ATOMIC_VAR_INIT(0);
+
+    /// Next packet number to assign.  Application thread only
+    unsigned NextPacketNum = 0;
+
+    /// First unacknowledged column of the encoder window.  Written under EncoderLock
+    std::atomic<unsigned> WindowStart = ATOMIC_VAR_INIT(0);
+
+
+    /// Lock protecting slot states and the ready queue
+    std::mutex ReadyLock;
+
+    /// Recovery packet slots
+    ReadySlot Slots[kPipelineMaxSlots];
+
+    /// Ring of slot indices in the Ready state, oldest first
+    unsigned ReadyQueue[kPipelineMaxSlots];
+    unsigned ReadyHead = 0;
+    unsigned ReadyCount = 0;
+
+    /// Slot returned by the last Encode(), or -1
+    int HandedOutSlot = -1;
+
+    /// Recovery packet encoded on the application thread
+    GrowingAlignedDataBuffer FallbackBuffer;
+
+
+    /// Lock protecting WakeCondition
+    std::mutex WakeLock;
+
+    /// Condition that indicates the worker should wake up
+    std::condition_variable WakeCondition;
+
+    /// Is the worker waiting on WakeCondition?
+    std::atomic<bool> WorkerWaiting = ATOMIC_VAR_INIT(false);
+
+    /// Set when the application takes a ready packet or the window moves
+    std::atomic<bool> RefillRequested = ATOMIC_VAR_INIT(false);
+
+
+    /// Worker thread loop
+    void Loop();
+
+    /// Wake the worker if it is waiting
+    void WakeWorker();
+
+    /// Worker: Wait until there is something to do
+    void WaitForWork();
+
+    /// Apply queued adds to the encoder.  Precondition: EncoderLock is held
+    void DrainAdds();
+
+    /// Generate ready packets up to the target.  Precondition: EncoderLock is held
+    void FillReadyPackets();
+
+    /// Free ready packets generated before the window moved to the given
+    /// start column.  Precondition: ReadyLock is held
+    void DropStalePackets(unsigned windowStart);
+};
+
+
+//------------------------------------------------------------------------------
+// EncoderPipelineGuard
+
+/// While the pipeline is running, this holds the encoder lock so that the
+/// encoder can be used directly by the API functions without a data race
+class EncoderPipelineGuard
+{
+public:
+    EncoderPipelineGuard(Encoder* encoder, bool packetsAdded = false)
+        : Pipeline(encoder->Pipeline)
+        , PacketsAdded(packetsAdded)
+    {
+        if (Pipeline) {
+            Pipeline->Lock();
+        }
+    }
+    ~EncoderPipelineGuard()
+    {
+        if (Pipeline) {
+            Pipeline->Unlock(PacketsAdded);
+        }
+    }
+
+protected:
+    EncoderPipeline* Pipeline;
+    bool PacketsAdded;
+};
+
+
+} // namespace siamese
@@ -0,0 +1,160 @@
+/** \file
+    \brief Siamese FEC Implementation: Thread Pool
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of Siamese nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SiameseThreadPool.h"
+
+namespace siamese {
+
+static logger::Channel Logger("ThreadPool", logger::Level::Silent);
+
+
+//------------------------------------------------------------------------------
+// ThreadPool
+
+bool ThreadPool::Start(unsigned threadCount)
+{
+    SIAMESE_DEBUG_ASSERT(ThreadCount == 0);
+    SIAMESE_DEBUG_ASSERT(threadCount >= 1 && threadCount <= SIAMESE_DECODER_MAX_THREADS);
+
+    Terminated = false;
+
+    try
+    {
+        for (unsigned i = 0; i < threadCount; ++i)
+        {
+            Threads[i] = std::make_shared<std::thread>(&ThreadPool::Loop, this, i);
+            ThreadCount = i + 1;
+        }
+    }
+    catch (std::system_error& /*err*/)
+    {
+        Logger.Error("Failed to start worker thread");
+        Stop();
+        return false;
+    }
+
+    return true;
+}
+
+void ThreadPool::Stop()
+{
+    // Make sure that the notification happens after the termination flag is set
+    {
+        std::lock_guard<std::mutex> locker(BatchLock);
+        Terminated = true;
+        WakeCondition.notify_all();
+    }
+
+    for (unsigned i = 0; i < ThreadCount; ++i)
+    {
+        try
+        {
+            if (Threads[i]->joinable())
+                Threads[i]->join();
+        }
+        catch (std::system_error& /*err*/)
+        {
+        }
+        Threads[i] = nullptr;
+    }
+    ThreadCount = 0;
+}
+
+void ThreadPool::BeginBatch(ThreadPoolTask task, void* context)
+{
+    std::lock_guard<std::mutex> locker(BatchLock);
+    SIAMESE_DEBUG_ASSERT(CompletedCount == PublishedCount);
+
+    Task           = task;
+    Context        = context;
+    PublishedCount = 0;
+    NextTask       = 0;
+    CompletedCount = 0;
+}
+
+void ThreadPool::Publish(unsigned taskCount)
+{
+    std::lock_guard<std::mutex> locker(BatchLock);
+    SIAMESE_DEBUG_ASSERT(taskCount >= PublishedCount);
+
+    PublishedCount = taskCount;
+    WakeCondition.notify_one();
+}
+
+void ThreadPool::WaitBatch()
+{
+    std::unique_lock<std::mutex> locker(BatchLock);
+
+    // Help out with the remaining tasks
+    while (RunNextTask(locker, ThreadCount)) {
+    }
+
+    // Wait for the tasks still running on the workers
+    while (CompletedCount < PublishedCount) {
+        DoneCondition.wait(locker);
+    }
+}
+
+bool ThreadPool::RunNextTask(std::unique_lock<std::mutex>& locker, unsigned workerIndex)
+{
+    if (NextTask >= PublishedCount) {
+        return false;
+    }
+
+    const unsigned taskIndex = NextTask++;
+
+    // Wake another worker if there is more to do
+    if (NextTask < PublishedCount) {
+        WakeCondition.notify_one();
+    }
+
+    locker.unlock();
+    Task(Context, workerIndex, taskIndex);
+    locker.lock();
+
+    if (++CompletedCount == PublishedCount) {
+        DoneCondition.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::Loop(unsigned workerIndex)
+{
+    std::unique_lock<std::mutex> locker(BatchLock);
+
+    while (!Terminated)
+    {
+        if (!RunNextTask(locker, workerIndex)) {
+            WakeCondition.wait(locker);
+        }
+    }
+}
+
+
+} // namespace siamese
@@ -0,0 +1,135 @@
+/** \file
+    \brief Siamese FEC Implementation: Thread Pool
+    \copyright Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of Siamese nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+/**
+    Thread Pool
+
+    Small pool of worker threads used by the decoder to run independent
+    recovery steps in parallel.
+
+    Work is submitted in batches.  The caller begins a batch with a task
+    function, publishes task indices as the tasks become ready to run, and
+    then waits for the batch to complete.  The waiting thread also runs
+    tasks, so the batch completes even if the workers are slow to wake up.
+
+    Each thread that runs tasks has a worker index, which lets the caller
+    give each thread its own scratch space.  The pool threads are numbered
+    from 0, and the thread that calls WaitBatch() gets the last index.
+*/
+
+#include "SiameseCommon.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+
+namespace siamese {
+
+
+//------------------------------------------------------------------------------
+// ThreadPool
+
+/// Task function run by the pool
+typedef void (*ThreadPoolTask)(void* context, unsigned workerIndex, unsigned taskIndex);
+
+class ThreadPool
+{
+public:
+    ~ThreadPool()
+    {
+        Stop();
+    }
+
+    /// Start the given number of worker threads.
+    /// Precondition: 1 <= threadCount <= SIAMESE_DECODER_MAX_THREADS
+    /// Returns false if the threads could not be started
+    bool Start(unsigned threadCount);
+
+    /// Stop all worker threads.  Precondition: No batch is running
+    void Stop();
+
+    /// Number of worker indices, including the thread that calls WaitBatch()
+    SIAMESE_FORCE_INLINE unsigned GetWorkerCount() const
+    {
+        return ThreadCount + 1;
+    }
+
+    /// Begin a batch of tasks that will call task(context, workerIndex, taskIndex)
+    void BeginBatch(ThreadPoolTask task, void* context);
+
+    /// Publish that tasks [0, taskCount) are ready to run
+    void Publish(unsigned taskCount);
+
+    /// Run published tasks on this thread until all of them have completed
+    void WaitBatch();
+
+protected:
+    /// Worker threads
+    std::shared_ptr<std::thread> Threads[SIAMESE_DECODER_MAX_THREADS];
+    unsigned ThreadCount = 0;
+
+    /// Lock protecting the batch state
+    std::mutex BatchLock;
+
+    /// Signaled when tasks are published or the pool is stopped
+    std::condition_variable WakeCondition;
+
+    /// Signaled when the last running task completes
+    std::condition_variable DoneCondition;
+
+    /// Task for the current batch
+    ThreadPoolTask Task = nullptr;
+    void* Context = nullptr;
+
+    /// Number of tasks published in the current batch
+    unsigned PublishedCount = 0;
+
+    /// Next task to run
+    unsigned NextTask = 0;
+
+    /// Number of tasks that have completed
+    unsigned CompletedCount = 0;
+
+    /// Should the worker threads stop?
+    bool Terminated = false;
+
+
+    /// Worker thread loop
+    void Loop(unsigned workerIndex);
+
+    /// Run the next published task, releasing the lock while it runs.
+    /// Returns false if no task was ready
+    bool RunNextTask(std::unique_lock<std::mutex>& locker, unsigned workerIndex);
+};
+
+
+} // namespace siamese
@@ -0,0 +1,30 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/Logger.cpp" "CMakeFiles/unit_test.dir/Logger.cpp.o" "gcc" "CMakeFiles/unit_test.dir/Logger.cpp.o.d"
+  "/root/repo/PacketAllocator.cpp" "CMakeFiles/unit_test.dir/PacketAllocator.cpp.o" "gcc" "CMakeFiles/unit_test.dir/PacketAllocator.cpp.o.d"
+  "/root/repo/SiameseCommon.cpp" "CMakeFiles/unit_test.dir/SiameseCommon.cpp.o" "gcc" "CMakeFiles/unit_test.dir/SiameseCommon.cpp.o.d"
+  "/root/repo/SiameseDecoder.cpp" "CMakeFiles/unit_test.dir/SiameseDecoder.cpp.o" "gcc" "CMakeFiles/unit_test.dir/SiameseDecoder.cpp.o.d"
+  "/root/repo/SiameseEncoder.cpp" "CMakeFiles/unit_test.dir/SiameseEncoder.cpp.o" "gcc" "CMakeFiles/unit_test.dir/SiameseEncoder.cpp.o.d"
+  "/root/repo/SiameseEncoderPipeline.cpp" "CMakeFiles/unit_test.dir/SiameseEncoderPipeline.cpp.o" "gcc" "CMakeFiles/unit_test.dir/SiameseEncoderPipeline.cpp.o.d"
+  "/root/repo/SiameseThreadPool.cpp" "CMakeFiles/unit_test.dir/SiameseThreadPool.cpp.o" "gcc" "CMakeFiles/unit_test.dir/SiameseThreadPool.cpp.o.d"
+  "/root/repo/SiameseTools.cpp" "CMakeFiles/unit_test.dir/SiameseTools.cpp.o" "gcc" "CMakeFiles/unit_test.dir/SiameseTools.cpp.o.d"
+  "/root/repo/gf256.cpp" "CMakeFiles/unit_test.dir/gf256.cpp.o" "gcc" "CMakeFiles/unit_test.dir/gf256.cpp.o.d"
+  "/root/repo/siamese.cpp" "CMakeFiles/unit_test.dir/siamese.cpp.o" "gcc" "CMakeFiles/unit_test.dir/siamese.cpp.o.d"
+  "/root/repo/tests/TestTools.cpp" "CMakeFiles/unit_test.dir/tests/TestTools.cpp.o" "gcc" "CMakeFiles/unit_test.dir/tests/TestTools.cpp.o.d"
+  "/root/repo/tests/unit_test.cpp" "CMakeFiles/unit_test.dir/tests/unit_test.cpp.o" "gcc" "CMakeFiles/unit_test.dir/tests/unit_test.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,33 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/unit_test.dir/Logger.cpp.o"
+  "CMakeFiles/unit_test.dir/Logger.cpp.o.d"
+  "CMakeFiles/unit_test.dir/PacketAllocator.cpp.o"
+  "CMakeFiles/unit_test.dir/PacketAllocator.cpp.o.d"
+  "CMakeFiles/unit_test.dir/SiameseCommon.cpp.o"
+  "CMakeFiles/unit_test.dir/SiameseCommon.cpp.o.d"
+  "CMakeFiles/unit_test.dir/SiameseDecoder.cpp.o"
+  "CMakeFiles/unit_test.dir/SiameseDecoder.cpp.o.d"
+  "CMakeFiles/unit_test.dir/SiameseEncoder.cpp.o"
+  "CMakeFiles/unit_test.dir/SiameseEncoder.cpp.o.d"
+  "CMakeFiles/unit_test.dir/SiameseEncoderPipeline.cpp.o"
+  "CMakeFiles/unit_test.dir/SiameseEncoderPipeline.cpp.o.d"
+  "CMakeFiles/unit_test.dir/SiameseThreadPool.cpp.o"
+  "CMakeFiles/unit_test.dir/SiameseThreadPool.cpp.o.d"
+  "CMakeFiles/unit_test.dir/SiameseTools.cpp.o"
+  "CMakeFiles/unit_test.dir/SiameseTools.cpp.o.d"
+  "CMakeFiles/unit_test.dir/gf256.cpp.o"
+  "CMakeFiles/unit_test.dir/gf256.cpp.o.d"
+  "CMakeFiles/unit_test.dir/siamese.cpp.o"
+  "CMakeFiles/unit_test.dir/siamese.cpp.o.d"
+  "CMakeFiles/unit_test.dir/tests/TestTools.cpp.o"
+  "CMakeFiles/unit_test.dir/tests/TestTools.cpp.o.d"
+  "CMakeFiles/unit_test.dir/tests/unit_test.cpp.o"
+  "CMakeFiles/unit_test.dir/tests/unit_test.cpp.o.d"
+  "unit_test"
+  "unit_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/unit_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
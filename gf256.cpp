@@ -71,8 +71,8 @@ static GF256_FORCE_INLINE uint8x16_t vqtbl1q_u8(uint8x16_t a, uint8x16_t b)
 //
 // This is executed during initialization to make sure the library is working
 
-static const unsigned kTestBufferBytes = 32 + 16 + 8 + 4 + 2 + 1;
-static const unsigned kTestBufferAllocated = 64;
+static const unsigned kTestBufferBytes = 256 + 64 + 32 + 16 + 8 + 4 + 2 + 1;
+static const unsigned kTestBufferAllocated = 384;
 struct SelfTestBuffersT
 {
     GF256_ALIGNED uint8_t A[kTestBufferAllocated];
@@ -154,29 +154,77 @@ static bool gf256_self_test()
         if (m_SelfTestBuffers.A[i] != (0xaa ^ 0x6c))
             return false;
 
-    // Test gf256_muladd_mem()
-    for (unsigned i = 0; i < kTestBufferBytes; ++i)
+    // Test gf256_muladd_mem() for every y, since each y has its own tables
+    for (unsigned y = 0; y < 256; ++y)
     {
-        m_SelfTestBuffers.A[i] = 0xff;
-        m_SelfTestBuffers.B[i] = 0xaa;
+        for (unsigned i = 0; i < kTestBufferBytes; ++i)
+        {
+            m_SelfTestBuffers.A[i] = (uint8_t)(0xff - i);
+            m_SelfTestBuffers.B[i] = (uint8_t)(i * 0x1d + y);
+        }
+        gf256_muladd_mem(m_SelfTestBuffers.A, (uint8_t)y, m_SelfTestBuffers.B, kTestBufferBytes);
+        for (unsigned i = 0; i < kTestBufferBytes; ++i)
+        {
+            const uint8_t expectedMulAdd = gf256_mul(m_SelfTestBuffers.B[i], (uint8_t)y);
+            if (m_SelfTestBuffers.A[i] != (uint8_t)(expectedMulAdd ^ (0xff - i)))
+                return false;
+        }
     }
-    const uint8_t expectedMulAdd = gf256_mul(0xaa, 0x6c);
-    gf256_muladd_mem(m_SelfTestBuffers.A, 0x6c, m_SelfTestBuffers.B, kTestBufferBytes);
-    for (unsigned i = 0; i < kTestBufferBytes; ++i)
-        if (m_SelfTestBuffers.A[i] != (expectedMulAdd ^ 0xff))
-            return false;
 
-    // Test gf256_mul_mem()
-    for (unsigned i = 0; i < kTestBufferBytes; ++i)
+    // Test gf256_muladd_multi_mem() with sources of different lengths
+    for (unsigned y = 0; y < 256; ++y)
     {
-        m_SelfTestBuffers.A[i] = 0xff;
-        m_SelfTestBuffers.B[i] = 0x55;
+        for (unsigned i = 0; i < kTestBufferBytes; ++i)
+        {
+            m_SelfTestBuffers.A[i] = (uint8_t)(0x5a + i);
+            m_SelfTestBuffers.B[i] = (uint8_t)(i * 0x1d + y);
+            m_SelfTestBuffers.C[i] = (uint8_t)(i * 0x47 ^ y);
+        }
+        const uint8_t ys[4] = { (uint8_t)(y * 7), (uint8_t)y, (uint8_t)(255 - y), (uint8_t)(y + 1) };
+        const void * srcs[4] = { m_SelfTestBuffers.B, m_SelfTestBuffers.B, m_SelfTestBuffers.C, m_SelfTestBuffers.C };
+        const int srcBytes[4] = { 40, (int)kTestBufferBytes, (int)kTestBufferBytes - 21, 150 };
+        gf256_muladd_multi_mem(m_SelfTestBuffers.A, ys, srcs, srcBytes, 4);
+        for (unsigned i = 0; i < kTestBufferBytes; ++i)
+        {
+            uint8_t expected = (uint8_t)(0x5a + i);
+            for (unsigned j = 0; j < 4; ++j)
+                if ((int)i < srcBytes[j])
+                    expected ^= gf256_mul(reinterpret_cast<const uint8_t *>(srcs[j])[i], ys[j]);
+            if (m_SelfTestBuffers.A[i] != expected)
+                return false;
+        }
+    }
+
+    // Test gf256_mul_mem() for every y
+    for (unsigned y = 0; y < 256; ++y)
+    {
+        for (unsigned i = 0; i < kTestBufferBytes; ++i)
+        {
+            m_SelfTestBuffers.A[i] = 0xff;
+            m_SelfTestBuffers.B[i] = (uint8_t)(i * 0x3b + y);
+        }
+        gf256_mul_mem(m_SelfTestBuffers.A, m_SelfTestBuffers.B, (uint8_t)y, kTestBufferBytes);
+        for (unsigned i = 0; i < kTestBufferBytes; ++i)
+        {
+            const uint8_t expectedMul = gf256_mul(m_SelfTestBuffers.B[i], (uint8_t)y);
+            if (m_SelfTestBuffers.A[i] != expectedMul)
+                return false;
+        }
+    }
+
+    // Test gf256_mul_mem_inplace() for every y
+    for (unsigned y = 0; y < 256; ++y)
+    {
+        for (unsigned i = 0; i < kTestBufferBytes; ++i)
+            m_SelfTestBuffers.A[i] = (uint8_t)(i * 0x3b + y);
+        gf256_mul_mem_inplace(m_SelfTestBuffers.A, (uint8_t)y, kTestBufferBytes);
+        for (unsigned i = 0; i < kTestBufferBytes; ++i)
+        {
+            const uint8_t expectedMul = gf256_mul((uint8_t)(i * 0x3b + y), (uint8_t)y);
+            if (m_SelfTestBuffers.A[i] != expectedMul)
+                return false;
+        }
     }
-    const uint8_t expectedMul = gf256_mul(0xa2, 0x55);
-    gf256_mul_mem(m_SelfTestBuffers.A, m_SelfTestBuffers.B, 0xa2, kTestBufferBytes);
-    for (unsigned i = 0; i < kTestBufferBytes; ++i)
-        if (m_SelfTestBuffers.A[i] != expectedMul)
-            return false;
 
     if (m_SelfTestBuffers.A[kTestBufferBytes] != 0x5a)
         return false;
@@ -225,10 +273,24 @@ static bool CpuHasNeon64 = false;   // And we don't have ASIMD
 #ifdef GF256_TRY_AVX2
 static bool CpuHasAVX2 = false;
 #endif
+#ifdef GF256_TRY_AVX512
+static bool CpuHasAVX512 = false;
+#endif
+#ifdef GF256_TRY_GFNI
+static bool CpuHasGFNI = false;
+#endif
 static bool CpuHasSSSE3 = false;
 
-#define CPUID_EBX_AVX2    0x00000020
-#define CPUID_ECX_SSSE3   0x00000200
+#define CPUID_EBX_AVX2     0x00000020
+#define CPUID_EBX_AVX512F  0x00010000
+#define CPUID_EBX_AVX512BW 0x40000000
+#define CPUID_ECX_SSSE3    0x00000200
+#define CPUID_ECX_OSXSAVE  0x08000000
+#define CPUID_ECX_GFNI     0x00000100
+
+// XCR0: Register state enabled by the OS
+#define XCR0_AVX_STATE     0x00000006 // XMM | YMM
+#define XCR0_AVX512_STATE  0x000000e6 // XMM | YMM | Opmask | ZMM_Hi256 | Hi16_ZMM
 
 static void _cpuid(unsigned int cpu_info[4U], const unsigned int cpu_info_type)
 {
@@ -267,6 +329,20 @@ static void _cpuid(unsigned int cpu_info[4U], const unsigned int cpu_info_type)
 #endif
 }
 
+#ifdef GF256_TRY_AVX2
+// Returns the XCR0 register indicating which register state the OS preserves
+static uint64_t _xgetbv0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0U));
+    return ((uint64_t)edx << 32) | eax;
+#endif
+}
+#endif // GF256_TRY_AVX2
+
 #else
 #if defined(LINUX_ARM)
 static void checkLinuxARMNeonCapabilities( bool& cpuHasNeon )
@@ -328,8 +404,23 @@ static void gf256_architecture_init()
     CpuHasSSSE3 = ((cpu_info[2] & CPUID_ECX_SSSE3) != 0);
 
 #if defined(GF256_TRY_AVX2)
+    // The wider registers are only usable if the OS saves them on task switch
+    const uint64_t xcr0 = ((cpu_info[2] & CPUID_ECX_OSXSAVE) != 0) ? _xgetbv0() : 0;
+
     _cpuid(cpu_info, 7);
-    CpuHasAVX2 = ((cpu_info[1] & CPUID_EBX_AVX2) != 0);
+    CpuHasAVX2 = ((cpu_info[1] & CPUID_EBX_AVX2) != 0) &&
+        ((xcr0 & XCR0_AVX_STATE) == XCR0_AVX_STATE);
+
+# if defined(GF256_TRY_AVX512)
+    const unsigned avx512Mask = CPUID_EBX_AVX512F | CPUID_EBX_AVX512BW;
+    CpuHasAVX512 = ((cpu_info[1] & avx512Mask) == avx512Mask) && CpuHasAVX2 &&
+        ((xcr0 & XCR0_AVX512_STATE) == XCR0_AVX512_STATE);
+# endif // GF256_TRY_AVX512
+
+# if defined(GF256_TRY_GFNI)
+    // The 256-bit GFNI instructions are VEX-encoded so they also require AVX
+    CpuHasGFNI = ((cpu_info[2] & CPUID_ECX_GFNI) != 0) && CpuHasAVX2;
+# endif // GF256_TRY_GFNI
 #endif // GF256_TRY_AVX2
 
     // When AVX2 and SSSE3 are unavailable, Siamese takes 4x longer to decode
@@ -583,18 +674,1252 @@ static void gf256_mul_mem_init()
         _mm_storeu_si128(GF256Ctx.MM128.TABLE_LO_Y + y, table_lo);
         _mm_storeu_si128(GF256Ctx.MM128.TABLE_HI_Y + y, table_hi);
 # ifdef GF256_TRY_AVX2
-        if (CpuHasAVX2)
-        {
-            const GF256_M256 table_lo2 = _mm256_broadcastsi128_si256(table_lo);
-            const GF256_M256 table_hi2 = _mm256_broadcastsi128_si256(table_hi);
-            _mm256_storeu_si256(GF256Ctx.MM256.TABLE_LO_Y + y, table_lo2);
-            _mm256_storeu_si256(GF256Ctx.MM256.TABLE_HI_Y + y, table_hi2);
-        }
+        // Both 128-bit lanes hold the same table since VPSHUFB works per lane
+        uint8_t* lo2 = reinterpret_cast<uint8_t*>(GF256Ctx.MM256.TABLE_LO_Y + y);
+        uint8_t* hi2 = reinterpret_cast<uint8_t*>(GF256Ctx.MM256.TABLE_HI_Y + y);
+        memcpy(lo2, lo, 16);
+        memcpy(lo2 + 16, lo, 16);
+        memcpy(hi2, hi, 16);
+        memcpy(hi2 + 16, hi, 16);
 # endif // GF256_TRY_AVX2
 #endif // GF256_TARGET_MOBILE
+
+#if defined(GF256_TRY_GFNI)
+        /*
+            GF2P8AFFINEQB computes bit i of each output byte as the parity of
+            (x AND matrix.byte[7 - i]).  Since multiplication by y is linear
+            over GF(2), row i selects the bits j of x where bit i of
+            (2^j * y) is set, so one instruction multiplies 8 bytes by y.
+        */
+        uint64_t matrix = 0;
+        for (unsigned i = 0; i < 8; ++i)
+        {
+            unsigned row = 0;
+            for (unsigned j = 0; j < 8; ++j)
+                if (gf256_mul(static_cast<uint8_t>( 1 << j ), static_cast<uint8_t>( y )) & (1 << i))
+                    row |= 1 << j;
+            matrix |= (uint64_t)row << (8 * (7 - i));
+        }
+        GF256Ctx.GFNI_AFFINE_Y[y] = matrix;
+#endif // GF256_TRY_GFNI
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// x86 Kernels
+//
+// Each kernel is compiled for a single instruction set via GF256_TARGET(), so a
+// baseline x86-64 build still carries the AVX2, AVX-512 and GFNI versions.
+// The kernels process the data in multiples of 16 bytes and return the number
+// of bytes they handled.  The public functions below finish the remainder.
+
+#if !defined(GF256_TARGET_MOBILE)
+
+/// z[] ^= x[] : SSE2 is part of the x86-64 baseline so no target is needed
+static int gf256_add_mem_sse2(void * GF256_RESTRICT vx,
+                              const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<GF256_M128 *>(vx);
+    const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128 *>(vy);
+    const int original = bytes;
+
+    while (bytes >= 64)
+    {
+        GF256_M128 x0 = _mm_loadu_si128(x16);
+        GF256_M128 y0 = _mm_loadu_si128(y16);
+        x0 = _mm_xor_si128(x0, y0);
+        GF256_M128 x1 = _mm_loadu_si128(x16 + 1);
+        GF256_M128 y1 = _mm_loadu_si128(y16 + 1);
+        x1 = _mm_xor_si128(x1, y1);
+        GF256_M128 x2 = _mm_loadu_si128(x16 + 2);
+        GF256_M128 y2 = _mm_loadu_si128(y16 + 2);
+        x2 = _mm_xor_si128(x2, y2);
+        GF256_M128 x3 = _mm_loadu_si128(x16 + 3);
+        GF256_M128 y3 = _mm_loadu_si128(y16 + 3);
+        x3 = _mm_xor_si128(x3, y3);
+
+        _mm_storeu_si128(x16, x0);
+        _mm_storeu_si128(x16 + 1, x1);
+        _mm_storeu_si128(x16 + 2, x2);
+        _mm_storeu_si128(x16 + 3, x3);
+
+        bytes -= 64, x16 += 4, y16 += 4;
+    }
+
+    // Handle multiples of 16 bytes
+    while (bytes >= 16)
+    {
+        // x[i] = x[i] xor y[i]
+        _mm_storeu_si128(x16,
+            _mm_xor_si128(
+                _mm_loadu_si128(x16),
+                _mm_loadu_si128(y16)));
+
+        bytes -= 16, ++x16, ++y16;
+    }
+
+    return original - bytes;
+}
+
+static int gf256_add2_mem_sse2(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                               const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128*>(vz);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128*>(vx);
+    const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128*>(vy);
+    const int original = bytes;
+
+    // Handle multiples of 16 bytes
+    while (bytes >= 16)
+    {
+        // z[i] = z[i] xor x[i] xor y[i]
+        _mm_storeu_si128(z16,
+            _mm_xor_si128(
+                _mm_loadu_si128(z16),
+                _mm_xor_si128(
+                    _mm_loadu_si128(x16),
+                    _mm_loadu_si128(y16))));
+
+        bytes -= 16, ++x16, ++y16, ++z16;
+    }
+
+    return original - bytes;
+}
+
+static int gf256_addset_mem_sse2(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                 const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128*>(vz);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128*>(vx);
+    const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128*>(vy);
+    const int original = bytes;
+
+    // Handle multiples of 64 bytes
+    while (bytes >= 64)
+    {
+        GF256_M128 x0 = _mm_loadu_si128(x16);
+        GF256_M128 x1 = _mm_loadu_si128(x16 + 1);
+        GF256_M128 x2 = _mm_loadu_si128(x16 + 2);
+        GF256_M128 x3 = _mm_loadu_si128(x16 + 3);
+        GF256_M128 y0 = _mm_loadu_si128(y16);
+        GF256_M128 y1 = _mm_loadu_si128(y16 + 1);
+        GF256_M128 y2 = _mm_loadu_si128(y16 + 2);
+        GF256_M128 y3 = _mm_loadu_si128(y16 + 3);
+
+        _mm_storeu_si128(z16,     _mm_xor_si128(x0, y0));
+        _mm_storeu_si128(z16 + 1, _mm_xor_si128(x1, y1));
+        _mm_storeu_si128(z16 + 2, _mm_xor_si128(x2, y2));
+        _mm_storeu_si128(z16 + 3, _mm_xor_si128(x3, y3));
+
+        bytes -= 64, x16 += 4, y16 += 4, z16 += 4;
+    }
+
+    // Handle multiples of 16 bytes
+    while (bytes >= 16)
+    {
+        // z[i] = x[i] xor y[i]
+        _mm_storeu_si128(z16,
+            _mm_xor_si128(
+                _mm_loadu_si128(x16),
+                _mm_loadu_si128(y16)));
+
+        bytes -= 16, ++x16, ++y16, ++z16;
+    }
+
+    return original - bytes;
+}
+
+GF256_TARGET("ssse3")
+static int gf256_mul_mem_ssse3(void * vz, const void * vx, uint8_t y, int bytes)
+{
+    GF256_M128 * z16 = reinterpret_cast<GF256_M128 *>(vz);
+    const GF256_M128 * x16 = reinterpret_cast<const GF256_M128 *>(vx);
+    const int original = bytes;
+
+    // Partial product tables; see above
+    const GF256_M128 table_lo_y = _mm_loadu_si128(GF256Ctx.MM128.TABLE_LO_Y + y);
+    const GF256_M128 table_hi_y = _mm_loadu_si128(GF256Ctx.MM128.TABLE_HI_Y + y);
+
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M128 clr_mask = _mm_set1_epi8(0x0f);
+
+    // Handle multiples of 16 bytes
+    while (bytes >= 16)
+    {
+        // See above comments for details
+        GF256_M128 x0 = _mm_loadu_si128(x16);
+        GF256_M128 l0 = _mm_and_si128(x0, clr_mask);
+        x0 = _mm_srli_epi64(x0, 4);
+        GF256_M128 h0 = _mm_and_si128(x0, clr_mask);
+        l0 = _mm_shuffle_epi8(table_lo_y, l0);
+        h0 = _mm_shuffle_epi8(table_hi_y, h0);
+        _mm_storeu_si128(z16, _mm_xor_si128(l0, h0));
+
+        bytes -= 16, ++x16, ++z16;
+    }
+
+    return original - bytes;
+}
+
+GF256_TARGET("ssse3")
+static int gf256_muladd_mem_ssse3(void * GF256_RESTRICT vz, uint8_t y,
+                                  const void * GF256_RESTRICT vx, int bytes)
+{
+    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(vz);
+    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(vx);
+    const int original = bytes;
+
+    // Partial product tables; see above
+    const GF256_M128 table_lo_y = _mm_loadu_si128(GF256Ctx.MM128.TABLE_LO_Y + y);
+    const GF256_M128 table_hi_y = _mm_loadu_si128(GF256Ctx.MM128.TABLE_HI_Y + y);
+
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M128 clr_mask = _mm_set1_epi8(0x0f);
+
+    // This unroll seems to provide about 7% speed boost when AVX2 is disabled
+    while (bytes >= 32)
+    {
+        bytes -= 32;
+
+        GF256_M128 x1 = _mm_loadu_si128(x16 + 1);
+        GF256_M128 l1 = _mm_and_si128(x1, clr_mask);
+        x1 = _mm_srli_epi64(x1, 4);
+        GF256_M128 h1 = _mm_and_si128(x1, clr_mask);
+        l1 = _mm_shuffle_epi8(table_lo_y, l1);
+        h1 = _mm_shuffle_epi8(table_hi_y, h1);
+        const GF256_M128 z1 = _mm_loadu_si128(z16 + 1);
+
+        GF256_M128 x0 = _mm_loadu_si128(x16);
+        GF256_M128 l0 = _mm_and_si128(x0, clr_mask);
+        x0 = _mm_srli_epi64(x0, 4);
+        GF256_M128 h0 = _mm_and_si128(x0, clr_mask);
+        l0 = _mm_shuffle_epi8(table_lo_y, l0);
+        h0 = _mm_shuffle_epi8(table_hi_y, h0);
+        const GF256_M128 z0 = _mm_loadu_si128(z16);
+
+        const GF256_M128 p1 = _mm_xor_si128(l1, h1);
+        _mm_storeu_si128(z16 + 1, _mm_xor_si128(p1, z1));
+
+        const GF256_M128 p0 = _mm_xor_si128(l0, h0);
+        _mm_storeu_si128(z16, _mm_xor_si128(p0, z0));
+
+        x16 += 2, z16 += 2;
+    }
+
+    // Handle multiples of 16 bytes
+    while (bytes >= 16)
+    {
+        // See above comments for details
+        GF256_M128 x0 = _mm_loadu_si128(x16);
+        GF256_M128 l0 = _mm_and_si128(x0, clr_mask);
+        x0 = _mm_srli_epi64(x0, 4);
+        GF256_M128 h0 = _mm_and_si128(x0, clr_mask);
+        l0 = _mm_shuffle_epi8(table_lo_y, l0);
+        h0 = _mm_shuffle_epi8(table_hi_y, h0);
+        const GF256_M128 p0 = _mm_xor_si128(l0, h0);
+        const GF256_M128 z0 = _mm_loadu_si128(z16);
+        _mm_storeu_si128(z16, _mm_xor_si128(p0, z0));
+
+        bytes -= 16, ++x16, ++z16;
+    }
+
+    return original - bytes;
+}
+
+/// z[0..ends[i]) ^= ys[i] * srcs[i][0..ends[i]) for all i, in multiples of 16 bytes.
+/// Sources must be sorted longest first.  The final ends[i] % 16 bytes of
+/// each source are left for the caller
+GF256_TARGET("ssse3")
+static void gf256_muladd_multi_mem_ssse3(uint8_t * GF256_RESTRICT z1, const uint8_t * ys,
+                                         const uint8_t * const * srcs, const int * ends, int count)
+{
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M128 clr_mask = _mm_set1_epi8(0x0f);
+
+    // Handle multiples of 32 bytes, keeping the destination in registers
+    for (int offset = 0;; offset += 32)
+    {
+        // Sources are sorted longest first, so the ones that end are at the back.
+        // Handle multiples of 16 bytes of the rest of each one on its own
+        while (count > 0 && ends[count - 1] < offset + 32)
+        {
+            --count;
+            if (ends[count] - offset >= 16)
+                gf256_muladd_mem_ssse3(z1 + offset, ys[count], srcs[count] + offset, ends[count] - offset);
+        }
+        if (count <= 0)
+            break;
+
+        GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(z1 + offset);
+        GF256_M128 s0 = _mm_loadu_si128(z16);
+        GF256_M128 s1 = _mm_loadu_si128(z16 + 1);
+
+        for (int i = 0; i < count; ++i)
+        {
+            // Partial product tables; see above
+            const GF256_M128 table_lo_y = _mm_loadu_si128(GF256Ctx.MM128.TABLE_LO_Y + ys[i]);
+            const GF256_M128 table_hi_y = _mm_loadu_si128(GF256Ctx.MM128.TABLE_HI_Y + ys[i]);
+            const GF256_M128 * x16 = reinterpret_cast<const GF256_M128 *>(srcs[i] + offset);
+
+            GF256_M128 x0 = _mm_loadu_si128(x16);
+            GF256_M128 l0 = _mm_and_si128(x0, clr_mask);
+            x0 = _mm_srli_epi64(x0, 4);
+            GF256_M128 h0 = _mm_and_si128(x0, clr_mask);
+            l0 = _mm_shuffle_epi8(table_lo_y, l0);
+            h0 = _mm_shuffle_epi8(table_hi_y, h0);
+            s0 = _mm_xor_si128(s0, _mm_xor_si128(l0, h0));
+
+            GF256_M128 x1 = _mm_loadu_si128(x16 + 1);
+            GF256_M128 l1 = _mm_and_si128(x1, clr_mask);
+            x1 = _mm_srli_epi64(x1, 4);
+            GF256_M128 h1 = _mm_and_si128(x1, clr_mask);
+            l1 = _mm_shuffle_epi8(table_lo_y, l1);
+            h1 = _mm_shuffle_epi8(table_hi_y, h1);
+            s1 = _mm_xor_si128(s1, _mm_xor_si128(l1, h1));
+        }
+
+        _mm_storeu_si128(z16, s0);
+        _mm_storeu_si128(z16 + 1, s1);
+    }
+}
+
+#if defined(GF256_TRY_AVX2)
+
+GF256_TARGET("avx2")
+static int gf256_add_mem_avx2(void * GF256_RESTRICT vx,
+                              const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<GF256_M256 *>(vx);
+    const GF256_M256 * GF256_RESTRICT y32 = reinterpret_cast<const GF256_M256 *>(vy);
+    const int original = bytes;
+
+    while (bytes >= 128)
+    {
+        GF256_M256 x0 = _mm256_loadu_si256(x32);
+        GF256_M256 y0 = _mm256_loadu_si256(y32);
+        x0 = _mm256_xor_si256(x0, y0);
+        GF256_M256 x1 = _mm256_loadu_si256(x32 + 1);
+        GF256_M256 y1 = _mm256_loadu_si256(y32 + 1);
+        x1 = _mm256_xor_si256(x1, y1);
+        GF256_M256 x2 = _mm256_loadu_si256(x32 + 2);
+        GF256_M256 y2 = _mm256_loadu_si256(y32 + 2);
+        x2 = _mm256_xor_si256(x2, y2);
+        GF256_M256 x3 = _mm256_loadu_si256(x32 + 3);
+        GF256_M256 y3 = _mm256_loadu_si256(y32 + 3);
+        x3 = _mm256_xor_si256(x3, y3);
+
+        _mm256_storeu_si256(x32, x0);
+        _mm256_storeu_si256(x32 + 1, x1);
+        _mm256_storeu_si256(x32 + 2, x2);
+        _mm256_storeu_si256(x32 + 3, x3);
+
+        bytes -= 128, x32 += 4, y32 += 4;
+    }
+
+    // Handle multiples of 32 bytes
+    while (bytes >= 32)
+    {
+        // x[i] = x[i] xor y[i]
+        _mm256_storeu_si256(x32,
+            _mm256_xor_si256(
+                _mm256_loadu_si256(x32),
+                _mm256_loadu_si256(y32)));
+
+        bytes -= 32, ++x32, ++y32;
+    }
+
+    // Handle final 16 bytes
+    if (bytes >= 16)
+    {
+        GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<GF256_M128 *>(x32);
+        const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128 *>(y32);
+        _mm_storeu_si128(x16,
+            _mm_xor_si128(
+                _mm_loadu_si128(x16),
+                _mm_loadu_si128(y16)));
+        bytes -= 16;
+    }
+
+    return original - bytes;
+}
+
+GF256_TARGET("avx2")
+static int gf256_add2_mem_avx2(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                               const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(vz);
+    const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(vx);
+    const GF256_M256 * GF256_RESTRICT y32 = reinterpret_cast<const GF256_M256 *>(vy);
+    const int original = bytes;
+
+    const unsigned count = bytes / 32;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        _mm256_storeu_si256(z32 + i,
+            _mm256_xor_si256(
+                _mm256_loadu_si256(z32 + i),
+                _mm256_xor_si256(
+                    _mm256_loadu_si256(x32 + i),
+                    _mm256_loadu_si256(y32 + i))));
+    }
+    bytes -= count * 32;
+
+    // Handle final 16 bytes
+    if (bytes >= 16)
+    {
+        GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(z32 + count);
+        const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(x32 + count);
+        const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128 *>(y32 + count);
+        _mm_storeu_si128(z16,
+            _mm_xor_si128(
+                _mm_loadu_si128(z16),
+                _mm_xor_si128(
+                    _mm_loadu_si128(x16),
+                    _mm_loadu_si128(y16))));
+        bytes -= 16;
+    }
+
+    return original - bytes;
+}
+
+GF256_TARGET("avx2")
+static int gf256_addset_mem_avx2(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                 const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(vz);
+    const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(vx);
+    const GF256_M256 * GF256_RESTRICT y32 = reinterpret_cast<const GF256_M256 *>(vy);
+    const int original = bytes;
+
+    const unsigned count = bytes / 32;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        _mm256_storeu_si256(z32 + i,
+            _mm256_xor_si256(
+                _mm256_loadu_si256(x32 + i),
+                _mm256_loadu_si256(y32 + i)));
+    }
+    bytes -= count * 32;
+
+    // Handle final 16 bytes
+    if (bytes >= 16)
+    {
+        GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(z32 + count);
+        const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(x32 + count);
+        const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128 *>(y32 + count);
+        _mm_storeu_si128(z16,
+            _mm_xor_si128(
+                _mm_loadu_si128(x16),
+                _mm_loadu_si128(y16)));
+        bytes -= 16;
+    }
+
+    return original - bytes;
+}
+
+GF256_TARGET("avx2")
+static int gf256_mul_mem_avx2(void * vz, const void * vx, uint8_t y, int bytes)
+{
+    GF256_M256 * z32 = reinterpret_cast<GF256_M256 *>(vz);
+    const GF256_M256 * x32 = reinterpret_cast<const GF256_M256 *>(vx);
+    const int original = bytes;
+
+    // Partial product tables; see above
+    const GF256_M256 table_lo_y = _mm256_loadu_si256(GF256Ctx.MM256.TABLE_LO_Y + y);
+    const GF256_M256 table_hi_y = _mm256_loadu_si256(GF256Ctx.MM256.TABLE_HI_Y + y);
+
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M256 clr_mask = _mm256_set1_epi8(0x0f);
+
+    // Handle multiples of 32 bytes
+    while (bytes >= 32)
+    {
+        // See above comments for details
+        GF256_M256 x0 = _mm256_loadu_si256(x32);
+        GF256_M256 l0 = _mm256_and_si256(x0, clr_mask);
+        x0 = _mm256_srli_epi64(x0, 4);
+        GF256_M256 h0 = _mm256_and_si256(x0, clr_mask);
+        l0 = _mm256_shuffle_epi8(table_lo_y, l0);
+        h0 = _mm256_shuffle_epi8(table_hi_y, h0);
+        _mm256_storeu_si256(z32, _mm256_xor_si256(l0, h0));
+
+        bytes -= 32, ++x32, ++z32;
+    }
+
+    // Handle final 16 bytes
+    if (bytes >= 16)
+    {
+        GF256_M128 * z16 = reinterpret_cast<GF256_M128 *>(z32);
+        const GF256_M128 * x16 = reinterpret_cast<const GF256_M128 *>(x32);
+        GF256_M128 x0 = _mm_loadu_si128(x16);
+        GF256_M128 l0 = _mm_and_si128(x0, _mm256_castsi256_si128(clr_mask));
+        x0 = _mm_srli_epi64(x0, 4);
+        GF256_M128 h0 = _mm_and_si128(x0, _mm256_castsi256_si128(clr_mask));
+        l0 = _mm_shuffle_epi8(_mm256_castsi256_si128(table_lo_y), l0);
+        h0 = _mm_shuffle_epi8(_mm256_castsi256_si128(table_hi_y), h0);
+        _mm_storeu_si128(z16, _mm_xor_si128(l0, h0));
+        bytes -= 16;
+    }
+
+    return original - bytes;
+}
+
+GF256_TARGET("avx2")
+static int gf256_muladd_mem_avx2(void * GF256_RESTRICT vz, uint8_t y,
+                                 const void * GF256_RESTRICT vx, int bytes)
+{
+    GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(vz);
+    const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(vx);
+    const int original = bytes;
+
+    // Partial product tables; see above
+    const GF256_M256 table_lo_y = _mm256_loadu_si256(GF256Ctx.MM256.TABLE_LO_Y + y);
+    const GF256_M256 table_hi_y = _mm256_loadu_si256(GF256Ctx.MM256.TABLE_HI_Y + y);
+
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M256 clr_mask = _mm256_set1_epi8(0x0f);
+
+    // On my Reed Solomon codec, the encoder unit test runs in 640 usec without and 550 usec with the optimization (86% of the original time)
+    const unsigned count = bytes / 64;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        // See above comments for details
+        GF256_M256 x0 = _mm256_loadu_si256(x32 + i * 2);
+        GF256_M256 l0 = _mm256_and_si256(x0, clr_mask);
+        x0 = _mm256_srli_epi64(x0, 4);
+        const GF256_M256 z0 = _mm256_loadu_si256(z32 + i * 2);
+        GF256_M256 h0 = _mm256_and_si256(x0, clr_mask);
+        l0 = _mm256_shuffle_epi8(table_lo_y, l0);
+        h0 = _mm256_shuffle_epi8(table_hi_y, h0);
+        const GF256_M256 p0 = _mm256_xor_si256(l0, h0);
+        _mm256_storeu_si256(z32 + i * 2, _mm256_xor_si256(p0, z0));
+
+        GF256_M256 x1 = _mm256_loadu_si256(x32 + i * 2 + 1);
+        GF256_M256 l1 = _mm256_and_si256(x1, clr_mask);
+        x1 = _mm256_srli_epi64(x1, 4);
+        const GF256_M256 z1 = _mm256_loadu_si256(z32 + i * 2 + 1);
+        GF256_M256 h1 = _mm256_and_si256(x1, clr_mask);
+        l1 = _mm256_shuffle_epi8(table_lo_y, l1);
+        h1 = _mm256_shuffle_epi8(table_hi_y, h1);
+        const GF256_M256 p1 = _mm256_xor_si256(l1, h1);
+        _mm256_storeu_si256(z32 + i * 2 + 1, _mm256_xor_si256(p1, z1));
+    }
+    bytes -= count * 64;
+    z32 += count * 2;
+    x32 += count * 2;
+
+    if (bytes >= 32)
+    {
+        GF256_M256 x0 = _mm256_loadu_si256(x32);
+        GF256_M256 l0 = _mm256_and_si256(x0, clr_mask);
+        x0 = _mm256_srli_epi64(x0, 4);
+        GF256_M256 h0 = _mm256_and_si256(x0, clr_mask);
+        l0 = _mm256_shuffle_epi8(table_lo_y, l0);
+        h0 = _mm256_shuffle_epi8(table_hi_y, h0);
+        const GF256_M256 p0 = _mm256_xor_si256(l0, h0);
+        const GF256_M256 z0 = _mm256_loadu_si256(z32);
+        _mm256_storeu_si256(z32, _mm256_xor_si256(p0, z0));
+
+        bytes -= 32;
+        z32++;
+        x32++;
+    }
+
+    // Handle final 16 bytes
+    if (bytes >= 16)
+    {
+        GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(z32);
+        const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(x32);
+        GF256_M128 x0 = _mm_loadu_si128(x16);
+        GF256_M128 l0 = _mm_and_si128(x0, _mm256_castsi256_si128(clr_mask));
+        x0 = _mm_srli_epi64(x0, 4);
+        GF256_M128 h0 = _mm_and_si128(x0, _mm256_castsi256_si128(clr_mask));
+        l0 = _mm_shuffle_epi8(_mm256_castsi256_si128(table_lo_y), l0);
+        h0 = _mm_shuffle_epi8(_mm256_castsi256_si128(table_hi_y), h0);
+        const GF256_M128 p0 = _mm_xor_si128(l0, h0);
+        _mm_storeu_si128(z16, _mm_xor_si128(p0, _mm_loadu_si128(z16)));
+        bytes -= 16;
+    }
+
+    return original - bytes;
+}
+
+GF256_TARGET("avx2")
+static void gf256_muladd_multi_mem_avx2(uint8_t * GF256_RESTRICT z1, const uint8_t * ys,
+                                        const uint8_t * const * srcs, const int * ends, int count)
+{
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M256 clr_mask = _mm256_set1_epi8(0x0f);
+
+    // Handle multiples of 64 bytes, keeping the destination in registers
+    for (int offset = 0;; offset += 64)
+    {
+        // Finish sources that end within this block; see above
+        while (count > 0 && ends[count - 1] < offset + 64)
+        {
+            --count;
+            if (ends[count] - offset >= 16)
+                gf256_muladd_mem_avx2(z1 + offset, ys[count], srcs[count] + offset, ends[count] - offset);
+        }
+        if (count <= 0)
+            break;
+
+        GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(z1 + offset);
+        GF256_M256 s0 = _mm256_loadu_si256(z32);
+        GF256_M256 s1 = _mm256_loadu_si256(z32 + 1);
+
+        for (int i = 0; i < count; ++i)
+        {
+            // Partial product tables; see above
+            const GF256_M256 table_lo_y = _mm256_loadu_si256(GF256Ctx.MM256.TABLE_LO_Y + ys[i]);
+            const GF256_M256 table_hi_y = _mm256_loadu_si256(GF256Ctx.MM256.TABLE_HI_Y + ys[i]);
+            const GF256_M256 * x32 = reinterpret_cast<const GF256_M256 *>(srcs[i] + offset);
+
+            GF256_M256 x0 = _mm256_loadu_si256(x32);
+            GF256_M256 l0 = _mm256_and_si256(x0, clr_mask);
+            x0 = _mm256_srli_epi64(x0, 4);
+            GF256_M256 h0 = _mm256_and_si256(x0, clr_mask);
+            l0 = _mm256_shuffle_epi8(table_lo_y, l0);
+            h0 = _mm256_shuffle_epi8(table_hi_y, h0);
+            s0 = _mm256_xor_si256(s0, _mm256_xor_si256(l0, h0));
+
+            GF256_M256 x1 = _mm256_loadu_si256(x32 + 1);
+            GF256_M256 l1 = _mm256_and_si256(x1, clr_mask);
+            x1 = _mm256_srli_epi64(x1, 4);
+            GF256_M256 h1 = _mm256_and_si256(x1, clr_mask);
+            l1 = _mm256_shuffle_epi8(table_lo_y, l1);
+            h1 = _mm256_shuffle_epi8(table_hi_y, h1);
+            s1 = _mm256_xor_si256(s1, _mm256_xor_si256(l1, h1));
+        }
+
+        _mm256_storeu_si256(z32, s0);
+        _mm256_storeu_si256(z32 + 1, s1);
+    }
+}
+
+#endif // GF256_TRY_AVX2
+
+#if defined(GF256_TRY_GFNI)
+
+GF256_TARGET("avx2,gfni")
+static int gf256_mul_mem_gfni(void * vz, const void * vx, uint8_t y, int bytes)
+{
+    GF256_M256 * z32 = reinterpret_cast<GF256_M256 *>(vz);
+    const GF256_M256 * x32 = reinterpret_cast<const GF256_M256 *>(vx);
+    const int original = bytes;
+
+    // Bit-matrix for multiplication by y; see gf256_mul_mem_init()
+    const GF256_M256 matrix = _mm256_set1_epi64x((long long)GF256Ctx.GFNI_AFFINE_Y[y]);
+
+    // Handle multiples of 32 bytes
+    while (bytes >= 32)
+    {
+        const GF256_M256 p0 = _mm256_gf2p8affine_epi64_epi8(_mm256_loadu_si256(x32), matrix, 0);
+        _mm256_storeu_si256(z32, p0);
+
+        bytes -= 32, ++x32, ++z32;
+    }
+
+    // Handle final 16 bytes
+    if (bytes >= 16)
+    {
+        const GF256_M128 p0 = _mm_gf2p8affine_epi64_epi8(
+            _mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(x32)),
+            _mm256_castsi256_si128(matrix), 0);
+        _mm_storeu_si128(reinterpret_cast<GF256_M128 *>(z32), p0);
+        bytes -= 16;
+    }
+
+    return original - bytes;
+}
+
+GF256_TARGET("avx2,gfni")
+static int gf256_muladd_mem_gfni(void * GF256_RESTRICT vz, uint8_t y,
+                                 const void * GF256_RESTRICT vx, int bytes)
+{
+    GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(vz);
+    const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(vx);
+    const int original = bytes;
+
+    // Bit-matrix for multiplication by y; see gf256_mul_mem_init()
+    const GF256_M256 matrix = _mm256_set1_epi64x((long long)GF256Ctx.GFNI_AFFINE_Y[y]);
+
+    // Handle multiples of 32 bytes
+    while (bytes >= 32)
+    {
+        const GF256_M256 p0 = _mm256_gf2p8affine_epi64_epi8(_mm256_loadu_si256(x32), matrix, 0);
+        _mm256_storeu_si256(z32, _mm256_xor_si256(p0, _mm256_loadu_si256(z32)));
+
+        bytes -= 32, ++x32, ++z32;
+    }
+
+    // Handle final 16 bytes
+    if (bytes >= 16)
+    {
+        GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(z32);
+        const GF256_M128 p0 = _mm_gf2p8affine_epi64_epi8(
+            _mm_loadu_si128(reinterpret_cast<const GF256_M128 *>(x32)),
+            _mm256_castsi256_si128(matrix), 0);
+        _mm_storeu_si128(z16, _mm_xor_si128(p0, _mm_loadu_si128(z16)));
+        bytes -= 16;
+    }
+
+    return original - bytes;
+}
+
+GF256_TARGET("avx2,gfni")
+static void gf256_muladd_multi_mem_gfni(uint8_t * GF256_RESTRICT z1, const uint8_t * ys,
+                                        const uint8_t * const * srcs, const int * ends, int count)
+{
+    // Handle multiples of 64 bytes, keeping the destination in registers
+    for (int offset = 0;; offset += 64)
+    {
+        // Finish sources that end within this block; see above
+        while (count > 0 && ends[count - 1] < offset + 64)
+        {
+            --count;
+            if (ends[count] - offset >= 16)
+                gf256_muladd_mem_gfni(z1 + offset, ys[count], srcs[count] + offset, ends[count] - offset);
+        }
+        if (count <= 0)
+            break;
+
+        GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(z1 + offset);
+        GF256_M256 s0 = _mm256_loadu_si256(z32);
+        GF256_M256 s1 = _mm256_loadu_si256(z32 + 1);
+
+        for (int i = 0; i < count; ++i)
+        {
+            // Bit-matrix for multiplication by y; see gf256_mul_mem_init()
+            const GF256_M256 matrix = _mm256_set1_epi64x((long long)GF256Ctx.GFNI_AFFINE_Y[ys[i]]);
+            const GF256_M256 * x32 = reinterpret_cast<const GF256_M256 *>(srcs[i] + offset);
+
+            s0 = _mm256_xor_si256(s0, _mm256_gf2p8affine_epi64_epi8(_mm256_loadu_si256(x32), matrix, 0));
+            s1 = _mm256_xor_si256(s1, _mm256_gf2p8affine_epi64_epi8(_mm256_loadu_si256(x32 + 1), matrix, 0));
+        }
+
+        _mm256_storeu_si256(z32, s0);
+        _mm256_storeu_si256(z32 + 1, s1);
+    }
+}
+
+#endif // GF256_TRY_GFNI
+
+#if defined(GF256_TRY_AVX512)
+
+#if defined(__GNUC__) && !defined(__clang__)
+    // GCC 12 AVX-512 headers trip these warnings via _mm512_undefined_epi32()
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wuninitialized"
+    #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+GF256_TARGET("avx2,avx512f,avx512bw")
+static int gf256_add_mem_avx512(void * GF256_RESTRICT vx,
+                                const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M512 * GF256_RESTRICT x64 = reinterpret_cast<GF256_M512 *>(vx);
+    const GF256_M512 * GF256_RESTRICT y64 = reinterpret_cast<const GF256_M512 *>(vy);
+    const int original = bytes;
+
+    while (bytes >= 256)
+    {
+        GF256_M512 x0 = _mm512_loadu_si512(x64);
+        GF256_M512 y0 = _mm512_loadu_si512(y64);
+        x0 = _mm512_xor_si512(x0, y0);
+        GF256_M512 x1 = _mm512_loadu_si512(x64 + 1);
+        GF256_M512 y1 = _mm512_loadu_si512(y64 + 1);
+        x1 = _mm512_xor_si512(x1, y1);
+        GF256_M512 x2 = _mm512_loadu_si512(x64 + 2);
+        GF256_M512 y2 = _mm512_loadu_si512(y64 + 2);
+        x2 = _mm512_xor_si512(x2, y2);
+        GF256_M512 x3 = _mm512_loadu_si512(x64 + 3);
+        GF256_M512 y3 = _mm512_loadu_si512(y64 + 3);
+        x3 = _mm512_xor_si512(x3, y3);
+
+        _mm512_storeu_si512(x64, x0);
+        _mm512_storeu_si512(x64 + 1, x1);
+        _mm512_storeu_si512(x64 + 2, x2);
+        _mm512_storeu_si512(x64 + 3, x3);
+
+        bytes -= 256, x64 += 4, y64 += 4;
+    }
+
+    // Handle multiples of 64 bytes
+    while (bytes >= 64)
+    {
+        // x[i] = x[i] xor y[i]
+        _mm512_storeu_si512(x64,
+            _mm512_xor_si512(
+                _mm512_loadu_si512(x64),
+                _mm512_loadu_si512(y64)));
+
+        bytes -= 64, ++x64, ++y64;
+    }
+
+    // Finish with the 256-bit kernel
+    return original - bytes + gf256_add_mem_avx2(x64, y64, bytes);
+}
+
+GF256_TARGET("avx2,avx512f,avx512bw")
+static int gf256_add2_mem_avx512(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                 const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M512 * GF256_RESTRICT z64 = reinterpret_cast<GF256_M512 *>(vz);
+    const GF256_M512 * GF256_RESTRICT x64 = reinterpret_cast<const GF256_M512 *>(vx);
+    const GF256_M512 * GF256_RESTRICT y64 = reinterpret_cast<const GF256_M512 *>(vy);
+
+    const unsigned count = bytes / 64;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        // z[i] = z[i] xor x[i] xor y[i] : 0x96 is the three-way XOR truth table
+        _mm512_storeu_si512(z64 + i,
+            _mm512_ternarylogic_epi32(
+                _mm512_loadu_si512(z64 + i),
+                _mm512_loadu_si512(x64 + i),
+                _mm512_loadu_si512(y64 + i), 0x96));
+    }
+
+    // Finish with the 256-bit kernel
+    return count * 64 + gf256_add2_mem_avx2(z64 + count, x64 + count, y64 + count, bytes - count * 64);
+}
+
+GF256_TARGET("avx2,avx512f,avx512bw")
+static int gf256_addset_mem_avx512(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                   const void * GF256_RESTRICT vy, int bytes)
+{
+    GF256_M512 * GF256_RESTRICT z64 = reinterpret_cast<GF256_M512 *>(vz);
+    const GF256_M512 * GF256_RESTRICT x64 = reinterpret_cast<const GF256_M512 *>(vx);
+    const GF256_M512 * GF256_RESTRICT y64 = reinterpret_cast<const GF256_M512 *>(vy);
+
+    const unsigned count = bytes / 64;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        _mm512_storeu_si512(z64 + i,
+            _mm512_xor_si512(
+                _mm512_loadu_si512(x64 + i),
+                _mm512_loadu_si512(y64 + i)));
+    }
+
+    // Finish with the 256-bit kernel
+    return count * 64 + gf256_addset_mem_avx2(z64 + count, x64 + count, y64 + count, bytes - count * 64);
+}
+
+/// Returns a load/store mask that selects the first `bytes` of a 512-bit vector
+static GF256_FORCE_INLINE uint64_t gf256_mask64(int bytes)
+{
+    if (bytes >= 64)
+        return ~(uint64_t)0;
+    if (bytes <= 0)
+        return 0;
+    return ((uint64_t)1 << bytes) - 1;
+}
+
+GF256_TARGET("avx2,avx512f,avx512bw")
+static int gf256_mul_mem_avx512(void * vz, const void * vx, uint8_t y, int bytes)
+{
+    GF256_M512 * z64 = reinterpret_cast<GF256_M512 *>(vz);
+    const GF256_M512 * x64 = reinterpret_cast<const GF256_M512 *>(vx);
+    const int original = bytes;
+
+    // Partial product tables; see above
+    const GF256_M512 table_lo_y = _mm512_broadcast_i32x4(_mm_loadu_si128(GF256Ctx.MM128.TABLE_LO_Y + y));
+    const GF256_M512 table_hi_y = _mm512_broadcast_i32x4(_mm_loadu_si128(GF256Ctx.MM128.TABLE_HI_Y + y));
+
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M512 clr_mask = _mm512_set1_epi8(0x0f);
+
+    // Handle multiples of 64 bytes
+    while (bytes >= 64)
+    {
+        // See above comments for details
+        GF256_M512 x0 = _mm512_loadu_si512(x64);
+        GF256_M512 l0 = _mm512_and_si512(x0, clr_mask);
+        x0 = _mm512_srli_epi64(x0, 4);
+        GF256_M512 h0 = _mm512_and_si512(x0, clr_mask);
+        l0 = _mm512_shuffle_epi8(table_lo_y, l0);
+        h0 = _mm512_shuffle_epi8(table_hi_y, h0);
+        _mm512_storeu_si512(z64, _mm512_xor_si512(l0, h0));
+
+        bytes -= 64, ++x64, ++z64;
+    }
+
+    // Finish with the 256-bit kernel
+    return original - bytes + gf256_mul_mem_avx2(z64, x64, y, bytes);
+}
+
+GF256_TARGET("avx2,avx512f,avx512bw")
+static int gf256_muladd_mem_avx512(void * GF256_RESTRICT vz, uint8_t y,
+                                   const void * GF256_RESTRICT vx, int bytes)
+{
+    GF256_M512 * GF256_RESTRICT z64 = reinterpret_cast<GF256_M512 *>(vz);
+    const GF256_M512 * GF256_RESTRICT x64 = reinterpret_cast<const GF256_M512 *>(vx);
+    const int original = bytes;
+
+    // Partial product tables; see above
+    const GF256_M512 table_lo_y = _mm512_broadcast_i32x4(_mm_loadu_si128(GF256Ctx.MM128.TABLE_LO_Y + y));
+    const GF256_M512 table_hi_y = _mm512_broadcast_i32x4(_mm_loadu_si128(GF256Ctx.MM128.TABLE_HI_Y + y));
+
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M512 clr_mask = _mm512_set1_epi8(0x0f);
+
+    // Handle multiples of 64 bytes
+    while (bytes >= 64)
+    {
+        // See above comments for details
+        GF256_M512 x0 = _mm512_loadu_si512(x64);
+        GF256_M512 l0 = _mm512_and_si512(x0, clr_mask);
+        x0 = _mm512_srli_epi64(x0, 4);
+        const GF256_M512 z0 = _mm512_loadu_si512(z64);
+        GF256_M512 h0 = _mm512_and_si512(x0, clr_mask);
+        l0 = _mm512_shuffle_epi8(table_lo_y, l0);
+        h0 = _mm512_shuffle_epi8(table_hi_y, h0);
+        // z[i] ^= lo ^ hi : 0x96 is the three-way XOR truth table
+        _mm512_storeu_si512(z64, _mm512_ternarylogic_epi32(l0, h0, z0, 0x96));
+
+        bytes -= 64, ++x64, ++z64;
+    }
+
+    // Finish with the 256-bit kernel
+    return original - bytes + gf256_muladd_mem_avx2(z64, y, x64, bytes);
+}
+
+GF256_TARGET("avx2,avx512f,avx512bw")
+static void gf256_muladd_multi_mem_avx512(uint8_t * GF256_RESTRICT z1, const uint8_t * ys,
+                                          const uint8_t * const * srcs, const int * ends, int count)
+{
+    // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
+    const GF256_M512 clr_mask = _mm512_set1_epi8(0x0f);
+
+    // Handle multiples of 128 bytes, keeping the destination in registers
+    for (int offset = 0;; offset += 128)
+    {
+        // Sources that all end at the same place within this block are
+        // finished together below, otherwise finish them one at a time
+        const bool lastBlock = count > 0 && ends[0] < offset + 128 &&
+            (ends[0] & ~15) > offset && (ends[0] & ~15) == (ends[count - 1] & ~15);
+        while (!lastBlock && count > 0 && ends[count - 1] < offset + 128)
+        {
+            --count;
+            if (ends[count] - offset >= 16)
+                gf256_muladd_mem_avx512(z1 + offset, ys[count], srcs[count] + offset, ends[count] - offset);
+        }
+        if (count <= 0)
+            break;
+
+        GF256_M512 * GF256_RESTRICT z64 = reinterpret_cast<GF256_M512 *>(z1 + offset);
+
+        if (lastBlock)
+        {
+            const __mmask64 k0 = gf256_mask64((ends[0] & ~15) - offset);
+            const __mmask64 k1 = gf256_mask64((ends[0] & ~15) - offset - 64);
+            GF256_M512 s0 = _mm512_maskz_loadu_epi8(k0, z64);
+            GF256_M512 s1 = _mm512_maskz_loadu_epi8(k1, z64 + 1);
+
+            for (int i = 0; i < count; ++i)
+            {
+                // Partial product tables; see above
+                const GF256_M512 table_lo_y = _mm512_broadcast_i32x4(_mm_loadu_si128(GF256Ctx.MM128.TABLE_LO_Y + ys[i]));
+                const GF256_M512 table_hi_y = _mm512_broadcast_i32x4(_mm_loadu_si128(GF256Ctx.MM128.TABLE_HI_Y + ys[i]));
+                const GF256_M512 * x64 = reinterpret_cast<const GF256_M512 *>(srcs[i] + offset);
+
+                GF256_M512 x0 = _mm512_maskz_loadu_epi8(k0, x64);
+                GF256_M512 l0 = _mm512_and_si512(x0, clr_mask);
+                x0 = _mm512_srli_epi64(x0, 4);
+                GF256_M512 h0 = _mm512_and_si512(x0, clr_mask);
+                l0 = _mm512_shuffle_epi8(table_lo_y, l0);
+                h0 = _mm512_shuffle_epi8(table_hi_y, h0);
+                s0 = _mm512_ternarylogic_epi32(l0, h0, s0, 0x96);
+
+                GF256_M512 x1 = _mm512_maskz_loadu_epi8(k1, x64 + 1);
+                GF256_M512 l1 = _mm512_and_si512(x1, clr_mask);
+                x1 = _mm512_srli_epi64(x1, 4);
+                GF256_M512 h1 = _mm512_and_si512(x1, clr_mask);
+                l1 = _mm512_shuffle_epi8(table_lo_y, l1);
+                h1 = _mm512_shuffle_epi8(table_hi_y, h1);
+                s1 = _mm512_ternarylogic_epi32(l1, h1, s1, 0x96);
+            }
+
+            _mm512_mask_storeu_epi8(z64, k0, s0);
+            _mm512_mask_storeu_epi8(z64 + 1, k1, s1);
+            break;
+        }
+
+        GF256_M512 s0 = _mm512_loadu_si512(z64);
+        GF256_M512 s1 = _mm512_loadu_si512(z64 + 1);
+
+        for (int i = 0; i < count; ++i)
+        {
+            // Partial product tables; see above
+            const GF256_M512 table_lo_y = _mm512_broadcast_i32x4(_mm_loadu_si128(GF256Ctx.MM128.TABLE_LO_Y + ys[i]));
+            const GF256_M512 table_hi_y = _mm512_broadcast_i32x4(_mm_loadu_si128(GF256Ctx.MM128.TABLE_HI_Y + ys[i]));
+            const GF256_M512 * x64 = reinterpret_cast<const GF256_M512 *>(srcs[i] + offset);
+
+            GF256_M512 x0 = _mm512_loadu_si512(x64);
+            GF256_M512 l0 = _mm512_and_si512(x0, clr_mask);
+            x0 = _mm512_srli_epi64(x0, 4);
+            GF256_M512 h0 = _mm512_and_si512(x0, clr_mask);
+            l0 = _mm512_shuffle_epi8(table_lo_y, l0);
+            h0 = _mm512_shuffle_epi8(table_hi_y, h0);
+            // s ^= lo ^ hi : 0x96 is the three-way XOR truth table
+            s0 = _mm512_ternarylogic_epi32(l0, h0, s0, 0x96);
+
+            GF256_M512 x1 = _mm512_loadu_si512(x64 + 1);
+            GF256_M512 l1 = _mm512_and_si512(x1, clr_mask);
+            x1 = _mm512_srli_epi64(x1, 4);
+            GF256_M512 h1 = _mm512_and_si512(x1, clr_mask);
+            l1 = _mm512_shuffle_epi8(table_lo_y, l1);
+            h1 = _mm512_shuffle_epi8(table_hi_y, h1);
+            s1 = _mm512_ternarylogic_epi32(l1, h1, s1, 0x96);
+        }
+
+        _mm512_storeu_si512(z64, s0);
+        _mm512_storeu_si512(z64 + 1, s1);
+    }
+}
+
+#if defined(GF256_TRY_GFNI)
+
+GF256_TARGET("avx2,avx512f,avx512bw,gfni")
+static int gf256_mul_mem_avx512_gfni(void * vz, const void * vx, uint8_t y, int bytes)
+{
+    GF256_M512 * z64 = reinterpret_cast<GF256_M512 *>(vz);
+    const GF256_M512 * x64 = reinterpret_cast<const GF256_M512 *>(vx);
+    const int original = bytes;
+
+    // Bit-matrix for multiplication by y; see gf256_mul_mem_init()
+    const GF256_M512 matrix = _mm512_set1_epi64((long long)GF256Ctx.GFNI_AFFINE_Y[y]);
+
+    // Handle multiples of 64 bytes
+    while (bytes >= 64)
+    {
+        const GF256_M512 p0 = _mm512_gf2p8affine_epi64_epi8(_mm512_loadu_si512(x64), matrix, 0);
+        _mm512_storeu_si512(z64, p0);
+
+        bytes -= 64, ++x64, ++z64;
+    }
+
+    // Finish with the 256-bit kernel
+    return original - bytes + gf256_mul_mem_gfni(z64, x64, y, bytes);
+}
+
+GF256_TARGET("avx2,avx512f,avx512bw,gfni")
+static int gf256_muladd_mem_avx512_gfni(void * GF256_RESTRICT vz, uint8_t y,
+                                        const void * GF256_RESTRICT vx, int bytes)
+{
+    GF256_M512 * GF256_RESTRICT z64 = reinterpret_cast<GF256_M512 *>(vz);
+    const GF256_M512 * GF256_RESTRICT x64 = reinterpret_cast<const GF256_M512 *>(vx);
+    const int original = bytes;
+
+    // Bit-matrix for multiplication by y; see gf256_mul_mem_init()
+    const GF256_M512 matrix = _mm512_set1_epi64((long long)GF256Ctx.GFNI_AFFINE_Y[y]);
+
+    // Handle multiples of 64 bytes
+    while (bytes >= 64)
+    {
+        const GF256_M512 p0 = _mm512_gf2p8affine_epi64_epi8(_mm512_loadu_si512(x64), matrix, 0);
+        _mm512_storeu_si512(z64, _mm512_xor_si512(p0, _mm512_loadu_si512(z64)));
+
+        bytes -= 64, ++x64, ++z64;
+    }
+
+    // Finish with the 256-bit kernel
+    return original - bytes + gf256_muladd_mem_gfni(z64, y, x64, bytes);
+}
+
+GF256_TARGET("avx2,avx512f,avx512bw,gfni")
+static void gf256_muladd_multi_mem_avx512_gfni(uint8_t * GF256_RESTRICT z1, const uint8_t * ys,
+                                               const uint8_t * const * srcs, const int * ends, int count)
+{
+    // Handle multiples of 128 bytes, keeping the destination in registers
+    for (int offset = 0;; offset += 128)
+    {
+        // Sources that all end at the same place within this block are
+        // finished together below, otherwise finish them one at a time
+        const bool lastBlock = count > 0 && ends[0] < offset + 128 &&
+            (ends[0] & ~15) > offset && (ends[0] & ~15) == (ends[count - 1] & ~15);
+        while (!lastBlock && count > 0 && ends[count - 1] < offset + 128)
+        {
+            --count;
+            if (ends[count] - offset >= 16)
+                gf256_muladd_mem_avx512_gfni(z1 + offset, ys[count], srcs[count] + offset, ends[count] - offset);
+        }
+        if (count <= 0)
+            break;
+
+        GF256_M512 * GF256_RESTRICT z64 = reinterpret_cast<GF256_M512 *>(z1 + offset);
+
+        if (lastBlock)
+        {
+            const __mmask64 k0 = gf256_mask64((ends[0] & ~15) - offset);
+            const __mmask64 k1 = gf256_mask64((ends[0] & ~15) - offset - 64);
+            GF256_M512 s0 = _mm512_maskz_loadu_epi8(k0, z64);
+            GF256_M512 s1 = _mm512_maskz_loadu_epi8(k1, z64 + 1);
+
+            for (int i = 0; i < count; ++i)
+            {
+                const GF256_M512 matrix = _mm512_set1_epi64((long long)GF256Ctx.GFNI_AFFINE_Y[ys[i]]);
+                const GF256_M512 * x64 = reinterpret_cast<const GF256_M512 *>(srcs[i] + offset);
+
+                s0 = _mm512_xor_si512(s0, _mm512_gf2p8affine_epi64_epi8(_mm512_maskz_loadu_epi8(k0, x64), matrix, 0));
+                s1 = _mm512_xor_si512(s1, _mm512_gf2p8affine_epi64_epi8(_mm512_maskz_loadu_epi8(k1, x64 + 1), matrix, 0));
+            }
+
+            _mm512_mask_storeu_epi8(z64, k0, s0);
+            _mm512_mask_storeu_epi8(z64 + 1, k1, s1);
+            break;
+        }
+
+        GF256_M512 s0 = _mm512_loadu_si512(z64);
+        GF256_M512 s1 = _mm512_loadu_si512(z64 + 1);
+
+        for (int i = 0; i < count; ++i)
+        {
+            // Bit-matrix for multiplication by y; see gf256_mul_mem_init()
+            const GF256_M512 matrix = _mm512_set1_epi64((long long)GF256Ctx.GFNI_AFFINE_Y[ys[i]]);
+            const GF256_M512 * x64 = reinterpret_cast<const GF256_M512 *>(srcs[i] + offset);
+
+            s0 = _mm512_xor_si512(s0, _mm512_gf2p8affine_epi64_epi8(_mm512_loadu_si512(x64), matrix, 0));
+            s1 = _mm512_xor_si512(s1, _mm512_gf2p8affine_epi64_epi8(_mm512_loadu_si512(x64 + 1), matrix, 0));
+        }
+
+        _mm512_storeu_si512(z64, s0);
+        _mm512_storeu_si512(z64 + 1, s1);
+    }
+}
+
+#endif // GF256_TRY_GFNI
+
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic pop
+#endif
+
+#endif // GF256_TRY_AVX512
+
+
+//------------------------------------------------------------------------------
+// Runtime Dispatch
+
+/// Kernels selected for this CPU by gf256_dispatch_init()
+struct gf256_dispatch
+{
+    int (*AddMem)(void * GF256_RESTRICT vx, const void * GF256_RESTRICT vy, int bytes);
+    int (*Add2Mem)(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                   const void * GF256_RESTRICT vy, int bytes);
+    int (*AddSetMem)(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                     const void * GF256_RESTRICT vy, int bytes);
+
+    /// These are nullptr when the CPU does not support SSSE3
+    // Note: MulMem kernels do not use restrict, so they may run in place
+    int (*MulMem)(void * vz, const void * vx, uint8_t y, int bytes);
+    int (*MulAddMem)(void * GF256_RESTRICT vz, uint8_t y, const void * GF256_RESTRICT vx, int bytes);
+    void (*MulAddMultiMem)(uint8_t * GF256_RESTRICT z1, const uint8_t * ys,
+                           const uint8_t * const * srcs, const int * ends, int count);
+};
+
+static gf256_dispatch GF256Dispatch = {
+    gf256_add_mem_sse2,
+    gf256_add2_mem_sse2,
+    gf256_addset_mem_sse2,
+    nullptr,
+    nullptr,
+    nullptr
+};
+
+/// Instruction set tiers, from slowest to fastest
+enum class KernelTier
+{
+    SSE2,
+    SSSE3,
+    AVX2,
+    GFNI,       ///< AVX2 + GFNI
+    AVX512,     ///< AVX-512BW
+    AVX512_GFNI ///< AVX-512BW + GFNI
+};
+
+/// Returns true if the CPU supports the given tier
+static bool gf256_dispatch_supported(KernelTier tier)
+{
+    switch (tier)
+    {
+    case KernelTier::SSE2: return true;
+    case KernelTier::SSSE3: return CpuHasSSSE3;
+#if defined(GF256_TRY_AVX2)
+    case KernelTier::AVX2: return CpuHasAVX2;
+#endif
+#if defined(GF256_TRY_GFNI)
+    case KernelTier::GFNI: return CpuHasGFNI;
+#endif
+#if defined(GF256_TRY_AVX512)
+    case KernelTier::AVX512: return CpuHasAVX512;
+# if defined(GF256_TRY_GFNI)
+    case KernelTier::AVX512_GFNI: return CpuHasAVX512 && CpuHasGFNI;
+# endif
+#endif
+    default: break;
+    }
+    return false;
+}
+
+/// Select the kernels for the given tier.  Precondition: Tier is supported
+static void gf256_dispatch_init(KernelTier tier)
+{
+    GF256Dispatch.AddMem = gf256_add_mem_sse2;
+    GF256Dispatch.Add2Mem = gf256_add2_mem_sse2;
+    GF256Dispatch.AddSetMem = gf256_addset_mem_sse2;
+    GF256Dispatch.MulMem = nullptr;
+    GF256Dispatch.MulAddMem = nullptr;
+    GF256Dispatch.MulAddMultiMem = nullptr;
+
+    if (tier >= KernelTier::SSSE3)
+    {
+        GF256Dispatch.MulMem = gf256_mul_mem_ssse3;
+        GF256Dispatch.MulAddMem = gf256_muladd_mem_ssse3;
+        GF256Dispatch.MulAddMultiMem = gf256_muladd_multi_mem_ssse3;
+    }
+#if defined(GF256_TRY_AVX2)
+    if (tier >= KernelTier::AVX2)
+    {
+        GF256Dispatch.AddMem = gf256_add_mem_avx2;
+        GF256Dispatch.Add2Mem = gf256_add2_mem_avx2;
+        GF256Dispatch.AddSetMem = gf256_addset_mem_avx2;
+        GF256Dispatch.MulMem = gf256_mul_mem_avx2;
+        GF256Dispatch.MulAddMem = gf256_muladd_mem_avx2;
+        GF256Dispatch.MulAddMultiMem = gf256_muladd_multi_mem_avx2;
+    }
+#endif // GF256_TRY_AVX2
+#if defined(GF256_TRY_GFNI)
+    if (tier == KernelTier::GFNI)
+    {
+        GF256Dispatch.MulMem = gf256_mul_mem_gfni;
+        GF256Dispatch.MulAddMem = gf256_muladd_mem_gfni;
+        GF256Dispatch.MulAddMultiMem = gf256_muladd_multi_mem_gfni;
     }
+#endif // GF256_TRY_GFNI
+#if defined(GF256_TRY_AVX512)
+    if (tier >= KernelTier::AVX512)
+    {
+        GF256Dispatch.AddMem = gf256_add_mem_avx512;
+        GF256Dispatch.Add2Mem = gf256_add2_mem_avx512;
+        GF256Dispatch.AddSetMem = gf256_addset_mem_avx512;
+        GF256Dispatch.MulMem = gf256_mul_mem_avx512;
+        GF256Dispatch.MulAddMem = gf256_muladd_mem_avx512;
+        GF256Dispatch.MulAddMultiMem = gf256_muladd_multi_mem_avx512;
+    }
+# if defined(GF256_TRY_GFNI)
+    if (tier == KernelTier::AVX512_GFNI)
+    {
+        GF256Dispatch.MulMem = gf256_mul_mem_avx512_gfni;
+        GF256Dispatch.MulAddMem = gf256_muladd_mem_avx512_gfni;
+        GF256Dispatch.MulAddMultiMem = gf256_muladd_multi_mem_avx512_gfni;
+    }
+# endif // GF256_TRY_GFNI
+#endif // GF256_TRY_AVX512
 }
 
+#endif // GF256_TARGET_MOBILE
+
 
 //------------------------------------------------------------------------------
 // Initialization
@@ -640,8 +1965,22 @@ extern "C" int gf256_init_(int version)
     gf256_sqr_init();
     gf256_mul_mem_init();
 
+#if !defined(GF256_TARGET_MOBILE)
+    // Self-test each kernel tier supported by this CPU, ending on the fastest
+    for (int tier = (int)KernelTier::SSE2; tier <= (int)KernelTier::AVX512_GFNI; ++tier)
+    {
+        if (!gf256_dispatch_supported((KernelTier)tier))
+            continue;
+
+        gf256_dispatch_init((KernelTier)tier);
+
+        if (!gf256_self_test())
+            return -3; // Self-test failed (perhaps untested configuration)
+    }
+#else // GF256_TARGET_MOBILE
     if (!gf256_self_test())
         return -3; // Self-test failed (perhaps untested configuration)
+#endif // GF256_TARGET_MOBILE
 
     return 0;
 }
@@ -707,92 +2046,13 @@ extern "C" void gf256_add_mem(void * GF256_RESTRICT vx,
         bytes -= (count * 8);
     }
 #else // GF256_TARGET_MOBILE
-# if defined(GF256_TRY_AVX2)
-    if (CpuHasAVX2)
-    {
-        GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<GF256_M256 *>(x16);
-        const GF256_M256 * GF256_RESTRICT y32 = reinterpret_cast<const GF256_M256 *>(y16);
-
-        while (bytes >= 128)
-        {
-            GF256_M256 x0 = _mm256_loadu_si256(x32);
-            GF256_M256 y0 = _mm256_loadu_si256(y32);
-            x0 = _mm256_xor_si256(x0, y0);
-            GF256_M256 x1 = _mm256_loadu_si256(x32 + 1);
-            GF256_M256 y1 = _mm256_loadu_si256(y32 + 1);
-            x1 = _mm256_xor_si256(x1, y1);
-            GF256_M256 x2 = _mm256_loadu_si256(x32 + 2);
-            GF256_M256 y2 = _mm256_loadu_si256(y32 + 2);
-            x2 = _mm256_xor_si256(x2, y2);
-            GF256_M256 x3 = _mm256_loadu_si256(x32 + 3);
-            GF256_M256 y3 = _mm256_loadu_si256(y32 + 3);
-            x3 = _mm256_xor_si256(x3, y3);
-
-            _mm256_storeu_si256(x32, x0);
-            _mm256_storeu_si256(x32 + 1, x1);
-            _mm256_storeu_si256(x32 + 2, x2);
-            _mm256_storeu_si256(x32 + 3, x3);
-
-            bytes -= 128, x32 += 4, y32 += 4;
-        }
-
-        // Handle multiples of 32 bytes
-        while (bytes >= 32)
-        {
-            // x[i] = x[i] xor y[i]
-            _mm256_storeu_si256(x32,
-                _mm256_xor_si256(
-                    _mm256_loadu_si256(x32),
-                    _mm256_loadu_si256(y32)));
-
-            bytes -= 32, ++x32, ++y32;
-        }
-
-        x16 = reinterpret_cast<GF256_M128 *>(x32);
-        y16 = reinterpret_cast<const GF256_M128 *>(y32);
-    }
-    else
-# endif // GF256_TRY_AVX2
-    {
-        while (bytes >= 64)
-        {
-            GF256_M128 x0 = _mm_loadu_si128(x16);
-            GF256_M128 y0 = _mm_loadu_si128(y16);
-            x0 = _mm_xor_si128(x0, y0);
-            GF256_M128 x1 = _mm_loadu_si128(x16 + 1);
-            GF256_M128 y1 = _mm_loadu_si128(y16 + 1);
-            x1 = _mm_xor_si128(x1, y1);
-            GF256_M128 x2 = _mm_loadu_si128(x16 + 2);
-            GF256_M128 y2 = _mm_loadu_si128(y16 + 2);
-            x2 = _mm_xor_si128(x2, y2);
-            GF256_M128 x3 = _mm_loadu_si128(x16 + 3);
-            GF256_M128 y3 = _mm_loadu_si128(y16 + 3);
-            x3 = _mm_xor_si128(x3, y3);
-
-            _mm_storeu_si128(x16, x0);
-            _mm_storeu_si128(x16 + 1, x1);
-            _mm_storeu_si128(x16 + 2, x2);
-            _mm_storeu_si128(x16 + 3, x3);
-
-            bytes -= 64, x16 += 4, y16 += 4;
-        }
-    }
+    // Handle multiples of 16 bytes with the fastest kernel for this CPU
+    const int bulk = GF256Dispatch.AddMem(x16, y16, bytes);
+    x16 = reinterpret_cast<GF256_M128 *>(reinterpret_cast<uint8_t *>(x16) + bulk);
+    y16 = reinterpret_cast<const GF256_M128 *>(reinterpret_cast<const uint8_t *>(y16) + bulk);
+    bytes -= bulk;
 #endif // GF256_TARGET_MOBILE
 
-#if !defined(GF256_TARGET_MOBILE)
-    // Handle multiples of 16 bytes
-    while (bytes >= 16)
-    {
-        // x[i] = x[i] xor y[i]
-        _mm_storeu_si128(x16,
-            _mm_xor_si128(
-                _mm_loadu_si128(x16),
-                _mm_loadu_si128(y16)));
-
-        bytes -= 16, ++x16, ++y16;
-    }
-#endif
-
     uint8_t * GF256_RESTRICT x1 = reinterpret_cast<uint8_t *>(x16);
     const uint8_t * GF256_RESTRICT y1 = reinterpret_cast<const uint8_t *>(y16);
 
@@ -870,44 +2130,12 @@ extern "C" void gf256_add2_mem(void * GF256_RESTRICT vz, const void * GF256_REST
         bytes -= (count * 8);
     }
 #else // GF256_TARGET_MOBILE
-# if defined(GF256_TRY_AVX2)
-    if (CpuHasAVX2)
-    {
-        GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(z16);
-        const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(x16);
-        const GF256_M256 * GF256_RESTRICT y32 = reinterpret_cast<const GF256_M256 *>(y16);
-
-        const unsigned count = bytes / 32;
-        for (unsigned i = 0; i < count; ++i)
-        {
-            _mm256_storeu_si256(z32 + i,
-                _mm256_xor_si256(
-                    _mm256_loadu_si256(z32 + i),
-                    _mm256_xor_si256(
-                        _mm256_loadu_si256(x32 + i),
-                        _mm256_loadu_si256(y32 + i))));
-        }
-
-        bytes -= count * 32;
-        z16 = reinterpret_cast<GF256_M128 *>(z32 + count);
-        x16 = reinterpret_cast<const GF256_M128 *>(x32 + count);
-        y16 = reinterpret_cast<const GF256_M128 *>(y32 + count);
-    }
-# endif // GF256_TRY_AVX2
-
-    // Handle multiples of 16 bytes
-    while (bytes >= 16)
-    {
-        // z[i] = z[i] xor x[i] xor y[i]
-        _mm_storeu_si128(z16,
-            _mm_xor_si128(
-                _mm_loadu_si128(z16),
-                _mm_xor_si128(
-                    _mm_loadu_si128(x16),
-                    _mm_loadu_si128(y16))));
-
-        bytes -= 16, ++x16, ++y16, ++z16;
-    }
+    // Handle multiples of 16 bytes with the fastest kernel for this CPU
+    const int bulk = GF256Dispatch.Add2Mem(z16, x16, y16, bytes);
+    z16 = reinterpret_cast<GF256_M128 *>(reinterpret_cast<uint8_t *>(z16) + bulk);
+    x16 = reinterpret_cast<const GF256_M128 *>(reinterpret_cast<const uint8_t *>(x16) + bulk);
+    y16 = reinterpret_cast<const GF256_M128 *>(reinterpret_cast<const uint8_t *>(y16) + bulk);
+    bytes -= bulk;
 #endif // GF256_TARGET_MOBILE
 
     uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t *>(z16);
@@ -1007,62 +2235,12 @@ extern "C" void gf256_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RE
         bytes -= (count * 8);
     }
 #else // GF256_TARGET_MOBILE
-# if defined(GF256_TRY_AVX2)
-    if (CpuHasAVX2)
-    {
-        GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(z16);
-        const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(x16);
-        const GF256_M256 * GF256_RESTRICT y32 = reinterpret_cast<const GF256_M256 *>(y16);
-
-        const unsigned count = bytes / 32;
-        for (unsigned i = 0; i < count; ++i)
-        {
-            _mm256_storeu_si256(z32 + i,
-                _mm256_xor_si256(
-                    _mm256_loadu_si256(x32 + i),
-                    _mm256_loadu_si256(y32 + i)));
-        }
-
-        bytes -= count * 32;
-        z16 = reinterpret_cast<GF256_M128 *>(z32 + count);
-        x16 = reinterpret_cast<const GF256_M128 *>(x32 + count);
-        y16 = reinterpret_cast<const GF256_M128 *>(y32 + count);
-    }
-    else
-# endif // GF256_TRY_AVX2
-    {
-        // Handle multiples of 64 bytes
-        while (bytes >= 64)
-        {
-            GF256_M128 x0 = _mm_loadu_si128(x16);
-            GF256_M128 x1 = _mm_loadu_si128(x16 + 1);
-            GF256_M128 x2 = _mm_loadu_si128(x16 + 2);
-            GF256_M128 x3 = _mm_loadu_si128(x16 + 3);
-            GF256_M128 y0 = _mm_loadu_si128(y16);
-            GF256_M128 y1 = _mm_loadu_si128(y16 + 1);
-            GF256_M128 y2 = _mm_loadu_si128(y16 + 2);
-            GF256_M128 y3 = _mm_loadu_si128(y16 + 3);
-
-            _mm_storeu_si128(z16,     _mm_xor_si128(x0, y0));
-            _mm_storeu_si128(z16 + 1, _mm_xor_si128(x1, y1));
-            _mm_storeu_si128(z16 + 2, _mm_xor_si128(x2, y2));
-            _mm_storeu_si128(z16 + 3, _mm_xor_si128(x3, y3));
-
-            bytes -= 64, x16 += 4, y16 += 4, z16 += 4;
-        }
-    }
-
-    // Handle multiples of 16 bytes
-    while (bytes >= 16)
-    {
-        // z[i] = x[i] xor y[i]
-        _mm_storeu_si128(z16,
-            _mm_xor_si128(
-                _mm_loadu_si128(x16),
-                _mm_loadu_si128(y16)));
-
-        bytes -= 16, ++x16, ++y16, ++z16;
-    }
+    // Handle multiples of 16 bytes with the fastest kernel for this CPU
+    const int bulk = GF256Dispatch.AddSetMem(z16, x16, y16, bytes);
+    z16 = reinterpret_cast<GF256_M128 *>(reinterpret_cast<uint8_t *>(z16) + bulk);
+    x16 = reinterpret_cast<const GF256_M128 *>(reinterpret_cast<const uint8_t *>(x16) + bulk);
+    y16 = reinterpret_cast<const GF256_M128 *>(reinterpret_cast<const uint8_t *>(y16) + bulk);
+    bytes -= bulk;
 #endif // GF256_TARGET_MOBILE
 
     uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t *>(z16);
@@ -1101,7 +2279,8 @@ extern "C" void gf256_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RE
     }
 }
 
-extern "C" void gf256_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
+/// Shared by gf256_mul_mem() and gf256_mul_mem_inplace(), so vz may equal vx
+static void gf256_mul_mem_shared(void * vz, const void * vx, uint8_t y, int bytes)
 {
     // Use a single if-statement to handle special cases
     if (y <= 1)
@@ -1113,8 +2292,8 @@ extern "C" void gf256_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTR
         return;
     }
 
-    GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128 *>(vz);
-    const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128 *>(vx);
+    GF256_M128 * z16 = reinterpret_cast<GF256_M128 *>(vz);
+    const GF256_M128 * x16 = reinterpret_cast<const GF256_M128 *>(vx);
 
 #if defined(GF256_TARGET_MOBILE)
 #if defined(GF256_TRY_NEON)
@@ -1143,73 +2322,25 @@ extern "C" void gf256_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTR
         } while (bytes >= 16);
     }
 #endif
-#else
-# if defined(GF256_TRY_AVX2)
-    if (bytes >= 32 && CpuHasAVX2)
-    {
-        // Partial product tables; see above
-        const GF256_M256 table_lo_y = _mm256_loadu_si256(GF256Ctx.MM256.TABLE_LO_Y + y);
-        const GF256_M256 table_hi_y = _mm256_loadu_si256(GF256Ctx.MM256.TABLE_HI_Y + y);
-
-        // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
-        const GF256_M256 clr_mask = _mm256_set1_epi8(0x0f);
-
-        GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(vz);
-        const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(vx);
-
-        // Handle multiples of 32 bytes
-        do
-        {
-            // See above comments for details
-            GF256_M256 x0 = _mm256_loadu_si256(x32);
-            GF256_M256 l0 = _mm256_and_si256(x0, clr_mask);
-            x0 = _mm256_srli_epi64(x0, 4);
-            GF256_M256 h0 = _mm256_and_si256(x0, clr_mask);
-            l0 = _mm256_shuffle_epi8(table_lo_y, l0);
-            h0 = _mm256_shuffle_epi8(table_hi_y, h0);
-            _mm256_storeu_si256(z32, _mm256_xor_si256(l0, h0));
-
-            bytes -= 32, ++x32, ++z32;
-        } while (bytes >= 32);
-
-        z16 = reinterpret_cast<GF256_M128 *>(z32);
-        x16 = reinterpret_cast<const GF256_M128 *>(x32);
-    }
-# endif // GF256_TRY_AVX2
-    if (bytes >= 16 && CpuHasSSSE3)
+#else // GF256_TARGET_MOBILE
+    if (GF256Dispatch.MulMem)
     {
-        // Partial product tables; see above
-        const GF256_M128 table_lo_y = _mm_loadu_si128(GF256Ctx.MM128.TABLE_LO_Y + y);
-        const GF256_M128 table_hi_y = _mm_loadu_si128(GF256Ctx.MM128.TABLE_HI_Y + y);
-
-        // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
-        const GF256_M128 clr_mask = _mm_set1_epi8(0x0f);
-
-        // Handle multiples of 16 bytes
-        do
-        {
-            // See above comments for details
-            GF256_M128 x0 = _mm_loadu_si128(x16);
-            GF256_M128 l0 = _mm_and_si128(x0, clr_mask);
-            x0 = _mm_srli_epi64(x0, 4);
-            GF256_M128 h0 = _mm_and_si128(x0, clr_mask);
-            l0 = _mm_shuffle_epi8(table_lo_y, l0);
-            h0 = _mm_shuffle_epi8(table_hi_y, h0);
-            _mm_storeu_si128(z16, _mm_xor_si128(l0, h0));
-
-            bytes -= 16, ++x16, ++z16;
-        } while (bytes >= 16);
+        // Handle multiples of 16 bytes with the fastest kernel for this CPU
+        const int bulk = GF256Dispatch.MulMem(z16, x16, y, bytes);
+        z16 = reinterpret_cast<GF256_M128 *>(reinterpret_cast<uint8_t *>(z16) + bulk);
+        x16 = reinterpret_cast<const GF256_M128 *>(reinterpret_cast<const uint8_t *>(x16) + bulk);
+        bytes -= bulk;
     }
-#endif
+#endif // GF256_TARGET_MOBILE
 
-    uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t*>(z16);
-    const uint8_t * GF256_RESTRICT x1 = reinterpret_cast<const uint8_t*>(x16);
-    const uint8_t * GF256_RESTRICT table = GF256Ctx.GF256_MUL_TABLE + ((unsigned)y << 8);
+    uint8_t * z1 = reinterpret_cast<uint8_t*>(z16);
+    const uint8_t * x1 = reinterpret_cast<const uint8_t*>(x16);
+    const uint8_t * table = GF256Ctx.GF256_MUL_TABLE + ((unsigned)y << 8);
 
     // Handle blocks of 8 bytes
     while (bytes >= 8)
     {
-        uint64_t * GF256_RESTRICT z8 = reinterpret_cast<uint64_t *>(z1);
+        uint64_t * z8 = reinterpret_cast<uint64_t *>(z1);
 #ifdef GF256_IS_BIG_ENDIAN
         uint64_t word = (uint64_t)table[x1[0]] << 56;
         word |= (uint64_t)table[x1[1]] << 48;
@@ -1238,7 +2369,7 @@ extern "C" void gf256_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTR
     const int four = bytes & 4;
     if (four)
     {
-        uint32_t * GF256_RESTRICT z4 = reinterpret_cast<uint32_t *>(z1);
+        uint32_t * z4 = reinterpret_cast<uint32_t *>(z1);
 #ifdef GF256_IS_BIG_ENDIAN
         uint32_t word = (uint32_t)table[x1[0]] << 24;
         word |= (uint32_t)table[x1[1]] << 16;
@@ -1265,6 +2396,16 @@ extern "C" void gf256_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTR
     }
 }
 
+extern "C" void gf256_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
+{
+    gf256_mul_mem_shared(vz, vx, y, bytes);
+}
+
+extern "C" void gf256_mul_mem_inplace(void * vz, uint8_t y, int bytes)
+{
+    gf256_mul_mem_shared(vz, vz, y, bytes);
+}
+
 extern "C" void gf256_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
                                  const void * GF256_RESTRICT vx, int bytes)
 {
@@ -1310,124 +2451,13 @@ extern "C" void gf256_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
     }
 #endif
 #else // GF256_TARGET_MOBILE
-# if defined(GF256_TRY_AVX2)
-    if (bytes >= 32 && CpuHasAVX2)
-    {
-        // Partial product tables; see above
-        const GF256_M256 table_lo_y = _mm256_loadu_si256(GF256Ctx.MM256.TABLE_LO_Y + y);
-        const GF256_M256 table_hi_y = _mm256_loadu_si256(GF256Ctx.MM256.TABLE_HI_Y + y);
-
-        // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
-        const GF256_M256 clr_mask = _mm256_set1_epi8(0x0f);
-
-        GF256_M256 * GF256_RESTRICT z32 = reinterpret_cast<GF256_M256 *>(z16);
-        const GF256_M256 * GF256_RESTRICT x32 = reinterpret_cast<const GF256_M256 *>(x16);
-
-        // On my Reed Solomon codec, the encoder unit test runs in 640 usec without and 550 usec with the optimization (86% of the original time)
-        const unsigned count = bytes / 64;
-        for (unsigned i = 0; i < count; ++i)
-        {
-            // See above comments for details
-            GF256_M256 x0 = _mm256_loadu_si256(x32 + i * 2);
-            GF256_M256 l0 = _mm256_and_si256(x0, clr_mask);
-            x0 = _mm256_srli_epi64(x0, 4);
-            const GF256_M256 z0 = _mm256_loadu_si256(z32 + i * 2);
-            GF256_M256 h0 = _mm256_and_si256(x0, clr_mask);
-            l0 = _mm256_shuffle_epi8(table_lo_y, l0);
-            h0 = _mm256_shuffle_epi8(table_hi_y, h0);
-            const GF256_M256 p0 = _mm256_xor_si256(l0, h0);
-            _mm256_storeu_si256(z32 + i * 2, _mm256_xor_si256(p0, z0));
-
-            GF256_M256 x1 = _mm256_loadu_si256(x32 + i * 2 + 1);
-            GF256_M256 l1 = _mm256_and_si256(x1, clr_mask);
-            x1 = _mm256_srli_epi64(x1, 4);
-            const GF256_M256 z1 = _mm256_loadu_si256(z32 + i * 2 + 1);
-            GF256_M256 h1 = _mm256_and_si256(x1, clr_mask);
-            l1 = _mm256_shuffle_epi8(table_lo_y, l1);
-            h1 = _mm256_shuffle_epi8(table_hi_y, h1);
-            const GF256_M256 p1 = _mm256_xor_si256(l1, h1);
-            _mm256_storeu_si256(z32 + i * 2 + 1, _mm256_xor_si256(p1, z1));
-        }
-        bytes -= count * 64;
-        z32 += count * 2;
-        x32 += count * 2;
-
-        if (bytes >= 32)
-        {
-            GF256_M256 x0 = _mm256_loadu_si256(x32);
-            GF256_M256 l0 = _mm256_and_si256(x0, clr_mask);
-            x0 = _mm256_srli_epi64(x0, 4);
-            GF256_M256 h0 = _mm256_and_si256(x0, clr_mask);
-            l0 = _mm256_shuffle_epi8(table_lo_y, l0);
-            h0 = _mm256_shuffle_epi8(table_hi_y, h0);
-            const GF256_M256 p0 = _mm256_xor_si256(l0, h0);
-            const GF256_M256 z0 = _mm256_loadu_si256(z32);
-            _mm256_storeu_si256(z32, _mm256_xor_si256(p0, z0));
-
-            bytes -= 32;
-            z32++;
-            x32++;
-        }
-
-        z16 = reinterpret_cast<GF256_M128 *>(z32);
-        x16 = reinterpret_cast<const GF256_M128 *>(x32);
-    }
-# endif // GF256_TRY_AVX2
-    if (bytes >= 16 && CpuHasSSSE3)
+    if (GF256Dispatch.MulAddMem)
     {
-        // Partial product tables; see above
-        const GF256_M128 table_lo_y = _mm_loadu_si128(GF256Ctx.MM128.TABLE_LO_Y + y);
-        const GF256_M128 table_hi_y = _mm_loadu_si128(GF256Ctx.MM128.TABLE_HI_Y + y);
-
-        // clr_mask = 0x0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f
-        const GF256_M128 clr_mask = _mm_set1_epi8(0x0f);
-
-        // This unroll seems to provide about 7% speed boost when AVX2 is disabled
-        while (bytes >= 32)
-        {
-            bytes -= 32;
-
-            GF256_M128 x1 = _mm_loadu_si128(x16 + 1);
-            GF256_M128 l1 = _mm_and_si128(x1, clr_mask);
-            x1 = _mm_srli_epi64(x1, 4);
-            GF256_M128 h1 = _mm_and_si128(x1, clr_mask);
-            l1 = _mm_shuffle_epi8(table_lo_y, l1);
-            h1 = _mm_shuffle_epi8(table_hi_y, h1);
-            const GF256_M128 z1 = _mm_loadu_si128(z16 + 1);
-
-            GF256_M128 x0 = _mm_loadu_si128(x16);
-            GF256_M128 l0 = _mm_and_si128(x0, clr_mask);
-            x0 = _mm_srli_epi64(x0, 4);
-            GF256_M128 h0 = _mm_and_si128(x0, clr_mask);
-            l0 = _mm_shuffle_epi8(table_lo_y, l0);
-            h0 = _mm_shuffle_epi8(table_hi_y, h0);
-            const GF256_M128 z0 = _mm_loadu_si128(z16);
-
-            const GF256_M128 p1 = _mm_xor_si128(l1, h1);
-            _mm_storeu_si128(z16 + 1, _mm_xor_si128(p1, z1));
-
-            const GF256_M128 p0 = _mm_xor_si128(l0, h0);
-            _mm_storeu_si128(z16, _mm_xor_si128(p0, z0));
-
-            x16 += 2, z16 += 2;
-        }
-
-        // Handle multiples of 16 bytes
-        while (bytes >= 16)
-        {
-            // See above comments for details
-            GF256_M128 x0 = _mm_loadu_si128(x16);
-            GF256_M128 l0 = _mm_and_si128(x0, clr_mask);
-            x0 = _mm_srli_epi64(x0, 4);
-            GF256_M128 h0 = _mm_and_si128(x0, clr_mask);
-            l0 = _mm_shuffle_epi8(table_lo_y, l0);
-            h0 = _mm_shuffle_epi8(table_hi_y, h0);
-            const GF256_M128 p0 = _mm_xor_si128(l0, h0);
-            const GF256_M128 z0 = _mm_loadu_si128(z16);
-            _mm_storeu_si128(z16, _mm_xor_si128(p0, z0));
-
-            bytes -= 16, ++x16, ++z16;
-        }
+        // Handle multiples of 16 bytes with the fastest kernel for this CPU
+        const int bulk = GF256Dispatch.MulAddMem(z16, y, x16, bytes);
+        z16 = reinterpret_cast<GF256_M128 *>(reinterpret_cast<uint8_t *>(z16) + bulk);
+        x16 = reinterpret_cast<const GF256_M128 *>(reinterpret_cast<const uint8_t *>(x16) + bulk);
+        bytes -= bulk;
     }
 #endif // GF256_TARGET_MOBILE
 
@@ -1494,6 +2524,67 @@ extern "C" void gf256_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
     }
 }
 
+/// Sources are multiplied into the destination in groups of this size.
+/// Longer groups run out of registers for the product tables
+static const int kMulAddMultiGroupSize = 8;
+
+extern "C" void gf256_muladd_multi_mem(void * GF256_RESTRICT vz, const uint8_t * ys,
+                                       const void * const * srcs, const int * srcBytes, int count)
+{
+#if !defined(GF256_TARGET_MOBILE)
+    if (GF256Dispatch.MulAddMultiMem)
+    {
+        uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t *>(vz);
+
+        while (count > 0)
+        {
+            // Gather the next group of non-empty sources with non-zero
+            // coefficients, sorted longest first
+            const uint8_t * group[kMulAddMultiGroupSize];
+            uint8_t groupY[kMulAddMultiGroupSize];
+            int groupEnd[kMulAddMultiGroupSize];
+            int n = 0;
+            while (count > 0 && n < kMulAddMultiGroupSize)
+            {
+                const int bytes = *srcBytes;
+                if (bytes > 0 && *ys != 0)
+                {
+                    int i = n++;
+                    for (; i > 0 && groupEnd[i - 1] < bytes; --i)
+                    {
+                        group[i] = group[i - 1];
+                        groupY[i] = groupY[i - 1];
+                        groupEnd[i] = groupEnd[i - 1];
+                    }
+                    group[i] = reinterpret_cast<const uint8_t *>(*srcs);
+                    groupY[i] = *ys;
+                    groupEnd[i] = bytes;
+                }
+                ++ys, ++srcs, ++srcBytes, --count;
+            }
+
+            // Handle multiples of 16 bytes with the fastest kernel for this CPU
+            GF256Dispatch.MulAddMultiMem(z1, groupY, group, groupEnd, n);
+
+            // Handle final bytes of each source
+            for (int i = 0; i < n; ++i)
+            {
+                const uint8_t * GF256_RESTRICT table = GF256Ctx.GF256_MUL_TABLE + ((unsigned)groupY[i] << 8);
+                const uint8_t * x1 = group[i];
+                for (int offset = groupEnd[i] & ~15; offset < groupEnd[i]; ++offset)
+                    z1[offset] ^= table[x1[offset]];
+            }
+        }
+        return;
+    }
+#endif // GF256_TARGET_MOBILE
+
+    // Fall back to one pass per source
+    for (int i = 0; i < count; ++i)
+        if (srcBytes[i] > 0)
+            gf256_muladd_mem(vz, ys[i], srcs[i], srcBytes[i]);
+}
+
 extern "C" void gf256_memswap(void * GF256_RESTRICT vx, void * GF256_RESTRICT vy, int bytes)
 {
 #if defined(GF256_TARGET_MOBILE)
@@ -57,13 +57,43 @@
     #define GF256_TARGET_MOBILE
 #endif // ANDROID
 
-#if defined(__AVX2__) || (defined (_MSC_VER) && _MSC_VER >= 1900)
+/*
+    Kernels for newer instruction sets are compiled with function target
+    attributes and selected at runtime by gf256_init(), so a build for the
+    baseline x86-64 instruction set still runs the fastest code the CPU has.
+*/
+#if !defined(GF256_TARGET_MOBILE)
+# if defined(_MSC_VER)
+    // MSVC accepts intrinsics for any instruction set without compiler flags
+#  if _MSC_VER >= 1900
     #define GF256_TRY_AVX2 /* 256-bit */
+#  endif
+#  if _MSC_VER >= 1920
+    #define GF256_TRY_AVX512 /* 512-bit */
+    #define GF256_TRY_GFNI /* GF2P8AFFINEQB single-instruction multiply */
+#  endif
+# else // GCC/Clang
+    #define GF256_TARGET(isa) __attribute__((target(isa)))
+    #define GF256_TRY_AVX2 /* 256-bit */
+#  if (defined(__clang__) && __clang_major__ >= 7) || (!defined(__clang__) && __GNUC__ >= 8)
+    #define GF256_TRY_AVX512 /* 512-bit */
+    #define GF256_TRY_GFNI /* GF2P8AFFINEQB single-instruction multiply */
+#  endif
+# endif // _MSC_VER
     #include <immintrin.h>
-    #define GF256_ALIGN_BYTES 32
-#else // __AVX2__
+#endif // GF256_TARGET_MOBILE
+
+#ifndef GF256_TARGET
+    #define GF256_TARGET(isa) /* Compile function for the given instruction set */
+#endif
+
+// Align buffers to a cache line, which also covers the widest vector loads.
+// This does not depend on the CPU that the code ends up running on.
+#if defined(GF256_TARGET_MOBILE)
     #define GF256_ALIGN_BYTES 16
-#endif // __AVX2__
+#else // GF256_TARGET_MOBILE
+    #define GF256_ALIGN_BYTES 64
+#endif // GF256_TARGET_MOBILE
 
 #if !defined(GF256_TARGET_MOBILE)
     // Note: MSVC currently only supports SSSE3 but not AVX2
@@ -99,6 +129,11 @@
     #define GF256_M256 __m256i
 #endif
 
+#ifdef GF256_TRY_AVX512
+    // Compiler-specific 512-bit SIMD register keyword
+    #define GF256_M512 __m512i
+#endif
+
 // Compiler-specific C++11 restrict keyword
 #define GF256_RESTRICT __restrict
 
@@ -142,6 +177,7 @@ struct gf256_ctx
 {
     /// We require memory to be aligned since the SIMD instructions benefit from
     /// or require aligned accesses to the table data.
+    /// MM256 is filled in regardless of CPU support; it is selected at runtime.
     struct
     {
         GF256_ALIGNED GF256_M128 TABLE_LO_Y[256];
@@ -154,6 +190,10 @@ struct gf256_ctx
         GF256_ALIGNED GF256_M256 TABLE_HI_Y[256];
     } MM256;
 #endif // GF256_TRY_AVX2
+#ifdef GF256_TRY_GFNI
+    /// GF2P8AFFINEQB bit-matrix that multiplies each byte by y
+    uint64_t GFNI_AFFINE_Y[256];
+#endif // GF256_TRY_GFNI
 
     /// Mul/Div/Inv/Sqr tables
     uint8_t GF256_MUL_TABLE[256 * 256];
@@ -188,7 +228,7 @@ extern gf256_ctx GF256Ctx;
     threads.  The gf256_init() is relatively expensive and should only be done
     once, though it will take less than a millisecond.
     
-    The gf256_ctx object must be aligned to 16 byte boundary.
+    The gf256_ctx object must be aligned to GF256_ALIGN_BYTES boundary.
     Simply tag the object with GF256_ALIGNED to achieve this.
     
     Example:
@@ -256,10 +296,20 @@ extern void gf256_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRI
 extern void gf256_mul_mem(void * GF256_RESTRICT vz,
                           const void * GF256_RESTRICT vx, uint8_t y, int bytes);
 
+/// Performs "z[] *= y" bulk memory operation in place
+extern void gf256_mul_mem_inplace(void * vz, uint8_t y, int bytes);
+
 /// Performs "z[] += x[] * y" bulk memory operation
 extern void gf256_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
                              const void * GF256_RESTRICT vx, int bytes);
 
+/// Performs "z[] += ys[0] * srcs[0][] + ... + ys[count-1] * srcs[count-1][]"
+/// Source i covers the first srcBytes[i] bytes of z[], so lengths may differ.
+/// z[] is only streamed once per group of sources.  Sources of the same length
+/// are fastest: a source that ends early is finished with its own call
+extern void gf256_muladd_multi_mem(void * GF256_RESTRICT vz, const uint8_t * ys,
+                                   const void * const * srcs, const int * srcBytes, int count);
+
 /// Performs "x[] /= y" bulk memory operation
 static GF256_FORCE_INLINE void gf256_div_mem(void * GF256_RESTRICT vz,
                                              const void * GF256_RESTRICT vx, uint8_t y, int bytes)
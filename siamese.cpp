@@ -30,6 +30,7 @@
 #include "siamese.h"
 
 #include "SiameseEncoder.h"
+#include "SiameseEncoderPipeline.h"
 #include "SiameseDecoder.h"
 
 extern "C" {
@@ -53,6 +54,74 @@ SIAMESE_EXPORT int siamese_init_(int version)
 }
 
 
+//------------------------------------------------------------------------------
+// Segment Validation
+
+/// Returns the total number of bytes in the segments, or 0 if they are invalid
+static unsigned GetSegmentsBytes(const SiameseSegment* segments, unsigned segmentCount)
+{
+    if (!segments || segmentCount <= 0) {
+        return 0;
+    }
+
+    unsigned totalBytes = 0;
+    for (unsigned i = 0; i < segmentCount; ++i)
+    {
+        const unsigned segmentBytes = segments[i].DataBytes;
+        if (segmentBytes <= 0) {
+            continue;
+        }
+
+        // Checked one at a time to avoid integer overflows
+        if (!segments[i].Data ||
+            segmentBytes > SIAMESE_MAX_PACKET_BYTES - totalBytes)
+        {
+            return 0;
+        }
+        totalBytes += segmentBytes;
+    }
+
+    return totalBytes;
+}
+
+
+//------------------------------------------------------------------------------
+// Allocator Pool API
+
+SIAMESE_EXPORT SiameseAllocatorPool siamese_allocator_pool_create()
+{
+    SIAMESE_DEBUG_ASSERT(m_Initialized); // Must call siamese_init() first
+    if (!m_Initialized)
+        return nullptr;
+
+    pktalloc::WindowPool* pool = new(std::nothrow) pktalloc::WindowPool;
+
+    return reinterpret_cast<SiameseAllocatorPool>(pool);
+}
+
+SIAMESE_EXPORT void siamese_allocator_pool_free(
+    SiameseAllocatorPool pool_t)
+{
+    pktalloc::WindowPool* pool = reinterpret_cast<pktalloc::WindowPool*>(pool_t);
+    delete pool;
+}
+
+SIAMESE_EXPORT SiameseResult siamese_allocator_pool_trim(
+    SiameseAllocatorPool pool_t,
+    unsigned keepBytes,
+    unsigned* pooledBytesOut)
+{
+    pktalloc::WindowPool* pool = reinterpret_cast<pktalloc::WindowPool*>(pool_t);
+    if (!pool)
+        return Siamese_InvalidInput;
+
+    const unsigned pooledBytes = pool->Trim(keepBytes);
+    if (pooledBytesOut)
+        *pooledBytesOut = pooledBytes;
+    return Siamese_Success;
+}
+
+
 //------------------------------------------------------------------------------
 // Encoder API
 
@@ -67,6 +136,19 @@ SIAMESE_EXPORT SiameseEncoder siamese_encoder_create()
     return reinterpret_cast<SiameseEncoder>(encoder);
 }
 
+SIAMESE_EXPORT SiameseEncoder siamese_encoder_create_pooled(
+    SiameseAllocatorPool pool_t)
+{
+    SIAMESE_DEBUG_ASSERT(m_Initialized); // Must call siamese_init() first
+    if (!m_Initialized || !pool_t)
+        return nullptr;
+
+    pktalloc::WindowPool* pool = reinterpret_cast<pktalloc::WindowPool*>(pool_t);
+    siamese::Encoder* encoder = new(std::nothrow) siamese::Encoder(pool);
+
+    return reinterpret_cast<SiameseEncoder>(encoder);
+}
+
 SIAMESE_EXPORT void siamese_encoder_free(
     SiameseEncoder encoder_t)
 {
@@ -74,6 +156,28 @@ SIAMESE_EXPORT void siamese_encoder_free(
     delete encoder;
 }
 
+SIAMESE_EXPORT SiameseResult siamese_encoder_pipeline_start(
+    SiameseEncoder encoder_t,
+    unsigned readyCount)
+{
+    siamese::Encoder* encoder = reinterpret_cast<siamese::Encoder*>(encoder_t);
+    if (!encoder || readyCount <= 0 || readyCount > SIAMESE_PIPELINE_MAX_READY)
+        return Siamese_InvalidInput;
+
+    return encoder->StartPipeline(readyCount);
+}
+
+SIAMESE_EXPORT SiameseResult siamese_encoder_pipeline_stop(
+    SiameseEncoder encoder_t)
+{
+    siamese::Encoder* encoder = reinterpret_cast<siamese::Encoder*>(encoder_t);
+    if (!encoder)
+        return Siamese_InvalidInput;
+
+    encoder->StopPipeline();
+    return Siamese_Success;
+}
+
 SIAMESE_EXPORT SiameseResult siamese_encoder_is_ready(
     SiameseEncoder encoder_t ///< [in] Encoder to check
 )
@@ -83,10 +187,13 @@ SIAMESE_EXPORT SiameseResult siamese_encoder_is_ready(
         return Siamese_InvalidInput;
     }
 
+    const unsigned remainingSlots = encoder->Pipeline ?
+        encoder->Pipeline->GetRemainingSlots() : encoder->GetRemainingSlots();
+
     // Provide a buffer of some packets, to allow the application some slack
     // to add two packets after checking.  Otherwise it's pretty easy for
     // app developers to write code that accidentally does that in practice.
-    if (encoder->GetRemainingSlots() <= 2) {
+    if (remainingSlots <= 2) {
         return Siamese_MaxPacketsReached;
     }
 
@@ -104,9 +211,54 @@ SIAMESE_EXPORT SiameseResult siamese_encoder_add(
         return Siamese_InvalidInput;
     }
 
+    if (encoder->Pipeline) {
+        return encoder->Pipeline->Add(*packet);
+    }
+
     return encoder->Add(*packet);
 }
 
+SIAMESE_EXPORT SiameseResult siamese_encoder_add_zero_copy(
+    SiameseEncoder encoder_t,
+    SiameseOriginalPacket* packet,
+    SiameseReleaseCallback release,
+    void* context)
+{
+    siamese::Encoder* encoder = reinterpret_cast<siamese::Encoder*>(encoder_t);
+    if (!encoder || !packet || !packet->Data || !release ||
+        packet->DataBytes <= 0 || packet->DataBytes > SIAMESE_MAX_PACKET_BYTES)
+    {
+        return Siamese_InvalidInput;
+    }
+
+    siamese::EncoderPipelineGuard guard(encoder, true);
+    return encoder->AddZeroCopy(*packet, release, context);
+}
+
+SIAMESE_EXPORT SiameseResult siamese_encoder_add_segments(
+    SiameseEncoder encoder_t,
+    const SiameseSegment* segments,
+    unsigned segmentCount,
+    unsigned* packetNumOut)
+{
+    siamese::Encoder* encoder = reinterpret_cast<siamese::Encoder*>(encoder_t);
+    const unsigned dataBytes = GetSegmentsBytes(segments, segmentCount);
+    if (!encoder || !packetNumOut || dataBytes <= 0) {
+        return Siamese_InvalidInput;
+    }
+
+    SiameseOriginalPacket packet;
+    packet.DataBytes = dataBytes;
+    packet.Data      = nullptr;
+
+    siamese::EncoderPipelineGuard guard(encoder, true);
+    const SiameseResult result = encoder->AddSegments(packet, segments, segmentCount);
+    if (result == Siamese_Success) {
+        *packetNumOut = packet.PacketNum;
+    }
+    return result;
+}
+
 SIAMESE_EXPORT SiameseResult siamese_encoder_get(
     SiameseEncoder encoder_t,
     SiameseOriginalPacket* packet)
@@ -117,6 +269,7 @@ SIAMESE_EXPORT SiameseResult siamese_encoder_get(
         return Siamese_InvalidInput;
     }
 
+    siamese::EncoderPipelineGuard guard(encoder);
     return encoder->Get(*packet);
 }
 
@@ -128,6 +281,7 @@ SIAMESE_EXPORT SiameseResult siamese_encoder_remove_before(
     if (!encoder || packetNum > SIAMESE_PACKET_NUM_MAX)
         return Siamese_InvalidInput;
 
+    siamese::EncoderPipelineGuard guard(encoder);
     encoder->RemoveBefore(packetNum);
     return Siamese_Success;
 }
@@ -142,6 +296,7 @@ SIAMESE_EXPORT SiameseResult siamese_encoder_ack(
     if (!encoder || !buffer || bytes < 1 || !nextExpectedPacketNum)
         return Siamese_InvalidInput;
 
+    siamese::EncoderPipelineGuard guard(encoder);
     return encoder->Acknowledge((uint8_t*)buffer, bytes, *nextExpectedPacketNum);
 }
 
@@ -153,6 +308,7 @@ SIAMESE_EXPORT SiameseResult siamese_encoder_retransmit(
     if (!encoder || !original)
         return Siamese_InvalidInput;
 
+    siamese::EncoderPipelineGuard guard(encoder);
     return encoder->Retransmit(*original);
 }
 
@@ -164,9 +320,53 @@ SIAMESE_EXPORT SiameseResult siamese_encode(
     if (!encoder || !recovery)
         return Siamese_InvalidInput;
 
+    if (encoder->Pipeline) {
+        return encoder->Pipeline->Encode(*recovery);
+    }
+
     return encoder->Encode(*recovery);
 }
 
+SIAMESE_EXPORT SiameseResult siamese_encoder_idle_work(
+    SiameseEncoder encoder_t,
+    unsigned budgetUsec)
+{
+    siamese::Encoder* encoder = reinterpret_cast<siamese::Encoder*>(encoder_t);
+    if (!encoder)
+        return Siamese_InvalidInput;
+
+    siamese::EncoderPipelineGuard guard(encoder);
+    return encoder->IdleWork(budgetUsec);
+}
+
+SIAMESE_EXPORT SiameseResult siamese_encode_into(
+    SiameseEncoder encoder_t,
+    unsigned char* buffer,
+    unsigned bufferBytes,
+    unsigned offsetBytes,
+    SiameseRecoveryPacket* recovery)
+{
+    siamese::Encoder* encoder = reinterpret_cast<siamese::Encoder*>(encoder_t);
+    if (!encoder || !buffer || !recovery || offsetBytes >= bufferBytes)
+        return Siamese_InvalidInput;
+
+    siamese::EncoderPipelineGuard guard(encoder);
+    return encoder->EncodeInto(buffer + offsetBytes, bufferBytes - offsetBytes, *recovery);
+}
+
+SIAMESE_EXPORT SiameseResult siamese_encode_batch(
+    SiameseEncoder encoder_t,
+    unsigned count,
+    SiameseRecoveryPacket* recoveryOut)
+{
+    siamese::Encoder* encoder = reinterpret_cast<siamese::Encoder*>(encoder_t);
+    if (!encoder || !recoveryOut || count == 0 || count > SIAMESE_MAX_ENCODE_BATCH)
+        return Siamese_InvalidInput;
+
+    siamese::EncoderPipelineGuard guard(encoder);
+    return encoder->EncodeBatch(recoveryOut, count);
+}
+
 SIAMESE_EXPORT SiameseResult siamese_encoder_stats(
     SiameseEncoder encoder_t,
     uint64_t* statsOut,
@@ -176,6 +376,7 @@ SIAMESE_EXPORT SiameseResult siamese_encoder_stats(
     if (!encoder || !statsOut || statsCount <= 0)
         return Siamese_InvalidInput;
 
+    siamese::EncoderPipelineGuard guard(encoder);
     return encoder->GetStatistics(statsOut, statsCount);
 }
 
@@ -194,6 +395,19 @@ SIAMESE_EXPORT SiameseDecoder siamese_decoder_create()
     return reinterpret_cast<SiameseDecoder>(decoder);
 }
 
+SIAMESE_EXPORT SiameseDecoder siamese_decoder_create_pooled(
+    SiameseAllocatorPool pool_t)
+{
+    SIAMESE_DEBUG_ASSERT(m_Initialized); // Must call siamese_init() first
+    if (!m_Initialized || !pool_t)
+        return nullptr;
+
+    pktalloc::WindowPool* pool = reinterpret_cast<pktalloc::WindowPool*>(pool_t);
+    siamese::Decoder* decoder = new(std::nothrow) siamese::Decoder(pool);
+
+    return reinterpret_cast<SiameseDecoder>(decoder);
+}
+
 SIAMESE_EXPORT void siamese_decoder_free(
     SiameseDecoder decoder_t)
 {
@@ -204,6 +418,28 @@ SIAMESE_EXPORT void siamese_decoder_free(
     delete decoder;
 }
 
+SIAMESE_EXPORT SiameseResult siamese_decoder_threads_start(
+    SiameseDecoder decoder_t,
+    unsigned threadCount)
+{
+    siamese::Decoder* decoder = reinterpret_cast<siamese::Decoder*>(decoder_t);
+    if (!decoder || threadCount <= 0 || threadCount > SIAMESE_DECODER_MAX_THREADS)
+        return Siamese_InvalidInput;
+
+    return decoder->StartThreads(threadCount);
+}
+
+SIAMESE_EXPORT SiameseResult siamese_decoder_threads_stop(
+    SiameseDecoder decoder_t)
+{
+    siamese::Decoder* decoder = reinterpret_cast<siamese::Decoder*>(decoder_t);
+    if (!decoder)
+        return Siamese_InvalidInput;
+
+    decoder->StopThreads();
+    return Siamese_Success;
+}
+
 SIAMESE_EXPORT SiameseResult siamese_decoder_add_original(
     SiameseDecoder decoder_t,
     const SiameseOriginalPacket* packet)
@@ -219,6 +455,28 @@ SIAMESE_EXPORT SiameseResult siamese_decoder_add_original(
     return decoder->AddOriginal(*packet);
 }
 
+SIAMESE_EXPORT SiameseResult siamese_decoder_add_original_segments(
+    SiameseDecoder decoder_t,
+    unsigned packetNum,
+    const SiameseSegment* segments,
+    unsigned segmentCount)
+{
+    siamese::Decoder* decoder = reinterpret_cast<siamese::Decoder*>(decoder_t);
+    const unsigned dataBytes = GetSegmentsBytes(segments, segmentCount);
+    if (!decoder || dataBytes <= 0 ||
+        packetNum > SIAMESE_PACKET_NUM_MAX)
+    {
+        return Siamese_InvalidInput;
+    }
+
+    SiameseOriginalPacket packet;
+    packet.PacketNum = packetNum;
+    packet.DataBytes = dataBytes;
+    packet.Data      = nullptr;
+
+    return decoder->AddOriginalSegments(packet, segments, segmentCount);
+}
+
 SIAMESE_EXPORT SiameseResult siamese_decoder_add_recovery(
     SiameseDecoder decoder_t,
     const SiameseRecoveryPacket* packet)
@@ -268,6 +526,17 @@ SIAMESE_EXPORT SiameseResult siamese_decode(
         countOut);
 }
 
+SIAMESE_EXPORT SiameseResult siamese_decoder_idle_work(
+    SiameseDecoder decoder_t,
+    unsigned budgetUsec)
+{
+    siamese::Decoder* decoder = reinterpret_cast<siamese::Decoder*>(decoder_t);
+    if (!decoder)
+        return Siamese_InvalidInput;
+
+    return decoder->IdleWork(budgetUsec);
+}
+
 SIAMESE_EXPORT SiameseResult siamese_decoder_ack(
     SiameseDecoder decoder_t,
     void* buffer,
@@ -180,6 +180,19 @@ typedef enum SiameseResultT
 /// Note that the actual overhead is closer to 6 bytes.
 #define SIAMESE_MAX_ENCODE_OVERHEAD     8
 
+/// Maximum number of recovery packets generated by one siamese_encode_batch()
+#define SIAMESE_MAX_ENCODE_BATCH        8
+
+/// Number of bytes beyond the largest packet size added so far that must be
+/// available after the offset in a siamese_encode_into() buffer
+#define SIAMESE_ENCODE_INTO_OVERHEAD   12
+
+/// Maximum number of recovery packets kept ready by the encoder pipeline
+#define SIAMESE_PIPELINE_MAX_READY     16
+
+/// Maximum number of worker threads for siamese_decoder_threads_start()
+#define SIAMESE_DECODER_MAX_THREADS    16
+
 /// Minimum number of bytes in an acknowledgement buffer
 #define SIAMESE_ACK_MIN_BYTES          16
 
@@ -191,6 +204,24 @@ struct SiameseOriginalPacket
     const unsigned char* Data; ///< Original packet data
 };
 
+/// Piece of an original data packet that is stored in several buffers
+struct SiameseSegment
+{
+    unsigned DataBytes;        ///< Length of data in bytes
+    const unsigned char* Data; ///< Segment data
+};
+
+/// Number of writable bytes required in front of the packet data passed to
+/// siamese_encoder_add_zero_copy(), where the packet length field is stored
+#define SIAMESE_ZERO_COPY_HEADROOM      4
+
+/**
+    Callback invoked when the encoder no longer references packet data that
+    was added by siamese_encoder_add_zero_copy().  'data' is the Data pointer
+    that was passed in, and 'context' is the context given with it.
+*/
+typedef void (*SiameseReleaseCallback)(void* context, const unsigned char* data);
+
 /// Recovery data packet
 struct SiameseRecoveryPacket
 {
@@ -199,6 +230,52 @@ struct SiameseRecoveryPacket
 };
 
 
+//------------------------------------------------------------------------------
+// Allocator Pool API
+
+/// Allocator pool object type
+typedef struct SiameseAllocatorPoolImpl { int impl; }* SiameseAllocatorPool;
+
+/**
+    Create a memory pool that can be shared by many encoders and decoders.
+
+    By default each codec preallocates its own packet memory and holds on to
+    it for its whole lifetime.  Codecs created with a pool instead take memory
+    from the pool as they need it and give it back when they are done, so
+    idle codecs hold almost no memory.  The MemoryUsed statistic of each
+    codec still reports only the memory that codec is holding.
+
+    The pool keeps the memory it is given back for reuse.  Call
+    siamese_allocator_pool_trim() to release it after a burst of activity.
+
+    The pool is thread-safe, but for best performance use one pool for each
+    thread that drives codecs.  The pool must be freed after all the codecs
+    that use it.
+
+    Returns 0 on failure.
+*/
+SIAMESE_EXPORT SiameseAllocatorPool siamese_allocator_pool_create();
+
+/// Free memory for allocator pool
+SIAMESE_EXPORT void siamese_allocator_pool_free(
+    SiameseAllocatorPool pool ///< [in] Pool to free
+);
+
+/**
+    siamese_allocator_pool_trim()
+
+    Free memory held by the pool that no codec is using, until at most
+    keepBytes remain.  Pass 0 to free all of it.
+
+    If pooledBytesOut is not null, it is set to the bytes still held.
+*/
+SIAMESE_EXPORT SiameseResult siamese_allocator_pool_trim(
+    SiameseAllocatorPool pool,  ///< [in] Pool to trim
+    unsigned keepBytes,         ///< [in] Bytes the pool may keep
+    unsigned* pooledBytesOut    ///< [out] Bytes still held by the pool
+);
+
+
 //------------------------------------------------------------------------------
 // Encoder API
 
@@ -212,11 +289,63 @@ typedef struct SiameseEncoderImpl { int impl; }* SiameseEncoder;
 */
 SIAMESE_EXPORT SiameseEncoder siamese_encoder_create();
 
+/**
+    Create a Siamese encoder that takes its memory from a shared pool.
+
+    See siamese_allocator_pool_create().  Returns 0 on failure.
+*/
+SIAMESE_EXPORT SiameseEncoder siamese_encoder_create_pooled(
+    SiameseAllocatorPool pool ///< [in] Pool to take memory from
+);
+
 /// Free memory for encoder
 SIAMESE_EXPORT void siamese_encoder_free(
     SiameseEncoder encoder ///< [in] Encoder to free
 );
 
+/**
+    Start a background thread that does the encoder work ahead of time.
+
+    After this call, siamese_encoder_add() copies the packet into a lock-free
+    queue and returns.  The worker thread folds queued packets into the
+    running sums and keeps up to readyCount recovery packets ready to send.
+    siamese_encode() hands out the oldest ready packet, and otherwise it
+    encodes on the calling thread as usual.  This moves nearly all of the
+    encoding work off the application thread.
+
+    Ready packets are kept when more packets are added, so a packet that is
+    handed out may not cover the last few packets added.  Those are covered
+    by the packets generated after it, which means recovery for a new packet
+    can lag by up to readyCount recovery packets.  Ready packets are dropped
+    once siamese_encoder_ack() or siamese_encoder_remove_before() moves the
+    window past the data they were generated from.
+
+    The other encoder functions still work, and briefly wait for the worker
+    to finish what it is doing.  The API must still be called from one
+    thread at a time.  Release callbacks from siamese_encoder_add_zero_copy()
+    may be called from the worker thread.
+
+    Returns 0 on success and other codes on error.
+    Returns Siamese_InvalidInput if readyCount is 0 or exceeds
+    SIAMESE_PIPELINE_MAX_READY, or the pipeline is already running.
+*/
+SIAMESE_EXPORT SiameseResult siamese_encoder_pipeline_start(
+    SiameseEncoder encoder, ///< [in] Encoder to use
+    unsigned readyCount     ///< [in] Number of recovery packets to keep ready
+);
+
+/**
+    Stop the background thread started by siamese_encoder_pipeline_start().
+
+    Queued packets are applied to the encoder before this returns.
+    This is also done by siamese_encoder_free().
+
+    Returns 0 on success and other codes on error.
+*/
+SIAMESE_EXPORT SiameseResult siamese_encoder_pipeline_stop(
+    SiameseEncoder encoder ///< [in] Encoder to use
+);
+
 /**
     This function checks if the encoder is ready to accept more data.
 
@@ -250,6 +379,54 @@ SIAMESE_EXPORT SiameseResult siamese_encoder_add(
     SiameseOriginalPacket* packet    ///< [in, out] Packet to add
 );
 
+/**
+    Add a packet of data to the end of the protected set without copying it.
+
+    This works like siamese_encoder_add() except that the encoder references
+    packet->Data in place instead of copying it.  The application must keep
+    the data unmodified until release() is called for it.
+
+    There must be SIAMESE_ZERO_COPY_HEADROOM bytes of writable memory just
+    before packet->Data.  The encoder stores the packet length field there.
+
+    release() is called after the packet is acknowledged (or removed with
+    siamese_encoder_remove_before()) and the encoder has rolled it out of its
+    running sums, which happens lazily during siamese_encode() or
+    siamese_encoder_idle_work().  It is also called for every packet still
+    held when siamese_encoder_free() is called.
+    If this function fails, the encoder does not take the buffer and release()
+    is not called.
+
+    Returns 0 on success and other codes on error.
+    Returns Siamese_MaxPacketsReached if SIAMESE_MAX_PACKETS are added.
+*/
+SIAMESE_EXPORT SiameseResult siamese_encoder_add_zero_copy(
+    SiameseEncoder encoder,          ///< [in] Encoder to add to
+    SiameseOriginalPacket* packet,   ///< [in, out] Packet to add
+    SiameseReleaseCallback release,  ///< [in] Called when the encoder is done with packet->Data
+    void* context                    ///< [in] Passed to release()
+);
+
+/**
+    Add a packet of data made up of several segments to the protected set.
+
+    This works like siamese_encoder_add() except that the packet data is the
+    concatenation of segments[0..segmentCount-1], which avoids flattening the
+    packet into a temporary buffer first.  Segments may be empty, but the
+    total must be between 1 and SIAMESE_MAX_PACKET_BYTES bytes.
+
+    packetNumOut will be set to the next packet number.
+
+    Returns 0 on success and other codes on error.
+    Returns Siamese_MaxPacketsReached if SIAMESE_MAX_PACKETS are added.
+*/
+SIAMESE_EXPORT SiameseResult siamese_encoder_add_segments(
+    SiameseEncoder encoder,          ///< [in] Encoder to add to
+    const SiameseSegment* segments,  ///< [in] Segments to concatenate
+    unsigned segmentCount,           ///< [in] Number of segments
+    unsigned* packetNumOut           ///< [out] Packet number assigned
+);
+
 /**
     Get a packet that was submitted to the codec.
 
@@ -351,6 +528,80 @@ SIAMESE_EXPORT SiameseResult siamese_encode(
     SiameseRecoveryPacket* recovery ///< [out] Recovery Packet generated
 );
 
+/**
+    Do deferred encoder work while the application is idle.
+
+    siamese_encode() folds each new original packet into the running sums
+    lazily, so after many siamese_encoder_add() calls the next encode can
+    take much longer than usual.  Calling this function from an event loop
+    when there is spare time does that work ahead of time and also removes
+    acknowledged data, so that siamese_encode() stays fast.
+
+    The work stops once budgetUsec microseconds have elapsed, checked every
+    few packets.  If budgetUsec is 0 then all of the pending work is done.
+
+    Returns 0 if all of the pending work is done.
+    Returns Siamese_NeedMoreData if the budget ran out and work remains.
+    Returns other codes on error.
+*/
+SIAMESE_EXPORT SiameseResult siamese_encoder_idle_work(
+    SiameseEncoder encoder, ///< [in] Encoder to use
+    unsigned budgetUsec     ///< [in] Time budget in microseconds, or 0
+);
+
+/**
+    Encode a recovery packet directly into an application buffer.
+
+    This works like siamese_encode() except that the recovery packet is
+    written into buffer[offsetBytes..bufferBytes-1] rather than an internal
+    buffer.  The bytes before offsetBytes are left untouched, so space can be
+    reserved for a transport header.  Since the application owns the memory,
+    any number of these packets may be outstanding at once.
+
+    The buffer must have room for at least the largest packet size added so
+    far plus SIAMESE_ENCODE_INTO_OVERHEAD bytes after the offset.
+
+    recovery->Data will point at buffer + offsetBytes.
+
+    Returns 0 on success.
+    Returns Siamese_NeedMoreData if there is no data to encode.
+    Returns Siamese_InvalidInput if the buffer is too small.
+    Returns other codes on error.
+*/
+SIAMESE_EXPORT SiameseResult siamese_encode_into(
+    SiameseEncoder encoder,          ///< [in] Encoder to use
+    unsigned char* buffer,           ///< [in] Application buffer to write into
+    unsigned bufferBytes,            ///< [in] Capacity of buffer in bytes
+    unsigned offsetBytes,            ///< [in] Offset to write the recovery packet at
+    SiameseRecoveryPacket* recovery  ///< [out] Recovery Packet generated
+);
+
+/**
+    Encode several recovery packets at once.
+
+    This produces the same packets as calling siamese_encode() 'count' times,
+    but it visits each original packet and running sum once for the whole
+    batch rather than once per packet.  Use it to send a burst of recovery
+    packets, for example after a loss report.
+
+    Each recovery packet gets its own buffer.  The returned data pointers are
+    valid until the next call to siamese_encode() or siamese_encode_batch().
+
+    If only one packet is unacknowledged, then there is only one distinct
+    recovery packet: The first entry is filled and the others have DataBytes
+    set to 0 and should be skipped.
+
+    Returns 0 on success.
+    Returns Siamese_NeedMoreData if there is no data to encode.
+    Returns Siamese_InvalidInput if count is 0 or exceeds SIAMESE_MAX_ENCODE_BATCH.
+    Returns other codes on error.
+*/
+SIAMESE_EXPORT SiameseResult siamese_encode_batch(
+    SiameseEncoder encoder,            ///< [in] Encoder to use
+    unsigned count,                    ///< [in] Number of packets to generate
+    SiameseRecoveryPacket* recoveryOut ///< [out] Array of 'count' Recovery Packets
+);
+
 
 //------------------------------------------------------------------------------
 // Decoder API
@@ -365,11 +616,52 @@ typedef struct SiameseDecoderImpl { int impl; }* SiameseDecoder;
 */
 SIAMESE_EXPORT SiameseDecoder siamese_decoder_create();
 
+/**
+    Create a Siamese decoder that takes its memory from a shared pool.
+
+    See siamese_allocator_pool_create().  Returns 0 on failure.
+*/
+SIAMESE_EXPORT SiameseDecoder siamese_decoder_create_pooled(
+    SiameseAllocatorPool pool ///< [in] Pool to take memory from
+);
+
 /// Free memory for decoder
 SIAMESE_EXPORT void siamese_decoder_free(
     SiameseDecoder decoder  ///< [in] Decoder to free
 );
 
+/**
+    Start worker threads that speed up large decodes.
+
+    When siamese_decode() solves for many lost packets at once, most of the
+    time is spent removing the received original data from each of the
+    recovery packets.  With worker threads, that work is split up between
+    the workers and the calling thread.  Small decodes still run on the
+    calling thread only, since waking the workers would cost more than it
+    saves.
+
+    The API must still be called from one thread at a time.
+
+    Returns 0 on success and other codes on error.
+    Returns Siamese_InvalidInput if threadCount is 0 or exceeds
+    SIAMESE_DECODER_MAX_THREADS, or the threads are already running.
+*/
+SIAMESE_EXPORT SiameseResult siamese_decoder_threads_start(
+    SiameseDecoder decoder, ///< [in] Decoder to use
+    unsigned threadCount    ///< [in] Number of worker threads to start
+);
+
+/**
+    Stop the worker threads started by siamese_decoder_threads_start().
+
+    This is also done by siamese_decoder_free().
+
+    Returns 0 on success and other codes on error.
+*/
+SIAMESE_EXPORT SiameseResult siamese_decoder_threads_stop(
+    SiameseDecoder decoder ///< [in] Decoder to use
+);
+
 /**
     Pass original data to the decoder.
 
@@ -383,6 +675,21 @@ SIAMESE_EXPORT SiameseResult siamese_decoder_add_original(
     const SiameseOriginalPacket* packet ///< [in] Original Packet to add
 );
 
+/**
+    Pass original data made up of several segments to the decoder.
+
+    This works like siamese_decoder_add_original() except that the packet data
+    is the concatenation of segments[0..segmentCount-1].
+
+    Returns 0 on success and other codes on error.
+*/
+SIAMESE_EXPORT SiameseResult siamese_decoder_add_original_segments(
+    SiameseDecoder decoder,          ///< [in] Decoder to use
+    unsigned packetNum,              ///< [in] Packet number of the data
+    const SiameseSegment* segments,  ///< [in] Segments to concatenate
+    unsigned segmentCount            ///< [in] Number of segments
+);
+
 /**
     Pass recovery data to the decoder from the encoder.
 
@@ -460,6 +767,30 @@ SIAMESE_EXPORT SiameseResult siamese_decode(
     unsigned* countOut                      ///< [out] Number of packets recovered
 );
 
+/**
+    Do deferred decoder work while the application is idle.
+
+    Most of the time in siamese_decode() is spent removing the received
+    original data from each of the recovery packets, and that cost is paid
+    all at once when the last recovery packet needed arrives.  Calling this
+    function from an event loop when there is spare time does that work for
+    the recovery packets received so far, so that siamese_decode() mostly
+    has to solve for the lost packets.  Original data that arrives late is
+    removed from those recovery packets when it is added.
+
+    The work stops once budgetUsec microseconds have elapsed, checked after
+    each recovery packet.  If budgetUsec is 0 then all of the pending work is
+    done.
+
+    Returns 0 if all of the pending work is done.
+    Returns Siamese_NeedMoreData if the budget ran out and work remains.
+    Returns other codes on error.
+*/
+SIAMESE_EXPORT SiameseResult siamese_decoder_idle_work(
+    SiameseDecoder decoder, ///< [in] Decoder to use
+    unsigned budgetUsec     ///< [in] Time budget in microseconds, or 0 for no limit
+);
+
 /**
     This writes an acknowledgement message to the provided buffer, which
     includes the next expected packet number and a list of negative
@@ -516,6 +847,20 @@ typedef enum SiameseEncoderStatsT
     // Return number of bytes of memory used by the codec
     SiameseEncoderStats_MemoryUsed,
 
+    // Number of recovery packets the pipeline had ready ahead of time
+    SiameseEncoderStats_PipelineReadyCount,
+
+    // Number of recovery packets the pipeline had to encode on demand
+    SiameseEncoderStats_PipelineFallbackCount,
+
+    // Number of running sums that resumed from a checkpoint after the sums
+    // were reset, instead of being accumulated again from the new start
+    SiameseEncoderStats_SumCheckpointCount,
+
+    // Number of large buffers that the codec allocated with calloc() because
+    // no freed buffer of a similar size was available for reuse
+    SiameseEncoderStats_FallbackAllocateCount,
+
     SiameseEncoderStats_Count
 } SiameseEncoderStats;
 
@@ -568,6 +913,28 @@ typedef enum SiameseDecoderStatsT
     // Return number of bytes of memory used by the codec
     SiameseDecoderStats_MemoryUsed,
 
+    // Number of running sums that resumed from a checkpoint instead of being
+    // accumulated again from the start of the sum
+    SiameseDecoderStats_SumCheckpointCount,
+
+    // Number of recovery packets that siamese_decoder_idle_work() removed the
+    // received original data from ahead of siamese_decode()
+    SiameseDecoderStats_IdleEliminationCount,
+
+    // Number of solutions for a single lost packet, which are solved directly
+    // from one recovery packet without a recovery matrix.  These are also
+    // counted in SolveSuccessCount
+    SiameseDecoderStats_SingleLossSolveCount,
+
+    // Number of solutions for losses covered only by Cauchy and parity rows,
+    // which are solved with a closed-form inverse instead of Gaussian
+    // elimination.  These are also counted in SolveSuccessCount
+    SiameseDecoderStats_CauchySolveCount,
+
+    // Number of large buffers that the codec allocated with calloc() because
+    // no freed buffer of a similar size was available for reuse
+    SiameseDecoderStats_FallbackAllocateCount,
+
     SiameseDecoderStats_Count
 } SiameseDecoderStats;
 
@@ -72,6 +72,7 @@ static void TestRecoverySort()
         4, 9
     };
     siamese::RecoveryPacket* recoveries[kRecoveryCount];
+    unsigned emptyUsedBytes = 0;
 
     // Check all possible inputs
     unsigned order[kRecoveryCount];
@@ -113,29 +114,29 @@ static void TestRecoverySort()
 
                             unsigned x = order[y];
                             recoveries[x] = recovery;
-                            lister.Insert(recovery);
+                            lister.Insert(recovery, false);
                         }
 
                         SIAMESE_DEBUG_ASSERT(lister.RecoveryPacketCount == kRecoveryCount);
-                        SIAMESE_DEBUG_ASSERT(lister.Head);
-                        SIAMESE_DEBUG_ASSERT(lister.Tail);
+                        SIAMESE_DEBUG_ASSERT(lister.Head());
+                        SIAMESE_DEBUG_ASSERT(lister.Tail());
 
-                        siamese::RecoveryPacket* recovery = lister.Head;
-                        siamese::RecoveryPacket* prev = nullptr;
                         for (unsigned y = 0; y < kRecoveryCount; ++y)
                         {
+                            siamese::RecoveryPacket* recovery = lister.Head();
                             SIAMESE_DEBUG_ASSERT(recovery != nullptr);
                             // Verify it was sorted in the correct order
                             SIAMESE_DEBUG_ASSERT(recovery->Metadata.Row == y);
-                            prev = recovery;
-                            recovery = recovery->Next;
-                            SIAMESE_DEBUG_ASSERT(!recovery || recovery->Prev == prev);
-                            lister.Delete(prev);
+                            SIAMESE_DEBUG_ASSERT(lister.GetPacket(lister.HeadIndex) == recovery);
+                            lister.DeleteHead();
                         }
-                        SIAMESE_DEBUG_ASSERT(recovery == nullptr);
+                        SIAMESE_DEBUG_ASSERT(lister.Head() == nullptr);
 
+                        // Only the ring of packet pointers remains allocated
                         const unsigned usedBytes = allocator.GetMemoryUsedBytes();
-                        SIAMESE_DEBUG_ASSERT(usedBytes == 0);
+                        if (emptyUsedBytes == 0)
+                            emptyUsedBytes = usedBytes;
+                        SIAMESE_DEBUG_ASSERT(usedBytes == emptyUsedBytes);
                         SIAMESE_DEBUG_ASSERT(lister.RecoveryPacketCount == 0);
                     }
                 }
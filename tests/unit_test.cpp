@@ -29,6 +29,9 @@
 #include <vector>
 #include <string>
 #include <queue>
+#include <thread>
+#include <chrono>
+#include <memory>
 using namespace std;
 
 #include "../Logger.h"
@@ -47,10 +50,61 @@ using namespace std;
 // Test: Encoding data with packetloss
 #define TEST_STREAMING
 
+// Benchmark: Running sums over the whole window in the encoder and decoder
+//#define TEST_SUM_BENCHMARK
+
 // Test: Using Siamese as a block code
 #define TEST_BLOCK
 #define TEST_ENABLE_DECODER
 
+// Test: Recovering losses with bursts of packets from siamese_encode_batch()
+#define TEST_ENCODE_BATCH
+
+// Test: Adding packets with siamese_encoder_add_zero_copy() and releasing them
+#define TEST_ZERO_COPY
+
+// Test: Adding packets split into several segments
+#define TEST_SEGMENTS
+
+// Test: Writing recovery packets into application buffers with siamese_encode_into()
+#define TEST_ENCODE_INTO
+
+// Test: siamese_encoder_idle_work() does not change the recovery packets
+#define TEST_IDLE_WORK
+
+// Test: Recovering losses with the encoder pipeline thread running
+#define TEST_PIPELINE
+
+// Test: Encoder and decoder resume running sums from checkpoints after the sums restart
+#define TEST_SUM_CHECKPOINTS
+
+// Test: Recovering large bursts of losses with decoder worker threads
+#define TEST_DECODER_THREADS
+
+// Test: siamese_decoder_idle_work() with original data arriving late
+#define TEST_DECODER_IDLE_WORK
+
+// Test: Recovering a single lost packet without a recovery matrix
+#define TEST_SINGLE_LOSS
+
+// Test: Recovering losses in short windows with the closed-form Cauchy inverse
+#define TEST_CAUCHY_SOLVE
+
+// Test: Recovering losses from hundreds of recovery packets received out of order
+#define TEST_RECOVERY_REORDER
+
+// Test: siamese_decoder_ack() NACK lists match the packets that are still missing
+#define TEST_DECODER_ACK
+
+// Test: A packet far ahead of the window does not allocate the span in between
+#define TEST_DECODER_JUMP_AHEAD
+
+// Test: Codecs sharing an allocator pool hold no memory while idle
+#define TEST_ALLOCATOR_POOL
+
+// Test: Jumbo packets reuse freed large buffers instead of calling calloc()
+#define TEST_LARGE_PACKETS
+
 // This experiment uses FEC instead of retransmission to see how it performs
 //#define HARQ_RETRANSMIT_WITH_FEC
 
@@ -170,6 +224,206 @@ public:
 };
 
 
+//------------------------------------------------------------------------------
+// TestCodecs
+
+/// Encoder and decoder pair shared by the send/recover loops in the tests.
+/// Both codecs are freed when this goes out of scope, so a test can return
+/// false from anywhere without leaking them.  Errors are logged here
+struct TestCodecs
+{
+    SiameseEncoder Encoder = nullptr;
+    SiameseDecoder Decoder = nullptr;
+
+    /// Number of original packets the decoder received or recovered
+    unsigned ReceivedCount = 0;
+
+    /// Packets recovered by the last Decode(), already checked
+    SiameseOriginalPacket* Recovered = nullptr;
+    unsigned RecoveredCount = 0;
+
+    /// Optional timers for siamese_encode() and siamese_decode()
+    FunctionTimer* EncodeTimer = nullptr;
+    FunctionTimer* DecodeTimer = nullptr;
+
+    ~TestCodecs()
+    {
+        Free();
+    }
+
+    /// Create the codecs, taking memory from the pool if one is given
+    bool Create(SiameseAllocatorPool pool = nullptr)
+    {
+        Encoder = pool ? siamese_encoder_create_pooled(pool) : siamese_encoder_create();
+        Decoder = pool ? siamese_decoder_create_pooled(pool) : siamese_decoder_create();
+        if (!Encoder || !Decoder)
+        {
+            Logger.Error("Unable to create codec");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+        return true;
+    }
+
+    /// Free the codecs before going out of scope
+    void Free()
+    {
+        siamese_encoder_free(Encoder);
+        siamese_decoder_free(Decoder);
+        Encoder = nullptr;
+        Decoder = nullptr;
+    }
+
+    /// Add the next original packet to the encoder, and pass it to the
+    /// decoder unless it is lost
+    bool Send(unsigned packetNum, bool lost)
+    {
+        uint8_t buffer[2000];
+        const unsigned bytes = GetPacketBytes(packetNum);
+        SetPacket(packetNum, buffer, bytes);
+
+        SiameseOriginalPacket original;
+        original.Data = buffer;
+        original.DataBytes = bytes;
+        if (0 != siamese_encoder_add(Encoder, &original) || original.PacketNum != packetNum)
+        {
+            Logger.Error("Unable to add original data to encoder");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        return lost || Receive(packetNum);
+    }
+
+    /// Send packets [0, count), losing about 10% including the first one
+    bool SendWithLosses(unsigned count, siamese::PCGRandom& prng)
+    {
+        for (unsigned i = 0; i < count; ++i)
+        {
+            if (!Send(i, i == 0 || prng.Next() % 10 == 0)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Pass original data to the decoder, which may have been lost before
+    bool Receive(unsigned packetNum)
+    {
+        uint8_t buffer[2000];
+        SiameseOriginalPacket original;
+        original.PacketNum = packetNum;
+        original.Data = buffer;
+        original.DataBytes = GetPacketBytes(packetNum);
+        SetPacket(packetNum, buffer, original.DataBytes);
+
+        if (0 != siamese_decoder_add_original(Decoder, &original))
+        {
+            Logger.Error("Unable to add original data to decoder");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+        ++ReceivedCount;
+        return true;
+    }
+
+    /// Pass a recovery packet to the decoder
+    bool AddRecovery(const SiameseRecoveryPacket& recovery)
+    {
+        if (0 != siamese_decoder_add_recovery(Decoder, &recovery))
+        {
+            Logger.Error("Unable to add recovery data to decoder");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+        return true;
+    }
+
+    /// Decode if the decoder is ready, and check the recovered packets.
+    /// RecoveredCount is 0 if nothing was recovered
+    bool Decode()
+    {
+        Recovered = nullptr;
+        RecoveredCount = 0;
+
+        if (siamese_decoder_is_ready(Decoder) != Siamese_Success) {
+            return true;
+        }
+
+        if (DecodeTimer) {
+            DecodeTimer->BeginCall();
+        }
+        const int result = siamese_decode(Decoder, &Recovered, &RecoveredCount);
+        if (DecodeTimer) {
+            DecodeTimer->EndCall();
+        }
+        if (result == Siamese_NeedMoreData)
+        {
+            RecoveredCount = 0;
+            return true;
+        }
+        if (result)
+        {
+            Logger.Error("Decode returned ", result);
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        for (unsigned j = 0; j < RecoveredCount; ++j)
+        {
+            if (!CheckPacket(Recovered[j].PacketNum, Recovered[j].Data, Recovered[j].DataBytes))
+            {
+                Logger.Error("Packet check failed for ", Recovered[j].PacketNum);
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+        }
+        ReceivedCount += RecoveredCount;
+        return true;
+    }
+
+    /// Send one recovery packet from siamese_encode() and decode if possible
+    bool Recover()
+    {
+        SiameseRecoveryPacket recovery;
+        if (EncodeTimer) {
+            EncodeTimer->BeginCall();
+        }
+        const int result = siamese_encode(Encoder, &recovery);
+        if (EncodeTimer) {
+            EncodeTimer->EndCall();
+        }
+        if (result != 0)
+        {
+            Logger.Error("Unable to generate encoded data");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        return AddRecovery(recovery) && Decode();
+    }
+
+    /// Send recovery packets until the decoder has packets [0, count)
+    bool RecoverAll(unsigned count, unsigned maxAttempts)
+    {
+        for (unsigned attempt = 0; ReceivedCount < count; ++attempt)
+        {
+            if (attempt >= maxAttempts)
+            {
+                Logger.Error("Failed to recover ", count - ReceivedCount, " of ", count,
+                    " packets with ", maxAttempts, " recovery packets");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+            if (!Recover()) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+
 static void BlockRecoveryTest()
 {
     Logger.Info("Recover one large block up to 255...");
@@ -377,6 +631,95 @@ DoneDecoding:
 }
 
 
+#ifdef TEST_SUM_BENCHMARK
+
+static void SumBenchmark()
+{
+    Logger.Info("Running sums over the whole window...");
+
+    static const unsigned kWindowSizes[] = { 1000, 4000, 16000 };
+    static const unsigned kPacketSizes[] = { 16, 1000 };
+    static const unsigned kTrials = 20;
+
+    for (unsigned packetBytes : kPacketSizes)
+    for (unsigned N : kWindowSizes)
+    {
+        FunctionTimer t_siamese_encode("siamese_encode (all sums)");
+        FunctionTimer t_siamese_decode("siamese_decode (all sums)");
+
+        std::vector<uint8_t> buffer(packetBytes);
+
+        for (unsigned trial = 0; trial < kTrials; ++trial)
+        {
+            SiameseEncoder encoder = siamese_encoder_create();
+            SiameseDecoder decoder = siamese_decoder_create();
+            if (!encoder || !decoder)
+            {
+                Logger.Error("Unable to create codec");
+                SIAMESE_DEBUG_BREAK();
+                return;
+            }
+
+            for (unsigned i = 0; i < N; ++i)
+            {
+                SetPacket(i, &buffer[0], packetBytes);
+
+                SiameseOriginalPacket original;
+                original.Data = &buffer[0];
+                original.DataBytes = packetBytes;
+                if (0 != siamese_encoder_add(encoder, &original))
+                {
+                    Logger.Error("Unable to add original data to encoder");
+                    SIAMESE_DEBUG_BREAK();
+                    return;
+                }
+
+                // Lose the first packet so decoding needs the sums
+                if (i > 0 && 0 != siamese_decoder_add_original(decoder, &original))
+                {
+                    Logger.Error("Unable to add original data to decoder");
+                    SIAMESE_DEBUG_BREAK();
+                    return;
+                }
+            }
+
+            // The first recovery packet sums every lane across the window
+            SiameseRecoveryPacket recovery;
+            t_siamese_encode.BeginCall();
+            int result = siamese_encode(encoder, &recovery);
+            t_siamese_encode.EndCall();
+            if (result != 0 || 0 != siamese_decoder_add_recovery(decoder, &recovery))
+            {
+                Logger.Error("Unable to pass recovery data to decoder");
+                SIAMESE_DEBUG_BREAK();
+                return;
+            }
+
+            SiameseOriginalPacket* packets = nullptr;
+            unsigned packetCount = 0;
+            t_siamese_decode.BeginCall();
+            result = siamese_decode(decoder, &packets, &packetCount);
+            t_siamese_decode.EndCall();
+            if (result != 0 || packetCount != 1)
+            {
+                Logger.Error("Decode failed: ", result);
+                SIAMESE_DEBUG_BREAK();
+                return;
+            }
+
+            siamese_encoder_free(encoder);
+            siamese_decoder_free(decoder);
+        }
+
+        Logger.Info("Window of ", N, " packets of ", packetBytes, " bytes:");
+        t_siamese_encode.Print(kTrials);
+        t_siamese_decode.Print(kTrials);
+    }
+}
+
+#endif // TEST_SUM_BENCHMARK
+
+
 static void StreamingTest()
 {
     siamese::PCGRandom prngLoss;
@@ -1268,7 +1611,7 @@ void HARQSimulation::Run(unsigned seed)
             break;
         }
 
-        ::Sleep(kPacketIntervalMsec); // ms between rounds
+        std::this_thread::sleep_for(std::chrono::milliseconds(kPacketIntervalMsec)); // ms between rounds
 
         // TODO: Reordering
 
@@ -1772,38 +2115,1893 @@ DoneDecoding:
 }
 
 
-int main()
+// Sends recovery data in bursts from siamese_encode_batch() for window sizes
+// that use the single packet, Cauchy and Siamese sum code paths.
+bool TestEncodeBatch()
 {
-    FunctionTimer t_siamese_init("siamese_init");
+    Logger.Info("Test: TestEncodeBatch");
 
-    t_siamese_init.BeginCall();
-    if (0 != siamese_init())
+    FunctionTimer t_siamese_encode_batch("siamese_encode_batch");
+
+    static const unsigned kWindowSizes[] = { 1, 10, 100, 1000 };
+    static const unsigned kBatchSize = 4;
+    static const unsigned kMaxBatches = 64;
+
+    for (unsigned N : kWindowSizes)
     {
-        Logger.Error("Failed to initialize");
-        return -1;
+        siamese::PCGRandom prng;
+        prng.Seed(kSeed, N);
+
+        TestCodecs codecs;
+        if (!codecs.Create() || !codecs.SendWithLosses(N, prng)) {
+            return false;
+        }
+
+        for (unsigned batch = 0; codecs.ReceivedCount < N; ++batch)
+        {
+            if (batch >= kMaxBatches)
+            {
+                Logger.Error("Batch encoding failed to recover N = ", N);
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+
+            SiameseRecoveryPacket recovery[kBatchSize];
+            t_siamese_encode_batch.BeginCall();
+            int result = siamese_encode_batch(codecs.Encoder, kBatchSize, recovery);
+            t_siamese_encode_batch.EndCall();
+            if (result)
+            {
+                Logger.Error("Unable to generate batch encoded data");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+
+            for (unsigned j = 0; j < kBatchSize; ++j)
+            {
+                if (recovery[j].DataBytes != 0 && !codecs.AddRecovery(recovery[j])) {
+                    return false;
+                }
+            }
+
+            if (!codecs.Decode()) {
+                return false;
+            }
+        }
     }
-    t_siamese_init.EndCall();
 
-    t_siamese_init.Print(1);
+    Logger.Info("Test successful. Timing summary:");
+    t_siamese_encode_batch.Print(1);
 
-#ifdef TEST_LARGE_BURST_LOSS
-    if (!TestLargeBurstLoss())
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// TestZeroCopy
+
+static const unsigned kZeroCopyPackets = 200;
+
+struct ZeroCopyBuffers
+{
+    uint8_t Storage[kZeroCopyPackets][SIAMESE_ZERO_COPY_HEADROOM + 2000];
+    bool Released[kZeroCopyPackets];
+    unsigned ReleaseCount = 0;
+    bool Invalid = false;
+};
+
+static void OnZeroCopyRelease(void* context, const unsigned char* data)
+{
+    ZeroCopyBuffers* buffers = (ZeroCopyBuffers*)context;
+    const unsigned i = (unsigned)((data - SIAMESE_ZERO_COPY_HEADROOM - &buffers->Storage[0][0]) / sizeof(buffers->Storage[0]));
+    if (i >= kZeroCopyPackets ||
+        data != buffers->Storage[i] + SIAMESE_ZERO_COPY_HEADROOM ||
+        buffers->Released[i])
     {
-        Logger.Error("Test failed: TestLargeBurstLoss");
-        SIAMESE_DEBUG_BREAK();
-        return -1;
+        buffers->Invalid = true;
+        return;
     }
-#endif
-#ifdef TEST_HARQ_STREAM
-    for (unsigned seed = 0;; ++seed)
+    buffers->Released[i] = true;
+    ++buffers->ReleaseCount;
+}
+
+bool TestZeroCopy()
+{
+    Logger.Info("Test: TestZeroCopy");
+
+    static const unsigned kFirstKept = 100;
+
+    // Declared before the codecs so it outlives them on error paths
+    std::unique_ptr<ZeroCopyBuffers> buffers(new ZeroCopyBuffers);
+    memset(buffers->Released, 0, sizeof(buffers->Released));
+
+    TestCodecs codecs;
+    if (!codecs.Create()) {
+        return false;
+    }
+
+    for (unsigned i = 0; i < kZeroCopyPackets; ++i)
     {
-        HARQSimulation simulation;
-        simulation.Run(seed);
+        uint8_t* data = buffers->Storage[i] + SIAMESE_ZERO_COPY_HEADROOM;
+        const unsigned bytes = GetPacketBytes(i);
+        SetPacket(i, data, bytes);
+
+        SiameseOriginalPacket original;
+        original.Data = data;
+        original.DataBytes = bytes;
+        if (0 != siamese_encoder_add_zero_copy(codecs.Encoder, &original, OnZeroCopyRelease, buffers.get()))
+        {
+            Logger.Error("Unable to add zero-copy data to encoder");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        // The decoder receives the first half, and loses every 7th packet after that
+        if ((i < kFirstKept || i % 7 != 0) && !codecs.Receive(i)) {
+            return false;
+        }
     }
-#endif
+
+    if (buffers->ReleaseCount != 0)
+    {
+        Logger.Error("Released zero-copy data too early");
+        SIAMESE_DEBUG_BREAK();
+        return false;
+    }
+
+    if (0 != siamese_encoder_remove_before(codecs.Encoder, kFirstKept))
+    {
+        Logger.Error("Unable to remove data from encoder");
+        SIAMESE_DEBUG_BREAK();
+        return false;
+    }
+
+    for (unsigned attempt = 0; codecs.ReceivedCount < kZeroCopyPackets; ++attempt)
+    {
+        if (attempt >= 100)
+        {
+            Logger.Error("Zero-copy encoding failed to recover");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        SiameseRecoveryPacket recovery;
+        if (0 != siamese_encode(codecs.Encoder, &recovery))
+        {
+            Logger.Error("Unable to generate encoded data");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        // Rolling removed packets out of the sums hands them back
+        for (unsigned i = kFirstKept; i < kZeroCopyPackets; ++i)
+        {
+            if (buffers->Released[i])
+            {
+                Logger.Error("Released zero-copy data that is still in use");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+        }
+
+        if (!codecs.AddRecovery(recovery) || !codecs.Decode()) {
+            return false;
+        }
+    }
+
+    codecs.Free();
+
+    if (buffers->Invalid || buffers->ReleaseCount != kZeroCopyPackets)
+    {
+        Logger.Error("Zero-copy data was not released exactly once");
+        SIAMESE_DEBUG_BREAK();
+        return false;
+    }
+
+    Logger.Info("Test successful.");
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// TestSegments
+
+bool TestSegments()
+{
+    Logger.Info("Test: TestSegments");
+
+    static const unsigned N = 100;
+
+    siamese::PCGRandom prng;
+    prng.Seed(kSeed, N);
+
+    TestCodecs codecs;
+    if (!codecs.Create()) {
+        return false;
+    }
+
+    for (unsigned i = 0; i < N; ++i)
+    {
+        uint8_t buffer[2000];
+        const unsigned bytes = GetPacketBytes(i);
+        SetPacket(i, buffer, bytes);
+
+        // Split into a short header, an empty segment, and the remainder
+        const unsigned headerBytes = prng.Next() % (bytes + 1);
+        SiameseSegment segments[3];
+        segments[0].Data = buffer;
+        segments[0].DataBytes = headerBytes;
+        segments[1].Data = nullptr;
+        segments[1].DataBytes = 0;
+        segments[2].Data = buffer + headerBytes;
+        segments[2].DataBytes = bytes - headerBytes;
+
+        unsigned packetNum = 0;
+        if (0 != siamese_encoder_add_segments(codecs.Encoder, segments, 3, &packetNum) || packetNum != i)
+        {
+            Logger.Error("Unable to add segments to encoder");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        if (i == 0 || prng.Next() % 10 == 0) {
+            continue;
+        }
+
+        if (0 != siamese_decoder_add_original_segments(codecs.Decoder, i, segments, 3))
+        {
+            Logger.Error("Unable to add segments to decoder");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+        ++codecs.ReceivedCount;
+
+        SiameseOriginalPacket original;
+        original.PacketNum = i;
+        if (0 != siamese_decoder_get(codecs.Decoder, &original) ||
+            !CheckPacket(i, original.Data, original.DataBytes))
+        {
+            Logger.Error("Decoder packet check failed for ", i);
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+    }
+
+    if (!codecs.RecoverAll(N, 100)) {
+        return false;
+    }
+
+    Logger.Info("Test successful.");
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// TestEncodeInto
+
+bool TestEncodeInto()
+{
+    Logger.Info("Test: TestEncodeInto");
+
+    static const unsigned kWindowSizes[] = { 1, 10, 100 };
+    static const unsigned kOutstanding = 4;
+    static const unsigned kOffset = 16;
+    static const unsigned kBufferBytes = kOffset + 2000 + SIAMESE_ENCODE_INTO_OVERHEAD;
+    static const uint8_t kHeaderFill = 0xfe;
+
+    for (unsigned N : kWindowSizes)
+    {
+        siamese::PCGRandom prng;
+        prng.Seed(kSeed, N);
+
+        TestCodecs codecs;
+        if (!codecs.Create() || !codecs.SendWithLosses(N, prng)) {
+            return false;
+        }
+
+        // A buffer that is too small must be rejected
+        uint8_t small[kOffset + 8];
+        SiameseRecoveryPacket recovery;
+        if (N > 1 && 0 == siamese_encode_into(codecs.Encoder, small, sizeof(small), kOffset, &recovery))
+        {
+            Logger.Error("Accepted a buffer that is too small");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        for (unsigned round = 0; codecs.ReceivedCount < N; ++round)
+        {
+            if (round >= 32)
+            {
+                Logger.Error("Encoding into buffers failed to recover N = ", N);
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+
+            // Keep several packets outstanding before handing them to the decoder
+            static uint8_t buffers[kOutstanding][kBufferBytes];
+            SiameseRecoveryPacket packets[kOutstanding];
+            for (unsigned j = 0; j < kOutstanding; ++j)
+            {
+                memset(buffers[j], kHeaderFill, kOffset);
+                if (0 != siamese_encode_into(codecs.Encoder, buffers[j], kBufferBytes, kOffset, &packets[j]) ||
+                    packets[j].Data != buffers[j] + kOffset ||
+                    packets[j].DataBytes > kBufferBytes - kOffset)
+                {
+                    Logger.Error("Unable to encode into buffer");
+                    SIAMESE_DEBUG_BREAK();
+                    return false;
+                }
+            }
+
+            for (unsigned j = 0; j < kOutstanding; ++j)
+            {
+                for (unsigned k = 0; k < kOffset; ++k)
+                {
+                    if (buffers[j][k] != kHeaderFill)
+                    {
+                        Logger.Error("Header space was overwritten");
+                        SIAMESE_DEBUG_BREAK();
+                        return false;
+                    }
+                }
+
+                if (!codecs.AddRecovery(packets[j])) {
+                    return false;
+                }
+            }
+
+            if (!codecs.Decode()) {
+                return false;
+            }
+        }
+    }
+
+    Logger.Info("Test successful.");
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// TestIdleWork
+
+/// Feed the same packets to both encoders, running idle work on the eager
+/// one, and check that they produce the same recovery packets
+static bool CompareIdleWork(SiameseEncoder lazy, SiameseEncoder eager, FunctionTimer& t_siamese_encoder_idle_work)
+{
+    static const unsigned kRounds = 40;
+    static const unsigned kAddsPerRound = 50;
+
+    unsigned packetNum = 0;
+
+    for (unsigned round = 0; round < kRounds; ++round)
+    {
+        for (unsigned i = 0; i < kAddsPerRound; ++i, ++packetNum)
+        {
+            uint8_t buffer[2000];
+            const unsigned bytes = GetPacketBytes(packetNum);
+            SetPacket(packetNum, buffer, bytes);
+
+            SiameseOriginalPacket original;
+            original.Data = buffer;
+            original.DataBytes = bytes;
+            if (0 != siamese_encoder_add(lazy, &original) ||
+                0 != siamese_encoder_add(eager, &original))
+            {
+                Logger.Error("Unable to add original data to encoder");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+        }
+
+        // Acknowledge older data now and then so removal happens during idle work
+        if (round % 8 == 7)
+        {
+            const unsigned firstKept = packetNum - kAddsPerRound;
+            if (0 != siamese_encoder_remove_before(lazy, firstKept) ||
+                0 != siamese_encoder_remove_before(eager, firstKept))
+            {
+                Logger.Error("Unable to remove data from encoder");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+        }
+
+        // Alternate between a tiny budget and finishing everything
+        const unsigned budgetUsec = (round % 2 == 0) ? 1 : 0;
+        t_siamese_encoder_idle_work.BeginCall();
+        const int result = siamese_encoder_idle_work(eager, budgetUsec);
+        t_siamese_encoder_idle_work.EndCall();
+        if (result != Siamese_Success && result != Siamese_NeedMoreData)
+        {
+            Logger.Error("Idle work returned ", result);
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+        if (budgetUsec == 0 && result != Siamese_Success)
+        {
+            Logger.Error("Idle work did not finish with an unlimited budget");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        SiameseRecoveryPacket lazyRecovery, eagerRecovery;
+        if (0 != siamese_encode(lazy, &lazyRecovery) ||
+            0 != siamese_encode(eager, &eagerRecovery))
+        {
+            Logger.Error("Unable to generate encoded data");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        if (lazyRecovery.DataBytes != eagerRecovery.DataBytes ||
+            0 != memcmp(lazyRecovery.Data, eagerRecovery.Data, lazyRecovery.DataBytes))
+        {
+            Logger.Error("Idle work changed the recovery data in round ", round);
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool TestIdleWork()
+{
+    Logger.Info("Test: TestIdleWork");
+
+    FunctionTimer t_siamese_encoder_idle_work("siamese_encoder_idle_work");
+
+    // The first encoder does all of its work in siamese_encode()
+    SiameseEncoder lazy = siamese_encoder_create();
+    SiameseEncoder eager = siamese_encoder_create();
+
+    bool success = false;
+    if (!lazy || !eager)
+    {
+        Logger.Error("Unable to create codec");
+        SIAMESE_DEBUG_BREAK();
+    }
+    else {
+        success = CompareIdleWork(lazy, eager, t_siamese_encoder_idle_work);
+    }
+
+    siamese_encoder_free(lazy);
+    siamese_encoder_free(eager);
+
+    if (!success) {
+        return false;
+    }
+
+    Logger.Info("Test successful. Timing summary:");
+    t_siamese_encoder_idle_work.Print(1);
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// TestPipeline
+
+/// Maximum number of 1 msec polls to wait for the pipeline worker
+static const unsigned kPipelinePollLimit = 1000;
+
+static bool GetPipelineReadyCount(SiameseEncoder encoder, uint64_t& readyCountOut)
+{
+    uint64_t stats[SiameseEncoderStats_Count];
+    if (0 != siamese_encoder_stats(encoder, stats, SiameseEncoderStats_Count)) {
+        return false;
+    }
+    readyCountOut = stats[SiameseEncoderStats_PipelineReadyCount];
+    return true;
+}
+
+bool TestPipeline()
+{
+    Logger.Info("Test: TestPipeline");
+
+    FunctionTimer t_siamese_encode("siamese_encode (pipeline)");
+
+    static const unsigned kWindowSizes[] = { 1, 10, 100, 1000 };
+    static const unsigned kReadyCount = 4;
+
+    for (unsigned N : kWindowSizes)
+    {
+        siamese::PCGRandom prng;
+        prng.Seed(kSeed, N);
+
+        TestCodecs codecs;
+        codecs.EncodeTimer = &t_siamese_encode;
+        if (!codecs.Create()) {
+            return false;
+        }
+        if (0 != siamese_encoder_pipeline_start(codecs.Encoder, kReadyCount))
+        {
+            Logger.Error("Unable to start pipeline");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        if (!codecs.SendWithLosses(N, prng)) {
+            return false;
+        }
+
+        // Queued packets must be visible to the other encoder functions
+        SiameseOriginalPacket last;
+        last.PacketNum = N - 1;
+        if (0 != siamese_encoder_get(codecs.Encoder, &last) ||
+            !CheckPacket(N - 1, last.Data, last.DataBytes))
+        {
+            Logger.Error("Queued packet was not added to the encoder");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        if (!codecs.RecoverAll(N, 200)) {
+            return false;
+        }
+
+        // Poll until the worker hands out a packet it prepared ahead of time
+        uint64_t readyCount = 0;
+        for (unsigned poll = 0; readyCount == 0; ++poll)
+        {
+            SiameseRecoveryPacket recovery;
+            if (poll >= kPipelinePollLimit ||
+                0 != siamese_encode(codecs.Encoder, &recovery) ||
+                !GetPipelineReadyCount(codecs.Encoder, readyCount))
+            {
+                Logger.Error("Pipeline never had a packet ready");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+            if (readyCount == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    // Ready packets must survive adds
+    {
+        TestCodecs codecs;
+        if (!codecs.Create()) {
+            return false;
+        }
+        if (0 != siamese_encoder_pipeline_start(codecs.Encoder, kReadyCount))
+        {
+            Logger.Error("Unable to start pipeline");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        // Poll until an encode right after an add is served from the ready
+        // packets, rather than guessing how long the worker needs to fill them
+        uint64_t readyCount = 0;
+        for (unsigned i = 0; readyCount == 0; ++i)
+        {
+            if (i >= kPipelinePollLimit)
+            {
+                Logger.Error("Pipeline dropped ready packets on add");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+            if (i > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            if (!codecs.Send(i, true)) {
+                return false;
+            }
+
+            SiameseRecoveryPacket recovery;
+            if (0 != siamese_encode(codecs.Encoder, &recovery) ||
+                !GetPipelineReadyCount(codecs.Encoder, readyCount))
+            {
+                Logger.Error("Unable to encode with the pipeline");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+        }
+    }
+
+    Logger.Info("Test successful. Timing summary:");
+    t_siamese_encode.Print(1);
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// TestSumCheckpoints
+
+bool TestSumCheckpoints()
+{
+    Logger.Info("Test: TestSumCheckpoints");
+
+    FunctionTimer t_siamese_decode("siamese_decode");
+
+    // Many packets in flight so the windows are large when the encoder
+    // restarts its sums at SIAMESE_MAX_PACKETS
+    static const unsigned kPacketCount = 30000;
+    static const unsigned kInFlight = 5000;
+    static const unsigned kRecoveryInterval = 20;
+    static const unsigned kLossInterval = 97;
+
+    TestCodecs codecs;
+    codecs.DecodeTimer = &t_siamese_decode;
+    if (!codecs.Create()) {
+        return false;
+    }
+
+    unsigned lostCount = 0;
+
+    for (unsigned packetNum = 0; packetNum < kPacketCount; ++packetNum)
+    {
+        const bool lost = (packetNum % kLossInterval == kLossInterval / 2);
+        if (lost) {
+            ++lostCount;
+        }
+        if (!codecs.Send(packetNum, lost)) {
+            return false;
+        }
+
+        // Acknowledge data that was sent one round trip ago
+        if (packetNum % 100 == 0 && packetNum >= kInFlight)
+        {
+            if (0 != siamese_encoder_remove_before(codecs.Encoder, packetNum - kInFlight))
+            {
+                Logger.Error("Unable to remove data from encoder");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+        }
+
+        if (packetNum % kRecoveryInterval == kRecoveryInterval - 1 &&
+            !codecs.Recover())
+        {
+            return false;
+        }
+    }
+
+    uint64_t stats[SiameseDecoderStats_Count];
+    if (0 != siamese_decoder_stats(codecs.Decoder, stats, SiameseDecoderStats_Count))
+    {
+        Logger.Error("Unable to get decoder stats");
+        SIAMESE_DEBUG_BREAK();
+        return false;
+    }
+    if (stats[SiameseDecoderStats_SumCheckpointCount] == 0)
+    {
+        Logger.Error("Decoder never resumed from a sum checkpoint");
+        SIAMESE_DEBUG_BREAK();
+        return false;
+    }
+
+    uint64_t encoderStats[SiameseEncoderStats_Count];
+    if (0 != siamese_encoder_stats(codecs.Encoder, encoderStats, SiameseEncoderStats_Count))
+    {
+        Logger.Error("Unable to get encoder stats");
+        SIAMESE_DEBUG_BREAK();
+        return false;
+    }
+    if (encoderStats[SiameseEncoderStats_SumCheckpointCount] == 0)
+    {
+        Logger.Error("Encoder never resumed from a sum checkpoint");
+        SIAMESE_DEBUG_BREAK();
+        return false;
+    }
+
+    // Only the losses after the last recovery packet can be left over
+    const unsigned recoveredCount = codecs.ReceivedCount - (kPacketCount - lostCount);
+    if (recoveredCount + kRecoveryInterval / kLossInterval + 1 < lostCount)
+    {
+        Logger.Error("Only recovered ", recoveredCount, " of ", lostCount, " lost packets");
+        SIAMESE_DEBUG_BREAK();
+        return false;
+    }
+
+    Logger.Info("Test successful: Resumed from ", encoderStats[SiameseEncoderStats_SumCheckpointCount],
+        " encoder and ", stats[SiameseDecoderStats_SumCheckpointCount], " decoder checkpoints. Timing summary:");
+    t_siamese_decode.Print(1);
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// TestDecoderThreads
+
+bool TestDecoderThreads()
+{
+    Logger.Info("Test: TestDecoderThreads");
+
+    FunctionTimer t_siamese_decode("siamese_decode (threads)");
+
+    // Includes windows that use Cauchy rows and windows that use Siamese rows
+    static const unsigned kWindowSizes[] = { 10, 60, 1000, 2000 };
+    static const unsigned kThreadCount = 3;
+
+    for (unsigned N : kWindowSizes)
+    {
+        siamese::PCGRandom prng;
+        prng.Seed(kSeed, N);
+
+        TestCodecs codecs;
+        codecs.DecodeTimer = &t_siamese_decode;
+        if (!codecs.Create()) {
+            return false;
+        }
+        if (0 != siamese_decoder_threads_start(codecs.Decoder, kThreadCount))
+        {
+            Logger.Error("Unable to start decoder threads");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        // Lose about 10% so that one decode solves for many packets
+        if (!codecs.SendWithLosses(N, prng)) {
+            return false;
+        }
+
+        const unsigned lostCount = N - codecs.ReceivedCount;
+        if (!codecs.RecoverAll(N, lostCount + 20)) {
+            return false;
+        }
+
+        if (0 != siamese_decoder_threads_stop(codecs.Decoder))
+        {
+            Logger.Error("Unable to stop decoder threads");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+    }
+
+    Logger.Info("Test successful. Timing summary:");
+    t_siamese_decode.Print(1);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// TestDecoderIdleWork
+
+/// Receiver side of TestDecoderIdleWork()
+struct IdleWorkReceiver
+{
+    TestCodecs Codecs;
+    std::vector<bool> Got;
+    unsigned GotCount = 0;
+
+    /// Deliver original data to the decoder, which may have recovered it
+    bool Deliver(unsigned packetNum)
+    {
+        uint8_t buffer[2000];
+        SiameseOriginalPacket original;
+        original.PacketNum = packetNum;
+        original.Data = buffer;
+        original.DataBytes = GetPacketBytes(packetNum);
+        SetPacket(packetNum, buffer, original.DataBytes);
+
+        const int result = siamese_decoder_add_original(Codecs.Decoder, &original);
+        if (result == Siamese_DuplicateData && Got[packetNum]) {
+            return true;
+        }
+        if (result != Siamese_Success || Got[packetNum]) {
+            return false;
+        }
+        Got[packetNum] = true;
+        ++GotCount;
+        return true;
+    }
+
+    /// Send a recovery packet, do idle work, and decode when possible
+    bool Recover()
+    {
+        SiameseRecoveryPacket recovery;
+        if (0 != siamese_encode(Codecs.Encoder, &recovery) ||
+            !Codecs.AddRecovery(recovery) ||
+            0 != siamese_decoder_idle_work(Codecs.Decoder, 0) ||
+            !Codecs.Decode())
+        {
+            return false;
+        }
+
+        for (unsigned j = 0; j < Codecs.RecoveredCount; ++j)
+        {
+            const unsigned packetNum = Codecs.Recovered[j].PacketNum;
+            if (packetNum >= Got.size() || Got[packetNum])
+            {
+                Logger.Error("Recovered unexpected packet ", packetNum);
+                return false;
+            }
+            Got[packetNum] = true;
+            ++GotCount;
+        }
+        return true;
+    }
+};
+
+bool TestDecoderIdleWork()
+{
+    Logger.Info("Test: TestDecoderIdleWork");
+
+    FunctionTimer t_siamese_decode("siamese_decode (idle work)");
+
+    // Includes windows that use Cauchy rows and windows that use Siamese rows
+    static const unsigned kWindowSizes[] = { 10, 60, 1000, 2000 };
+    static const unsigned kRecoveryInterval = 8;
+    static const unsigned kLateDelay = 40;
+
+    uint64_t eliminatedCount = 0;
+
+    for (unsigned N : kWindowSizes)
+    {
+        siamese::PCGRandom prng;
+        prng.Seed(kSeed, N);
+
+        IdleWorkReceiver receiver;
+        receiver.Codecs.DecodeTimer = &t_siamese_decode;
+        receiver.Got.resize(N, false);
+        if (!receiver.Codecs.Create()) {
+            return false;
+        }
+
+        std::queue<unsigned> late;
+
+        for (unsigned i = 0; i < N; ++i)
+        {
+            if (!receiver.Codecs.Send(i, true)) {
+                return false;
+            }
+
+            // Lose about 10%, and deliver half of those after recovery
+            // packets that cover them were eliminated without them
+            if (i > 0 && prng.Next() % 10 == 0)
+            {
+                if (prng.Next() % 2 == 0) {
+                    late.push(i);
+                }
+            }
+            else if (!receiver.Deliver(i))
+            {
+                Logger.Error("Unable to add original data to decoder");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+
+            for (; !late.empty() && late.front() + kLateDelay <= i; late.pop())
+            {
+                if (!receiver.Deliver(late.front()))
+                {
+                    Logger.Error("Unable to add late original data to decoder");
+                    SIAMESE_DEBUG_BREAK();
+                    return false;
+                }
+            }
+
+            if (i % kRecoveryInterval == kRecoveryInterval - 1 &&
+                !receiver.Recover())
+            {
+                Logger.Error("Recovery failed for N = ", N, " at ", i);
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+        }
+
+        for (; !late.empty(); late.pop())
+        {
+            if (!receiver.Deliver(late.front()))
+            {
+                Logger.Error("Unable to add late original data to decoder");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+        }
+
+        for (unsigned attempt = 0; receiver.GotCount < N; ++attempt)
+        {
+            if (attempt >= N || !receiver.Recover())
+            {
+                Logger.Error("Decoding with idle work failed to recover N = ", N);
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+        }
+
+        uint64_t stats[SiameseDecoderStats_Count];
+        if (0 != siamese_decoder_stats(receiver.Codecs.Decoder, stats, SiameseDecoderStats_Count))
+        {
+            Logger.Error("Unable to get decoder stats");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+        eliminatedCount += stats[SiameseDecoderStats_IdleEliminationCount];
+    }
+
+    if (eliminatedCount == 0)
+    {
+        Logger.Error("Idle work did not eliminate any recovery packets");
+        SIAMESE_DEBUG_BREAK();
+        return false;
+    }
+
+    Logger.Info("Test successful. Timing summary:");
+    t_siamese_decode.Print(1);
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// TestSingleLoss
+
+bool TestSingleLoss()
+{
+    Logger.Info("Test: TestSingleLoss");
+
+    FunctionTimer t_siamese_decode("siamese_decode (single loss)");
+
+    // Includes windows that use parity/Cauchy rows and windows that use Siamese rows
+    static const unsigned kWindowSizes[] = { 2, 10, 60, 1000, 2000 };
+    static const unsigned kRounds = 4;
+
+    for (unsigned N : kWindowSizes)
+    {
+        siamese::PCGRandom prng;
+        prng.Seed(kSeed, N);
+
+        TestCodecs codecs;
+        codecs.DecodeTimer = &t_siamese_decode;
+        if (!codecs.Create()) {
+            return false;
+        }
+
+        unsigned packetNum = 0;
+
+        // Each round loses one packet and then recovers it
+        for (unsigned round = 0; round < kRounds; ++round)
+        {
+            const unsigned lostPacketNum = packetNum + 1 + prng.Next() % (N - 1);
+
+            for (unsigned i = 0; i < N; ++i, ++packetNum)
+            {
+                if (!codecs.Send(packetNum, packetNum == lostPacketNum)) {
+                    return false;
+                }
+            }
+
+            for (unsigned attempt = 0;; ++attempt)
+            {
+                if (attempt >= 10)
+                {
+                    Logger.Error("Single loss was not recovered for N = ", N);
+                    SIAMESE_DEBUG_BREAK();
+                    return false;
+                }
+
+                if (!codecs.Recover()) {
+                    return false;
+                }
+                if (codecs.RecoveredCount == 0) {
+                    continue;
+                }
+                if (codecs.RecoveredCount != 1 ||
+                    codecs.Recovered[0].PacketNum != lostPacketNum)
+                {
+                    Logger.Error("Single loss recovery failed for N = ", N);
+                    SIAMESE_DEBUG_BREAK();
+                    return false;
+                }
+                break;
+            }
+        }
+
+        uint64_t stats[SiameseDecoderStats_Count];
+        if (0 != siamese_decoder_stats(codecs.Decoder, stats, SiameseDecoderStats_Count))
+        {
+            Logger.Error("Unable to get decoder stats");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+        if (stats[SiameseDecoderStats_SingleLossSolveCount] != kRounds)
+        {
+            Logger.Error("Single losses were not solved directly for N = ", N);
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+    }
+
+    Logger.Info("Test successful. Timing summary:");
+    t_siamese_decode.Print(1);
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// TestCauchySolve
+
+bool TestCauchySolve()
+{
+    Logger.Info("Test: TestCauchySolve");
+
+    FunctionTimer t_siamese_decode("siamese_decode (Cauchy)");
+
+    // Windows at or below SIAMESE_CAUCHY_THRESHOLD only use parity/Cauchy rows
+    static const unsigned kWindowSizes[] = { 3, 10, 30, 64 };
+    static const unsigned kTrials = 20;
+    static const unsigned kMaxLosses = 12;
+
+    for (unsigned N : kWindowSizes)
+    {
+        siamese::PCGRandom prng;
+        prng.Seed(kSeed, N);
+
+        for (unsigned trial = 0; trial < kTrials; ++trial)
+        {
+            TestCodecs codecs;
+            codecs.DecodeTimer = &t_siamese_decode;
+            if (!codecs.Create()) {
+                return false;
+            }
+
+            // Lose at least two packets, but never the first one
+            const unsigned maxLosses = (N - 1 < kMaxLosses) ? N - 1 : kMaxLosses;
+            const unsigned lossCount = 2 + prng.Next() % (maxLosses - 1);
+            std::vector<bool> lost(N, false);
+            for (unsigned i = 0; i < lossCount;)
+            {
+                const unsigned packetNum = 1 + prng.Next() % (N - 1);
+                if (!lost[packetNum])
+                {
+                    lost[packetNum] = true;
+                    ++i;
+                }
+            }
+
+            for (unsigned i = 0; i < N; ++i)
+            {
+                if (!codecs.Send(i, lost[i])) {
+                    return false;
+                }
+            }
+
+            for (unsigned attempt = 0;; ++attempt)
+            {
+                if (attempt >= lossCount + 10)
+                {
+                    Logger.Error("Cauchy losses were not recovered for N = ", N);
+                    SIAMESE_DEBUG_BREAK();
+                    return false;
+                }
+
+                if (!codecs.Recover()) {
+                    return false;
+                }
+                if (codecs.RecoveredCount == 0) {
+                    continue;
+                }
+                if (codecs.RecoveredCount != lossCount)
+                {
+                    Logger.Error("Cauchy decode recovered ", codecs.RecoveredCount, " of ", lossCount, " for N = ", N);
+                    SIAMESE_DEBUG_BREAK();
+                    return false;
+                }
+
+                for (unsigned j = 0; j < codecs.RecoveredCount; ++j)
+                {
+                    const unsigned packetNum = codecs.Recovered[j].PacketNum;
+                    if (packetNum >= N || !lost[packetNum])
+                    {
+                        Logger.Error("Recovered unexpected packet ", packetNum);
+                        SIAMESE_DEBUG_BREAK();
+                        return false;
+                    }
+                    lost[packetNum] = false;
+                }
+                break;
+            }
+
+            uint64_t stats[SiameseDecoderStats_Count];
+            if (0 != siamese_decoder_stats(codecs.Decoder, stats, SiameseDecoderStats_Count) ||
+                stats[SiameseDecoderStats_CauchySolveCount] != 1)
+            {
+                Logger.Error("Losses were not solved with the Cauchy inverse for N = ", N);
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+        }
+    }
+
+    Logger.Info("Test successful. Timing summary:");
+    t_siamese_decode.Print(1);
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// TestRecoveryReorder
+
+bool TestRecoveryReorder()
+{
+    Logger.Info("Test: TestRecoveryReorder");
+
+    FunctionTimer t_siamese_decoder_add_recovery("siamese_decoder_add_recovery (reordered)");
+
+    static const unsigned N = 2000;
+    static const unsigned kRecoveryCount = 400;
+
+    siamese::PCGRandom prng;
+    prng.Seed(kSeed, N);
+
+    TestCodecs codecs;
+    if (!codecs.Create()) {
+        return false;
+    }
+
+    struct StoredRecovery
+    {
+        std::vector<uint8_t> Data;
+    };
+    std::vector<StoredRecovery> stored(kRecoveryCount);
+    unsigned storedCount = 0;
+
+    for (unsigned i = 0; i < N; ++i)
+    {
+        // Lose about 5%
+        const bool lost = (i > 0 && prng.Next() % 20 == 0);
+        if (!codecs.Send(i, lost)) {
+            return false;
+        }
+        if (lost) {
+            continue;
+        }
+
+        // Generate recovery packets along the way and hold them back
+        if (i % (N / kRecoveryCount) == N / kRecoveryCount - 1)
+        {
+            SiameseRecoveryPacket recovery;
+            if (0 != siamese_encode(codecs.Encoder, &recovery))
+            {
+                Logger.Error("Unable to encode");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+            stored[storedCount++].Data.assign(recovery.Data, recovery.Data + recovery.DataBytes);
+        }
+    }
+
+    // Deliver them in a shuffled order
+    for (unsigned i = storedCount - 1; i > 0; --i) {
+        std::swap(stored[i], stored[prng.Next() % (i + 1)]);
+    }
+
+    for (unsigned i = 0; i < storedCount; ++i)
+    {
+        SiameseRecoveryPacket recovery;
+        recovery.Data = &stored[i].Data[0];
+        recovery.DataBytes = (unsigned)stored[i].Data.size();
+
+        t_siamese_decoder_add_recovery.BeginCall();
+        const bool added = codecs.AddRecovery(recovery);
+        t_siamese_decoder_add_recovery.EndCall();
+        if (!added) {
+            return false;
+        }
+    }
+
+    // Decode until everything is recovered, sending more if needed
+    if (!codecs.Decode() || !codecs.RecoverAll(N, N)) {
+        return false;
+    }
+
+    Logger.Info("Test successful. Timing summary:");
+    t_siamese_decoder_add_recovery.Print(1);
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// TestDecoderAck
+
+/// Parse an acknowledgement and check that the NACK list names exactly the
+/// packets that are missing before windowEnd
+static bool CheckDecoderAck(
+    const uint8_t* data,
+    unsigned bytes,
+    const std::vector<bool>& got,
+    unsigned windowEnd)
+{
+    unsigned nextColumnExpected = 0;
+    const int headerBytes = siamese::DeserializeHeader_PacketNum(data, (int)bytes, nextColumnExpected);
+    if (headerBytes < 1) {
+        return false;
+    }
+
+    unsigned expectedNext = 0;
+    while (expectedNext < windowEnd && got[expectedNext]) {
+        ++expectedNext;
+    }
+    if (nextColumnExpected != expectedNext) {
+        return false;
+    }
+
+    std::vector<bool> nacked(windowEnd + 1, false);
+
+    // Zero padding so the last range can be read safely
+    std::vector<uint8_t> padded(data + headerBytes, data + bytes);
+    unsigned remaining = (unsigned)padded.size();
+    padded.resize(remaining + siamese::kMaxLossRangeFieldBytes, 0);
+
+    unsigned offset = 0;
+    unsigned rangeOffset = nextColumnExpected;
+    while (offset < remaining)
+    {
+        unsigned relativeStart, lossCountM1;
+        const int rangeBytes = siamese::DeserializeHeader_NACKLossRange(
+            &padded[offset], (unsigned)padded.size() - offset, relativeStart, lossCountM1);
+        if (rangeBytes < 1) {
+            return false;
+        }
+        offset += rangeBytes;
+
+        const unsigned rangeStart = rangeOffset + relativeStart;
+        const unsigned rangeEnd = rangeStart + lossCountM1 + 1;
+        if (rangeEnd > windowEnd + 1) {
+            return false;
+        }
+        for (unsigned column = rangeStart; column < rangeEnd; ++column) {
+            nacked[column] = true;
+        }
+        rangeOffset = rangeEnd + 1;
+    }
+
+    // The last range may point one beyond the window at the next packet
+    for (unsigned column = expectedNext; column < windowEnd; ++column) {
+        if (nacked[column] == got[column]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool TestDecoderAck()
+{
+    Logger.Info("Test: TestDecoderAck");
+
+    FunctionTimer t_siamese_decoder_ack("siamese_decoder_ack");
+
+    static const unsigned N = 4000;
+
+    siamese::PCGRandom prng;
+    prng.Seed(kSeed, N);
+
+    TestCodecs codecs;
+    if (!codecs.Create()) {
+        return false;
+    }
+
+    std::vector<bool> got(N, false);
+    std::vector<unsigned> lost;
+    unsigned windowEnd = 0;
+    unsigned ackCount = 0;
+
+    for (unsigned i = 0; i < N; ++i)
+    {
+        // Lose about 10%, sometimes in bursts
+        const bool isLost = (i > 0 && prng.Next() % 10 == 0);
+        if (!codecs.Send(i, isLost)) {
+            return false;
+        }
+        if (isLost) {
+            lost.push_back(i);
+        }
+        else
+        {
+            got[i] = true;
+            windowEnd = i + 1;
+        }
+
+        // Sometimes a lost packet is retransmitted late
+        if (!lost.empty() && prng.Next() % 8 == 0)
+        {
+            const unsigned lostIndex = prng.Next() % (unsigned)lost.size();
+            const unsigned packetNum = lost[lostIndex];
+            lost[lostIndex] = lost.back();
+            lost.pop_back();
+
+            if (!got[packetNum])
+            {
+                if (!codecs.Receive(packetNum)) {
+                    return false;
+                }
+                got[packetNum] = true;
+            }
+        }
+
+        // Send fewer recovery packets than losses so holes stay open
+        if (i % 25 == 24)
+        {
+            if (!codecs.Recover()) {
+                return false;
+            }
+            windowEnd = i + 1;
+
+            for (unsigned j = 0; j < codecs.RecoveredCount; ++j) {
+                got[codecs.Recovered[j].PacketNum] = true;
+            }
+        }
+
+        if (i % 10 == 9)
+        {
+            uint8_t ack[8000];
+            unsigned usedBytes = 0;
+
+            t_siamese_decoder_ack.BeginCall();
+            const int result = siamese_decoder_ack(codecs.Decoder, ack, (unsigned)sizeof(ack), &usedBytes);
+            t_siamese_decoder_ack.EndCall();
+            if (result != 0)
+            {
+                Logger.Error("Unable to generate decoder acknowledgement message: ", result);
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+
+            if (!CheckDecoderAck(ack, usedBytes, got, windowEnd))
+            {
+                Logger.Error("Acknowledgement NACK list does not match losses at packet ", i);
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+            ++ackCount;
+        }
+    }
+
+    Logger.Info("Test successful: Checked ", ackCount, " acknowledgements. Timing summary:");
+    t_siamese_decoder_ack.Print(1);
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// TestDecoderJumpAhead
+
+static bool GetDecoderMemoryUsed(SiameseDecoder decoder, uint64_t& memoryUsedOut)
+{
+    uint64_t stats[SiameseDecoderStats_Count];
+    if (0 != siamese_decoder_stats(decoder, stats, SiameseDecoderStats_Count)) {
+        return false;
+    }
+    memoryUsedOut = stats[SiameseDecoderStats_MemoryUsed];
+    return true;
+}
+
+bool TestDecoderJumpAhead()
+{
+    Logger.Info("Test: TestDecoderJumpAhead");
+
+    static const unsigned kBefore = 100;
+    static const unsigned kJumpPacketNum = 8000;
+    static const unsigned kLostPacketNum = 4321;
+
+    // Without lazy subwindows the jump would allocate about 125 subwindows
+    static const uint64_t kMaxJumpBytes = 64 * 1024;
+
+    TestCodecs codecs;
+    if (!codecs.Create()) {
+        return false;
+    }
+
+    for (unsigned i = 0; i <= kJumpPacketNum; ++i)
+    {
+        if (!codecs.Send(i, true)) {
+            return false;
+        }
+    }
+
+    for (unsigned i = 0; i < kBefore; ++i)
+    {
+        if (!codecs.Receive(i)) {
+            return false;
+        }
+    }
+
+    uint64_t memoryBefore = 0, memoryAfter = 0;
+    if (!GetDecoderMemoryUsed(codecs.Decoder, memoryBefore) ||
+        !codecs.Receive(kJumpPacketNum) ||
+        !GetDecoderMemoryUsed(codecs.Decoder, memoryAfter))
+    {
+        Logger.Error("Unable to add jump packet to decoder");
+        SIAMESE_DEBUG_BREAK();
+        return false;
+    }
+
+    if (memoryAfter > memoryBefore + kMaxJumpBytes)
+    {
+        Logger.Error("Jumping ahead allocated ", memoryAfter - memoryBefore, " bytes");
+        SIAMESE_DEBUG_BREAK();
+        return false;
+    }
+
+    // Fill in the gap except for one packet, and recover that one
+    for (unsigned i = kBefore; i < kJumpPacketNum; ++i)
+    {
+        if (i != kLostPacketNum && !codecs.Receive(i)) {
+            return false;
+        }
+    }
+
+    for (unsigned attempt = 0;; ++attempt)
+    {
+        if (attempt >= 10)
+        {
+            Logger.Error("Unable to recover the lost packet after jumping ahead");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        if (!codecs.Recover()) {
+            return false;
+        }
+        if (codecs.RecoveredCount == 0) {
+            continue;
+        }
+        if (codecs.RecoveredCount != 1 ||
+            codecs.Recovered[0].PacketNum != kLostPacketNum)
+        {
+            Logger.Error("Recovery after jumping ahead recovered the wrong packets");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+        break;
+    }
+
+    Logger.Info("Test successful: Jumping ahead ", kJumpPacketNum - kBefore,
+        " packets allocated ", memoryAfter - memoryBefore, " bytes");
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// TestAllocatorPool
+
+static bool GetEncoderMemoryUsed(SiameseEncoder encoder, uint64_t& memoryUsedOut)
+{
+    uint64_t stats[SiameseEncoderStats_Count];
+    if (0 != siamese_encoder_stats(encoder, stats, SiameseEncoderStats_Count)) {
+        return false;
+    }
+    memoryUsedOut = stats[SiameseEncoderStats_MemoryUsed];
+    return true;
+}
+
+/// Number of codecs sharing the pool at once in TestAllocatorPool()
+static const unsigned kPooledSessionCount = 32;
+
+/// Run one round of pooled sessions that each lose and recover one packet.
+/// The codecs are freed before this returns, even on failure
+static bool RunPooledSessions(SiameseAllocatorPool pool)
+{
+    static const unsigned kPacketCount = 50;
+    static const unsigned kLostPacketNum = 7;
+
+    TestCodecs sessions[kPooledSessionCount];
+
+    for (unsigned session = 0; session < kPooledSessionCount; ++session)
+    {
+        if (!sessions[session].Create(pool)) {
+            return false;
+        }
+
+        uint64_t encoderMemory = 0, decoderMemory = 0;
+        if (!GetEncoderMemoryUsed(sessions[session].Encoder, encoderMemory) ||
+            !GetDecoderMemoryUsed(sessions[session].Decoder, decoderMemory) ||
+            encoderMemory != 0 || decoderMemory != 0)
+        {
+            Logger.Error("Idle pooled codec holds ", encoderMemory, " + ", decoderMemory, " bytes");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+    }
+
+    for (unsigned session = 0; session < kPooledSessionCount; ++session)
+    {
+        TestCodecs& codecs = sessions[session];
+
+        for (unsigned i = 0; i < kPacketCount; ++i)
+        {
+            if (!codecs.Send(i, i == kLostPacketNum)) {
+                return false;
+            }
+        }
+
+        // Each active codec reports only the memory it is holding
+        uint64_t encoderMemory = 0, decoderMemory = 0;
+        if (!GetEncoderMemoryUsed(codecs.Encoder, encoderMemory) ||
+            !GetDecoderMemoryUsed(codecs.Decoder, decoderMemory) ||
+            encoderMemory == 0 || decoderMemory == 0)
+        {
+            Logger.Error("Active pooled codec reports ", encoderMemory, " + ", decoderMemory, " bytes");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        for (unsigned attempt = 0;; ++attempt)
+        {
+            if (attempt >= 10)
+            {
+                Logger.Error("Unable to recover the lost packet with a pooled codec");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+
+            if (!codecs.Recover()) {
+                return false;
+            }
+            if (codecs.RecoveredCount == 0) {
+                continue;
+            }
+            if (codecs.RecoveredCount != 1 ||
+                codecs.Recovered[0].PacketNum != kLostPacketNum)
+            {
+                Logger.Error("Recovery with a pooled codec recovered the wrong packets");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool TestAllocatorPool()
+{
+    Logger.Info("Test: TestAllocatorPool");
+
+    static const unsigned kRounds = 3;
+
+    SiameseAllocatorPool pool = siamese_allocator_pool_create();
+    if (!pool)
+    {
+        Logger.Error("Unable to create allocator pool");
+        SIAMESE_DEBUG_BREAK();
+        return false;
+    }
+
+    // Windows freed by one round of sessions are reused by the next round
+    bool success = true;
+    for (unsigned round = 0; success && round < kRounds; ++round) {
+        success = RunPooledSessions(pool);
+    }
+
+    // The pool keeps the windows given back until it is trimmed
+    unsigned pooledBytes = 0;
+    if (success &&
+        (0 != siamese_allocator_pool_trim(pool, ~0u, &pooledBytes) ||
+        pooledBytes == 0))
+    {
+        Logger.Error("Pool holds no windows after the codecs are freed");
+        SIAMESE_DEBUG_BREAK();
+        success = false;
+    }
+    if (success &&
+        (0 != siamese_allocator_pool_trim(pool, 0, &pooledBytes) ||
+        pooledBytes != 0))
+    {
+        Logger.Error("Pool still holds ", pooledBytes, " bytes after trim");
+        SIAMESE_DEBUG_BREAK();
+        success = false;
+    }
+
+    siamese_allocator_pool_free(pool);
+
+    if (!success) {
+        return false;
+    }
+
+    Logger.Info("Test successful: ", kRounds * kPooledSessionCount, " pooled sessions");
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// TestLargePackets
+
+bool TestLargePackets()
+{
+    Logger.Info("Test: TestLargePackets");
+
+    static const unsigned kPacketCount = 300;
+    static const unsigned kLossInterval = 10;
+
+    // Packets are larger than CheckPacket() allows, so only the codec
+    // lifetime comes from TestCodecs
+    TestCodecs codecs;
+    if (!codecs.Create()) {
+        return false;
+    }
+
+    std::vector<std::vector<uint8_t>> packets(kPacketCount);
+    std::vector<uint8_t> ack(1000);
+
+    for (unsigned i = 0; i < kPacketCount; ++i)
+    {
+        // Mix 64 KB and 9000 byte packets with the usual sizes
+        unsigned packetBytes = GetPacketBytes(i);
+        if (i % 3 == 0) {
+            packetBytes = 65536;
+        }
+        else if (i % 3 == 1) {
+            packetBytes = 9000;
+        }
+        packets[i].resize(packetBytes);
+        SetPacket(i, &packets[i][0], packetBytes);
+
+        SiameseOriginalPacket original;
+        original.Data = &packets[i][0];
+        original.DataBytes = packetBytes;
+        if (0 != siamese_encoder_add(codecs.Encoder, &original))
+        {
+            Logger.Error("Unable to add original data to encoder");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+
+        if (i % kLossInterval != kLossInterval / 2)
+        {
+            if (0 != siamese_decoder_add_original(codecs.Decoder, &original))
+            {
+                Logger.Error("Unable to add original data to decoder");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+            continue;
+        }
+
+        // Recover the lost packet
+        for (unsigned attempt = 0;; ++attempt)
+        {
+            if (attempt >= 10)
+            {
+                Logger.Error("Unable to recover a large packet");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+
+            SiameseRecoveryPacket recovery;
+            if (0 != siamese_encode(codecs.Encoder, &recovery) ||
+                0 != siamese_decoder_add_recovery(codecs.Decoder, &recovery))
+            {
+                Logger.Error("Unable to pass recovery data to decoder");
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+
+            SiameseOriginalPacket* recovered = nullptr;
+            unsigned recoveredCount = 0;
+            const int result = siamese_decode(codecs.Decoder, &recovered, &recoveredCount);
+            if (result == Siamese_NeedMoreData) {
+                continue;
+            }
+            if (result || recoveredCount != 1 ||
+                recovered[0].PacketNum != i ||
+                recovered[0].DataBytes != packetBytes ||
+                0 != memcmp(recovered[0].Data, &packets[i][0], packetBytes))
+            {
+                Logger.Error("Large packet recovery failed: ", result);
+                SIAMESE_DEBUG_BREAK();
+                return false;
+            }
+            break;
+        }
+
+        // Acknowledge so the encoder can free the packets
+        unsigned ackBytes = 0, nextExpected = 0;
+        if (0 != siamese_decoder_ack(codecs.Decoder, &ack[0], (unsigned)ack.size(), &ackBytes) ||
+            0 != siamese_encoder_ack(codecs.Encoder, &ack[0], ackBytes, &nextExpected))
+        {
+            Logger.Error("Unable to acknowledge large packets");
+            SIAMESE_DEBUG_BREAK();
+            return false;
+        }
+    }
+
+    uint64_t encoderStats[SiameseEncoderStats_Count];
+    uint64_t decoderStats[SiameseDecoderStats_Count];
+    if (0 != siamese_encoder_stats(codecs.Encoder, encoderStats, SiameseEncoderStats_Count) ||
+        0 != siamese_decoder_stats(codecs.Decoder, decoderStats, SiameseDecoderStats_Count))
+    {
+        Logger.Error("Unable to get codec stats");
+        SIAMESE_DEBUG_BREAK();
+        return false;
+    }
+
+    // Without reuse each 64 KB packet would be allocated with calloc()
+    const uint64_t encoderFallbacks = encoderStats[SiameseEncoderStats_FallbackAllocateCount];
+    const uint64_t decoderFallbacks = decoderStats[SiameseDecoderStats_FallbackAllocateCount];
+    if (encoderFallbacks <= 0 || encoderFallbacks >= kPacketCount / 6)
+    {
+        Logger.Error("Encoder allocated ", encoderFallbacks, " large buffers with calloc()");
+        SIAMESE_DEBUG_BREAK();
+        return false;
+    }
+
+    Logger.Info("Test successful: Large buffers allocated with calloc(): Encoder = ",
+        encoderFallbacks, ", Decoder = ", decoderFallbacks);
+
+    return true;
+}
+
+
+int main()
+{
+    FunctionTimer t_siamese_init("siamese_init");
+
+    t_siamese_init.BeginCall();
+    if (0 != siamese_init())
+    {
+        Logger.Error("Failed to initialize");
+        return -1;
+    }
+    t_siamese_init.EndCall();
+
+    t_siamese_init.Print(1);
+
+#ifdef TEST_LARGE_BURST_LOSS
+    if (!TestLargeBurstLoss())
+    {
+        Logger.Error("Test failed: TestLargeBurstLoss");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
+#ifdef TEST_HARQ_STREAM
+    for (unsigned seed = 0;; ++seed)
+    {
+        HARQSimulation simulation;
+        simulation.Run(seed);
+    }
+#endif
+#ifdef TEST_ENCODE_BATCH
+    if (!TestEncodeBatch())
+    {
+        Logger.Error("Test failed: TestEncodeBatch");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
+#ifdef TEST_ZERO_COPY
+    if (!TestZeroCopy())
+    {
+        Logger.Error("Test failed: TestZeroCopy");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
+#ifdef TEST_SEGMENTS
+    if (!TestSegments())
+    {
+        Logger.Error("Test failed: TestSegments");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
+#ifdef TEST_ENCODE_INTO
+    if (!TestEncodeInto())
+    {
+        Logger.Error("Test failed: TestEncodeInto");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
+#ifdef TEST_IDLE_WORK
+    if (!TestIdleWork())
+    {
+        Logger.Error("Test failed: TestIdleWork");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
+#ifdef TEST_PIPELINE
+    if (!TestPipeline())
+    {
+        Logger.Error("Test failed: TestPipeline");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
+#ifdef TEST_SUM_CHECKPOINTS
+    if (!TestSumCheckpoints())
+    {
+        Logger.Error("Test failed: TestSumCheckpoints");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
+#ifdef TEST_DECODER_THREADS
+    if (!TestDecoderThreads())
+    {
+        Logger.Error("Test failed: TestDecoderThreads");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
+#ifdef TEST_DECODER_IDLE_WORK
+    if (!TestDecoderIdleWork())
+    {
+        Logger.Error("Test failed: TestDecoderIdleWork");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
+#ifdef TEST_SINGLE_LOSS
+    if (!TestSingleLoss())
+    {
+        Logger.Error("Test failed: TestSingleLoss");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
+#ifdef TEST_CAUCHY_SOLVE
+    if (!TestCauchySolve())
+    {
+        Logger.Error("Test failed: TestCauchySolve");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
+#ifdef TEST_RECOVERY_REORDER
+    if (!TestRecoveryReorder())
+    {
+        Logger.Error("Test failed: TestRecoveryReorder");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
+#ifdef TEST_DECODER_ACK
+    if (!TestDecoderAck())
+    {
+        Logger.Error("Test failed: TestDecoderAck");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
+#ifdef TEST_DECODER_JUMP_AHEAD
+    if (!TestDecoderJumpAhead())
+    {
+        Logger.Error("Test failed: TestDecoderJumpAhead");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
+#ifdef TEST_ALLOCATOR_POOL
+    if (!TestAllocatorPool())
+    {
+        Logger.Error("Test failed: TestAllocatorPool");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
+#ifdef TEST_LARGE_PACKETS
+    if (!TestLargePackets())
+    {
+        Logger.Error("Test failed: TestLargePackets");
+        SIAMESE_DEBUG_BREAK();
+        return -1;
+    }
+#endif
 #ifdef TEST_STREAMING
     StreamingTest();
 #endif
+#ifdef TEST_SUM_BENCHMARK
+    SumBenchmark();
+#endif
 #ifdef TEST_BLOCK
     BlockRecoveryTest();
 #endif